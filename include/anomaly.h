@@ -0,0 +1,124 @@
+/**
+ * @file anomaly.h
+ * @brief Rolling-baseline anomaly detection on the interval time series
+ *
+ * The continuous counterpart of regression.c: instead of one finished
+ * run against a baseline file, every time series interval is compared
+ * against a trailing baseline of the same run. Per metric the detector
+ * keeps an exponentially weighted mean and an exponentially weighted
+ * mean absolute deviation (a running MAD), both updated in O(1) per
+ * interval with fixed-size state.
+ *
+ * An interval deviates when it is further than threshold x 1.2533 x MAD
+ * (about threshold standard deviations for normal noise) from the mean
+ * in the bad direction: pps below, drop rate and latency above. Values
+ * are clamped to the band before they update the baseline, so a spike
+ * hardly moves it but a lasting shift is absorbed over about one window.
+ * An alert is raised after `persist` deviating intervals in a row
+ * (logged, counted in "anomaly_alerts", "anomaly_active" set to 1) and
+ * cleared after as many normal ones.
+ *
+ * Observations come from the time series sampler thread; a metrics reset
+ * (new run) starts the baselines over.
+ */
+
+#ifndef ANOMALY_H
+#define ANOMALY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "timeseries.h"
+
+/* Defaults */
+#define ANOMALY_WINDOW_DEFAULT 60           /* Baseline span in intervals (alpha = 2 / (window + 1)) */
+#define ANOMALY_THRESHOLD_DEFAULT 4.0       /* Band half-width in robust standard deviations */
+#define ANOMALY_PERSIST_DEFAULT 3           /* Intervals in a row to raise or clear an alert */
+#define ANOMALY_WARMUP_DEFAULT 10           /* Intervals before any alert */
+
+/* Monitored interval metrics */
+typedef enum {
+    ANOMALY_PPS,                /* Processed packets per second (alert when low) */
+    ANOMALY_DROP_RATE,          /* Drops / (processed + drops) */
+    ANOMALY_P50,                /* Interval latency percentiles */
+    ANOMALY_P95,
+    ANOMALY_P99,
+    ANOMALY_METRIC_COUNT
+} anomaly_metric_t;
+
+/* Detector configuration; zero fields take the defaults */
+typedef struct {
+    uint32_t window;
+    double threshold;
+    uint32_t persist;
+    uint32_t warmup;
+} anomaly_config_t;
+
+/**
+ * @brief Baseline and alert state of one metric
+ */
+typedef struct {
+    uint64_t observed;          /* Intervals that updated the baseline */
+    double last;                /* Most recent interval value */
+    double baseline;            /* EWMA of the (clamped) values */
+    double mad;                 /* EWMA of the absolute deviation from the baseline */
+    double band;                /* Deviation that counts as anomalous */
+    uint32_t streak;            /* Consecutive deviating intervals */
+    bool active;                /* Alert raised and not yet cleared */
+    uint64_t alerts;            /* Alerts raised since the last reset */
+} anomaly_status_t;
+
+/**
+ * @brief Enable detection with the given settings (NULL = defaults)
+ *
+ * Call before timeseries_start(); the sampler then feeds every interval
+ * until capture ends. The first call registers "anomaly_alerts" and
+ * "anomaly_active"; runs without detection do not export them.
+ *
+ * @return 0 on success, -1 if a setting is out of range (logged)
+ */
+int anomaly_configure(const anomaly_config_t *config);
+
+/**
+ * @brief Disable detection and clear all state
+ */
+void anomaly_disable(void);
+
+/**
+ * @brief Whether anomaly_configure() enabled detection
+ */
+bool anomaly_enabled(void);
+
+/**
+ * @brief Start all baselines over (new measurement epoch)
+ */
+void anomaly_reset(void);
+
+/**
+ * @brief Compare one interval against the baselines and update them
+ *
+ * Intervals without processed packets or drops leave the drop rate and
+ * latency baselines alone. No-op while detection is disabled.
+ *
+ * @return Number of alerts raised by this interval
+ */
+int anomaly_observe(const timeseries_sample_t *sample);
+
+/**
+ * @brief Copy the state of every metric
+ *
+ * @param out Array of ANOMALY_METRIC_COUNT entries
+ */
+void anomaly_get_status(anomaly_status_t *out);
+
+/**
+ * @brief Metric name as used for the "metric" label ("pps", "drop_rate", ...)
+ */
+const char* anomaly_metric_name(anomaly_metric_t metric);
+
+/**
+ * @brief Write the "anomaly" block of the metrics JSON (no trailing comma)
+ */
+void anomaly_write_json(FILE *fp);
+
+#endif /* ANOMALY_H */
@@ -0,0 +1,102 @@
+/**
+ * @file dump.h
+ * @brief Sampled, asynchronous packet dump
+ *
+ * Worker threads select packets (1-in-N sampling, filter match, first N
+ * per flow) and enqueue a compact record of the parsed headers into a
+ * bounded lock-free queue. A dedicated formatter thread turns records
+ * into log lines, so output volume no longer limits packet throughput.
+ */
+
+#ifndef DUMP_H
+#define DUMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "packet.h"
+
+/* Bytes of frame data kept per record for hexdump mode */
+#define DUMP_SNAP_BYTES 64
+
+/* Default queue capacity in records (power of two) */
+#define DUMP_QUEUE_DEFAULT 4096
+
+/* Flow counter slots for first-N-per-flow selection (power of two) */
+#define DUMP_FLOW_SLOTS 8192
+
+/* Worker threads with private selection counters; later threads share one */
+#define DUMP_MAX_THREADS 64
+
+/* Output modes */
+typedef enum {
+    DUMP_OFF,                   /* No packet output */
+    DUMP_SUMMARY,               /* One line per packet */
+    DUMP_FULL,                  /* One line per header layer */
+    DUMP_HEXDUMP                /* Full plus the first DUMP_SNAP_BYTES of the frame */
+} dump_mode_t;
+
+/* Header filter; zero fields match anything */
+typedef struct {
+    uint8_t ip_proto;           /* 6=tcp, 17=udp, 1=icmp */
+    uint16_t port;              /* Either source or destination port */
+    uint32_t host;              /* Either address (network byte order) */
+} dump_filter_t;
+
+/* Dump configuration */
+typedef struct {
+    dump_mode_t mode;
+    uint32_t sample_n;          /* Dump 1 in N selected packets per thread (0/1 = all) */
+    uint32_t first_n;           /* Dump only the first N packets per flow (0 = no limit) */
+    dump_filter_t filter;
+    uint32_t queue_capacity;    /* Records (0 = DUMP_QUEUE_DEFAULT) */
+} dump_config_t;
+
+/* Dump counters */
+typedef struct {
+    uint64_t seen;              /* Packets offered to dump_packet() */
+    uint64_t selected;          /* Packets that passed selection */
+    uint64_t written;           /* Records formatted */
+    uint64_t dropped;           /* Records lost because the queue was full */
+} dump_stats_t;
+
+/**
+ * @brief Start the dump subsystem and its formatter thread
+ *
+ * @return 0 on success, -1 on error
+ */
+int dump_init(const dump_config_t *config);
+
+/**
+ * @brief Select a parsed packet and enqueue its record (worker hot path)
+ */
+void dump_packet(const packet_t *packet);
+
+/**
+ * @brief Drain queued records, stop the formatter thread and log counters
+ */
+void dump_shutdown(void);
+
+/**
+ * @brief Read dump counters
+ */
+void dump_get_stats(dump_stats_t *stats);
+
+/**
+ * @brief Parse a mode name (off, summary, full, hexdump)
+ *
+ * @return 0 on success, -1 if the name is unknown
+ */
+int dump_parse_mode(const char *name, dump_mode_t *mode);
+
+/**
+ * @brief Parse a filter expression such as "tcp port 443 host 10.0.0.1"
+ *
+ * Terms are tcp, udp, icmp, "port N" and "host A.B.C.D", separated by
+ * spaces or commas; all given terms must match.
+ *
+ * @return 0 on success, -1 on a malformed expression
+ */
+int dump_parse_filter(const char *expr, dump_filter_t *filter);
+
+#endif /* DUMP_H */
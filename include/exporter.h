@@ -0,0 +1,51 @@
+/**
+ * @file exporter.h
+ * @brief Prometheus/OpenMetrics HTTP exporter
+ *
+ * A single background thread listens on a local TCP port and answers
+ * GET /metrics with the current metrics in OpenMetrics text format. Each
+ * scrape takes its own metrics snapshot on the exporter thread, so
+ * workers never wait on a scrape and a slow client only delays the
+ * exporter itself.
+ */
+
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Defaults */
+#define EXPORTER_BIND_DEFAULT "127.0.0.1"
+#define EXPORTER_IO_TIMEOUT_MS 1000     /* Per-connection read/write budget */
+
+/* Histogram bucket bounds: powers of two from 2^10 ns (~1 µs) to 2^35 ns (~34 s) */
+#define EXPORTER_BUCKET_MIN_LOG2 10
+#define EXPORTER_BUCKET_MAX_LOG2 35
+
+/* Exporter configuration */
+typedef struct {
+    uint16_t port;              /* TCP port (0 = exporter disabled) */
+    const char *bind_addr;      /* IPv4 address to listen on (NULL = EXPORTER_BIND_DEFAULT) */
+} exporter_config_t;
+
+/**
+ * @brief Bind the listening socket and start the exporter thread
+ *
+ * @return 0 on success, -1 on error
+ */
+int exporter_start(const exporter_config_t *config);
+
+/**
+ * @brief Stop the exporter thread and close the socket
+ */
+void exporter_stop(void);
+
+/**
+ * @brief Write the current metrics in OpenMetrics text format
+ *
+ * Produces the body served at /metrics, ending with "# EOF".
+ */
+void exporter_write_openmetrics(FILE *fp);
+
+#endif /* EXPORTER_H */
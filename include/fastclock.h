@@ -0,0 +1,102 @@
+/**
+ * @file fastclock.h
+ * @brief Calibrated TSC clock for hot-path timestamps
+ *
+ * On x86 CPUs with an invariant TSC, fastclock_ticks() is a single rdtsc
+ * and fastclock_to_ns() a fixed-point multiply, instead of a
+ * clock_gettime() call per timestamp. The tick rate is calibrated against
+ * CLOCK_MONOTONIC at startup over several rounds; if the TSC is not
+ * invariant or the rounds disagree, ticks fall back to CLOCK_MONOTONIC
+ * nanoseconds and everything keeps working, only slower.
+ */
+
+#ifndef FASTCLOCK_H
+#define FASTCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* Calibration: rounds of FASTCLOCK_CALIBRATION_NS each; fall back above the spread limit */
+#define FASTCLOCK_CALIBRATION_ROUNDS 3
+#define FASTCLOCK_CALIBRATION_NS 2000000ULL
+#define FASTCLOCK_MAX_SPREAD_PPM 500.0
+
+/* Tick sources */
+typedef enum {
+    FASTCLOCK_MONOTONIC,        /* clock_gettime(CLOCK_MONOTONIC), 1 tick = 1 ns */
+    FASTCLOCK_TSC               /* rdtsc, calibrated */
+} fastclock_source_t;
+
+/* Calibration result */
+typedef struct {
+    fastclock_source_t source;
+    bool invariant_tsc;         /* CPUID reports a constant-rate, non-stop TSC */
+    double ticks_per_ns;        /* TSC frequency in GHz (1.0 for CLOCK_MONOTONIC) */
+    double spread_ppm;          /* Max disagreement between calibration rounds */
+    const char *fallback_reason; /* Why the TSC was not used, or NULL */
+} fastclock_info_t;
+
+/* Set by fastclock_init(); read on every fastclock_ticks() */
+extern bool fastclock_tsc_enabled;
+
+/**
+ * @brief Detect and calibrate the TSC (idempotent, about 6 ms the first time)
+ *
+ * Call before starting threads that take timestamps.
+ */
+void fastclock_init(void);
+
+/**
+ * @brief CLOCK_MONOTONIC in nanoseconds
+ */
+static inline uint64_t fastclock_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Read the tick counter
+ *
+ * Convert differences with fastclock_to_ns(); absolute values are only
+ * meaningful to fastclock_ticks_to_monotonic_ns().
+ */
+static inline uint64_t fastclock_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (fastclock_tsc_enabled) {
+        return __builtin_ia32_rdtsc();
+    }
+#endif
+    return fastclock_monotonic_ns();
+}
+
+/**
+ * @brief Convert a tick difference to nanoseconds
+ */
+uint64_t fastclock_to_ns(uint64_t ticks);
+
+/**
+ * @brief Map a tick reading onto the CLOCK_MONOTONIC timeline
+ */
+uint64_t fastclock_ticks_to_monotonic_ns(uint64_t ticks);
+
+/**
+ * @brief Wall-clock seconds derived from a tick reading
+ *
+ * Anchored to CLOCK_REALTIME at fastclock_init(); later wall-clock steps
+ * are not followed, which is fine for per-packet log timestamps.
+ */
+time_t fastclock_ticks_to_wall_sec(uint64_t ticks);
+
+/**
+ * @brief Get the calibration result
+ */
+void fastclock_get_info(fastclock_info_t *info);
+
+/**
+ * @brief Name of a tick source ("tsc", "monotonic")
+ */
+const char* fastclock_source_name(fastclock_source_t source);
+
+#endif /* FASTCLOCK_H */
@@ -0,0 +1,173 @@
+/**
+ * @file hdr_histogram.h
+ * @brief High dynamic range latency histogram
+ *
+ * Values are bucketed by power of two; each power-of-two range is split
+ * into enough linear sub-buckets to keep the given number of significant
+ * decimal digits. Values below 2 * 10^digits ns are recorded exactly, and
+ * the relative error of any reported value stays below 10^-digits.
+ *
+ * Histograms with the same configuration merge exactly by adding counts,
+ * so per-thread instances and per-run results can be combined without
+ * losing precision.
+ */
+
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/* Supported significant digits */
+#define HDR_DIGITS_MIN 1
+#define HDR_DIGITS_MAX 5
+
+/**
+ * @brief Histogram with a fixed value range and precision
+ *
+ * counts[] is allocated with the structure. Recording uses atomics so
+ * histograms can be shared; hdr_record_local() is the cheaper form for a
+ * histogram written by a single thread.
+ */
+typedef struct {
+    int significant_digits;
+    uint64_t highest_trackable;         /* Larger values are clamped to this */
+    int sub_bucket_half_count_magnitude;
+    uint32_t sub_bucket_count;
+    uint32_t sub_bucket_half_count;
+    uint64_t sub_bucket_mask;
+    int bucket_count;
+    int counts_len;
+    _Atomic uint64_t counts[];
+} hdr_histogram_t;
+
+/**
+ * @brief Create an empty histogram
+ *
+ * @param highest_trackable Largest value kept exactly in range (>= 2)
+ * @param significant_digits Decimal digits of precision (1 - 5)
+ * @return New histogram, or NULL on invalid arguments or allocation failure
+ */
+hdr_histogram_t* hdr_create(uint64_t highest_trackable, int significant_digits);
+
+/**
+ * @brief Create a histogram with the configuration and counts of h
+ *
+ * @return New histogram, or NULL if h is NULL or allocation fails
+ */
+hdr_histogram_t* hdr_copy(const hdr_histogram_t *h);
+
+/**
+ * @brief Free a histogram (NULL is ignored)
+ */
+void hdr_destroy(hdr_histogram_t *h);
+
+/**
+ * @brief Zero all counts
+ *
+ * Uses relaxed stores; callers must not race with other writers.
+ */
+void hdr_reset(hdr_histogram_t *h);
+
+/**
+ * @brief Record a value from any thread (atomic increment)
+ */
+void hdr_record(hdr_histogram_t *h, uint64_t value);
+
+/**
+ * @brief Record a value into a histogram only the calling thread writes
+ *
+ * Relaxed load + store, no locked read-modify-write. Readers may merge
+ * the histogram concurrently.
+ */
+void hdr_record_local(hdr_histogram_t *h, uint64_t value);
+
+/**
+ * @brief Add all counts of src to dst
+ *
+ * @return 0 on success, -1 if the configurations differ
+ */
+int hdr_add(hdr_histogram_t *dst, const hdr_histogram_t *src);
+
+/**
+ * @brief Subtract the counts of src from dst (src must be an earlier copy of dst)
+ *
+ * Counts that would go negative are clamped to 0.
+ *
+ * @return 0 on success, -1 if the configurations differ
+ */
+int hdr_subtract(hdr_histogram_t *dst, const hdr_histogram_t *src);
+
+/**
+ * @brief Total number of recorded values
+ */
+uint64_t hdr_total_count(const hdr_histogram_t *h);
+
+/**
+ * @brief Value at a quantile
+ *
+ * Returns the highest value equivalent (within the histogram precision)
+ * to the recorded value at the quantile.
+ *
+ * @param quantile Quantile (0.0 - 1.0)
+ * @return Value, or 0 if the histogram is empty
+ */
+uint64_t hdr_value_at_quantile(const hdr_histogram_t *h, double quantile);
+
+/**
+ * @brief Values at several quantiles of the sum of histograms, without merging them
+ *
+ * Reads the counts in place, so live histograms need no hdr_copy().
+ * Histograms configured differently from the first are skipped.
+ *
+ * @param hists Histograms to sum (NULL entries are skipped)
+ * @param quantiles Ascending quantiles (0.0 - 1.0)
+ * @param values Receives one value per quantile (0 if all are empty)
+ */
+void hdr_sum_quantiles(const hdr_histogram_t *const *hists, int count,
+                       const double *quantiles, uint64_t *values, int quantile_count);
+
+/**
+ * @brief Number of counts[] entries
+ */
+int hdr_counts_len(const hdr_histogram_t *h);
+
+/**
+ * @brief Lowest value recorded into counts[index]
+ */
+uint64_t hdr_value_at_index(const hdr_histogram_t *h, int index);
+
+/**
+ * @brief counts[] entry a value is recorded into (clamped like hdr_record())
+ */
+int hdr_index_of(const hdr_histogram_t *h, uint64_t value);
+
+/**
+ * @brief Highest value recorded into the same counts[] entry as value
+ */
+uint64_t hdr_highest_equivalent(const hdr_histogram_t *h, uint64_t value);
+
+/**
+ * @brief Number of recorded values up to and including value's counts[] entry
+ */
+uint64_t hdr_count_at_or_below(const hdr_histogram_t *h, uint64_t value);
+
+/**
+ * @brief Write the histogram as a single-line JSON object
+ *
+ * Format: {"digits": D, "highest": H, "counts": [...]}. counts[] runs up
+ * to the last non-zero entry; a negative number -N stands for N zero
+ * entries.
+ */
+void hdr_write_json(const hdr_histogram_t *h, FILE *fp);
+
+/**
+ * @brief Parse a histogram written by hdr_write_json()
+ *
+ * @param json Text starting at or before the histogram object
+ * @return New histogram, or NULL if the object is missing or malformed
+ */
+hdr_histogram_t* hdr_parse_json(const char *json);
+
+#endif /* HDR_HISTOGRAM_H */
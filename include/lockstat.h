@@ -0,0 +1,144 @@
+/**
+ * @file lockstat.h
+ * @brief Instrumented mutexes with per-site wait and hold histograms
+ *
+ * lockstat_lock() tries the mutex first and only times the wait, and
+ * counts a contention, when that fails. Hold time runs from acquisition
+ * to lockstat_unlock() in fastclock ticks. Everything is recorded while
+ * the mutex is held, into the registry's per-thread shards, so an
+ * uncontended lock/unlock pair costs one trylock, two tick reads and a
+ * few thread-local stores on top of the plain mutex.
+ *
+ * The results are registry metrics labeled by lock site, reset with the
+ * other metrics by metrics_init():
+ *   lock_acquisitions   acquisitions (condition wait wake-ups included)
+ *   lock_contentions    acquisitions that found the mutex taken
+ *   lock_wait_ns        wait of contended acquisitions (log2 histogram)
+ *   lock_hold_ns        hold time per acquisition (log2 histogram)
+ */
+
+#ifndef LOCKSTAT_H
+#define LOCKSTAT_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "registry.h"
+#include "fastclock.h"
+
+/* Instrumented lock sites */
+typedef enum {
+    LOCKSTAT_QUEUE,             /* thread_pool queue_lock */
+    LOCKSTAT_METRICS,           /* metrics shard list and buffer switch */
+    LOCKSTAT_MEMBUDGET,         /* membudget level transitions */
+    LOCKSTAT_TIMESERIES,        /* timeseries interval ring */
+    LOCKSTAT_SITE_COUNT
+} lockstat_site_t;
+
+/**
+ * @brief Mutex with its site; acquired_ticks is only touched by the holder
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    lockstat_site_t site;
+    uint64_t acquired_ticks;
+} lockstat_mutex_t;
+
+#define LOCKSTAT_MUTEX_INITIALIZER(site) { PTHREAD_MUTEX_INITIALIZER, (site), 0 }
+
+/* Registry slots of one site, -1 until lockstat_register() (recording is then a no-op) */
+typedef struct {
+    int acquisitions;
+    int contentions;
+    int wait;
+    int hold;
+} lockstat_slots_t;
+
+extern lockstat_slots_t lockstat_slots[LOCKSTAT_SITE_COUNT];
+
+/**
+ * @brief Per-site totals read from a registry snapshot
+ */
+typedef struct {
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_ns;           /* Total wait of contended acquisitions */
+    uint64_t wait_p50_ns;       /* Quantiles are log2 bucket upper bounds */
+    uint64_t wait_p99_ns;
+    uint64_t hold_ns;           /* Total hold time */
+    uint64_t hold_p50_ns;
+    uint64_t hold_p99_ns;
+} lockstat_summary_t;
+
+/**
+ * @brief Register the lock metrics and resolve their slots
+ *
+ * Only the first call does anything, so the slots never change while
+ * threads record.
+ */
+void lockstat_register(void);
+
+/**
+ * @brief Initialize a mutex for a site (for mutexes inside allocated structs)
+ *
+ * @return pthread_mutex_init() result
+ */
+int lockstat_mutex_init(lockstat_mutex_t *m, lockstat_site_t site);
+
+/**
+ * @brief Destroy a mutex initialized with lockstat_mutex_init()
+ */
+void lockstat_mutex_destroy(lockstat_mutex_t *m);
+
+/**
+ * @brief Lock, timing the wait only when the mutex is already taken
+ */
+static inline void lockstat_lock(lockstat_mutex_t *m) {
+    const lockstat_slots_t *slots = &lockstat_slots[m->site];
+    if (pthread_mutex_trylock(&m->mutex) != 0) {
+        uint64_t start = fastclock_ticks();
+        pthread_mutex_lock(&m->mutex);
+        m->acquired_ticks = fastclock_ticks();
+        registry_add_slot(slots->contentions, 1);
+        registry_observe_slot(slots->wait, fastclock_to_ns(m->acquired_ticks - start));
+    } else {
+        m->acquired_ticks = fastclock_ticks();
+    }
+    registry_add_slot(slots->acquisitions, 1);
+}
+
+/**
+ * @brief Record the hold time and unlock
+ */
+static inline void lockstat_unlock(lockstat_mutex_t *m) {
+    registry_observe_slot(lockstat_slots[m->site].hold,
+                          fastclock_to_ns(fastclock_ticks() - m->acquired_ticks));
+    pthread_mutex_unlock(&m->mutex);
+}
+
+/**
+ * @brief pthread_cond_wait() on an instrumented mutex
+ *
+ * Time spent waiting for the condition is neither hold nor wait time:
+ * the hold ends before the wait and a new one starts on wake-up.
+ */
+static inline int lockstat_cond_wait(pthread_cond_t *cond, lockstat_mutex_t *m) {
+    const lockstat_slots_t *slots = &lockstat_slots[m->site];
+    registry_observe_slot(slots->hold, fastclock_to_ns(fastclock_ticks() - m->acquired_ticks));
+    int rc = pthread_cond_wait(cond, &m->mutex);
+    m->acquired_ticks = fastclock_ticks();
+    registry_add_slot(slots->acquisitions, 1);
+    return rc;
+}
+
+/**
+ * @brief Totals and quantiles of one site
+ */
+void lockstat_summarize(const registry_snapshot_t *snapshot, lockstat_site_t site,
+                        lockstat_summary_t *summary);
+
+/**
+ * @brief Site name as used for the "site" label
+ */
+const char* lockstat_site_name(lockstat_site_t site);
+
+#endif /* LOCKSTAT_H */
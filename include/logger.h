@@ -2,8 +2,34 @@
 #define LOGGER_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <time.h>
 
+/* Maximum formatted line length (longer lines are truncated) */
+#define LOGGER_LINE_MAX 1024
+
+/* Maximum number of producer threads with a private async ring */
+#define LOGGER_ASYNC_MAX_THREADS 64
+
+/* Default async memory budget shared by all per-thread rings */
+#define LOGGER_ASYNC_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+/* Smallest budget: one full line per possible thread ring */
+#define LOGGER_ASYNC_MIN_BUDGET (LOGGER_LINE_MAX * LOGGER_ASYNC_MAX_THREADS)
+
+/*
+ * Build-time level threshold for the LOGGER_* macros: 0=debug, 1=info,
+ * 2=warn, 3=error, 4=critical. Macros below it compile to nothing, so
+ * their arguments are never evaluated (e.g. make LOG_LEVEL=1).
+ */
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL 0
+#endif
+
+#define LOGGER_LIKELY(x)   __builtin_expect(!!(x), 1)
+#define LOGGER_UNLIKELY(x) __builtin_expect(!!(x), 0)
+
 /* Log Level Enumeration */
 typedef enum {
     LOG_DEBUG,
@@ -13,6 +39,12 @@ typedef enum {
     LOG_CRITICAL
 } log_level_t;
 
+/* Async ring overflow policy */
+typedef enum {
+    LOG_OVERFLOW_DROP,          /* Drop the line and count it */
+    LOG_OVERFLOW_BLOCK          /* Wait for the writer to make room */
+} log_overflow_policy_t;
+
 /* Logger Configuration */
 typedef struct {
     FILE *output_file;          /* Output file pointer */
@@ -21,6 +53,31 @@ typedef struct {
     int use_timestamps;         /* Include timestamps in logs */
 } logger_config_t;
 
+/* Default per-call-site token bucket for rate-limited macros */
+#define LOGGER_RATELIMIT_BURST 5            /* Messages allowed back to back */
+#define LOGGER_RATELIMIT_PER_SEC 1          /* Sustained messages per second */
+
+/**
+ * @brief Per-call-site token bucket
+ *
+ * state packs the last refill time in ms (upper 48 bits) and the
+ * available tokens (lower 16 bits) so it is updated with one CAS.
+ */
+typedef struct {
+    _Atomic uint64_t state;
+    _Atomic uint64_t suppressed;    /* Messages dropped since the last one logged */
+} logger_ratelimit_t;
+
+/* Runtime minimum level (above LOG_CRITICAL until logger_init) */
+extern int g_logger_min_level;
+
+/**
+ * @brief Inlined runtime level check used by the LOGGER_* macros
+ */
+static inline int logger_is_enabled(log_level_t level) {
+    return (int)level >= g_logger_min_level;
+}
+
 /* Function Declarations */
 void logger_init(const char *log_file, log_level_t min_level);
 void logger_cleanup(void);
@@ -32,4 +89,132 @@ void logger_error(const char *format, ...);
 void logger_critical(const char *format, ...);
 void logger_hexdump(const char *label, const uint8_t *data, size_t length);
 
+/**
+ * @brief Take a token from a call site's bucket
+ *
+ * @param rl Call-site bucket (zero-initialized static)
+ * @param per_sec Sustained refill rate in messages per second
+ * @param burst Bucket capacity
+ * @param suppressed Receives how many messages were dropped since the
+ *                   previous allowed one (only set when allowed)
+ * @return 1 if the message may be logged, 0 if it is suppressed
+ */
+int logger_ratelimit_allow(logger_ratelimit_t *rl, uint32_t per_sec, uint32_t burst,
+                           uint64_t *suppressed);
+
+/**
+ * @brief Log a message, noting how many similar ones were suppressed
+ */
+void logger_log_suppressed(log_level_t level, uint64_t suppressed, const char *format, ...);
+
+/**
+ * @brief Switch the logger to asynchronous output
+ *
+ * Each producer thread formats into its own lock-free ring buffer and a
+ * background writer drains all rings with writev(). Rings are allocated
+ * lazily; their combined size never exceeds memory_budget. Pending lines
+ * are flushed by logger_cleanup() and on fatal signals.
+ *
+ * @param memory_budget Total bytes for all rings (0 = LOGGER_ASYNC_DEFAULT_BUDGET,
+ *                      otherwise at least LOGGER_ASYNC_MIN_BUDGET)
+ * @param policy What producers do when their ring is full
+ * @return 0 on success, -1 on error or a budget below the minimum
+ *         (logged; the logger stays synchronous)
+ */
+int logger_start_async(size_t memory_budget, log_overflow_policy_t policy);
+
+/**
+ * @brief Functions the async writer thread calls when it starts and exits
+ *
+ * Lets other modules (e.g. the profiler) set up per-thread state for the
+ * writer without the logger depending on them. Set before
+ * logger_start_async(); either may be NULL.
+ */
+void logger_set_writer_hooks(void (*on_start)(void), void (*on_exit)(void));
+
+/**
+ * @brief Block until all lines queued so far have been written
+ */
+void logger_flush(void);
+
+/**
+ * @brief Number of lines dropped by the async overflow policy
+ */
+uint64_t logger_dropped_count(void);
+
+/**
+ * @brief Memory held by the async rings
+ *
+ * @param bytes Ring bytes currently allocated (may be NULL)
+ * @param allocs Rings allocated since logger_start_async() (may be NULL)
+ */
+void logger_memory_usage(uint64_t *bytes, uint64_t *allocs);
+
+/*
+ * Level macros: compiled out below LOGGER_COMPILE_LEVEL, otherwise an
+ * inlined, branch-predicted check guards argument evaluation and the call.
+ * Disabled macros keep an if (0) body so format arguments stay type-checked.
+ */
+#if LOGGER_COMPILE_LEVEL <= 0
+#define LOGGER_DEBUG(fmt, ...) do { \
+    if (LOGGER_UNLIKELY(logger_is_enabled(LOG_DEBUG))) logger_debug((fmt), ##__VA_ARGS__); \
+} while (0)
+#else
+#define LOGGER_DEBUG(fmt, ...) do { if (0) logger_debug((fmt), ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= 1
+#define LOGGER_INFO(fmt, ...) do { \
+    if (LOGGER_LIKELY(logger_is_enabled(LOG_INFO))) logger_info((fmt), ##__VA_ARGS__); \
+} while (0)
+#else
+#define LOGGER_INFO(fmt, ...) do { if (0) logger_info((fmt), ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= 2
+#define LOGGER_WARN(fmt, ...) do { \
+    if (LOGGER_LIKELY(logger_is_enabled(LOG_WARN))) logger_warn((fmt), ##__VA_ARGS__); \
+} while (0)
+#else
+#define LOGGER_WARN(fmt, ...) do { if (0) logger_warn((fmt), ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= 3
+#define LOGGER_ERROR(fmt, ...) do { \
+    if (LOGGER_LIKELY(logger_is_enabled(LOG_ERROR))) logger_error((fmt), ##__VA_ARGS__); \
+} while (0)
+#else
+#define LOGGER_ERROR(fmt, ...) do { if (0) logger_error((fmt), ##__VA_ARGS__); } while (0)
+#endif
+
+/* Critical messages are never filtered */
+#define LOGGER_CRITICAL(fmt, ...) logger_critical((fmt), ##__VA_ARGS__)
+
+#if LOGGER_COMPILE_LEVEL <= 0
+#define LOGGER_HEXDUMP(label, data, length) do { \
+    if (LOGGER_UNLIKELY(logger_is_enabled(LOG_DEBUG))) logger_hexdump((label), (data), (length)); \
+} while (0)
+#else
+#define LOGGER_HEXDUMP(label, data, length) do { if (0) logger_hexdump((label), (data), (length)); } while (0)
+#endif
+
+/*
+ * Rate-limited logging: each call site owns a token bucket. Messages over
+ * the limit are counted, and the next one logged carries a
+ * "(suppressed N similar messages)" suffix.
+ */
+#define LOGGER_RATELIMITED(level, per_sec, burst, fmt, ...) do { \
+    static logger_ratelimit_t logger_rl_; \
+    uint64_t logger_rl_suppressed_; \
+    if ((int)(level) >= LOGGER_COMPILE_LEVEL && logger_is_enabled(level) && \
+        logger_ratelimit_allow(&logger_rl_, (per_sec), (burst), &logger_rl_suppressed_)) { \
+        logger_log_suppressed((level), logger_rl_suppressed_, (fmt), ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define LOGGER_WARN_RATELIMITED(fmt, ...) \
+    LOGGER_RATELIMITED(LOG_WARN, LOGGER_RATELIMIT_PER_SEC, LOGGER_RATELIMIT_BURST, fmt, ##__VA_ARGS__)
+#define LOGGER_ERROR_RATELIMITED(fmt, ...) \
+    LOGGER_RATELIMITED(LOG_ERROR, LOGGER_RATELIMIT_PER_SEC, LOGGER_RATELIMIT_BURST, fmt, ##__VA_ARGS__)
+
 #endif /* LOGGER_H */
@@ -0,0 +1,144 @@
+/**
+ * @file logger_bin.h
+ * @brief Binary deferred-format logging
+ *
+ * The hot path records only a static call-site id, a timestamp and the
+ * raw argument values into a per-thread buffer; no formatting happens in
+ * the process. Format strings are written once per call site and the
+ * offline decoder (build/binlog_decode) renders the text later.
+ *
+ * Supported conversions: d i u o x X c (with hh h l ll j z t modifiers),
+ * f F e E g G a A, s (copied, truncated to LOGGER_BIN_STR_MAX bytes), p
+ * and '*' width/precision.
+ */
+
+#ifndef LOGGER_BIN_H
+#define LOGGER_BIN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "logger.h"
+
+/* File format */
+#define LOGGER_BIN_MAGIC "PABLOG1"      /* 8 bytes including terminator */
+#define LOGGER_BIN_VERSION 1
+
+/* Record types */
+#define LOGGER_BIN_REC_SITE  1          /* Call-site definition */
+#define LOGGER_BIN_REC_EVENT 2          /* Logged event */
+
+/* Limits */
+#define LOGGER_BIN_MAX_ARGS 12
+#define LOGGER_BIN_STR_MAX 32
+#define LOGGER_BIN_THREAD_BUFFER (64 * 1024)
+#define LOGGER_BIN_MAX_THREADS 64
+
+/* Argument encodings (stored per site, derived from the format) */
+typedef enum {
+    BIN_ARG_INT = 1,            /* int (also char/short after promotion), 4 bytes */
+    BIN_ARG_LONG,               /* long, 8 bytes */
+    BIN_ARG_LLONG,              /* long long, 8 bytes */
+    BIN_ARG_SIZE,               /* size_t, 8 bytes */
+    BIN_ARG_INTMAX,             /* intmax_t, 8 bytes */
+    BIN_ARG_PTRDIFF,            /* ptrdiff_t, 8 bytes */
+    BIN_ARG_DOUBLE,             /* double, 8 bytes */
+    BIN_ARG_STRING,             /* length byte + up to LOGGER_BIN_STR_MAX bytes */
+    BIN_ARG_PTR                 /* void *, 8 bytes */
+} logger_bin_arg_t;
+
+/**
+ * @brief Static per-call-site descriptor
+ *
+ * Declared by LOGGER_BIN()/LOGGER_TRACE(); registered on first use.
+ */
+typedef struct {
+    const char *format;
+    const char *file;
+    int line;
+    log_level_t level;
+    _Atomic uint32_t id;        /* 0 until registered, UINT32_MAX if unsupported */
+    _Atomic uint32_t generation;/* Log file the id belongs to */
+    int nargs;                  /* -1 if the format is not supported */
+    uint8_t arg_types[LOGGER_BIN_MAX_ARGS];
+} logger_bin_site_t;
+
+/* Non-zero while a binary log is open (read by the inline check below) */
+extern _Atomic int g_logger_bin_active;
+
+/**
+ * @brief Check whether binary logging is enabled
+ */
+static inline bool logger_bin_active(void) {
+    return atomic_load_explicit(&g_logger_bin_active, memory_order_relaxed) != 0;
+}
+
+/**
+ * @brief Record a binary log event for a call site
+ *
+ * Normally invoked through LOGGER_BIN()/LOGGER_TRACE().
+ */
+void logger_bin_record(logger_bin_site_t *site, ...);
+
+/**
+ * @brief Record an event in the binary log (no-op when not open)
+ */
+#define LOGGER_BIN(lvl, fmt, ...) do { \
+    static logger_bin_site_t logger_bin_site_ = { (fmt), __FILE__, __LINE__, (lvl), 0, 0, 0, {0} }; \
+    if (logger_bin_active()) { \
+        logger_bin_record(&logger_bin_site_, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+/**
+ * @brief Per-packet debug trace: binary when a binary log is open, text otherwise
+ *
+ * Has its own switch: LOGGER_NO_TRACE (make TRACE=0) compiles it out,
+ * independently of LOGGER_COMPILE_LEVEL. A LOG_LEVEL > 0 build keeps the
+ * binary trace and only drops the text fallback with the debug macros.
+ */
+#if defined(LOGGER_NO_TRACE)
+#define LOGGER_TRACE(fmt, ...) do { if (0) logger_debug((fmt), ##__VA_ARGS__); } while (0)
+#else
+#define LOGGER_TRACE(fmt, ...) do { \
+    static logger_bin_site_t logger_bin_site_ = { (fmt), __FILE__, __LINE__, LOG_DEBUG, 0, 0, 0, {0} }; \
+    if (logger_bin_active()) { \
+        logger_bin_record(&logger_bin_site_, ##__VA_ARGS__); \
+    } else { \
+        LOGGER_DEBUG(fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+#endif
+
+/**
+ * @brief Open a binary log file
+ *
+ * @param filepath Output path
+ * @param min_level Minimum level recorded (independent of the text logger)
+ * @return 0 on success, -1 on error
+ */
+int logger_bin_open(const char *filepath, log_level_t min_level);
+
+/**
+ * @brief Flush all per-thread buffers and close the binary log
+ *
+ * Producing threads must have stopped; events recorded afterwards are lost.
+ */
+void logger_bin_close(void);
+
+/**
+ * @brief Number of events recorded since logger_bin_open()
+ */
+uint64_t logger_bin_event_count(void);
+
+/**
+ * @brief Decode a binary log into text
+ *
+ * @param in Binary log stream
+ * @param out Text output stream
+ * @return Number of events decoded, or -1 on a malformed file
+ */
+long logger_bin_decode(FILE *in, FILE *out);
+
+#endif /* LOGGER_BIN_H */
@@ -0,0 +1,206 @@
+/**
+ * @file membudget.h
+ * @brief Global memory budget with per-subsystem accounting
+ *
+ * Tracks bytes held by each stateful subsystem against a single global
+ * budget. As usage approaches the budget the analyzer degrades step by
+ * step (smaller snaplen, sampling, flow eviction, no payload analysis)
+ * instead of growing until the OOM killer takes the whole process down.
+ * Once the budget is exhausted new packets are refused at admission.
+ *
+ * Per measurement window (membudget_window_begin(), called from
+ * metrics_start()) it also profiles the footprint: allocations and
+ * bytes charged and peak bytes per subsystem, the bytes each queued
+ * packet holds, and process RSS sampled from /proc/self/status.
+ */
+
+#ifndef MEMBUDGET_H
+#define MEMBUDGET_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Snaplen applied once the budget reaches MEM_DEGRADE_SNAPLEN */
+#define MEMBUDGET_DEGRADED_SNAPLEN 128
+
+/* 1-in-N admission rate once the budget reaches MEM_DEGRADE_SAMPLING */
+#define MEMBUDGET_SAMPLE_RATE 4
+
+/* Number of level transitions retained for reporting */
+#define MEMBUDGET_MAX_TRANSITIONS 32
+
+/* Interval at which the capture loop samples RSS */
+#define MEMBUDGET_RSS_SAMPLE_MS 100
+
+/**
+ * @brief Accounted subsystems
+ */
+typedef enum {
+    MEM_SUBSYS_PACKET = 0,      /* Packet structures, raw and parsed data */
+    MEM_SUBSYS_QUEUE,           /* Work queue items */
+    MEM_SUBSYS_FLOW,            /* Flow tracking state */
+    MEM_SUBSYS_REASSEMBLY,      /* Reassembly buffers */
+    MEM_SUBSYS_SKETCH,          /* Probabilistic sketches */
+    MEM_SUBSYS_COUNT
+} mem_subsys_t;
+
+/**
+ * @brief Degradation levels, entered in order as usage grows
+ *
+ * Level thresholds (fraction of budget): 70% snaplen, 80% sampling,
+ * 90% flow eviction, 95% payload analysis disabled. A level is left
+ * again once usage falls 10% of the budget below its threshold.
+ */
+typedef enum {
+    MEM_DEGRADE_NONE = 0,       /* Full feature set */
+    MEM_DEGRADE_SNAPLEN,        /* Truncate packets to MEMBUDGET_DEGRADED_SNAPLEN */
+    MEM_DEGRADE_SAMPLING,       /* Admit 1-in-MEMBUDGET_SAMPLE_RATE packets */
+    MEM_DEGRADE_EVICT_FLOWS,    /* Stateful subsystems must shed state */
+    MEM_DEGRADE_NO_PAYLOAD,     /* Skip payload extraction */
+    MEM_DEGRADE_LEVELS
+} mem_degrade_level_t;
+
+/**
+ * @brief Recorded level transition
+ */
+typedef struct {
+    uint64_t time_ns;           /* metrics_now_ns() at transition */
+    mem_degrade_level_t from;
+    mem_degrade_level_t to;
+    uint64_t used_bytes;        /* Total usage when the transition happened */
+} membudget_transition_t;
+
+/**
+ * @brief Point-in-time copy of budget state for reporting
+ */
+typedef struct {
+    uint64_t budget_bytes;      /* 0 = unlimited (accounting only) */
+    uint64_t used_bytes;
+    uint64_t peak_bytes;
+    uint64_t subsys_bytes[MEM_SUBSYS_COUNT];
+    mem_degrade_level_t level;
+
+    /* Footprint profile since membudget_window_begin() */
+    uint64_t subsys_peak_bytes[MEM_SUBSYS_COUNT];
+    uint64_t subsys_allocs[MEM_SUBSYS_COUNT];       /* Charges */
+    uint64_t subsys_alloc_bytes[MEM_SUBSYS_COUNT];  /* Bytes charged */
+    uint64_t log_bytes;         /* Async logger rings (fixed, outside the budget) */
+    uint64_t log_allocs;
+    uint64_t queued_packets;    /* Packets accepted by the work queue */
+    uint64_t queued_bytes;      /* Their packet + queue item bytes at enqueue */
+    bool rss_valid;             /* /proc/self/status could be read */
+    uint64_t rss_bytes;         /* VmRSS at the snapshot */
+    uint64_t rss_start_bytes;   /* VmRSS at window begin */
+    uint64_t rss_peak_bytes;    /* Highest RSS in the window (samples and VmHWM) */
+    uint64_t rss_samples;
+
+    uint64_t admission_drops;   /* Packets refused because budget was exhausted */
+    uint64_t sampled_out;       /* Packets skipped by degraded sampling */
+    uint64_t transition_count;  /* Total level changes (may exceed retained) */
+    int transitions_retained;
+    membudget_transition_t transitions[MEMBUDGET_MAX_TRANSITIONS];
+} membudget_snapshot_t;
+
+/**
+ * @brief Initialize the memory budget
+ *
+ * Usage counters are kept across calls; only the limit and level state
+ * are reset.
+ *
+ * @param budget_bytes Global budget in bytes (0 = unlimited)
+ */
+void membudget_init(uint64_t budget_bytes);
+
+/**
+ * @brief Account bytes allocated by a subsystem
+ */
+void membudget_charge(mem_subsys_t subsys, size_t bytes);
+
+/**
+ * @brief Account bytes freed by a subsystem
+ */
+void membudget_release(mem_subsys_t subsys, size_t bytes);
+
+/**
+ * @brief Account a packet accepted by the work queue
+ *
+ * @param bytes Packet plus queue item footprint at enqueue
+ */
+void membudget_note_queued(size_t bytes);
+
+/**
+ * @brief Start a profiling window
+ *
+ * Clears the allocation and queued-packet counters, restarts the peaks
+ * from current usage and records the starting RSS. Peak RSS also
+ * includes the kernel's VmHWM when it can be reset for the window.
+ */
+void membudget_window_begin(void);
+
+/**
+ * @brief Read RSS from /proc/self/status and fold it into the window peak
+ */
+void membudget_sample_rss(void);
+
+/**
+ * @brief Mean bytes held per queued packet, 0 if none were queued
+ */
+double membudget_bytes_per_queued_packet(const membudget_snapshot_t *snapshot);
+
+/**
+ * @brief Admission control for a newly captured packet
+ *
+ * Refuses the packet when admitting it would exceed the budget, and
+ * applies 1-in-N sampling while at MEM_DEGRADE_SAMPLING or above.
+ *
+ * @param bytes Expected footprint of the packet
+ * @return true if the packet may be admitted
+ */
+bool membudget_admit(size_t bytes);
+
+/**
+ * @brief Apply the current snaplen to a captured length
+ */
+uint32_t membudget_snaplen(uint32_t length);
+
+/**
+ * @brief Whether payload extraction is currently allowed
+ */
+bool membudget_payload_enabled(void);
+
+/**
+ * @brief Current degradation level
+ */
+mem_degrade_level_t membudget_level(void);
+
+/**
+ * @brief Name of a degradation level (e.g. "sampling")
+ */
+const char* membudget_level_name(mem_degrade_level_t level);
+
+/**
+ * @brief Name of a subsystem (e.g. "packet_pool")
+ */
+const char* membudget_subsys_name(mem_subsys_t subsys);
+
+/**
+ * @brief Take a snapshot of budget state
+ *
+ * RSS fields hold the last membudget_sample_rss(); the snapshot itself
+ * does not read /proc.
+ */
+void membudget_snapshot(membudget_snapshot_t *snapshot);
+
+/**
+ * @brief Write the "memory" member of the metrics JSON object
+ *
+ * Emits `  "memory": { ... }` without a trailing comma or newline so the
+ * caller controls separators.
+ *
+ * @param fp Output file
+ */
+void membudget_write_json(FILE *fp);
+
+#endif /* MEMBUDGET_H */
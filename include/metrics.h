@@ -12,10 +12,65 @@
 #include <stdint.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include "hdr_histogram.h"
+#include "fastclock.h"
+#include "perfcount.h"
+#include "registry.h"
+#include "membudget.h"
 
 /* Histogram configuration: 32 buckets for nanosecond latency tracking */
 #define METRICS_HISTOGRAM_BUCKETS 32
 
+/* HDR latency histogram: range and default precision */
+#define METRICS_LATENCY_MAX_NS 60000000000ULL      /* 60 s */
+#define METRICS_LATENCY_DIGITS_DEFAULT 3
+
+/* Per-packet pipeline stages with their own latency histograms */
+typedef enum {
+    METRICS_STAGE_CAPTURE,      /* Capture to enqueue (copy + queue handoff) */
+    METRICS_STAGE_QUEUE,        /* Enqueue to dequeue (queue wait) */
+    METRICS_STAGE_PARSE,        /* Dequeue to parse done */
+    METRICS_STAGE_ANALYZE,      /* Parse done to analysis done */
+    METRICS_STAGE_COUNT
+} metrics_stage_t;
+
+/*
+ * Latency and byte volume by L4 protocol x packet-size class. Cells use
+ * 1-digit HDR histograms (about 4 KB each, under 10% relative error), so
+ * the whole grid costs less per shard than one default-precision histogram.
+ */
+typedef enum {
+    METRICS_L4_TCP,
+    METRICS_L4_UDP,
+    METRICS_L4_ICMP,            /* ICMP and ICMPv6 */
+    METRICS_L4_OTHER,           /* Other IP protocols and non-IP frames */
+    METRICS_L4_COUNT
+} metrics_l4_t;
+
+/* IMIX-style frame size classes: <=64, <=128, <=256, <=512, <=1024, <=1518, jumbo */
+#define METRICS_SIZE_CLASS_COUNT 7
+#define METRICS_CLASS_DIGITS 1
+
+/* Histograms copied by metrics_snapshot_select(); the others stay NULL */
+#define METRICS_SNAP_LATENCY 0x1u           /* latency_hdr and latency_histogram[] */
+#define METRICS_SNAP_STAGES 0x2u            /* stage_hdr[] */
+#define METRICS_SNAP_CLASSES 0x4u           /* classes[][].latency_hdr */
+#define METRICS_SNAP_ALL (METRICS_SNAP_LATENCY | METRICS_SNAP_STAGES | METRICS_SNAP_CLASSES)
+
+/* Work queue occupancy: arrivals bucketed by the fill level they find, in
+ * 10% steps of capacity plus a last bucket for a full queue */
+#define METRICS_QUEUE_OCC_BUCKETS 11
+#define METRICS_QUEUE_HIGH_PCT 80           /* Depth counted as "high" from here */
+
+/* Per-thread metric shards */
+#define METRICS_CACHE_LINE 64
+#define METRICS_MAX_SHARDS 64
+#define METRICS_THREAD_NAME_LEN 16
+
+/* Slowest packets kept per shard and per snapshot, and their address size */
+#define METRICS_EXEMPLARS 16
+#define METRICS_ADDR_LEN 16
+
 /* Maximum string length for metadata fields */
 #define METRICS_META_STRING_LEN 64
 
@@ -37,9 +92,32 @@ typedef struct {
     int duration_sec;
     int warmup_sec;
     int traffic_rate;                           /* Traffic rate in pps (0 if disabled) */
+    char clock_source[METRICS_META_STRING_LEN]; /* Per-packet timestamp clock: "tsc", "monotonic" */
+    double clock_ghz;                           /* Calibrated TSC rate (0 if not used) */
+    double clock_spread_ppm;                    /* Disagreement between calibration rounds */
     bool valid;
 } metrics_metadata_t;
 
+/**
+ * @brief One slow packet kept as a tail-latency exemplar
+ *
+ * Timestamps are in ns after capture_ts_ns, one per stage boundary:
+ * enqueued, dequeued, parsed, analyzed (the last equals latency_ns).
+ */
+typedef struct {
+    uint64_t latency_ns;                /* Capture to analysis done */
+    uint64_t capture_ts_ns;             /* CLOCK_MONOTONIC capture time */
+    uint64_t stage_end_ns[METRICS_STAGE_COUNT];
+    uint32_t length;                    /* Frame length in bytes */
+    uint8_t protocol;                   /* IP protocol, 0 for non-IP frames */
+    uint8_t ip_version;                 /* 4 or 6, 0 when there is no flow tuple */
+    uint16_t src_port;                  /* Host order, 0 without TCP/UDP */
+    uint16_t dst_port;
+    uint8_t src_addr[METRICS_ADDR_LEN]; /* Network order; IPv4 uses the first 4 bytes */
+    uint8_t dst_addr[METRICS_ADDR_LEN];
+    int worker_id;                      /* -1 if not recorded by a pool worker */
+} metrics_exemplar_t;
+
 /* Histogram bucket boundaries (nanoseconds):
  * Bucket 0:  [0, 1µs)
  * Bucket 1:  [1µs, 2µs)
@@ -53,6 +131,16 @@ typedef struct {
  * 
  * All counters use C11 atomics for lock-free concurrent access.
  * Uses _Atomic qualifier for proper memory ordering.
+ *
+ * There are two instances: metrics_init() prepares the idle one, makes
+ * it current by advancing the epoch and waits for writers still inside
+ * the retired one, so a reset never races an update.
+ *
+ * Plain counters live in the registry. What stays here is what the
+ * registry cannot express: packet and byte counts that must land in the
+ * same epoch and feed per-thread CPU stats, the HDR histograms and
+ * exemplars merged per shard, and the queue gauges kept under the queue
+ * lock.
  */
 typedef struct {
     /* Packet counters */
@@ -61,38 +149,100 @@ typedef struct {
     _Atomic uint64_t bytes_captured;
     _Atomic uint64_t bytes_processed;
 
-    /* Error counters */
-    _Atomic uint64_t parse_errors;
-    _Atomic uint64_t checksum_failures;
-    _Atomic uint64_t queue_drops;
-    _Atomic uint64_t capture_drops;
-
-    /* EtherType counters (L2/L3) */
-    _Atomic uint64_t ether_ipv4;
-    _Atomic uint64_t ether_ipv6;
-    _Atomic uint64_t ether_arp;
-    _Atomic uint64_t ether_other;
+    /* Error, drop, EtherType and L4 protocol counts live in the registry
+     * ("errors", "drops", "ethertype", "protocols") */
 
-    /* Protocol counters (L4) */
-    _Atomic uint64_t proto_tcp;
-    _Atomic uint64_t proto_udp;
-    _Atomic uint64_t proto_icmp;
-    _Atomic uint64_t proto_other;
-
-    /* Queue tracking */
-    _Atomic uint32_t queue_depth_max;
+    /* Queue gauges are kept outside the double buffer (serialized by the queue lock) */
 
     /* Latency tracking (nanoseconds) */
     _Atomic uint64_t latency_count;
     _Atomic uint64_t latency_sum_ns;
     _Atomic uint64_t latency_max_ns;
-    _Atomic uint64_t latency_histogram[METRICS_HISTOGRAM_BUCKETS];
+    hdr_histogram_t *latency_hdr;       /* Latencies from unregistered threads */
+    hdr_histogram_t *stage_hdr[METRICS_STAGE_COUNT];
+
+    /* Protocol x size class cells */
+    _Atomic uint64_t class_packets[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    _Atomic uint64_t class_bytes[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    hdr_histogram_t *class_hdr[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+
+    /* Exemplars from unregistered and exited threads (min-heap, g_shard_lock) */
+    metrics_exemplar_t exemplars[METRICS_EXEMPLARS];
+    int exemplar_count;
 
     /* Timing */
     uint64_t start_time_ns;
     uint64_t capture_end_time_ns;  /* Set when capture loop ends */
+
+    /* Epoch bookkeeping, not cleared on reset */
+    uint64_t epoch;                     /* Epoch the buffer collects */
+    _Alignas(METRICS_CACHE_LINE) _Atomic uint32_t writers;  /* Shared-path updates in flight */
 } metrics_t;
 
+/**
+ * @brief Per-thread counter shard
+ *
+ * Only the owning thread writes a shard, using relaxed load + store
+ * (no read-modify-write); metrics_snapshot() sums all shards. Shards
+ * are cache-line aligned so threads never share a written line.
+ */
+typedef struct {
+    _Alignas(METRICS_CACHE_LINE) _Atomic uint64_t generation;  /* Reset epoch the counters belong to */
+    hdr_histogram_t *latency_hdr;       /* Owned by the shard, reset with the counters */
+    hdr_histogram_t *stage_hdr[METRICS_STAGE_COUNT];
+    hdr_histogram_t *class_hdr[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+
+    /* CPU accounting, not reset with the counters: the owner only adds
+     * busy/idle ticks, window bases are set under the registry lock */
+    char name[METRICS_THREAD_NAME_LEN]; /* "capture", "worker-0", ... */
+    bool has_cpu_clock;
+    clockid_t cpu_clock;                /* Owner's thread CPU-time clock */
+    _Atomic uint64_t busy_ticks;        /* Worker loop: processing an item */
+    _Atomic uint64_t idle_ticks;        /* Worker loop: waiting for work */
+    uint64_t cpu_base_ns;
+    uint64_t busy_base_ticks;
+    uint64_t idle_base_ticks;
+
+    /* Slowest packets of the epoch: min-heap on latency, owner-written;
+     * readers copy it under the sequence count (odd while it changes) */
+    _Atomic uint32_t exemplar_seq;
+    int exemplar_count;
+    metrics_exemplar_t exemplars[METRICS_EXEMPLARS];
+
+    _Atomic uint64_t pkts_captured;
+    _Atomic uint64_t pkts_processed;
+    _Atomic uint64_t bytes_captured;
+    _Atomic uint64_t bytes_processed;
+
+    _Atomic uint64_t latency_count;
+    _Atomic uint64_t latency_sum_ns;
+    _Atomic uint64_t latency_max_ns;
+
+    _Atomic uint64_t class_packets[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    _Atomic uint64_t class_bytes[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+} metrics_shard_t;
+
+/**
+ * @brief One protocol x size class cell of a snapshot
+ */
+typedef struct {
+    uint64_t packets;
+    uint64_t bytes;
+    hdr_histogram_t *latency_hdr;       /* Freed by metrics_snapshot_free() */
+} metrics_class_stats_t;
+
+/**
+ * @brief CPU time of one registered thread since metrics_start()
+ */
+typedef struct {
+    char name[METRICS_THREAD_NAME_LEN];
+    bool cpu_valid;                     /* Thread CPU clock could be read */
+    uint64_t cpu_ns;                    /* User + system CPU time */
+    uint64_t busy_ns;                   /* Worker loop time spent processing */
+    uint64_t idle_ns;                   /* Worker loop time spent waiting for work */
+    uint64_t packets;                   /* Captured (capture thread) or processed (worker) */
+} metrics_thread_cpu_t;
+
 /**
  * @brief Snapshot of metrics for reporting
  * 
@@ -105,6 +255,7 @@ typedef struct {
     uint64_t bytes_captured;
     uint64_t bytes_processed;
     
+    /* Read from the registry snapshot below */
     uint64_t parse_errors;
     uint64_t checksum_failures;
     uint64_t queue_drops;
@@ -121,19 +272,86 @@ typedef struct {
     uint64_t proto_other;
     
     uint32_t queue_depth_max;
+    uint32_t queue_depth;
+    uint32_t queue_capacity;            /* 0 if no pool has reported one */
+    uint64_t queue_occupancy[METRICS_QUEUE_OCC_BUCKETS];  /* Enqueue attempts by fill level */
+    uint64_t queue_area_ns;             /* Integral of depth (depth x ns) over the window */
+    uint64_t queue_high_ns;             /* Time at or above METRICS_QUEUE_HIGH_PCT of capacity */
+    uint64_t queue_window_ns;           /* Time the integrals cover */
+    double queue_depth_mean;            /* Time-weighted mean depth over the window */
     
     uint64_t latency_count;
     uint64_t latency_sum_ns;
     uint64_t latency_max_ns;
-    uint64_t latency_histogram[METRICS_HISTOGRAM_BUCKETS];
+    uint64_t latency_histogram[METRICS_HISTOGRAM_BUCKETS];  /* log2 µs view of latency_hdr */
+    hdr_histogram_t *latency_hdr;       /* Merged HDR histogram, freed by metrics_snapshot_free() */
+    hdr_histogram_t *stage_hdr[METRICS_STAGE_COUNT];  /* Per-stage latency, same ownership */
+    metrics_class_stats_t classes[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    metrics_exemplar_t exemplars[METRICS_EXEMPLARS];  /* Slowest packets, slowest first */
+    int exemplar_count;
     
+    uint64_t epoch;              /* Reset epoch, advanced by every metrics_init() */
     uint64_t start_time_ns;
     uint64_t snapshot_time_ns;
     uint64_t capture_end_time_ns;
     double elapsed_sec;
     double capture_elapsed_sec;  /* Capture loop duration only (excludes drain time) */
+
+    perfcount_totals_t perf;     /* Hardware counters since metrics_start() */
+
+    /* Thread CPU time since metrics_start() */
+    metrics_thread_cpu_t threads[METRICS_MAX_SHARDS];  /* Registered threads */
+    int thread_count;
+    uint64_t cpu_ns;             /* Registered threads plus those that exited in the window */
+    uint64_t cpu_window_ns;      /* Wall time from metrics_start() to the CPU clock reads */
+    bool cpu_valid;              /* CPU time of every counted thread is known */
+
+    registry_snapshot_t registry; /* All registered metrics, including the above counts */
+
+    membudget_snapshot_t memory;  /* Budget, allocations and RSS since metrics_start() */
 } metrics_snapshot_t;
 
+/**
+ * @brief Counters of one registered thread (current epoch only)
+ */
+typedef struct {
+    uint64_t pkts_captured;
+    uint64_t pkts_processed;
+    uint64_t bytes_processed;
+} metrics_shard_stats_t;
+
+/**
+ * @brief Counters and latency summary of the current epoch
+ *
+ * What live monitors publish several times a second. Unlike a snapshot
+ * it copies no histogram and reads nothing from /proc: the percentiles
+ * are computed in place over the shared and per-thread HDR histograms.
+ */
+typedef struct {
+    uint64_t pkts_captured;
+    uint64_t pkts_processed;
+    uint64_t bytes_captured;
+    uint64_t bytes_processed;
+    uint64_t parse_errors;
+    uint64_t checksum_failures;
+    uint64_t queue_drops;
+    uint64_t capture_drops;
+    uint64_t ether_ipv4, ether_ipv6, ether_arp, ether_other;
+    uint64_t proto_tcp, proto_udp, proto_icmp, proto_other;
+    uint32_t queue_depth;
+    uint32_t queue_depth_max;
+    uint64_t latency_count;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+    uint64_t latency_p50_ns;            /* Capped at latency_max_ns, like metrics_percentile_ns() */
+    uint64_t latency_p95_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_histogram[METRICS_HISTOGRAM_BUCKETS];  /* log2 µs buckets */
+    uint64_t epoch;
+    double elapsed_sec;
+    double capture_elapsed_sec;
+} metrics_summary_t;
+
 /* EtherType identifiers for metrics_record_ethertype */
 typedef enum {
     ETHER_IPV4 = 0x0800,
@@ -157,9 +375,24 @@ typedef enum {
  * @brief Initialize the global metrics subsystem
  * 
  * Resets all counters to zero. Must be called before any other metrics function.
+ *
+ * Safe while other threads record: updates made before the epoch
+ * advances are discarded whole, later ones are counted whole. Returns
+ * once no thread is still writing into the retired epoch.
  */
 void metrics_init(void);
 
+/**
+ * @brief Set the significant digits of the HDR latency histogram
+ *
+ * Takes effect at the next metrics_init(); call before any thread
+ * registers a shard.
+ *
+ * @param digits Significant decimal digits (HDR_DIGITS_MIN - HDR_DIGITS_MAX)
+ * @return 0 on success, -1 if digits is out of range
+ */
+int metrics_set_latency_digits(int digits);
+
 /**
  * @brief Mark the start time for metrics collection
  * 
@@ -190,6 +423,40 @@ bool metrics_is_active(void);
  */
 uint64_t metrics_now_ns(void);
 
+
+/**
+ * @brief Give the calling thread its own counter shard
+ *
+ * Recording functions called from a registered thread update its shard
+ * with plain relaxed stores instead of contended global atomics.
+ * Unregistered threads keep using the global atomics.
+ *
+ * @return 0 on success, -1 if no shard is available
+ */
+int metrics_register_thread(void);
+
+/**
+ * @brief Fold the calling thread's shard into the globals and release it
+ *
+ * Call before a registered thread exits.
+ */
+void metrics_unregister_thread(void);
+
+/**
+ * @brief Name the calling thread's shard in the per-thread CPU report
+ *
+ * @param name Short role name, truncated to METRICS_THREAD_NAME_LEN - 1
+ */
+void metrics_set_thread_name(const char *name);
+
+/**
+ * @brief Add worker loop time to the calling thread's busy/idle totals
+ *
+ * @param busy_ticks fastclock ticks spent processing
+ * @param idle_ticks fastclock ticks spent waiting for work
+ */
+void metrics_add_thread_time(uint64_t busy_ticks, uint64_t idle_ticks);
+
 /* ============================================================================
  * Recording Functions (Thread-safe, lock-free)
  * ============================================================================ */
@@ -203,6 +470,65 @@ uint64_t metrics_now_ns(void);
  */
 void metrics_observe_latency(uint64_t latency_ns);
 
+/**
+ * @brief Record the latency of one pipeline stage
+ * 
+ * @param stage Pipeline stage
+ * @param latency_ns Time spent in the stage in nanoseconds
+ */
+void metrics_observe_stage(metrics_stage_t stage, uint64_t latency_ns);
+
+/**
+ * @brief Stage name used in reports and JSON ("capture", "queue", ...)
+ */
+const char* metrics_stage_name(metrics_stage_t stage);
+
+/**
+ * @brief Record latency and bytes of a processed packet by protocol and size
+ * 
+ * @param protocol IP protocol number (0 for non-IP frames)
+ * @param length Frame length in bytes
+ * @param latency_ns End-to-end latency in nanoseconds
+ */
+void metrics_observe_class(uint8_t protocol, uint32_t length, uint64_t latency_ns);
+
+/**
+ * @brief Map an IP protocol number to its class row
+ */
+metrics_l4_t metrics_l4_class(uint8_t protocol);
+
+/**
+ * @brief Map a frame length to its size class (0 .. METRICS_SIZE_CLASS_COUNT - 1)
+ */
+int metrics_size_class(uint32_t length);
+
+/**
+ * @brief Protocol row name used in reports and JSON ("tcp", "udp", "icmp", "other")
+ */
+const char* metrics_l4_name(metrics_l4_t l4);
+
+/**
+ * @brief Size class name used in reports and JSON ("0-64", ..., "1519+")
+ */
+const char* metrics_size_class_name(int size_class);
+
+/**
+ * @brief Whether a packet this slow would be kept as an exemplar
+ *
+ * Lets callers skip filling in a metrics_exemplar_t for the (usual)
+ * packet that is faster than every exemplar the thread already holds.
+ */
+bool metrics_exemplar_wanted(uint64_t latency_ns);
+
+/**
+ * @brief Offer a packet as a tail-latency exemplar
+ *
+ * Kept if it is among the METRICS_EXEMPLARS slowest of the calling
+ * thread's shard (or of the shared set for unregistered threads) since
+ * the last metrics_init(). Snapshots merge all sets.
+ */
+void metrics_observe_exemplar(const metrics_exemplar_t *exemplar);
+
 /**
  * @brief Record protocol type for a processed packet
  * 
@@ -260,6 +586,36 @@ void metrics_inc_capture_drops(void);
  */
 void metrics_update_queue_depth_max(uint32_t current_depth);
 
+/**
+ * @brief Set the current queue depth gauge
+ * 
+ * Also integrates the previous depth over the time it was held, for the
+ * time-weighted mean and time-above-threshold. Callers serialize depth
+ * changes (the pool calls it with its queue lock held).
+ * 
+ * @param current_depth Current queue depth
+ */
+void metrics_set_queue_depth(uint32_t current_depth);
+
+/**
+ * @brief Set the work queue capacity used for occupancy buckets
+ * 
+ * Kept across metrics_init().
+ */
+void metrics_set_queue_capacity(uint32_t capacity);
+
+/**
+ * @brief Record the queue depth an arriving packet finds (queue lock held)
+ * 
+ * @param depth Depth before the packet is added (capacity if it is dropped)
+ */
+void metrics_observe_queue_occupancy(uint32_t depth);
+
+/**
+ * @brief Occupancy bucket label ("0-10", ..., "90-100", "full")
+ */
+const char* metrics_queue_occupancy_name(int bucket);
+
 /* ============================================================================
  * Reporting Functions
  * ============================================================================ */
@@ -267,14 +623,55 @@ void metrics_update_queue_depth_max(uint32_t current_depth);
 /**
  * @brief Take a consistent snapshot of all metrics
  * 
+ * Sums the global counters and every registered thread shard.
+ * 
  * @param snapshot Pointer to snapshot structure to fill
  */
 void metrics_snapshot(metrics_snapshot_t *snapshot);
 
+/**
+ * @brief Take a snapshot copying only the selected histograms
+ * 
+ * Counters, class packet/byte counts and exemplars are always filled;
+ * each histogram group is copied and merged only if its METRICS_SNAP_*
+ * flag is set. metrics_snapshot() is metrics_snapshot_select(METRICS_SNAP_ALL).
+ * 
+ * @param snapshot Pointer to snapshot structure to fill
+ * @param flags METRICS_SNAP_* bits
+ */
+void metrics_snapshot_select(metrics_snapshot_t *snapshot, unsigned int flags);
+
+/**
+ * @brief Release the HDR histogram held by a snapshot
+ *
+ * @param snapshot Snapshot filled by metrics_snapshot() or metrics_snapshot_select()
+ */
+void metrics_snapshot_free(metrics_snapshot_t *snapshot);
+
+/**
+ * @brief Read the counters and latency percentiles without a full snapshot
+ *
+ * Holds the shard lock only for the counter reads and one pass over the
+ * latency histograms; allocates nothing.
+ */
+void metrics_summary(metrics_summary_t *summary);
+
+/**
+ * @brief Copy the counters of each registered thread shard
+ *
+ * Shards not yet touched since the last reset report zeros.
+ *
+ * @param out Destination array
+ * @param max Capacity of out
+ * @return Number of shards copied
+ */
+int metrics_shard_stats(metrics_shard_stats_t *out, int max);
+
 /**
  * @brief Print one-line human-readable metrics summary
  * 
- * Outputs: packets/sec, MB/sec, drops, p50/p95/p99/max latency
+ * Outputs: packets/sec, MB/sec, drops, p50/p95/p99/max latency,
+ * then p50/p95/p99 per pipeline stage
  */
 void metrics_print_human(void);
 
@@ -323,9 +720,21 @@ void metrics_set_metadata(const char *interface, const char *filter,
  */
 const metrics_metadata_t* metrics_get_metadata(void);
 
+/**
+ * @brief Thread CPU nanoseconds per processed packet
+ *
+ * Counts every registered thread (capture and workers) over the window.
+ *
+ * @return CPU ns per packet, or 0 if CPU time or packets are unknown
+ */
+double metrics_cpu_ns_per_packet(const metrics_snapshot_t *snapshot);
+
 /**
  * @brief Calculate percentile latency from histogram
  * 
+ * Uses the HDR histogram when the snapshot has one (relative error below
+ * 10^-digits, capped at latency_max_ns), else the log2 µs buckets.
+ * 
  * @param snapshot Metrics snapshot containing histogram
  * @param percentile Percentile to calculate (0.0 - 1.0)
  * @return Latency value in nanoseconds
@@ -335,7 +744,8 @@ uint64_t metrics_percentile_ns(const metrics_snapshot_t *snapshot, double percen
 /**
  * @brief Get pointer to global metrics structure
  * 
- * For direct atomic access when needed.
+ * For direct atomic access when needed. Points at the buffer of the
+ * current epoch; the next metrics_init() switches to the other one.
  * 
  * @return Pointer to global metrics
  */
@@ -46,10 +46,21 @@ typedef struct {
     uint16_t ethertype;         /* EtherType (0x0800 for IPv4) */
 } ethernet_header_t;
 
+/* Pipeline timestamps kept per packet (fastclock_ticks() units) */
+typedef enum {
+    PACKET_TS_CAPTURE,          /* packet_create() */
+    PACKET_TS_ENQUEUE,          /* Linked into the work queue */
+    PACKET_TS_DEQUEUE,          /* Taken by a worker */
+    PACKET_TS_PARSED,           /* packet_parse() done */
+    PACKET_TS_ANALYZED,         /* Dump and metrics recording done */
+    PACKET_TS_COUNT
+} packet_ts_t;
+
 /* Captured Packet Structure */
 typedef struct {
     time_t timestamp;           /* Packet capture timestamp (wall clock) */
     uint64_t capture_ts_ns;     /* High-resolution capture timestamp (CLOCK_MONOTONIC, ns) */
+    uint64_t ts_ticks[PACKET_TS_COUNT];
     uint32_t packet_length;     /* Total packet length */
     uint8_t *raw_data;          /* Raw packet data */
     
@@ -0,0 +1,71 @@
+/**
+ * @file perfcount.h
+ * @brief Per-thread hardware performance counters (perf_event_open)
+ *
+ * Each thread that registers opens its own set of counters, counting
+ * user-space work of that thread only. A measurement window starts with
+ * perfcount_window_begin(); perfcount_read() sums what all registered
+ * (and since exited) threads counted in the window. Counters that cannot
+ * be opened (not Linux, perf_event_paranoid, no PMU in a VM) are reported
+ * as unavailable and never fail the caller.
+ */
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PERFCOUNT_MAX_THREADS 64
+
+/* Counted events */
+typedef enum {
+    PERFCOUNT_CYCLES,
+    PERFCOUNT_INSTRUCTIONS,
+    PERFCOUNT_CACHE_MISSES,
+    PERFCOUNT_BRANCH_MISSES,
+    PERFCOUNT_CONTEXT_SWITCHES,
+    PERFCOUNT_EVENT_COUNT
+} perfcount_event_t;
+
+/* Window totals over all threads */
+typedef struct {
+    bool available;                         /* Cycles could be counted */
+    bool valid[PERFCOUNT_EVENT_COUNT];      /* Event opened on every counted thread */
+    uint64_t values[PERFCOUNT_EVENT_COUNT]; /* Scaled for multiplexing */
+    int threads;                            /* Threads that contributed */
+} perfcount_totals_t;
+
+/**
+ * @brief Open counters for the calling thread
+ *
+ * @return 0 on success, -1 if counters are unavailable (logged once)
+ */
+int perfcount_register_thread(void);
+
+/**
+ * @brief Keep the calling thread's window counts and close its counters
+ */
+void perfcount_unregister_thread(void);
+
+/**
+ * @brief Start a new measurement window for all registered threads
+ */
+void perfcount_window_begin(void);
+
+/**
+ * @brief Sum counts since perfcount_window_begin()
+ */
+void perfcount_read(perfcount_totals_t *totals);
+
+/**
+ * @brief JSON key of an event ("cycles", "cache_misses", ...)
+ */
+const char* perfcount_event_name(perfcount_event_t event);
+
+/**
+ * @brief Why counters are unavailable, or NULL if they are not known to be
+ */
+const char* perfcount_unavailable_reason(void);
+
+#endif /* PERFCOUNT_H */
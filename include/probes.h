@@ -0,0 +1,48 @@
+/**
+ * @file probes.h
+ * @brief USDT static tracepoints for bpftrace / perf
+ *
+ * With <sys/sdt.h> available (systemtap-sdt-dev on Debian/Ubuntu,
+ * systemtap-sdt-devel on Fedora) each probe is a single nop plus an ELF
+ * note; nothing runs until a tracer attaches. Without the header, or when
+ * built with PACKET_ANALYZER_NO_USDT (make USDT=0), probes compile to
+ * nothing and their arguments are never evaluated.
+ *
+ * Provider "packet_analyzer":
+ *   receive(len)                 packet read from the capture socket (capture thread)
+ *   enqueue(packet, len, depth)  packet queued to the workers, depth after insert
+ *   dequeue(packet, len, depth)  worker took the packet, depth after removal
+ *   parsed(packet, len, proto)   packet_parse() done, proto = IPv4 protocol or 0
+ *   analyzed(packet, len)        worker finished with the packet (freed next)
+ *   drop(reason, len)            packet discarded, reason is a string
+ *
+ * The packet pointer is valid from enqueue to analyzed; tools/bpftrace/
+ * uses it as the key to rebuild per-stage latency.
+ */
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#if !defined(PACKET_ANALYZER_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROBES_ENABLED 1
+#endif
+#endif
+
+/* Drop reasons passed as the first drop() argument */
+#define PROBE_DROP_QUEUE_FULL "queue_full"
+#define PROBE_DROP_MEMBUDGET  "membudget"
+
+#ifdef PROBES_ENABLED
+#define PROBE1(name, a1)             DTRACE_PROBE1(packet_analyzer, name, a1)
+#define PROBE2(name, a1, a2)         DTRACE_PROBE2(packet_analyzer, name, a1, a2)
+#define PROBE3(name, a1, a2, a3)     DTRACE_PROBE3(packet_analyzer, name, a1, a2, a3)
+#else
+/* Same if (0) trick as the LOGGER_* macros: arguments stay type-checked */
+#define PROBE1(name, a1)             do { if (0) { (void)(a1); } } while (0)
+#define PROBE2(name, a1, a2)         do { if (0) { (void)(a1); (void)(a2); } } while (0)
+#define PROBE3(name, a1, a2, a3)     do { if (0) { (void)(a1); (void)(a2); (void)(a3); } } while (0)
+#endif
+
+#endif /* PROBES_H */
@@ -0,0 +1,110 @@
+/**
+ * @file profiler.h
+ * @brief In-process sampling profiler writing folded stacks
+ *
+ * Each registered thread gets its own timer_create() timer on its
+ * thread CPU-time clock, delivering SIGPROF to that thread only. The
+ * handler walks the interrupted stack's frame pointers (the build uses
+ * -fno-omit-frame-pointer) and counts it in a per-thread table allocated
+ * at registration, so sampling never allocates, locks or calls into libc.
+ * Idle threads burn no CPU time and take no samples.
+ *
+ * profiler_stop() symbolizes the stacks (the executable's own symbol
+ * table, dladdr() for shared libraries) and writes one line per unique
+ * stack in the folded format read by flamegraph.pl, inferno and
+ * speedscope: "role;outer;...;leaf count". The first frame is the thread
+ * role, so one file holds a capture, a worker and a logger tree.
+ *
+ * Timer expiry is checked on the scheduler tick, so rates above CONFIG_HZ
+ * are capped by it. Linux only; elsewhere profiler_start() fails and the
+ * run continues.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PROFILER_HZ_DEFAULT 99          /* Off the 100 Hz tick to avoid lockstep */
+#define PROFILER_HZ_MAX 10000
+#define PROFILER_MAX_THREADS 32         /* Slots are never reused */
+#define PROFILER_MAX_DEPTH 48           /* Frames kept per sample, leaf first */
+#define PROFILER_MAX_STACKS 1024        /* Unique stacks per thread (power of two) */
+#define PROFILER_PATH_LEN 256
+
+/* Thread roles, written as the root frame of each stack */
+typedef enum {
+    PROFILER_ROLE_CAPTURE,
+    PROFILER_ROLE_WORKER,
+    PROFILER_ROLE_LOGGER,
+    PROFILER_ROLE_COUNT
+} profiler_role_t;
+
+/**
+ * @brief Profile totals, for the metrics JSON
+ */
+typedef struct {
+    bool enabled;                       /* profiler_start() succeeded */
+    bool written;                       /* profiler_stop() wrote the file */
+    char path[PROFILER_PATH_LEN];
+    int hz;
+    int threads;                        /* Threads that registered */
+    uint64_t samples[PROFILER_ROLE_COUNT];
+    uint64_t stacks;                    /* Unique stacks written */
+    uint64_t dropped;                   /* Samples lost to a full stack table */
+} profiler_summary_t;
+
+/**
+ * @brief Allocate the sample tables and install the SIGPROF handler
+ *
+ * Call before the threads to profile start; threads then opt in with
+ * profiler_register_thread().
+ *
+ * @param path Folded stack output file
+ * @param hz Samples per second of thread CPU time (1 - PROFILER_HZ_MAX)
+ * @return 0 on success, -1 on error (logged)
+ */
+int profiler_start(const char *path, int hz);
+
+/**
+ * @brief Start sampling the calling thread
+ *
+ * No-op returning -1 when the profiler is not running or all slots are taken.
+ */
+int profiler_register_thread(profiler_role_t role);
+
+/**
+ * @brief Stop sampling the calling thread; its samples are kept
+ */
+void profiler_unregister_thread(void);
+
+/**
+ * @brief Stop all timers and write the folded stacks
+ *
+ * @return 0 on success or if not running, -1 if the file could not be written
+ */
+int profiler_stop(void);
+
+/**
+ * @brief Restore SIGPROF and free the sample tables
+ */
+void profiler_cleanup(void);
+
+/**
+ * @brief Get the profile totals (zeroed if the profiler never started)
+ */
+void profiler_get_summary(profiler_summary_t *summary);
+
+/**
+ * @brief Write the "profile" member of the metrics JSON (no trailing comma)
+ */
+void profiler_write_json(FILE *fp);
+
+/**
+ * @brief Name of a role as written in the folded stacks
+ */
+const char* profiler_role_name(profiler_role_t role);
+
+#endif /* PROFILER_H */
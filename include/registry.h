@@ -0,0 +1,243 @@
+/**
+ * @file registry.h
+ * @brief Registry of named counters, gauges and histograms
+ *
+ * Modules describe a metric once at startup (name, type, help, one
+ * optional label with a fixed set of values) and get back an id. Every
+ * series of every metric owns a range of slots in one contiguous array;
+ * each registered thread has its own cache-aligned copy of the array, so
+ * recording is the same relaxed load + store into a thread shard as the
+ * built-in metrics. Snapshots, JSON and OpenMetrics output are generic
+ * over the descriptors, so adding a metric needs no reporting code.
+ *
+ * Counters and histograms are sharded per thread and reset by
+ * registry_reset(); gauges hold one shared current value.
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Capacity: metrics, slots per shard, label values per metric, thread shards */
+#define REGISTRY_MAX_METRICS 32
+#define REGISTRY_MAX_SLOTS 512
+#define REGISTRY_MAX_LABEL_VALUES 16
+#define REGISTRY_MAX_THREADS 64
+#define REGISTRY_CACHE_LINE 64
+
+/* Histogram bucket k counts values in [2^(k-1), 2^k), bucket 0 counts 0,
+ * the last bucket everything above; count and sum follow the buckets */
+#define REGISTRY_HISTOGRAM_BUCKETS 40
+
+/* Metric types */
+typedef enum {
+    REGISTRY_COUNTER,           /* Monotonic, summed over threads */
+    REGISTRY_GAUGE,             /* Current value, last write wins */
+    REGISTRY_HISTOGRAM          /* log2 buckets plus count and sum */
+} registry_type_t;
+
+/**
+ * @brief Metric descriptor (strings must outlive the registry)
+ */
+typedef struct {
+    const char *name;           /* JSON key, e.g. "protocols" */
+    const char *family;         /* OpenMetrics family without prefix (NULL = name) */
+    const char *help;           /* OpenMetrics HELP text */
+    const char *unit;           /* OpenMetrics UNIT, or NULL */
+    registry_type_t type;
+    const char *label;          /* Label name, or NULL for a single series */
+    const char *const *label_values;  /* label_count values, one series each */
+    int label_count;            /* 0 - REGISTRY_MAX_LABEL_VALUES */
+    bool json_owned;            /* Left out of registry_write_json(); the owner writes it */
+} registry_desc_t;
+
+/**
+ * @brief Per-thread copy of all slots; only the owning thread writes it
+ */
+typedef struct {
+    _Alignas(REGISTRY_CACHE_LINE) _Atomic uint64_t generation;  /* Reset epoch of the slots */
+    _Atomic uint64_t slots[REGISTRY_MAX_SLOTS];
+} registry_shard_t;
+
+/* Recording fast path state, owned by registry.c */
+extern _Thread_local registry_shard_t *registry_tls_shard;
+extern _Atomic uint64_t registry_generation;
+extern _Atomic uint64_t registry_shared[REGISTRY_MAX_SLOTS];
+
+/**
+ * @brief Values of all registered metrics at one point in time
+ *
+ * Index with registry_value() / registry_bucket().
+ */
+typedef struct {
+    int metric_count;
+    uint64_t slots[REGISTRY_MAX_SLOTS];
+} registry_snapshot_t;
+
+/**
+ * @brief Register a metric
+ *
+ * Registering a name again returns the existing id, so modules can
+ * register from an init function that runs more than once.
+ *
+ * @return Metric id (>= 0), or -1 if the descriptor is invalid or the
+ *         registry is full
+ */
+int registry_register(const registry_desc_t *desc);
+
+/**
+ * @brief Look up a metric id by name
+ *
+ * @return Metric id, or -1 if not registered
+ */
+int registry_find(const char *name);
+
+/**
+ * @brief Get the descriptor of a registered metric, or NULL
+ */
+const registry_desc_t* registry_describe(int id);
+
+/**
+ * @brief Give the calling thread its own slot shard
+ *
+ * @return 0 on success, -1 if no shard is available (the thread then
+ *         records into the shared slots)
+ */
+int registry_register_thread(void);
+
+/**
+ * @brief Fold the calling thread's shard into the shared slots and free it
+ */
+void registry_unregister_thread(void);
+
+/**
+ * @brief Zero all counters, histograms and gauges
+ *
+ * Thread shards are cleared lazily by their owners on their next update.
+ */
+void registry_reset(void);
+
+/**
+ * @brief Resolve the slot of a counter series once, outside the hot path
+ *
+ * For a histogram series this is the first bucket, for registry_observe_slot().
+ *
+ * @return Slot for registry_add_slot(), or -1 if id or series is out of range
+ */
+int registry_counter_slot(int id, int series);
+
+/**
+ * @brief Clear the calling thread's shard after a reset (registry_add_slot() slow path)
+ */
+void registry_shard_refresh(registry_shard_t *shard);
+
+/**
+ * @brief Add to a resolved counter slot
+ *
+ * Same cost as a built-in sharded counter: an epoch check and a relaxed
+ * load + store into the caller's shard. Threads without a shard fall
+ * back to an atomic add; slot -1 is ignored.
+ */
+static inline void registry_add_slot(int slot, uint64_t n) {
+    if (slot < 0) return;
+    registry_shard_t *shard = registry_tls_shard;
+    if (shard != NULL) {
+        if (atomic_load_explicit(&shard->generation, memory_order_relaxed) !=
+            atomic_load_explicit(&registry_generation, memory_order_relaxed)) {
+            registry_shard_refresh(shard);
+        }
+        _Atomic uint64_t *counter = &shard->slots[slot];
+        atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+                              memory_order_relaxed);
+    } else {
+        atomic_fetch_add(&registry_shared[slot], n);
+    }
+}
+
+/**
+ * @brief Record one value in a resolved histogram series
+ *
+ * Three registry_add_slot() calls: the log2 bucket, the count and the sum.
+ */
+static inline void registry_observe_slot(int slot, uint64_t value) {
+    if (slot < 0) return;
+    int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    if (bucket > REGISTRY_HISTOGRAM_BUCKETS - 1) {
+        bucket = REGISTRY_HISTOGRAM_BUCKETS - 1;
+    }
+    registry_add_slot(slot + bucket, 1);
+    registry_add_slot(slot + REGISTRY_HISTOGRAM_BUCKETS, 1);
+    registry_add_slot(slot + REGISTRY_HISTOGRAM_BUCKETS + 1, value);
+}
+
+/**
+ * @brief Add to a counter series
+ *
+ * Looks the slot up on every call; resolve it once with
+ * registry_counter_slot() for per-packet counters.
+ *
+ * @param id Metric id from registry_register()
+ * @param series Label value index (0 for unlabeled metrics); out of range is ignored
+ * @param n Amount to add
+ */
+void registry_add(int id, int series, uint64_t n);
+
+/**
+ * @brief Set a gauge series
+ */
+void registry_set(int id, int series, uint64_t value);
+
+/**
+ * @brief Record one value in a histogram series
+ */
+void registry_observe(int id, int series, uint64_t value);
+
+/**
+ * @brief Sum the shared slots and every current thread shard
+ */
+void registry_snapshot(registry_snapshot_t *snapshot);
+
+/**
+ * @brief Counter or gauge value of a series (histograms: observation count)
+ */
+uint64_t registry_value(const registry_snapshot_t *snapshot, int id, int series);
+
+/**
+ * @brief Histogram bucket count of a series
+ */
+uint64_t registry_bucket(const registry_snapshot_t *snapshot, int id, int series, int bucket);
+
+/**
+ * @brief Histogram sum of a series
+ */
+uint64_t registry_sum(const registry_snapshot_t *snapshot, int id, int series);
+
+/**
+ * @brief Upper bound of the log2 bucket holding quantile q of a histogram series
+ *
+ * @return 0 if the series is empty or not a histogram
+ */
+uint64_t registry_quantile(const registry_snapshot_t *snapshot, int id, int series, double q);
+
+/**
+ * @brief Write each metric as a top-level JSON member
+ *
+ * Unlabeled counters and gauges are written as a number, labeled ones as
+ * an object keyed by label value; histograms as {"count", "sum",
+ * "buckets"}. Every member ends with ",\n" so the caller closes the object.
+ * Metrics marked json_owned are skipped.
+ */
+void registry_write_json(FILE *fp, const registry_snapshot_t *snapshot);
+
+/**
+ * @brief Write every metric in OpenMetrics text format
+ *
+ * @param prefix Prepended to each family name (e.g. "packet_analyzer_")
+ */
+void registry_write_openmetrics(FILE *fp, const registry_snapshot_t *snapshot, const char *prefix);
+
+#endif /* REGISTRY_H */
@@ -16,6 +16,12 @@
 /* Default regression threshold (10%) */
 #define REGRESSION_THRESHOLD_DEFAULT 0.10
 
+/* Fewest packets a protocol x size class cell needs on both sides to be compared */
+#define REGRESSION_CLASS_MIN_PACKETS 1000
+
+/* p95 increase that flags a protocol x size class cell (informational, 25%) */
+#define REGRESSION_CLASS_THRESHOLD_DEFAULT 0.25
+
 /* Exit code for regression detection */
 #define EXIT_REGRESSION 2
 
@@ -29,6 +35,18 @@ typedef struct {
     double pkts_processed_per_sec;  /* Packets per second throughput */
     double mbps_processed;          /* Megabytes per second throughput */
     uint64_t latency_p95_ns;        /* 95th percentile latency in nanoseconds */
+    bool latency_hdr_valid;         /* p95 came from an HDR histogram (latency_hdr) */
+    uint64_t stage_p95_ns[METRICS_STAGE_COUNT];  /* Per-stage p95 (latency_stages_ns) */
+    bool stages_valid;              /* Baseline has per-stage latency */
+    uint64_t class_p95_ns[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];   /* latency_by_class */
+    uint64_t class_packets[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];  /* 0 = cell absent */
+    bool classes_valid;             /* Baseline has latency_by_class */
+    double cycles_per_packet;       /* CPU cycles per processed packet (perf) */
+    bool perf_valid;                /* Baseline was run with hardware counters */
+    double cpu_ns_per_packet;       /* Thread CPU ns per processed packet ("cpu") */
+    bool cpu_valid;                 /* Baseline has thread CPU time */
+    uint64_t peak_rss_bytes;        /* Peak RSS of the run ("memory"), 0 if unavailable */
+    double bytes_per_queued_packet; /* Packet + queue item bytes per queued packet */
     double drop_rate;               /* Drop rate (0.0 - 1.0) */
     
     /* Additional baseline data for reporting */
@@ -66,6 +84,51 @@ typedef struct {
     double latency_delta_pct;       /* Positive = regression */
     bool latency_regression;
     
+    /* Per-stage latency p95 (informational, not part of any_regression) */
+    bool stages_valid;
+    uint64_t baseline_stage_p95_ns[METRICS_STAGE_COUNT];
+    uint64_t current_stage_p95_ns[METRICS_STAGE_COUNT];
+    double stage_delta_pct[METRICS_STAGE_COUNT];
+    
+    /* Latency p95 per protocol x size class; a cell is compared only when
+     * both runs have REGRESSION_CLASS_MIN_PACKETS packets in it. Small
+     * cells are noisy, so flagged cells are reported but do not count
+     * towards any_regression */
+    bool classes_valid;
+    bool class_compared[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    uint64_t baseline_class_p95_ns[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    uint64_t current_class_p95_ns[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    double class_delta_pct[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];  /* Positive = regression */
+    bool class_regression[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];  /* Above class_threshold */
+    bool any_class_regression;
+    double class_threshold;
+    
+    /* Cycles per packet (only when both runs had hardware counters) */
+    bool perf_valid;
+    double baseline_cpp;
+    double current_cpp;
+    double cpp_delta_pct;           /* Positive = regression */
+    bool cpp_regression;
+    
+    /* Thread CPU time per packet (only when both runs had it) */
+    bool cpu_valid;
+    double baseline_cpu_ns_per_packet;
+    double current_cpu_ns_per_packet;
+    double cpu_delta_pct;           /* Positive = regression */
+    bool cpu_regression;
+    
+    /* Memory footprint (each only when both runs have it) */
+    bool rss_valid;
+    uint64_t baseline_peak_rss_bytes;
+    uint64_t current_peak_rss_bytes;
+    double rss_delta_pct;           /* Positive = regression */
+    bool rss_regression;
+    bool queued_bytes_valid;
+    double baseline_bytes_per_queued_packet;
+    double current_bytes_per_queued_packet;
+    double queued_bytes_delta_pct;  /* Positive = regression */
+    bool queued_bytes_regression;
+    
     /* Drop rate comparison */
     double baseline_drop_rate;
     double current_drop_rate;
@@ -94,6 +157,8 @@ int regression_load_baseline(const char *filepath, regression_baseline_t *baseli
  * 
  * Performs regression detection by comparing current run metrics
  * against the loaded baseline using the specified threshold.
+ * Current p95 latency comes from the HDR histogram when the baseline
+ * has one, otherwise from the log2 buckets older baselines were built on.
  * 
  * @param baseline Loaded baseline metrics
  * @param current Current metrics snapshot
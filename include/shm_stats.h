@@ -0,0 +1,119 @@
+/**
+ * @file shm_stats.h
+ * @brief Shared-memory metrics segment for external readers
+ *
+ * A publisher thread copies a metrics snapshot into a POSIX shared-memory
+ * segment (/dev/shm/packet_analyzer.<pid> on Linux) every interval. The
+ * copy is guarded by a seqlock: the sequence is odd while the publisher
+ * writes, and readers retry until they see the same even value before
+ * and after copying. Readers map the segment read-only, so polling it
+ * costs the analyzer nothing and needs no syscalls after the attach.
+ */
+
+#ifndef SHM_STATS_H
+#define SHM_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "metrics.h"
+
+/* Segment identification; bump the version on any layout change */
+#define SHM_STATS_MAGIC 0x534D4150u     /* "PAMS" */
+#define SHM_STATS_VERSION 1
+#define SHM_STATS_NAME_FMT "/packet_analyzer.%d"
+
+/* Defaults */
+#define SHM_STATS_INTERVAL_MS_DEFAULT 100
+#define SHM_STATS_READ_RETRIES 1000
+
+/* Published metrics; plain data, no pointers */
+typedef struct {
+    uint64_t pkts_captured;
+    uint64_t pkts_processed;
+    uint64_t bytes_captured;
+    uint64_t bytes_processed;
+    uint64_t parse_errors;
+    uint64_t checksum_failures;
+    uint64_t queue_drops;
+    uint64_t capture_drops;
+    uint64_t ether_ipv4, ether_ipv6, ether_arp, ether_other;
+    uint64_t proto_tcp, proto_udp, proto_icmp, proto_other;
+    uint32_t queue_depth;
+    uint32_t queue_depth_max;
+    uint64_t latency_count;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+    uint64_t latency_p50_ns;
+    uint64_t latency_p95_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_histogram[METRICS_HISTOGRAM_BUCKETS];
+    double elapsed_sec;
+    double capture_elapsed_sec;
+    uint32_t active;                    /* 1 while a measurement runs */
+    uint32_t shard_count;
+    metrics_shard_stats_t shards[METRICS_MAX_SHARDS];
+} shm_stats_t;
+
+/* Segment layout */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                      /* sizeof(shm_stats_segment_t) */
+    int32_t pid;
+    _Atomic uint64_t seq;               /* Odd while an update is in progress */
+    uint64_t publish_count;
+    uint64_t publish_time_ns;           /* CLOCK_MONOTONIC of the last update */
+    shm_stats_t stats;
+} shm_stats_segment_t;
+
+/* Read-only mapping of another process's segment */
+typedef struct {
+    const shm_stats_segment_t *segment;
+    pid_t pid;
+} shm_stats_reader_t;
+
+/**
+ * @brief Create the segment and start the publisher thread
+ *
+ * @param interval_ms Publish period (0 = SHM_STATS_INTERVAL_MS_DEFAULT)
+ * @return 0 on success, -1 on error
+ */
+int shm_stats_start(uint32_t interval_ms);
+
+/**
+ * @brief Stop the publisher and unlink the segment
+ */
+void shm_stats_stop(void);
+
+/**
+ * @brief Map the segment of a running analyzer
+ *
+ * @return 0 on success, -1 if it is missing or has another layout version
+ */
+int shm_stats_attach(pid_t pid, shm_stats_reader_t *reader);
+
+/**
+ * @brief Copy a consistent view of the published stats
+ *
+ * @param publish_count Optional; receives the update counter
+ * @return 0 on success, -1 if no consistent copy was seen within
+ *         SHM_STATS_READ_RETRIES attempts
+ */
+int shm_stats_read(const shm_stats_reader_t *reader, shm_stats_t *out, uint64_t *publish_count);
+
+/**
+ * @brief Unmap a segment mapped by shm_stats_attach()
+ */
+void shm_stats_detach(shm_stats_reader_t *reader);
+
+/**
+ * @brief Print published stats every interval until the process exits
+ *
+ * @param running Loop condition, cleared by the caller's signal handler
+ * @return 0 when the process exited or *running was cleared, -1 on attach failure
+ */
+int shm_stats_view(pid_t pid, uint32_t interval_ms, volatile int *running);
+
+#endif /* SHM_STATS_H */
@@ -3,6 +3,7 @@
 
 #include <pthread.h>
 #include "packet.h"
+#include "lockstat.h"
 
 /* Work Queue Item */
 typedef struct work_item {
@@ -22,12 +23,13 @@ typedef struct {
     int max_queue_size;
     
     /* Synchronization */
-    pthread_mutex_t queue_lock;
+    lockstat_mutex_t queue_lock;    /* Site LOCKSTAT_QUEUE */
     pthread_cond_t queue_cond;
     
     /* Control */
     int is_running;
     int packets_processed;
+    int workers_started;    /* Next worker index, taken under queue_lock */
 } thread_pool_t;
 
 /* Function Declarations */
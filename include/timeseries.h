@@ -0,0 +1,86 @@
+/**
+ * @file timeseries.h
+ * @brief Per-interval metrics time series
+ *
+ * A sampler thread takes a metrics snapshot every interval and stores the
+ * difference to the previous one (rates, drops, latency percentiles of
+ * the interval only, queue depth and occupancy) in a fixed-size ring. A writer thread
+ * streams new samples to a JSON-lines or CSV file, so neither the capture
+ * loop nor the workers ever wait on file I/O.
+ */
+
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "metrics.h"
+
+/* Defaults */
+#define TIMESERIES_INTERVAL_MS_DEFAULT 1000
+#define TIMESERIES_CAPACITY_DEFAULT 3600
+
+/* Output formats */
+typedef enum {
+    TIMESERIES_JSONL,           /* One JSON object per line */
+    TIMESERIES_CSV              /* Header line, then one row per sample */
+} timeseries_format_t;
+
+/* Time series configuration */
+typedef struct {
+    const char *path;           /* Output file (NULL = keep the ring only) */
+    timeseries_format_t format;
+    uint32_t interval_ms;       /* Sample resolution (0 = TIMESERIES_INTERVAL_MS_DEFAULT) */
+    uint32_t capacity;          /* Ring slots (0 = TIMESERIES_CAPACITY_DEFAULT) */
+} timeseries_config_t;
+
+/* One interval; counts and percentiles cover that interval only */
+typedef struct {
+    double t_sec;               /* Measurement time at the end of the interval */
+    double interval_sec;        /* Actual interval length */
+    uint64_t pkts;              /* Packets processed */
+    uint64_t bytes;             /* Bytes processed */
+    double pps;
+    double mbps;                /* MB/s processed */
+    uint64_t drops;             /* Queue + capture drops */
+    uint64_t latency_p50_ns;
+    uint64_t latency_p95_ns;
+    uint64_t latency_p99_ns;
+    uint32_t queue_depth;       /* Work queue depth at the end of the interval */
+    double queue_depth_mean;    /* Time-weighted mean depth over the interval */
+    double queue_high_pct;      /* Share of the interval at or above METRICS_QUEUE_HIGH_PCT */
+    uint64_t queue_occupancy[METRICS_QUEUE_OCC_BUCKETS];  /* Arrivals by fill level found */
+} timeseries_sample_t;
+
+/**
+ * @brief Start the sampler (and writer, if a path is given) threads
+ *
+ * Samples are taken only while metrics collection is active; a metrics
+ * reset (new run, end of warmup) starts the deltas from zero again.
+ *
+ * @return 0 on success, -1 on error
+ */
+int timeseries_start(const timeseries_config_t *config);
+
+/**
+ * @brief Stop the threads, write any pending samples and close the file
+ */
+void timeseries_stop(void);
+
+/**
+ * @brief Copy the most recent samples, oldest first
+ *
+ * @param out Destination array
+ * @param max Capacity of out
+ * @return Number of samples copied
+ */
+size_t timeseries_get_samples(timeseries_sample_t *out, size_t max);
+
+/**
+ * @brief Parse a format name (jsonl, csv)
+ *
+ * @return 0 on success, -1 if the name is unknown
+ */
+int timeseries_parse_format(const char *name, timeseries_format_t *format);
+
+#endif /* TIMESERIES_H */
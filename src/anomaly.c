@@ -0,0 +1,273 @@
+/**
+ * @file anomaly.c
+ * @brief Rolling-baseline anomaly detection implementation
+ *
+ * All state is a fixed array of per-metric structs updated by the time
+ * series sampler thread under g_anomaly_lock; readers (metrics JSON,
+ * tests) copy it under the same lock.
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "anomaly.h"
+#include "registry.h"
+#include "logger.h"
+
+static inline double dmax(double a, double b) { return a > b ? a : b; }
+static inline double dabs(double a) { return a < 0 ? -a : a; }
+
+/* Mean absolute deviation to standard deviation for normal noise (sqrt(pi / 2)) */
+#define ANOMALY_MAD_TO_SIGMA 1.2533
+
+/**
+ * @brief Fixed properties of a monitored metric
+ *
+ * The band never gets narrower than min_rel x baseline or min_abs, so a
+ * very steady metric does not alert on noise it has simply not seen yet.
+ */
+typedef struct {
+    int direction;              /* +1: alert when high, -1: alert when low */
+    double min_rel;
+    double min_abs;
+} anomaly_metric_desc_t;
+
+static const char *g_metric_names[ANOMALY_METRIC_COUNT] = {
+    "pps", "drop_rate", "latency_p50", "latency_p95", "latency_p99"
+};
+
+static const anomaly_metric_desc_t g_metric_desc[ANOMALY_METRIC_COUNT] = {
+    { -1, 0.05, 1.0 },          /* pps */
+    { +1, 0.0, 0.001 },         /* drop rate: 0.1 percentage points */
+    { +1, 0.10, 1000.0 },       /* latency percentiles (ns) */
+    { +1, 0.10, 1000.0 },
+    { +1, 0.10, 1000.0 },
+};
+
+_Static_assert(ANOMALY_METRIC_COUNT == 5, "extend g_metric_names and g_metric_desc");
+
+typedef struct {
+    anomaly_status_t status;
+    uint32_t calm;              /* Consecutive normal intervals while active */
+} anomaly_state_t;
+
+static pthread_mutex_t g_anomaly_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool g_enabled = false;
+static anomaly_config_t g_config;
+static double g_alpha;
+static anomaly_state_t g_state[ANOMALY_METRIC_COUNT];
+
+/* Registered by the first anomaly_configure(), then fixed (g_anomaly_lock) */
+static int g_alerts_metric = -1;
+static int g_active_metric = -1;
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+/**
+ * @brief Register the alert metrics (g_anomaly_lock held)
+ */
+static void register_metrics(void) {
+    static const registry_desc_t alerts = {
+        .name = "anomaly_alerts", .help = "Alerts raised by the rolling-baseline detector, by metric.",
+        .type = REGISTRY_COUNTER,
+        .label = "metric", .label_values = g_metric_names, .label_count = ANOMALY_METRIC_COUNT
+    };
+    static const registry_desc_t active = {
+        .name = "anomaly_active", .help = "1 while an anomaly alert is active, by metric.",
+        .type = REGISTRY_GAUGE,
+        .label = "metric", .label_values = g_metric_names, .label_count = ANOMALY_METRIC_COUNT
+    };
+    g_alerts_metric = registry_register(&alerts);
+    g_active_metric = registry_register(&active);
+}
+
+int anomaly_configure(const anomaly_config_t *config) {
+    anomaly_config_t c = { 0 };
+    if (config != NULL) c = *config;
+    if (c.window == 0) c.window = ANOMALY_WINDOW_DEFAULT;
+    if (c.threshold == 0.0) c.threshold = ANOMALY_THRESHOLD_DEFAULT;
+    if (c.persist == 0) c.persist = ANOMALY_PERSIST_DEFAULT;
+    if (c.warmup == 0) c.warmup = ANOMALY_WARMUP_DEFAULT;
+    if (c.window < 2 || !(c.threshold > 0.0)) {
+        logger_error("Invalid anomaly settings: window %u (>= 2), threshold %.2f (> 0)",
+                     c.window, c.threshold);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_anomaly_lock);
+    if (g_alerts_metric < 0 || g_active_metric < 0) {
+        register_metrics();
+    }
+    g_config = c;
+    g_alpha = 2.0 / (c.window + 1.0);
+    memset(g_state, 0, sizeof(g_state));
+    g_enabled = true;
+    pthread_mutex_unlock(&g_anomaly_lock);
+
+    logger_info("Anomaly detection: %u-interval baseline, %.1f-sigma band, %u intervals to alert, "
+                "%u warmup", c.window, c.threshold, c.persist, c.warmup);
+    return 0;
+}
+
+void anomaly_disable(void) {
+    pthread_mutex_lock(&g_anomaly_lock);
+    g_enabled = false;
+    memset(g_state, 0, sizeof(g_state));
+    pthread_mutex_unlock(&g_anomaly_lock);
+}
+
+bool anomaly_enabled(void) {
+    pthread_mutex_lock(&g_anomaly_lock);
+    bool enabled = g_enabled;
+    pthread_mutex_unlock(&g_anomaly_lock);
+    return enabled;
+}
+
+void anomaly_reset(void) {
+    pthread_mutex_lock(&g_anomaly_lock);
+    memset(g_state, 0, sizeof(g_state));
+    pthread_mutex_unlock(&g_anomaly_lock);
+}
+
+/* ============================================================================
+ * Detection
+ * ============================================================================ */
+
+/**
+ * @brief Test one value against its baseline, then fold it in (g_anomaly_lock held)
+ *
+ * @return true if this value raised an alert
+ */
+static bool observe_metric(anomaly_metric_t metric, double value) {
+    anomaly_state_t *state = &g_state[metric];
+    anomaly_status_t *s = &state->status;
+    const anomaly_metric_desc_t *desc = &g_metric_desc[metric];
+    bool raised = false;
+
+    s->last = value;
+    if (s->observed == 0) {
+        s->baseline = value;
+        s->mad = 0.0;
+        s->observed = 1;
+        return false;
+    }
+
+    double band = g_config.threshold * ANOMALY_MAD_TO_SIGMA * s->mad;
+    s->band = dmax(band, dmax(desc->min_rel * dabs(s->baseline), desc->min_abs));
+
+    double deviation = value - s->baseline;
+    if (s->observed >= g_config.warmup) {
+        if (deviation * desc->direction > s->band) {
+            s->streak++;
+            state->calm = 0;
+            if (s->streak >= g_config.persist && !s->active) {
+                s->active = true;
+                s->alerts++;
+                raised = true;
+                registry_add(g_alerts_metric, metric, 1);
+                registry_set(g_active_metric, metric, 1);
+                logger_warn("Anomaly: %s %.4g vs baseline %.4g (band %.4g) for %u intervals",
+                            g_metric_names[metric], value, s->baseline, s->band, s->streak);
+            }
+        } else {
+            s->streak = 0;
+            if (s->active && ++state->calm >= g_config.persist) {
+                s->active = false;
+                state->calm = 0;
+                registry_set(g_active_metric, metric, 0);
+                logger_info("Anomaly cleared: %s %.4g, baseline %.4g",
+                            g_metric_names[metric], value, s->baseline);
+            }
+        }
+
+        /* Clamp to the band so outliers barely move the baseline */
+        if (deviation > s->band) deviation = s->band;
+        if (deviation < -s->band) deviation = -s->band;
+    }
+
+    /* Plain running means until the window has filled, then the EWMA */
+    s->observed++;
+    double alpha = dmax(g_alpha, 1.0 / (double)s->observed);
+    s->baseline += alpha * deviation;
+    s->mad += alpha * (dabs(deviation) - s->mad);
+    return raised;
+}
+
+int anomaly_observe(const timeseries_sample_t *sample) {
+    if (sample == NULL || !(sample->interval_sec > 0)) return 0;
+
+    pthread_mutex_lock(&g_anomaly_lock);
+    if (!g_enabled) {
+        pthread_mutex_unlock(&g_anomaly_lock);
+        return 0;
+    }
+
+    int raised = observe_metric(ANOMALY_PPS, sample->pps);
+    uint64_t offered = sample->pkts + sample->drops;
+    if (offered > 0) {
+        raised += observe_metric(ANOMALY_DROP_RATE, (double)sample->drops / (double)offered);
+    }
+    if (sample->pkts > 0) {
+        raised += observe_metric(ANOMALY_P50, (double)sample->latency_p50_ns);
+        raised += observe_metric(ANOMALY_P95, (double)sample->latency_p95_ns);
+        raised += observe_metric(ANOMALY_P99, (double)sample->latency_p99_ns);
+    }
+    pthread_mutex_unlock(&g_anomaly_lock);
+    return raised;
+}
+
+/* ============================================================================
+ * Reporting
+ * ============================================================================ */
+
+void anomaly_get_status(anomaly_status_t *out) {
+    if (out == NULL) return;
+
+    pthread_mutex_lock(&g_anomaly_lock);
+    for (int m = 0; m < ANOMALY_METRIC_COUNT; m++) {
+        out[m] = g_state[m].status;
+    }
+    pthread_mutex_unlock(&g_anomaly_lock);
+}
+
+const char* anomaly_metric_name(anomaly_metric_t metric) {
+    if (metric < 0 || metric >= ANOMALY_METRIC_COUNT) return "unknown";
+    return g_metric_names[metric];
+}
+
+void anomaly_write_json(FILE *fp) {
+    if (fp == NULL) return;
+
+    pthread_mutex_lock(&g_anomaly_lock);
+    bool enabled = g_enabled;
+    anomaly_config_t config = g_config;
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    for (int m = 0; m < ANOMALY_METRIC_COUNT; m++) {
+        status[m] = g_state[m].status;
+    }
+    pthread_mutex_unlock(&g_anomaly_lock);
+
+    fprintf(fp, "  \"anomaly\": {\n");
+    if (!enabled) {
+        fprintf(fp, "    \"enabled\": false\n");
+        fprintf(fp, "  }");
+        return;
+    }
+    fprintf(fp, "    \"enabled\": true,\n");
+    fprintf(fp, "    \"window\": %u,\n", config.window);
+    fprintf(fp, "    \"threshold\": %.2f,\n", config.threshold);
+    fprintf(fp, "    \"persist\": %u,\n", config.persist);
+    fprintf(fp, "    \"warmup\": %u,\n", config.warmup);
+    fprintf(fp, "    \"metrics\": {");
+    for (int m = 0; m < ANOMALY_METRIC_COUNT; m++) {
+        const anomaly_status_t *s = &status[m];
+        fprintf(fp, "%s\n      \"%s\": {\"observed\": %" PRIu64 ", \"last\": %.6g, \"baseline\": %.6g, "
+                "\"mad\": %.6g, \"band\": %.6g, \"streak\": %u, \"active\": %s, \"alerts\": %" PRIu64 "}",
+                m > 0 ? "," : "", g_metric_names[m], s->observed, s->last, s->baseline,
+                s->mad, s->band, s->streak, s->active ? "true" : "false", s->alerts);
+    }
+    fprintf(fp, "\n    }\n");
+    fprintf(fp, "  }");
+}
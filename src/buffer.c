@@ -27,7 +27,7 @@ circular_buffer_t* buffer_create(size_t capacity) {
     buffer->head = 0;
     buffer->tail = 0;
 
-    logger_debug("Circular buffer created (capacity: %zu bytes)", capacity);
+    LOGGER_DEBUG("Circular buffer created (capacity: %zu bytes)", capacity);
     return buffer;
 }
 
@@ -39,7 +39,7 @@ void buffer_free(circular_buffer_t *buffer) {
     }
     free(buffer);
 
-    logger_debug("Circular buffer freed");
+    LOGGER_DEBUG("Circular buffer freed");
 }
 
 int buffer_write(circular_buffer_t *buffer, const uint8_t *data, size_t length) {
@@ -64,7 +64,7 @@ int buffer_write(circular_buffer_t *buffer, const uint8_t *data, size_t length)
     buffer->tail = write_pos;
     buffer->used += length;
 
-    logger_debug("Wrote %zu bytes to buffer (used: %zu/%zu)", length, buffer->used, buffer->capacity);
+    LOGGER_DEBUG("Wrote %zu bytes to buffer (used: %zu/%zu)", length, buffer->used, buffer->capacity);
     return 0;
 }
 
@@ -90,7 +90,7 @@ int buffer_read(circular_buffer_t *buffer, uint8_t *data, size_t length) {
     buffer->head = read_pos;
     buffer->used -= length;
 
-    logger_debug("Read %zu bytes from buffer (remaining: %zu/%zu)", length, buffer->used, buffer->capacity);
+    LOGGER_DEBUG("Read %zu bytes from buffer (remaining: %zu/%zu)", length, buffer->used, buffer->capacity);
     return 0;
 }
 
@@ -106,5 +106,5 @@ void buffer_reset(circular_buffer_t *buffer) {
     buffer->tail = 0;
     buffer->used = 0;
 
-    logger_debug("Buffer reset");
+    LOGGER_DEBUG("Buffer reset");
 }
@@ -0,0 +1,571 @@
+/**
+ * @file dump.c
+ * @brief Sampled, asynchronous packet dump implementation
+ *
+ * The queue is a bounded multi-producer ring with a per-slot sequence
+ * number: producers claim a slot with one CAS on the enqueue position,
+ * the single formatter thread consumes in order. A full queue drops the
+ * record and counts it rather than stalling the worker.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <arpa/inet.h>
+#include "dump.h"
+#include "logger.h"
+#include "membudget.h"
+
+/* Compact packet record captured on the worker thread */
+typedef struct {
+    uint64_t index;             /* Queue sequence number */
+    uint64_t capture_ts_ns;
+    time_t timestamp;
+    uint32_t packet_length;
+    uint32_t payload_length;
+    uint16_t ethertype;
+    uint8_t has_ipv4;
+    uint8_t ip_proto;
+    uint8_t ttl;
+    uint8_t tcp_flags;
+    uint8_t l4;                 /* 0 = none, 6 = tcp, 17 = udp */
+    uint8_t src_mac[6];
+    uint8_t dst_mac[6];
+    uint32_t src_ip;
+    uint32_t dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint32_t seq;
+    uint32_t ack;
+    uint16_t udp_length;
+    uint16_t snap_length;
+    uint8_t data[DUMP_SNAP_BYTES];
+} dump_record_t;
+
+typedef struct {
+    _Atomic uint64_t sequence;
+    dump_record_t record;
+} dump_slot_t;
+
+/* Header fields read for every packet; enough for the filter and flow hash */
+typedef struct {
+    uint16_t ethertype;
+    uint8_t has_ipv4;
+    uint8_t ip_proto;
+    uint8_t l4;
+    uint32_t src_ip;
+    uint32_t dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+} dump_key_t;
+
+/* Per-thread selection counters; only the owning thread writes them */
+typedef struct {
+    _Alignas(64) _Atomic uint64_t seen;
+    _Atomic uint64_t selected;
+} dump_counts_t;
+
+static dump_config_t g_dump_config;
+static _Atomic int g_dump_active = 0;
+
+static dump_slot_t *g_slots = NULL;
+static uint64_t g_slot_mask;
+static _Atomic uint64_t g_enqueue_pos;
+static uint64_t g_dequeue_pos;          /* Formatter thread only */
+
+static pthread_t g_formatter_thread;
+static _Atomic int g_formatter_running;
+
+/* Threads past DUMP_MAX_THREADS share the overflow block with atomic adds */
+static dump_counts_t g_counts[DUMP_MAX_THREADS];
+static dump_counts_t g_counts_overflow;
+static _Atomic int g_counts_used;
+static _Atomic int g_counts_generation;
+static _Thread_local dump_counts_t *tls_counts;
+static _Thread_local int tls_counts_generation;
+
+static _Atomic uint64_t g_written;
+static _Atomic uint64_t g_dropped;
+
+/* Approximate per-flow counts; colliding flows share a slot */
+static _Atomic uint32_t *g_flow_counts = NULL;
+
+static const char *mode_names[] = { "off", "summary", "full", "hexdump" };
+
+/* ============================================================================
+ * Selection (worker threads)
+ * ============================================================================ */
+
+static bool filter_matches(const dump_filter_t *f, const dump_key_t *r) {
+    if (f->ip_proto != 0 && (!r->has_ipv4 || r->ip_proto != f->ip_proto)) return false;
+    if (f->host != 0 && (!r->has_ipv4 || (r->src_ip != f->host && r->dst_ip != f->host))) return false;
+    if (f->port != 0 && (r->l4 == 0 || (r->src_port != f->port && r->dst_port != f->port))) return false;
+    return true;
+}
+
+/**
+ * @brief Hash the directional 5-tuple (FNV-1a)
+ */
+static uint32_t flow_hash(const dump_key_t *r) {
+    uint32_t words[4] = {
+        r->src_ip, r->dst_ip,
+        ((uint32_t)r->src_port << 16) | r->dst_port,
+        ((uint32_t)r->ip_proto << 16) | r->ethertype
+    };
+    const uint8_t *bytes = (const uint8_t *)words;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(words); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Read the header fields the filter and flow hash need
+ */
+static void key_fill(dump_key_t *k, const packet_t *packet) {
+    memset(k, 0, sizeof(*k));
+    if (packet->ethernet != NULL) {
+        k->ethertype = ntohs(packet->ethernet->ethertype);
+    }
+    if (packet->ipv4 != NULL) {
+        k->has_ipv4 = 1;
+        k->ip_proto = packet->ipv4->protocol;
+        k->src_ip = packet->ipv4->src_ip;
+        k->dst_ip = packet->ipv4->dst_ip;
+    }
+    if (packet->tcp != NULL) {
+        k->l4 = 6;
+        k->src_port = ntohs(packet->tcp->src_port);
+        k->dst_port = ntohs(packet->tcp->dst_port);
+    } else if (packet->udp != NULL) {
+        k->l4 = 17;
+        k->src_port = ntohs(packet->udp->src_port);
+        k->dst_port = ntohs(packet->udp->dst_port);
+    }
+}
+
+/**
+ * @brief Fill the rest of a selected packet's record
+ */
+static void record_fill(dump_record_t *r, const dump_key_t *k, const packet_t *packet) {
+    memset(r, 0, offsetof(dump_record_t, data));
+    r->capture_ts_ns = packet->capture_ts_ns;
+    r->timestamp = packet->timestamp;
+    r->packet_length = packet->packet_length;
+    r->payload_length = packet->payload_length;
+    r->ethertype = k->ethertype;
+    r->has_ipv4 = k->has_ipv4;
+    r->ip_proto = k->ip_proto;
+    r->l4 = k->l4;
+    r->src_ip = k->src_ip;
+    r->dst_ip = k->dst_ip;
+    r->src_port = k->src_port;
+    r->dst_port = k->dst_port;
+
+    if (packet->ethernet != NULL) {
+        memcpy(r->src_mac, packet->ethernet->src_mac, 6);
+        memcpy(r->dst_mac, packet->ethernet->dst_mac, 6);
+    }
+    if (packet->ipv4 != NULL) {
+        r->ttl = packet->ipv4->ttl;
+    }
+    if (packet->tcp != NULL) {
+        r->seq = ntohl(packet->tcp->seq_num);
+        r->ack = ntohl(packet->tcp->ack_num);
+        r->tcp_flags = packet->tcp->flags;
+    } else if (packet->udp != NULL) {
+        r->udp_length = ntohs(packet->udp->length);
+    }
+}
+
+/**
+ * @brief Get the calling thread's counter block for the current run
+ */
+static dump_counts_t *thread_counts(void) {
+    int generation = atomic_load_explicit(&g_counts_generation, memory_order_relaxed);
+    if (tls_counts != NULL && tls_counts_generation == generation) {
+        return tls_counts;
+    }
+
+    int idx = atomic_fetch_add(&g_counts_used, 1);
+    tls_counts = idx < DUMP_MAX_THREADS ? &g_counts[idx] : &g_counts_overflow;
+    tls_counts_generation = generation;
+    return tls_counts;
+}
+
+/**
+ * @brief Bump a counter and return its previous value
+ *
+ * Owned blocks take a plain load/store; the shared overflow block needs
+ * the atomic add.
+ */
+static uint64_t counts_bump(dump_counts_t *c, _Atomic uint64_t *counter) {
+    if (c == &g_counts_overflow) {
+        return atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+    }
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + 1, memory_order_relaxed);
+    return value;
+}
+
+void dump_packet(const packet_t *packet) {
+    if (!atomic_load_explicit(&g_dump_active, memory_order_relaxed) || packet == NULL) return;
+
+    dump_counts_t *counts = thread_counts();
+    counts_bump(counts, &counts->seen);
+
+    dump_key_t key;
+    key_fill(&key, packet);
+
+    if (!filter_matches(&g_dump_config.filter, &key)) return;
+
+    if (g_flow_counts != NULL) {
+        uint32_t slot = flow_hash(&key) & (DUMP_FLOW_SLOTS - 1);
+        if (atomic_fetch_add_explicit(&g_flow_counts[slot], 1, memory_order_relaxed) >= g_dump_config.first_n) {
+            return;
+        }
+    }
+
+    /* Each thread samples 1-in-N of its own selections */
+    uint64_t selected = counts_bump(counts, &counts->selected);
+    if (g_dump_config.sample_n > 1 && selected % g_dump_config.sample_n != 0) return;
+
+    dump_record_t r;
+    record_fill(&r, &key, packet);
+
+    /* Claim a slot */
+    uint64_t pos = atomic_load_explicit(&g_enqueue_pos, memory_order_relaxed);
+    dump_slot_t *slot;
+    for (;;) {
+        slot = &g_slots[pos & g_slot_mask];
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                r.index = pos;
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&g_enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    if (g_dump_config.mode == DUMP_HEXDUMP && packet->raw_data != NULL) {
+        r.snap_length = (uint16_t)(packet->packet_length < DUMP_SNAP_BYTES ?
+                                   packet->packet_length : DUMP_SNAP_BYTES);
+        memcpy(r.data, packet->raw_data, r.snap_length);
+        memcpy(&slot->record, &r, sizeof(r));
+    } else {
+        memcpy(&slot->record, &r, offsetof(dump_record_t, data));
+    }
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+}
+
+/* ============================================================================
+ * Formatting (formatter thread)
+ * ============================================================================ */
+
+static const char *proto_name(uint8_t proto) {
+    switch (proto) {
+        case 1:  return "ICMP";
+        case 6:  return "TCP";
+        case 17: return "UDP";
+        case 58: return "ICMPv6";
+        default: return "IP";
+    }
+}
+
+static void format_tcp_flags(uint8_t flags, char *out) {
+    static const char names[] = "FSRPAU";
+    int n = 0;
+    for (int i = 0; i < 6; i++) {
+        if (flags & (1u << i)) out[n++] = names[i];
+    }
+    if (n == 0) out[n++] = '.';
+    out[n] = '\0';
+}
+
+static void format_summary(const dump_record_t *r) {
+    if (!r->has_ipv4) {
+        logger_info("#%" PRIu64 " EtherType 0x%04x len=%u", r->index, r->ethertype, r->packet_length);
+        return;
+    }
+
+    char src[INET_ADDRSTRLEN], dst[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &r->src_ip, src, sizeof(src));
+    inet_ntop(AF_INET, &r->dst_ip, dst, sizeof(dst));
+
+    if (r->l4 == 6) {
+        char flags[8];
+        format_tcp_flags(r->tcp_flags, flags);
+        logger_info("#%" PRIu64 " %s:%u -> %s:%u TCP [%s] seq=%u ack=%u len=%u",
+                    r->index, src, r->src_port, dst, r->dst_port, flags, r->seq, r->ack,
+                    r->packet_length);
+    } else if (r->l4 == 17) {
+        logger_info("#%" PRIu64 " %s:%u -> %s:%u UDP len=%u",
+                    r->index, src, r->src_port, dst, r->dst_port, r->packet_length);
+    } else {
+        logger_info("#%" PRIu64 " %s -> %s %s len=%u",
+                    r->index, src, dst, proto_name(r->ip_proto), r->packet_length);
+    }
+}
+
+static void format_full(const dump_record_t *r) {
+    logger_info("=== Packet #%" PRIu64 " ===", r->index);
+    logger_info("Timestamp: %ld", (long)r->timestamp);
+    logger_info("Total Length: %u bytes", r->packet_length);
+    logger_info("Ethernet: %02x:%02x:%02x:%02x:%02x:%02x -> %02x:%02x:%02x:%02x:%02x:%02x (Type: 0x%04x)",
+                r->src_mac[0], r->src_mac[1], r->src_mac[2], r->src_mac[3], r->src_mac[4], r->src_mac[5],
+                r->dst_mac[0], r->dst_mac[1], r->dst_mac[2], r->dst_mac[3], r->dst_mac[4], r->dst_mac[5],
+                r->ethertype);
+
+    if (r->has_ipv4) {
+        char src[INET_ADDRSTRLEN], dst[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &r->src_ip, src, sizeof(src));
+        inet_ntop(AF_INET, &r->dst_ip, dst, sizeof(dst));
+        logger_info("IPv4: %s -> %s (TTL=%u, Protocol=%u)", src, dst, r->ttl, r->ip_proto);
+    }
+    if (r->l4 == 6) {
+        logger_info("TCP: Port %u -> %u (Seq=%u, Ack=%u, Flags=0x%02x)",
+                    r->src_port, r->dst_port, r->seq, r->ack, r->tcp_flags);
+    } else if (r->l4 == 17) {
+        logger_info("UDP: Port %u -> %u (Length=%u)", r->src_port, r->dst_port, r->udp_length);
+    }
+    if (r->payload_length > 0) {
+        logger_info("Payload: %u bytes", r->payload_length);
+    }
+}
+
+static void format_hexdump(const dump_record_t *r) {
+    char row[96];
+    for (uint16_t off = 0; off < r->snap_length; off += 16) {
+        size_t len = (size_t)snprintf(row, sizeof(row), "  %04x:", off);
+        for (uint16_t i = off; i < off + 16 && i < r->snap_length; i++) {
+            len += (size_t)snprintf(row + len, sizeof(row) - len, " %02x", r->data[i]);
+        }
+        logger_info("%s", row);
+    }
+}
+
+static void format_record(const dump_record_t *r) {
+    switch (g_dump_config.mode) {
+        case DUMP_SUMMARY:
+            format_summary(r);
+            break;
+        case DUMP_FULL:
+            format_full(r);
+            break;
+        case DUMP_HEXDUMP:
+            format_full(r);
+            format_hexdump(r);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Format all records currently in the queue
+ *
+ * @return Number of records formatted
+ */
+static size_t drain_queue(void) {
+    size_t count = 0;
+
+    for (;;) {
+        dump_slot_t *slot = &g_slots[g_dequeue_pos & g_slot_mask];
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (seq != g_dequeue_pos + 1) break;
+
+        dump_record_t record = slot->record;
+        atomic_store_explicit(&slot->sequence, g_dequeue_pos + g_slot_mask + 1, memory_order_release);
+        g_dequeue_pos++;
+
+        format_record(&record);
+        count++;
+    }
+
+    if (count > 0) {
+        atomic_fetch_add_explicit(&g_written, count, memory_order_relaxed);
+    }
+    return count;
+}
+
+static void* dump_formatter_thread(void *arg) {
+    (void)arg;
+
+    while (atomic_load(&g_formatter_running)) {
+        if (drain_queue() == 0) {
+            usleep(1000);
+        }
+    }
+    drain_queue();
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int dump_init(const dump_config_t *config) {
+    if (config == NULL) return -1;
+    if (atomic_load(&g_dump_active)) {
+        logger_error("Dump subsystem already running");
+        return -1;
+    }
+
+    g_dump_config = *config;
+    for (int i = 0; i < DUMP_MAX_THREADS; i++) {
+        atomic_store(&g_counts[i].seen, 0);
+        atomic_store(&g_counts[i].selected, 0);
+    }
+    atomic_store(&g_counts_overflow.seen, 0);
+    atomic_store(&g_counts_overflow.selected, 0);
+    atomic_store(&g_counts_used, 0);
+    atomic_fetch_add(&g_counts_generation, 1);
+    atomic_store(&g_written, 0);
+    atomic_store(&g_dropped, 0);
+
+    if (g_dump_config.mode == DUMP_OFF) return 0;
+
+    uint32_t capacity = DUMP_QUEUE_DEFAULT;
+    if (g_dump_config.queue_capacity > 0) {
+        capacity = 1;
+        while (capacity < g_dump_config.queue_capacity) capacity <<= 1;
+    }
+
+    g_slots = calloc(capacity, sizeof(dump_slot_t));
+    if (g_slots == NULL) {
+        logger_error("Failed to allocate dump queue (%u records)", capacity);
+        return -1;
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&g_slots[i].sequence, i);
+    }
+    g_slot_mask = capacity - 1;
+    g_dump_config.queue_capacity = capacity;
+    atomic_store(&g_enqueue_pos, 0);
+    g_dequeue_pos = 0;
+
+    if (g_dump_config.first_n > 0) {
+        g_flow_counts = calloc(DUMP_FLOW_SLOTS, sizeof(*g_flow_counts));
+        if (g_flow_counts == NULL) {
+            logger_error("Failed to allocate dump flow table");
+            free(g_slots);
+            g_slots = NULL;
+            return -1;
+        }
+    }
+
+    atomic_store(&g_formatter_running, 1);
+    if (pthread_create(&g_formatter_thread, NULL, dump_formatter_thread, NULL) != 0) {
+        logger_error("Failed to create dump formatter thread");
+        free(g_flow_counts);
+        g_flow_counts = NULL;
+        free(g_slots);
+        g_slots = NULL;
+        return -1;
+    }
+
+    membudget_charge(MEM_SUBSYS_QUEUE, (size_t)capacity * sizeof(dump_slot_t));
+    atomic_store(&g_dump_active, 1);
+
+    logger_info("Packet dump: mode=%s, sample 1/%u, first %u per flow, queue %u records",
+                mode_names[g_dump_config.mode],
+                g_dump_config.sample_n > 1 ? g_dump_config.sample_n : 1,
+                g_dump_config.first_n, capacity);
+    return 0;
+}
+
+void dump_shutdown(void) {
+    if (!atomic_load(&g_dump_active)) return;
+
+    atomic_store(&g_dump_active, 0);
+    atomic_store(&g_formatter_running, 0);
+    pthread_join(g_formatter_thread, NULL);
+
+    membudget_release(MEM_SUBSYS_QUEUE, (size_t)g_dump_config.queue_capacity * sizeof(dump_slot_t));
+    free(g_slots);
+    g_slots = NULL;
+    free(g_flow_counts);
+    g_flow_counts = NULL;
+
+    dump_stats_t stats;
+    dump_get_stats(&stats);
+    logger_info("Packet dump: %" PRIu64 " seen, %" PRIu64 " selected, %" PRIu64 " written, %"
+                PRIu64 " dropped (queue full)",
+                stats.seen, stats.selected, stats.written, stats.dropped);
+}
+
+void dump_get_stats(dump_stats_t *stats) {
+    if (stats == NULL) return;
+
+    int used = atomic_load(&g_counts_used);
+    if (used > DUMP_MAX_THREADS) used = DUMP_MAX_THREADS;
+
+    stats->seen = atomic_load(&g_counts_overflow.seen);
+    stats->selected = atomic_load(&g_counts_overflow.selected);
+    for (int i = 0; i < used; i++) {
+        stats->seen += atomic_load(&g_counts[i].seen);
+        stats->selected += atomic_load(&g_counts[i].selected);
+    }
+    stats->written = atomic_load(&g_written);
+    stats->dropped = atomic_load(&g_dropped);
+}
+
+int dump_parse_mode(const char *name, dump_mode_t *mode) {
+    if (name == NULL || mode == NULL) return -1;
+
+    for (int i = 0; i <= DUMP_HEXDUMP; i++) {
+        if (strcmp(name, mode_names[i]) == 0) {
+            *mode = (dump_mode_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int dump_parse_filter(const char *expr, dump_filter_t *filter) {
+    if (expr == NULL || filter == NULL) return -1;
+
+    memset(filter, 0, sizeof(*filter));
+
+    char buf[256];
+    strncpy(buf, expr, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, " ,", &save); tok != NULL; tok = strtok_r(NULL, " ,", &save)) {
+        if (strcmp(tok, "tcp") == 0) {
+            filter->ip_proto = 6;
+        } else if (strcmp(tok, "udp") == 0) {
+            filter->ip_proto = 17;
+        } else if (strcmp(tok, "icmp") == 0) {
+            filter->ip_proto = 1;
+        } else if (strcmp(tok, "port") == 0) {
+            char *arg = strtok_r(NULL, " ,", &save);
+            char *end = NULL;
+            long port = arg ? strtol(arg, &end, 10) : 0;
+            if (arg == NULL || *end != '\0' || port <= 0 || port > 65535) return -1;
+            filter->port = (uint16_t)port;
+        } else if (strcmp(tok, "host") == 0) {
+            char *arg = strtok_r(NULL, " ,", &save);
+            struct in_addr addr;
+            if (arg == NULL || inet_pton(AF_INET, arg, &addr) != 1) return -1;
+            filter->host = addr.s_addr;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
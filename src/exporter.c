@@ -0,0 +1,329 @@
+/**
+ * @file exporter.c
+ * @brief Prometheus/OpenMetrics HTTP exporter implementation
+ *
+ * Connections are served one at a time with non-blocking sockets and
+ * poll() deadlines; the response is rendered into memory first so the
+ * snapshot is released before any byte goes out on the network.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "exporter.h"
+#include "metrics.h"
+#include "logger.h"
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+#define REQUEST_MAX 4096
+#define METRIC_PREFIX "packet_analyzer_"
+
+static int g_listen_fd = -1;
+static pthread_t g_exporter_thread;
+static _Atomic int g_exporter_running = 0;
+static _Atomic uint64_t g_scrapes = 0;
+
+/* ============================================================================
+ * OpenMetrics Rendering
+ * ============================================================================ */
+
+static void write_family(FILE *fp, const char *name, const char *type,
+                         const char *unit, const char *help) {
+    fprintf(fp, "# TYPE " METRIC_PREFIX "%s %s\n", name, type);
+    if (unit != NULL) {
+        fprintf(fp, "# UNIT " METRIC_PREFIX "%s %s\n", name, unit);
+    }
+    fprintf(fp, "# HELP " METRIC_PREFIX "%s %s\n", name, help);
+}
+
+static void write_counter(FILE *fp, const char *name, const char *labels, uint64_t value) {
+    if (labels != NULL) {
+        fprintf(fp, METRIC_PREFIX "%s_total{%s} %" PRIu64 "\n", name, labels, value);
+    } else {
+        fprintf(fp, METRIC_PREFIX "%s_total %" PRIu64 "\n", name, value);
+    }
+}
+
+/**
+ * @brief Write cumulative power-of-two buckets, +Inf and _count of an HDR histogram
+ *
+ * HDR entries never straddle a power of two above the sub-bucket range,
+ * so each bucket count is exact.
+ *
+ * @param labels Extra labels with a trailing comma, or ""
+ */
+static void write_hdr_buckets(FILE *fp, const char *name, const char *labels,
+                              const hdr_histogram_t *h) {
+    uint64_t cumulative = 0;
+    int len = h != NULL ? hdr_counts_len(h) : 0;
+    int i = 0;
+
+    for (int k = EXPORTER_BUCKET_MIN_LOG2; k <= EXPORTER_BUCKET_MAX_LOG2; k++) {
+        uint64_t bound_ns = 1ULL << k;
+        while (i < len && hdr_value_at_index(h, i) < bound_ns) {
+            cumulative += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+            i++;
+        }
+        fprintf(fp, METRIC_PREFIX "%s_bucket{%sle=\"%.9g\"} %" PRIu64 "\n",
+                name, labels, (double)bound_ns / 1e9, cumulative);
+    }
+    for (; i < len; i++) {
+        cumulative += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    }
+    fprintf(fp, METRIC_PREFIX "%s_bucket{%sle=\"+Inf\"} %" PRIu64 "\n", name, labels, cumulative);
+
+    if (labels[0] != '\0') {
+        /* Drop the trailing comma for the plain series */
+        fprintf(fp, METRIC_PREFIX "%s_count{%.*s} %" PRIu64 "\n",
+                name, (int)strlen(labels) - 1, labels, cumulative);
+    } else {
+        fprintf(fp, METRIC_PREFIX "%s_count %" PRIu64 "\n", name, cumulative);
+    }
+}
+
+void exporter_write_openmetrics(FILE *fp) {
+    metrics_snapshot_t snap;
+    metrics_snapshot_select(&snap, METRICS_SNAP_LATENCY | METRICS_SNAP_STAGES);
+
+    write_family(fp, "captured_packets", "counter", NULL, "Packets read from the capture socket.");
+    write_counter(fp, "captured_packets", NULL, snap.pkts_captured);
+    write_family(fp, "processed_packets", "counter", NULL, "Packets processed by the workers.");
+    write_counter(fp, "processed_packets", NULL, snap.pkts_processed);
+    write_family(fp, "captured_bytes", "counter", "bytes", "Bytes read from the capture socket.");
+    write_counter(fp, "captured_bytes", NULL, snap.bytes_captured);
+    write_family(fp, "processed_bytes", "counter", "bytes", "Bytes processed by the workers.");
+    write_counter(fp, "processed_bytes", NULL, snap.bytes_processed);
+
+    /* Registered metrics: errors, drops, EtherType and protocol counts, plus any module's own */
+    registry_write_openmetrics(fp, &snap.registry, METRIC_PREFIX);
+
+    write_family(fp, "queue_depth", "gauge", NULL, "Packets waiting in the work queue.");
+    fprintf(fp, METRIC_PREFIX "queue_depth %" PRIu32 "\n", snap.queue_depth);
+    write_family(fp, "queue_depth_max", "gauge", NULL, "Highest work queue depth this run.");
+    fprintf(fp, METRIC_PREFIX "queue_depth_max %" PRIu32 "\n", snap.queue_depth_max);
+
+    write_family(fp, "measurement_elapsed_seconds", "gauge", "seconds",
+                 "Time since the current measurement started.");
+    fprintf(fp, METRIC_PREFIX "measurement_elapsed_seconds %.3f\n", snap.elapsed_sec);
+
+    write_family(fp, "latency_seconds", "histogram", "seconds",
+                 "End-to-end packet latency, capture to analysis done.");
+    write_hdr_buckets(fp, "latency_seconds", "", snap.latency_hdr);
+    fprintf(fp, METRIC_PREFIX "latency_seconds_sum %.9f\n", (double)snap.latency_sum_ns / 1e9);
+
+    write_family(fp, "stage_latency_seconds", "histogram", "seconds",
+                 "Packet latency by pipeline stage.");
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        char labels[32];
+        snprintf(labels, sizeof(labels), "stage=\"%s\",", metrics_stage_name((metrics_stage_t)i));
+        write_hdr_buckets(fp, "stage_latency_seconds", labels, snap.stage_hdr[i]);
+    }
+
+    write_family(fp, "exporter_scrapes", "counter", NULL, "Requests answered by this exporter.");
+    write_counter(fp, "exporter_scrapes", NULL, atomic_load(&g_scrapes));
+
+    fprintf(fp, "# EOF\n");
+    metrics_snapshot_free(&snap);
+}
+
+/* ============================================================================
+ * HTTP Handling
+ * ============================================================================ */
+
+/**
+ * @brief Wait until fd is ready for events or the deadline passes
+ *
+ * @return 1 if ready, 0 on timeout or error
+ */
+static int wait_fd(int fd, short events, uint64_t deadline_ns) {
+    uint64_t now_ns = metrics_now_ns();
+    if (now_ns >= deadline_ns) return 0;
+
+    struct pollfd pfd = { .fd = fd, .events = events };
+    int timeout_ms = (int)((deadline_ns - now_ns) / 1000000) + 1;
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+static int send_all(int fd, const char *data, size_t len, uint64_t deadline_ns) {
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(fd, data + sent, len - sent, SEND_FLAGS);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            if (!wait_fd(fd, POLLOUT, deadline_ns)) return -1;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void send_response(int fd, const char *status, const char *content_type,
+                          const char *body, size_t body_len, uint64_t deadline_ns) {
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 %s\r\n"
+                              "Content-Type: %s\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n",
+                              status, content_type, body_len);
+    if (send_all(fd, header, (size_t)header_len, deadline_ns) == 0 && body_len > 0) {
+        send_all(fd, body, body_len, deadline_ns);
+    }
+}
+
+static void handle_client(int fd) {
+    uint64_t deadline_ns = metrics_now_ns() + (uint64_t)EXPORTER_IO_TIMEOUT_MS * 1000000ULL;
+    char request[REQUEST_MAX];
+    size_t len = 0;
+
+    /* Read until the end of the request headers */
+    while (len < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (n > 0) {
+            len += (size_t)n;
+            request[len] = '\0';
+            if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL) break;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            if (!wait_fd(fd, POLLIN, deadline_ns)) return;
+        } else {
+            return;
+        }
+    }
+    request[len] = '\0';
+
+    char method[8], path[64];
+    if (sscanf(request, "%7s %63s", method, path) != 2) {
+        send_response(fd, "400 Bad Request", "text/plain", "", 0, deadline_ns);
+        return;
+    }
+    char *query = strchr(path, '?');
+    if (query != NULL) *query = '\0';
+
+    if (strcmp(path, "/metrics") != 0) {
+        const char *body = "Not found; metrics are served at /metrics\n";
+        send_response(fd, "404 Not Found", "text/plain", body, strlen(body), deadline_ns);
+        return;
+    }
+    if (strcmp(method, "GET") != 0) {
+        send_response(fd, "405 Method Not Allowed", "text/plain", "", 0, deadline_ns);
+        return;
+    }
+
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *fp = open_memstream(&body, &body_len);
+    if (fp == NULL) {
+        send_response(fd, "500 Internal Server Error", "text/plain", "", 0, deadline_ns);
+        return;
+    }
+    atomic_fetch_add(&g_scrapes, 1);
+    exporter_write_openmetrics(fp);
+    fclose(fp);
+
+    send_response(fd, "200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8",
+                  body, body_len, deadline_ns);
+    free(body);
+}
+
+static void* exporter_thread(void *arg) {
+    (void)arg;
+
+    while (atomic_load(&g_exporter_running)) {
+        struct pollfd pfd = { .fd = g_listen_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        int client_fd = accept(g_listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            continue;
+        }
+        fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(client_fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        handle_client(client_fd);
+        close(client_fd);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int exporter_start(const exporter_config_t *config) {
+    if (config == NULL || config->port == 0) return -1;
+    if (atomic_load(&g_exporter_running)) {
+        logger_error("Metrics exporter already running");
+        return -1;
+    }
+
+    const char *bind_addr = config->bind_addr != NULL ? config->bind_addr : EXPORTER_BIND_DEFAULT;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config->port);
+    if (inet_pton(AF_INET, bind_addr, &addr.sin_addr) != 1) {
+        logger_error("Invalid metrics exporter address: %s", bind_addr);
+        return -1;
+    }
+
+    g_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (g_listen_fd < 0) {
+        logger_error("Failed to create metrics exporter socket: %s", strerror(errno));
+        return -1;
+    }
+    int one = 1;
+    setsockopt(g_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    fcntl(g_listen_fd, F_SETFL, fcntl(g_listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (bind(g_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(g_listen_fd, 16) < 0) {
+        logger_error("Failed to listen on %s:%u for metrics: %s",
+                     bind_addr, (unsigned)config->port, strerror(errno));
+        close(g_listen_fd);
+        g_listen_fd = -1;
+        return -1;
+    }
+
+    atomic_store(&g_exporter_running, 1);
+    if (pthread_create(&g_exporter_thread, NULL, exporter_thread, NULL) != 0) {
+        logger_error("Failed to create metrics exporter thread");
+        atomic_store(&g_exporter_running, 0);
+        close(g_listen_fd);
+        g_listen_fd = -1;
+        return -1;
+    }
+
+    logger_info("Serving OpenMetrics at http://%s:%u/metrics", bind_addr, (unsigned)config->port);
+    return 0;
+}
+
+void exporter_stop(void) {
+    if (!atomic_load(&g_exporter_running)) return;
+
+    atomic_store(&g_exporter_running, 0);
+    pthread_join(g_exporter_thread, NULL);
+    close(g_listen_fd);
+    g_listen_fd = -1;
+    logger_info("Metrics exporter stopped (%" PRIu64 " scrapes)", atomic_load(&g_scrapes));
+}
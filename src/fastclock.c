@@ -0,0 +1,159 @@
+/**
+ * @file fastclock.c
+ * @brief Calibrated TSC clock implementation
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "fastclock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+bool fastclock_tsc_enabled = false;
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+static fastclock_info_t g_info = {
+    .source = FASTCLOCK_MONOTONIC, .ticks_per_ns = 1.0, .fallback_reason = "not initialized"
+};
+
+/* ns = (ticks * g_ns_mult) >> 32 */
+static uint64_t g_ns_mult = 1ULL << 32;
+static double g_ns_per_tick = 1.0;
+
+/* Anchors taken together at the end of calibration */
+static uint64_t g_base_ticks;
+static uint64_t g_base_ns;
+static uint64_t g_wall_base_ns;
+
+/* ============================================================================
+ * Calibration
+ * ============================================================================ */
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief CPUID 0x80000007 EDX bit 8: TSC runs at a constant rate in all P/C-states
+ */
+static bool cpu_has_invariant_tsc(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) {
+        return false;
+    }
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & (1U << 8)) != 0;
+}
+
+/**
+ * @brief Measure TSC ticks per nanosecond over one calibration window
+ */
+static double calibrate_round(uint64_t *ticks, uint64_t *ns) {
+    uint64_t ns_start = fastclock_monotonic_ns();
+    uint64_t ticks_start = __builtin_ia32_rdtsc();
+    uint64_t ns_end;
+    do {
+        ns_end = fastclock_monotonic_ns();
+    } while (ns_end - ns_start < FASTCLOCK_CALIBRATION_NS);
+    uint64_t ticks_end = __builtin_ia32_rdtsc();
+
+    *ticks = ticks_end - ticks_start;
+    *ns = ns_end - ns_start;
+    return ticks_end > ticks_start ? (double)*ticks / (double)*ns : 0.0;
+}
+
+static void calibrate_tsc(void) {
+    g_info.invariant_tsc = cpu_has_invariant_tsc();
+    if (!g_info.invariant_tsc) {
+        g_info.fallback_reason = "TSC not invariant";
+        return;
+    }
+
+    double min_rate = 0.0, max_rate = 0.0;
+    uint64_t total_ticks = 0, total_ns = 0;
+    for (int i = 0; i < FASTCLOCK_CALIBRATION_ROUNDS; i++) {
+        uint64_t ticks, ns;
+        double rate = calibrate_round(&ticks, &ns);
+        if (rate <= 0.0) {
+            g_info.fallback_reason = "TSC not advancing";
+            return;
+        }
+        if (i == 0 || rate < min_rate) min_rate = rate;
+        if (i == 0 || rate > max_rate) max_rate = rate;
+        total_ticks += ticks;
+        total_ns += ns;
+    }
+
+    double rate = (double)total_ticks / (double)total_ns;
+    g_info.ticks_per_ns = rate;
+    g_info.spread_ppm = (max_rate - min_rate) / rate * 1e6;
+    if (g_info.spread_ppm > FASTCLOCK_MAX_SPREAD_PPM) {
+        g_info.fallback_reason = "TSC calibration unstable";
+        g_info.ticks_per_ns = 1.0;
+        return;
+    }
+
+    g_ns_per_tick = 1.0 / rate;
+    g_ns_mult = (uint64_t)(g_ns_per_tick * 4294967296.0);
+    g_info.source = FASTCLOCK_TSC;
+    g_info.fallback_reason = NULL;
+    fastclock_tsc_enabled = true;
+}
+#endif
+
+static void fastclock_init_once(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    calibrate_tsc();
+#else
+    g_info.fallback_reason = "no TSC on this architecture";
+#endif
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    g_base_ticks = fastclock_ticks();
+    g_base_ns = fastclock_monotonic_ns();
+    g_wall_base_ns = (uint64_t)wall.tv_sec * 1000000000ULL + (uint64_t)wall.tv_nsec;
+}
+
+void fastclock_init(void) {
+    pthread_once(&g_init_once, fastclock_init_once);
+}
+
+/* ============================================================================
+ * Conversion
+ * ============================================================================ */
+
+uint64_t fastclock_to_ns(uint64_t ticks) {
+    if (!fastclock_tsc_enabled) {
+        return ticks;
+    }
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)(((unsigned __int128)ticks * g_ns_mult) >> 32);
+#else
+    return (uint64_t)((double)ticks * g_ns_per_tick);
+#endif
+}
+
+uint64_t fastclock_ticks_to_monotonic_ns(uint64_t ticks) {
+    if (ticks >= g_base_ticks) {
+        return g_base_ns + fastclock_to_ns(ticks - g_base_ticks);
+    }
+    uint64_t before = fastclock_to_ns(g_base_ticks - ticks);
+    return before < g_base_ns ? g_base_ns - before : 0;
+}
+
+time_t fastclock_ticks_to_wall_sec(uint64_t ticks) {
+    uint64_t elapsed_ns = ticks >= g_base_ticks ? fastclock_to_ns(ticks - g_base_ticks) : 0;
+    return (time_t)((g_wall_base_ns + elapsed_ns) / 1000000000ULL);
+}
+
+void fastclock_get_info(fastclock_info_t *info) {
+    if (info != NULL) {
+        *info = g_info;
+    }
+}
+
+const char* fastclock_source_name(fastclock_source_t source) {
+    return source == FASTCLOCK_TSC ? "tsc" : "monotonic";
+}
@@ -0,0 +1,369 @@
+/**
+ * @file hdr_histogram.c
+ * @brief High dynamic range latency histogram implementation
+ *
+ * Layout follows HdrHistogram: bucket 0 holds values [0, sub_bucket_count)
+ * at unit resolution; every further bucket doubles the range and the step
+ * and only uses the upper half of its sub-buckets, since the lower half
+ * overlaps the previous bucket.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "hdr_histogram.h"
+
+/* ============================================================================
+ * Index Arithmetic
+ * ============================================================================ */
+
+static inline int bucket_index(const hdr_histogram_t *h, uint64_t value) {
+    int pow2ceiling = 64 - __builtin_clzll(value | h->sub_bucket_mask);
+    return pow2ceiling - (h->sub_bucket_half_count_magnitude + 1);
+}
+
+static inline int counts_index(const hdr_histogram_t *h, uint64_t value) {
+    if (value > h->highest_trackable) {
+        value = h->highest_trackable;
+    }
+    int bucket = bucket_index(h, value);
+    int sub_bucket = (int)(value >> bucket);
+    return ((bucket + 1) << h->sub_bucket_half_count_magnitude) +
+           (sub_bucket - (int)h->sub_bucket_half_count);
+}
+
+uint64_t hdr_value_at_index(const hdr_histogram_t *h, int index) {
+    int bucket = (index >> h->sub_bucket_half_count_magnitude) - 1;
+    int sub_bucket = (index & (int)(h->sub_bucket_half_count - 1)) + (int)h->sub_bucket_half_count;
+    if (bucket < 0) {
+        sub_bucket -= (int)h->sub_bucket_half_count;
+        bucket = 0;
+    }
+    return (uint64_t)sub_bucket << bucket;
+}
+
+/**
+ * @brief Highest value that lands in the same counts[] entry as value
+ */
+static uint64_t highest_equivalent_value(const hdr_histogram_t *h, uint64_t value) {
+    int bucket = bucket_index(h, value);
+    uint64_t lowest = (value >> bucket) << bucket;
+    return lowest + (1ULL << bucket) - 1;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+hdr_histogram_t* hdr_create(uint64_t highest_trackable, int significant_digits) {
+    if (highest_trackable < 2 ||
+        significant_digits < HDR_DIGITS_MIN || significant_digits > HDR_DIGITS_MAX) {
+        return NULL;
+    }
+
+    /* Sub-buckets needed to resolve 2 * 10^digits at unit resolution */
+    uint64_t largest_single_unit = 2;
+    for (int i = 0; i < significant_digits; i++) {
+        largest_single_unit *= 10;
+    }
+    int sub_bucket_count_magnitude = 0;
+    while ((1ULL << sub_bucket_count_magnitude) < largest_single_unit) {
+        sub_bucket_count_magnitude++;
+    }
+
+    uint32_t sub_bucket_count = 1U << sub_bucket_count_magnitude;
+    int bucket_count = 1;
+    uint64_t smallest_untrackable = sub_bucket_count;
+    while (smallest_untrackable <= highest_trackable) {
+        if (smallest_untrackable > UINT64_MAX / 2) {
+            bucket_count++;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        bucket_count++;
+    }
+
+    int counts_len = (bucket_count + 1) * (int)(sub_bucket_count / 2);
+    hdr_histogram_t *h = calloc(1, sizeof(hdr_histogram_t) + (size_t)counts_len * sizeof(uint64_t));
+    if (h == NULL) {
+        return NULL;
+    }
+
+    h->significant_digits = significant_digits;
+    h->highest_trackable = highest_trackable;
+    h->sub_bucket_half_count_magnitude = sub_bucket_count_magnitude - 1;
+    h->sub_bucket_count = sub_bucket_count;
+    h->sub_bucket_half_count = sub_bucket_count / 2;
+    h->sub_bucket_mask = sub_bucket_count - 1;
+    h->bucket_count = bucket_count;
+    h->counts_len = counts_len;
+    return h;
+}
+
+hdr_histogram_t* hdr_copy(const hdr_histogram_t *h) {
+    if (h == NULL) {
+        return NULL;
+    }
+    hdr_histogram_t *copy = hdr_create(h->highest_trackable, h->significant_digits);
+    if (copy != NULL) {
+        hdr_add(copy, h);
+    }
+    return copy;
+}
+
+void hdr_destroy(hdr_histogram_t *h) {
+    free(h);
+}
+
+void hdr_reset(hdr_histogram_t *h) {
+    for (int i = 0; i < h->counts_len; i++) {
+        atomic_store_explicit(&h->counts[i], 0, memory_order_relaxed);
+    }
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+void hdr_record(hdr_histogram_t *h, uint64_t value) {
+    atomic_fetch_add_explicit(&h->counts[counts_index(h, value)], 1, memory_order_relaxed);
+}
+
+void hdr_record_local(hdr_histogram_t *h, uint64_t value) {
+    _Atomic uint64_t *count = &h->counts[counts_index(h, value)];
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+int hdr_add(hdr_histogram_t *dst, const hdr_histogram_t *src) {
+    if (dst->significant_digits != src->significant_digits ||
+        dst->counts_len != src->counts_len) {
+        return -1;
+    }
+    for (int i = 0; i < src->counts_len; i++) {
+        uint64_t count = atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+        if (count > 0) {
+            atomic_fetch_add_explicit(&dst->counts[i], count, memory_order_relaxed);
+        }
+    }
+    return 0;
+}
+
+int hdr_subtract(hdr_histogram_t *dst, const hdr_histogram_t *src) {
+    if (dst->significant_digits != src->significant_digits ||
+        dst->counts_len != src->counts_len) {
+        return -1;
+    }
+    for (int i = 0; i < src->counts_len; i++) {
+        uint64_t count = atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+        uint64_t current = atomic_load_explicit(&dst->counts[i], memory_order_relaxed);
+        atomic_store_explicit(&dst->counts[i], current > count ? current - count : 0,
+                              memory_order_relaxed);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Queries
+ * ============================================================================ */
+
+uint64_t hdr_total_count(const hdr_histogram_t *h) {
+    uint64_t total = 0;
+    for (int i = 0; i < h->counts_len; i++) {
+        total += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    }
+    return total;
+}
+
+/**
+ * @brief Rank of the value at a quantile (1-based, rounded up)
+ */
+static uint64_t quantile_rank(uint64_t total, double quantile) {
+    if (quantile < 0.0) quantile = 0.0;
+    if (quantile > 1.0) quantile = 1.0;
+    uint64_t target = (uint64_t)(quantile * (double)total);
+    if ((double)target < quantile * (double)total) target++;
+    return target < 1 ? 1 : target;
+}
+
+uint64_t hdr_value_at_quantile(const hdr_histogram_t *h, double quantile) {
+    uint64_t total = hdr_total_count(h);
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = quantile_rank(total, quantile);
+
+    uint64_t cumulative = 0;
+    for (int i = 0; i < h->counts_len; i++) {
+        cumulative += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (cumulative >= target) {
+            return highest_equivalent_value(h, hdr_value_at_index(h, i));
+        }
+    }
+    return h->highest_trackable;
+}
+
+void hdr_sum_quantiles(const hdr_histogram_t *const *hists, int count,
+                       const double *quantiles, uint64_t *values, int quantile_count) {
+    const hdr_histogram_t *ref = NULL;
+    uint64_t total = 0;
+    for (int h = 0; h < count; h++) {
+        if (hists[h] == NULL) continue;
+        if (ref == NULL) ref = hists[h];
+        if (hists[h]->significant_digits == ref->significant_digits &&
+            hists[h]->counts_len == ref->counts_len) {
+            total += hdr_total_count(hists[h]);
+        }
+    }
+    for (int q = 0; q < quantile_count; q++) {
+        values[q] = 0;
+    }
+    if (total == 0) {
+        return;
+    }
+
+    /* One pass over the buckets, summing each across the histograms */
+    int q = 0;
+    uint64_t target = quantile_rank(total, quantiles[0]);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < ref->counts_len && q < quantile_count; i++) {
+        for (int h = 0; h < count; h++) {
+            const hdr_histogram_t *hist = hists[h];
+            if (hist == NULL || hist->significant_digits != ref->significant_digits ||
+                hist->counts_len != ref->counts_len) {
+                continue;
+            }
+            cumulative += atomic_load_explicit(&hist->counts[i], memory_order_relaxed);
+        }
+        while (q < quantile_count && cumulative >= target) {
+            values[q++] = highest_equivalent_value(ref, hdr_value_at_index(ref, i));
+            if (q < quantile_count) target = quantile_rank(total, quantiles[q]);
+        }
+    }
+    for (; q < quantile_count; q++) {
+        values[q] = ref->highest_trackable;
+    }
+}
+
+int hdr_counts_len(const hdr_histogram_t *h) {
+    return h->counts_len;
+}
+
+int hdr_index_of(const hdr_histogram_t *h, uint64_t value) {
+    return counts_index(h, value);
+}
+
+uint64_t hdr_highest_equivalent(const hdr_histogram_t *h, uint64_t value) {
+    return highest_equivalent_value(h, hdr_value_at_index(h, counts_index(h, value)));
+}
+
+uint64_t hdr_count_at_or_below(const hdr_histogram_t *h, uint64_t value) {
+    int last = counts_index(h, value);
+    uint64_t total = 0;
+    for (int i = 0; i <= last; i++) {
+        total += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    }
+    return total;
+}
+
+/* ============================================================================
+ * JSON Serialization
+ * ============================================================================ */
+
+void hdr_write_json(const hdr_histogram_t *h, FILE *fp) {
+    int last = -1;
+    for (int i = 0; i < h->counts_len; i++) {
+        if (atomic_load_explicit(&h->counts[i], memory_order_relaxed) > 0) {
+            last = i;
+        }
+    }
+
+    fprintf(fp, "{\"digits\": %d, \"highest\": %" PRIu64 ", \"counts\": [",
+            h->significant_digits, h->highest_trackable);
+
+    const char *sep = "";
+    int zeros = 0;
+    for (int i = 0; i <= last; i++) {
+        uint64_t count = atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (count == 0) {
+            zeros++;
+            continue;
+        }
+        if (zeros > 0) {
+            fprintf(fp, "%s-%d", sep, zeros);
+            sep = ",";
+            zeros = 0;
+        }
+        fprintf(fp, "%s%" PRIu64, sep, count);
+        sep = ",";
+    }
+    fprintf(fp, "]}");
+}
+
+/**
+ * @brief Find "key": and return a pointer just past the colon
+ */
+static const char* find_value(const char *json, const char *key) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *pos = strstr(json, pattern);
+    if (pos == NULL) {
+        return NULL;
+    }
+    pos = strchr(pos + strlen(pattern), ':');
+    return pos != NULL ? pos + 1 : NULL;
+}
+
+hdr_histogram_t* hdr_parse_json(const char *json) {
+    if (json == NULL) {
+        return NULL;
+    }
+
+    const char *digits_pos = find_value(json, "digits");
+    const char *highest_pos = find_value(json, "highest");
+    const char *counts_pos = find_value(json, "counts");
+    if (digits_pos == NULL || highest_pos == NULL || counts_pos == NULL) {
+        return NULL;
+    }
+
+    hdr_histogram_t *h = hdr_create(strtoull(highest_pos, NULL, 10), atoi(digits_pos));
+    if (h == NULL) {
+        return NULL;
+    }
+
+    const char *p = strchr(counts_pos, '[');
+    if (p == NULL) {
+        hdr_destroy(h);
+        return NULL;
+    }
+    p++;
+
+    int index = 0;
+    for (;;) {
+        while (*p == ' ' || *p == ',' || *p == '\n' || *p == '\t') p++;
+        if (*p == ']') {
+            return h;
+        }
+
+        char *end;
+        long long value = strtoll(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        p = end;
+
+        if (value < 0) {
+            if (-value > (long long)(h->counts_len - index)) {
+                break;
+            }
+            index += (int)-value;
+        } else if (index < h->counts_len) {
+            atomic_store_explicit(&h->counts[index++], (uint64_t)value, memory_order_relaxed);
+        } else {
+            break;
+        }
+    }
+
+    hdr_destroy(h);
+    return NULL;
+}
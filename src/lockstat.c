@@ -0,0 +1,96 @@
+/**
+ * @file lockstat.c
+ * @brief Lock contention metrics: registration and summaries
+ */
+
+#include <string.h>
+#include "lockstat.h"
+
+static const char *g_site_names[LOCKSTAT_SITE_COUNT] = {
+    "queue", "metrics", "membudget", "timeseries"
+};
+
+_Static_assert(LOCKSTAT_SITE_COUNT == 4, "extend g_site_names and lockstat_slots");
+
+#define LOCKSTAT_NO_SLOTS { -1, -1, -1, -1 }
+lockstat_slots_t lockstat_slots[LOCKSTAT_SITE_COUNT] = {
+    LOCKSTAT_NO_SLOTS, LOCKSTAT_NO_SLOTS, LOCKSTAT_NO_SLOTS, LOCKSTAT_NO_SLOTS
+};
+
+static int g_acquisitions_metric = -1;
+static int g_contentions_metric = -1;
+static int g_wait_metric = -1;
+static int g_hold_metric = -1;
+
+/* Slots are written once, before any thread records; resets clear values only */
+static pthread_once_t g_register_once = PTHREAD_ONCE_INIT;
+
+static void register_metrics(void) {
+    static const registry_desc_t acquisitions = {
+        .name = "lock_acquisitions", .help = "Mutex acquisitions by lock site.",
+        .type = REGISTRY_COUNTER,
+        .label = "site", .label_values = g_site_names, .label_count = LOCKSTAT_SITE_COUNT
+    };
+    static const registry_desc_t contentions = {
+        .name = "lock_contentions", .help = "Mutex acquisitions that had to wait, by lock site.",
+        .type = REGISTRY_COUNTER,
+        .label = "site", .label_values = g_site_names, .label_count = LOCKSTAT_SITE_COUNT
+    };
+    static const registry_desc_t wait = {
+        .name = "lock_wait_ns", .family = "lock_wait_nanoseconds",
+        .help = "Wait time of contended mutex acquisitions.", .unit = "nanoseconds",
+        .type = REGISTRY_HISTOGRAM,
+        .label = "site", .label_values = g_site_names, .label_count = LOCKSTAT_SITE_COUNT
+    };
+    static const registry_desc_t hold = {
+        .name = "lock_hold_ns", .family = "lock_hold_nanoseconds",
+        .help = "Time a mutex was held per acquisition.", .unit = "nanoseconds",
+        .type = REGISTRY_HISTOGRAM,
+        .label = "site", .label_values = g_site_names, .label_count = LOCKSTAT_SITE_COUNT
+    };
+    g_acquisitions_metric = registry_register(&acquisitions);
+    g_contentions_metric = registry_register(&contentions);
+    g_wait_metric = registry_register(&wait);
+    g_hold_metric = registry_register(&hold);
+    for (int s = 0; s < LOCKSTAT_SITE_COUNT; s++) {
+        lockstat_slots[s].acquisitions = registry_counter_slot(g_acquisitions_metric, s);
+        lockstat_slots[s].contentions = registry_counter_slot(g_contentions_metric, s);
+        lockstat_slots[s].wait = registry_counter_slot(g_wait_metric, s);
+        lockstat_slots[s].hold = registry_counter_slot(g_hold_metric, s);
+    }
+}
+
+void lockstat_register(void) {
+    pthread_once(&g_register_once, register_metrics);
+}
+
+int lockstat_mutex_init(lockstat_mutex_t *m, lockstat_site_t site) {
+    m->site = site;
+    m->acquired_ticks = 0;
+    return pthread_mutex_init(&m->mutex, NULL);
+}
+
+void lockstat_mutex_destroy(lockstat_mutex_t *m) {
+    pthread_mutex_destroy(&m->mutex);
+}
+
+void lockstat_summarize(const registry_snapshot_t *snapshot, lockstat_site_t site,
+                        lockstat_summary_t *summary) {
+    if (summary == NULL) return;
+    memset(summary, 0, sizeof(*summary));
+    if (snapshot == NULL || site < 0 || site >= LOCKSTAT_SITE_COUNT) return;
+
+    summary->acquisitions = registry_value(snapshot, g_acquisitions_metric, site);
+    summary->contentions = registry_value(snapshot, g_contentions_metric, site);
+    summary->wait_ns = registry_sum(snapshot, g_wait_metric, site);
+    summary->wait_p50_ns = registry_quantile(snapshot, g_wait_metric, site, 0.50);
+    summary->wait_p99_ns = registry_quantile(snapshot, g_wait_metric, site, 0.99);
+    summary->hold_ns = registry_sum(snapshot, g_hold_metric, site);
+    summary->hold_p50_ns = registry_quantile(snapshot, g_hold_metric, site, 0.50);
+    summary->hold_p99_ns = registry_quantile(snapshot, g_hold_metric, site, 0.99);
+}
+
+const char* lockstat_site_name(lockstat_site_t site) {
+    if (site < 0 || site >= LOCKSTAT_SITE_COUNT) return "unknown";
+    return g_site_names[site];
+}
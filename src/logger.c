@@ -3,10 +3,74 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
 #include "logger.h"
 
 static logger_config_t *global_logger = NULL;
 
+int g_logger_min_level = LOG_CRITICAL + 1;
+
+/* Per-thread cache of the formatted wall-clock second */
+static _Thread_local time_t tls_ts_second = (time_t)-1;
+static _Thread_local char tls_ts_text[32];
+static _Thread_local size_t tls_ts_len;
+
+/* ============================================================================
+ * Async State
+ * ============================================================================ */
+
+/**
+ * @brief Single-producer/single-consumer byte ring owned by one thread
+ *
+ * The owning thread advances head, the writer thread advances tail.
+ * Both are monotonically increasing byte counts; offsets are taken
+ * modulo capacity (a power of two).
+ */
+typedef struct {
+    _Atomic uint64_t head;      /* Bytes produced */
+    _Atomic uint64_t tail;      /* Bytes written out */
+    size_t capacity;            /* Ring size in bytes (power of two) */
+    char *data;
+} log_ring_t;
+
+static _Atomic(log_ring_t *) g_rings[LOGGER_ASYNC_MAX_THREADS];
+static _Atomic int g_ring_count;
+static size_t g_ring_capacity;
+static log_overflow_policy_t g_overflow_policy;
+static _Atomic int g_async_active;
+static _Atomic int g_async_generation;
+static _Atomic int g_writer_running;
+static _Atomic uint64_t g_dropped;
+static _Atomic uint64_t g_ring_bytes;   /* Ring structs + data currently allocated */
+static _Atomic uint64_t g_ring_allocs;
+static pthread_t g_writer_thread;
+static int g_out_fd = -1;
+static void (*g_writer_on_start)(void);
+static void (*g_writer_on_exit)(void);
+
+/* Serializes direct writes from threads that found no free ring slot */
+static pthread_mutex_t g_fallback_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Fatal-signal flush state */
+static const int fatal_signals[] = { SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGILL };
+#define NUM_FATAL_SIGNALS (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+static struct sigaction g_prev_fatal_actions[NUM_FATAL_SIGNALS];
+static atomic_flag g_fatal_flushing = ATOMIC_FLAG_INIT;
+
+/* Held by whoever is draining the rings (writer thread or fatal handler) */
+static atomic_flag g_drain_owned = ATOMIC_FLAG_INIT;
+#define FATAL_DRAIN_WAIT_TRIES 100      /* x 1ms for the writer to finish its batch */
+
+/* Per-thread ring; stale once g_async_generation moves on */
+static _Thread_local log_ring_t *tls_ring;
+static _Thread_local int tls_ring_generation;
+
 static const char *log_level_to_string(log_level_t level) {
     switch (level) {
         case LOG_DEBUG: return "DEBUG";
@@ -29,6 +93,391 @@ static const char *get_color_code(log_level_t level) {
     }
 }
 
+/* ============================================================================
+ * Output Helpers
+ * ============================================================================ */
+
+/**
+ * @brief Write an iovec array completely (async-signal-safe)
+ */
+static void write_all_iov(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t written = writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+}
+
+/**
+ * @brief Drain every registered ring with a single batched writev()
+ *
+ * @return Number of bytes written
+ */
+static size_t drain_all_rings(void) {
+    struct iovec iov[LOGGER_ASYNC_MAX_THREADS * 2];
+    uint64_t new_tail[LOGGER_ASYNC_MAX_THREADS];
+    log_ring_t *rings[LOGGER_ASYNC_MAX_THREADS];
+    int iovcnt = 0;
+    int ring_total = 0;
+    size_t total = 0;
+
+    int count = atomic_load_explicit(&g_ring_count, memory_order_acquire);
+    if (count > LOGGER_ASYNC_MAX_THREADS) count = LOGGER_ASYNC_MAX_THREADS;
+
+    for (int i = 0; i < count; i++) {
+        log_ring_t *ring = atomic_load_explicit(&g_rings[i], memory_order_acquire);
+        if (ring == NULL) continue;
+
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (head == tail) continue;
+
+        size_t len = (size_t)(head - tail);
+        size_t off = (size_t)(tail & (ring->capacity - 1));
+        size_t first = len < ring->capacity - off ? len : ring->capacity - off;
+
+        iov[iovcnt].iov_base = ring->data + off;
+        iov[iovcnt].iov_len = first;
+        iovcnt++;
+        if (first < len) {
+            iov[iovcnt].iov_base = ring->data;
+            iov[iovcnt].iov_len = len - first;
+            iovcnt++;
+        }
+
+        rings[ring_total] = ring;
+        new_tail[ring_total] = head;
+        ring_total++;
+        total += len;
+    }
+
+    if (iovcnt == 0) return 0;
+
+    write_all_iov(g_out_fd, iov, iovcnt);
+
+    for (int i = 0; i < ring_total; i++) {
+        atomic_store_explicit(&rings[i]->tail, new_tail[i], memory_order_release);
+    }
+    return total;
+}
+
+/**
+ * @brief Drain the rings unless the fatal handler has taken them over
+ */
+static size_t drain_if_owner(void) {
+    if (atomic_flag_test_and_set_explicit(&g_drain_owned, memory_order_acquire)) {
+        return 0;
+    }
+    size_t total = drain_all_rings();
+    atomic_flag_clear_explicit(&g_drain_owned, memory_order_release);
+    return total;
+}
+
+static void* logger_writer_thread(void *arg) {
+    (void)arg;
+    struct timespec idle = { 0, 1000000 };  /* 1ms */
+
+    if (g_writer_on_start != NULL) {
+        g_writer_on_start();
+    }
+
+    while (atomic_load_explicit(&g_writer_running, memory_order_acquire)) {
+        if (drain_if_owner() == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    /* Final drain after producers have been told to stop */
+    drain_if_owner();
+
+    if (g_writer_on_exit != NULL) {
+        g_writer_on_exit();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Flush queued lines, then hand the signal to the previous action
+ *
+ * The handler takes the rings over from the writer (waiting briefly for
+ * a batch in flight) and never gives them back, so no line is written
+ * twice. If the writer itself faulted mid-drain, the flush is skipped.
+ * The signal stays blocked until the handler returns, so the re-raised
+ * one is delivered to the restored action right after.
+ */
+static void logger_fatal_handler(int signum) {
+    if (!atomic_flag_test_and_set(&g_fatal_flushing)) {
+        struct timespec wait = { 0, 1000000 };  /* 1ms */
+        for (int i = 0; i < FATAL_DRAIN_WAIT_TRIES; i++) {
+            if (!atomic_flag_test_and_set_explicit(&g_drain_owned, memory_order_acquire)) {
+                drain_all_rings();
+                break;
+            }
+            nanosleep(&wait, NULL);
+        }
+    }
+
+    for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++) {
+        if (fatal_signals[i] == signum) {
+            sigaction(signum, &g_prev_fatal_actions[i], NULL);
+            break;
+        }
+    }
+    raise(signum);
+}
+
+/**
+ * @brief Get (or lazily allocate) the calling thread's ring
+ *
+ * @return Ring, or NULL if all LOGGER_ASYNC_MAX_THREADS slots are taken
+ */
+static log_ring_t* ring_for_current_thread(void) {
+    int generation = atomic_load_explicit(&g_async_generation, memory_order_acquire);
+    if (tls_ring_generation == generation) {
+        return tls_ring;
+    }
+
+    tls_ring = NULL;
+    tls_ring_generation = generation;
+
+    int idx = atomic_fetch_add(&g_ring_count, 1);
+    if (idx >= LOGGER_ASYNC_MAX_THREADS) {
+        return NULL;
+    }
+
+    log_ring_t *ring = (log_ring_t *)calloc(1, sizeof(log_ring_t));
+    if (ring == NULL) return NULL;
+    ring->data = (char *)malloc(g_ring_capacity);
+    if (ring->data == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = g_ring_capacity;
+    atomic_fetch_add(&g_ring_bytes, sizeof(log_ring_t) + g_ring_capacity);
+    atomic_fetch_add(&g_ring_allocs, 1);
+    atomic_store_explicit(&g_rings[idx], ring, memory_order_release);
+
+    tls_ring = ring;
+    return ring;
+}
+
+/**
+ * @brief Copy a formatted line into a ring, honouring the overflow policy
+ */
+static void ring_push(log_ring_t *ring, const char *line, size_t len) {
+    if (len > ring->capacity) {
+        /* Cannot happen for single lines; count the cut so it is not silent */
+        atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+        len = ring->capacity;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->capacity - (size_t)(head - tail) >= len) break;
+
+        if (g_overflow_policy == LOG_OVERFLOW_DROP ||
+            !atomic_load_explicit(&g_writer_running, memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        sched_yield();
+    }
+
+    size_t off = (size_t)(head & (ring->capacity - 1));
+    size_t first = len < ring->capacity - off ? len : ring->capacity - off;
+    memcpy(ring->data + off, line, first);
+    memcpy(ring->data, line + first, len - first);
+
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+}
+
+/**
+ * @brief Emit a fully formatted line through the active output path
+ */
+static void logger_emit(const char *line, size_t len) {
+    if (atomic_load_explicit(&g_async_active, memory_order_acquire)) {
+        log_ring_t *ring = ring_for_current_thread();
+        if (ring != NULL) {
+            ring_push(ring, line, len);
+            return;
+        }
+
+        /* No ring slot left for this thread: write through directly */
+        struct iovec iov = { (void *)line, len };
+        pthread_mutex_lock(&g_fallback_lock);
+        write_all_iov(g_out_fd, &iov, 1);
+        pthread_mutex_unlock(&g_fallback_lock);
+        return;
+    }
+
+    FILE *out = global_logger->output_file;
+    fwrite(line, 1, len, out);
+    fflush(out);
+}
+
+/**
+ * @brief Append printf-style text to a line buffer, clamping at capacity
+ */
+static void line_appendf(char *buf, size_t cap, size_t *len, const char *format, ...) {
+    if (*len >= cap) return;
+
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + *len, cap - *len, format, args);
+    va_end(args);
+
+    if (n > 0) {
+        *len += (size_t)n;
+        if (*len >= cap) *len = cap - 1;
+    }
+}
+
+/**
+ * @brief Append the color code and timestamp that start every line
+ */
+static void line_prefix(char *buf, size_t cap, size_t *len, log_level_t level, int use_color) {
+    if (use_color) {
+        line_appendf(buf, cap, len, "%s", get_color_code(level));
+    }
+
+    if (global_logger->use_timestamps) {
+        /* Reformat only when the second changes */
+        time_t now = time(NULL);
+        if (now != tls_ts_second) {
+            struct tm timeinfo;
+            char timestamp[24];
+            localtime_r(&now, &timeinfo);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
+            tls_ts_len = (size_t)snprintf(tls_ts_text, sizeof(tls_ts_text), "[%s] ", timestamp);
+            tls_ts_second = now;
+        }
+        if (*len + tls_ts_len < cap) {
+            memcpy(buf + *len, tls_ts_text, tls_ts_len);
+            *len += tls_ts_len;
+        }
+    }
+}
+
+/**
+ * @brief Format and emit one log line
+ *
+ * Formatting happens on the calling thread; only the finished line is
+ * handed to the output path.
+ */
+static void logger_vlog(log_level_t level, uint64_t suppressed, const char *format, va_list args) {
+    static const char reset[] = "\033[0m";
+    char line[LOGGER_LINE_MAX];
+    size_t len = 0;
+    int use_color = global_logger->use_colors && global_logger->output_file == stdout;
+
+    /* Room for "\n" plus the color reset suffix */
+    size_t suffix_len = 1 + (use_color ? sizeof(reset) - 1 : 0);
+    size_t body_cap = sizeof(line) - suffix_len;
+
+    line_prefix(line, body_cap, &len, level, use_color);
+    line_appendf(line, body_cap, &len, "[%s] ", log_level_to_string(level));
+
+    if (len < body_cap - 1) {
+        int n = vsnprintf(line + len, body_cap - len, format, args);
+        if (n > 0) {
+            len += (size_t)n;
+            if (len >= body_cap) len = body_cap - 1;
+        }
+    }
+
+    if (suppressed > 0) {
+        line_appendf(line, body_cap, &len, " (suppressed %llu similar messages)",
+                     (unsigned long long)suppressed);
+    }
+
+    line[len++] = '\n';
+    if (use_color) {
+        memcpy(line + len, reset, sizeof(reset) - 1);
+        len += sizeof(reset) - 1;
+    }
+
+    logger_emit(line, len);
+}
+
+/* ============================================================================
+ * Rate Limiting
+ * ============================================================================ */
+
+#define RL_TOKEN_BITS 16
+#define RL_TOKEN_MASK ((1ULL << RL_TOKEN_BITS) - 1)
+
+static uint64_t ratelimit_now_ms(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    /* Offset by one so a zero state means "never used" */
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000 + 1;
+}
+
+int logger_ratelimit_allow(logger_ratelimit_t *rl, uint32_t per_sec, uint32_t burst,
+                           uint64_t *suppressed) {
+    if (burst == 0) burst = 1;
+    if (burst > RL_TOKEN_MASK) burst = RL_TOKEN_MASK;
+
+    uint64_t now = ratelimit_now_ms();
+    uint64_t state = atomic_load_explicit(&rl->state, memory_order_relaxed);
+
+    for (;;) {
+        uint64_t last = state >> RL_TOKEN_BITS;
+        uint64_t tokens = state & RL_TOKEN_MASK;
+
+        if (state == 0) {
+            /* First use: start with a full bucket */
+            last = now;
+            tokens = burst;
+        } else if (per_sec > 0 && now > last) {
+            uint64_t refill = (now - last) * per_sec / 1000;
+            if (refill > 0) {
+                tokens = tokens + refill > burst ? burst : tokens + refill;
+                /* Keep the fractional remainder unless the bucket is full */
+                last = tokens == burst ? now : last + refill * 1000 / per_sec;
+            }
+        }
+
+        if (tokens == 0) {
+            uint64_t refreshed = (last << RL_TOKEN_BITS);
+            if (refreshed != state &&
+                !atomic_compare_exchange_weak(&rl->state, &state, refreshed)) {
+                continue;
+            }
+            atomic_fetch_add_explicit(&rl->suppressed, 1, memory_order_relaxed);
+            return 0;
+        }
+
+        uint64_t next = (last << RL_TOKEN_BITS) | (tokens - 1);
+        if (atomic_compare_exchange_weak(&rl->state, &state, next)) {
+            break;
+        }
+    }
+
+    *suppressed = atomic_exchange_explicit(&rl->suppressed, 0, memory_order_relaxed);
+    return 1;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
 void logger_init(const char *log_file, log_level_t min_level) {
     if (global_logger != NULL) {
         logger_cleanup();
@@ -51,170 +500,222 @@ void logger_init(const char *log_file, log_level_t min_level) {
     }
 
     global_logger->min_level = min_level;
+    g_logger_min_level = (int)min_level;
     global_logger->use_colors = 1;
     global_logger->use_timestamps = 1;
 
     logger_info("Logger initialized");
 }
 
+/**
+ * @brief Stop the writer thread, flush pending lines and free the rings
+ *
+ * Callers must have stopped producing threads first; a line pushed after
+ * the final drain is lost.
+ */
+static void logger_stop_async(void) {
+    if (!atomic_load(&g_async_active)) return;
+
+    atomic_store(&g_async_active, 0);
+    atomic_store(&g_writer_running, 0);
+    pthread_join(g_writer_thread, NULL);
+
+    for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++) {
+        sigaction(fatal_signals[i], &g_prev_fatal_actions[i], NULL);
+    }
+
+    int count = atomic_load(&g_ring_count);
+    if (count > LOGGER_ASYNC_MAX_THREADS) count = LOGGER_ASYNC_MAX_THREADS;
+    for (int i = 0; i < count; i++) {
+        log_ring_t *ring = atomic_exchange(&g_rings[i], NULL);
+        if (ring != NULL) {
+            atomic_fetch_sub(&g_ring_bytes, sizeof(log_ring_t) + ring->capacity);
+            free(ring->data);
+            free(ring);
+        }
+    }
+    atomic_store(&g_ring_count, 0);
+    atomic_fetch_add(&g_async_generation, 1);
+
+    uint64_t dropped = atomic_load(&g_dropped);
+    if (dropped > 0) {
+        logger_warn("Async logger dropped %llu lines (ring full)", (unsigned long long)dropped);
+    }
+}
+
 void logger_cleanup(void) {
     if (global_logger == NULL) return;
 
+    logger_stop_async();
+
     if (global_logger->output_file != NULL && global_logger->output_file != stdout) {
         fclose(global_logger->output_file);
     }
 
     free(global_logger);
     global_logger = NULL;
+    g_logger_min_level = LOG_CRITICAL + 1;
 }
 
-void logger_log(log_level_t level, const char *format, ...) {
+int logger_start_async(size_t memory_budget, log_overflow_policy_t policy) {
     if (global_logger == NULL) {
         logger_init(NULL, LOG_INFO);
     }
+    if (global_logger == NULL) return -1;
+    if (atomic_load(&g_async_active)) return 0;
 
-    if (level < global_logger->min_level) {
-        return;
+    if (memory_budget == 0) {
+        memory_budget = LOGGER_ASYNC_DEFAULT_BUDGET;
+    }
+    if (memory_budget < LOGGER_ASYNC_MIN_BUDGET) {
+        logger_error("Async log budget of %zu bytes is below the minimum of %d (%d threads x %d-byte lines)",
+                     memory_budget, LOGGER_ASYNC_MIN_BUDGET, LOGGER_ASYNC_MAX_THREADS, LOGGER_LINE_MAX);
+        return -1;
     }
 
-    va_list args;
-    va_start(args, format);
+    /* Largest power-of-two ring that keeps all slots within the budget */
+    size_t capacity = LOGGER_LINE_MAX;
+    while (capacity * 2 * LOGGER_ASYNC_MAX_THREADS <= memory_budget) {
+        capacity *= 2;
+    }
 
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
+    fflush(global_logger->output_file);
+    g_out_fd = fileno(global_logger->output_file);
+    g_ring_capacity = capacity;
+    g_overflow_policy = policy;
+    atomic_store(&g_dropped, 0);
+    atomic_store(&g_ring_allocs, 0);
+    atomic_store(&g_ring_count, 0);
+    atomic_flag_clear(&g_fatal_flushing);
+    atomic_flag_clear(&g_drain_owned);
+    atomic_fetch_add(&g_async_generation, 1);
+
+    atomic_store(&g_writer_running, 1);
+    if (pthread_create(&g_writer_thread, NULL, logger_writer_thread, NULL) != 0) {
+        atomic_store(&g_writer_running, 0);
+        logger_error("Failed to start async logger thread");
+        return -1;
+    }
 
-    FILE *out = global_logger->output_file;
-    const char *level_str = log_level_to_string(level);
+    /* Flush queued lines before the process dies on a fatal signal */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = logger_fatal_handler;
+    sigemptyset(&sa.sa_mask);
+    for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++) {
+        sigaction(fatal_signals[i], &sa, &g_prev_fatal_actions[i]);
+    }
+
+    atomic_store(&g_async_active, 1);
+    logger_info("Async logger started (%zu KB ring per thread, up to %d threads, overflow=%s)",
+                capacity / 1024, LOGGER_ASYNC_MAX_THREADS,
+                policy == LOG_OVERFLOW_BLOCK ? "block" : "drop");
+    return 0;
+}
+
+void logger_flush(void) {
+    if (global_logger == NULL) return;
 
-    if (global_logger->use_colors && out == stdout) {
-        fprintf(out, "%s", get_color_code(level));
+    if (!atomic_load(&g_async_active)) {
+        fflush(global_logger->output_file);
+        return;
     }
 
-    if (global_logger->use_timestamps) {
-        fprintf(out, "[%s] ", timestamp);
+    /* Wait for the writer to catch up with everything queued so far */
+    int count = atomic_load(&g_ring_count);
+    if (count > LOGGER_ASYNC_MAX_THREADS) count = LOGGER_ASYNC_MAX_THREADS;
+    struct timespec wait = { 0, 100000 };  /* 100µs */
+
+    for (int i = 0; i < count; i++) {
+        log_ring_t *ring = atomic_load(&g_rings[i]);
+        if (ring == NULL) continue;
+        uint64_t target = atomic_load(&ring->head);
+        while (atomic_load(&ring->tail) < target && atomic_load(&g_writer_running)) {
+            nanosleep(&wait, NULL);
+        }
     }
+}
+
+uint64_t logger_dropped_count(void) {
+    return atomic_load(&g_dropped);
+}
 
-    fprintf(out, "[%s] ", level_str);
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
+void logger_set_writer_hooks(void (*on_start)(void), void (*on_exit)(void)) {
+    g_writer_on_start = on_start;
+    g_writer_on_exit = on_exit;
+}
+
+void logger_memory_usage(uint64_t *bytes, uint64_t *allocs) {
+    if (bytes != NULL) *bytes = atomic_load(&g_ring_bytes);
+    if (allocs != NULL) *allocs = atomic_load(&g_ring_allocs);
+}
+
+void logger_log(log_level_t level, const char *format, ...) {
+    if (global_logger == NULL) {
+        logger_init(NULL, LOG_INFO);
+    }
 
-    if (global_logger->use_colors && out == stdout) {
-        fprintf(out, "\033[0m");
+    if (level < global_logger->min_level) {
+        return;
     }
 
-    fflush(out);
+    va_list args;
+    va_start(args, format);
+    logger_vlog(level, 0, format, args);
+    va_end(args);
+}
+
+void logger_log_suppressed(log_level_t level, uint64_t suppressed, const char *format, ...) {
+    if (global_logger == NULL || (level < global_logger->min_level && level != LOG_CRITICAL)) return;
+
+    va_list args;
+    va_start(args, format);
+    logger_vlog(level, suppressed, format, args);
     va_end(args);
 }
 
 void logger_debug(const char *format, ...) {
     if (global_logger == NULL || global_logger->min_level > LOG_DEBUG) return;
-    
+
     va_list args;
     va_start(args, format);
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_DEBUG));
-    if (global_logger->use_timestamps) fprintf(out, "[%s] ", timestamp);
-    fprintf(out, "[DEBUG] ");
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    logger_vlog(LOG_DEBUG, 0, format, args);
     va_end(args);
 }
 
 void logger_info(const char *format, ...) {
     if (global_logger == NULL || global_logger->min_level > LOG_INFO) return;
-    
+
     va_list args;
     va_start(args, format);
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_INFO));
-    if (global_logger->use_timestamps) fprintf(out, "[%s] ", timestamp);
-    fprintf(out, "[INFO] ");
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    logger_vlog(LOG_INFO, 0, format, args);
     va_end(args);
 }
 
 void logger_warn(const char *format, ...) {
     if (global_logger == NULL || global_logger->min_level > LOG_WARN) return;
-    
+
     va_list args;
     va_start(args, format);
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_WARN));
-    if (global_logger->use_timestamps) fprintf(out, "[%s] ", timestamp);
-    fprintf(out, "[WARN] ");
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    logger_vlog(LOG_WARN, 0, format, args);
     va_end(args);
 }
 
 void logger_error(const char *format, ...) {
     if (global_logger == NULL || global_logger->min_level > LOG_ERROR) return;
-    
+
     va_list args;
     va_start(args, format);
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_ERROR));
-    if (global_logger->use_timestamps) fprintf(out, "[%s] ", timestamp);
-    fprintf(out, "[ERROR] ");
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    logger_vlog(LOG_ERROR, 0, format, args);
     va_end(args);
 }
 
 void logger_critical(const char *format, ...) {
     if (global_logger == NULL) return;
-    
+
     va_list args;
     va_start(args, format);
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_CRITICAL));
-    if (global_logger->use_timestamps) fprintf(out, "[%s] ", timestamp);
-    fprintf(out, "[CRITICAL] ");
-    vfprintf(out, format, args);
-    fprintf(out, "\n");
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    logger_vlog(LOG_CRITICAL, 0, format, args);
     va_end(args);
 }
 
@@ -222,34 +723,42 @@ void logger_hexdump(const char *label, const uint8_t *data, size_t length) {
     if (global_logger == NULL || global_logger->min_level > LOG_DEBUG) return;
     if (data == NULL || length == 0) return;
 
-    FILE *out = global_logger->output_file;
-    if (global_logger->use_colors && out == stdout) fprintf(out, "%s", get_color_code(LOG_DEBUG));
-    if (global_logger->use_timestamps) {
-        time_t now = time(NULL);
-        struct tm *timeinfo = localtime(&now);
-        char timestamp[32];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-        fprintf(out, "[%s] ", timestamp);
+    /* Build the dump in chunks so async output keeps its rows together;
+     * a chunk never exceeds the ring it is pushed into */
+    char buf[LOGGER_LINE_MAX * 4];
+    size_t chunk_max = sizeof(buf);
+    if (atomic_load_explicit(&g_async_active, memory_order_acquire) && g_ring_capacity < chunk_max) {
+        chunk_max = g_ring_capacity;
     }
-    fprintf(out, "[HEXDUMP] %s:\n", label);
+    size_t len = 0;
+    int use_color = global_logger->use_colors && global_logger->output_file == stdout;
+
+    line_prefix(buf, chunk_max, &len, LOG_DEBUG, use_color);
+    line_appendf(buf, chunk_max, &len, "[HEXDUMP] %s:\n", label);
 
     for (size_t i = 0; i < length; i += 16) {
-        fprintf(out, "  %04zx: ", i);
-        
+        /* Each row is under 96 bytes; flush before it could overflow */
+        if (chunk_max - len < 128) {
+            logger_emit(buf, len);
+            len = 0;
+        }
+
+        line_appendf(buf, chunk_max, &len, "  %04zx: ", i);
+
         for (size_t j = 0; j < 16 && i + j < length; j++) {
-            fprintf(out, "%02x ", data[i + j]);
+            line_appendf(buf, chunk_max, &len, "%02x ", data[i + j]);
         }
-        
-        fprintf(out, " | ");
-        
+
+        line_appendf(buf, chunk_max, &len, " | ");
+
         for (size_t j = 0; j < 16 && i + j < length; j++) {
             unsigned char c = data[i + j];
-            fprintf(out, "%c", (c >= 32 && c < 127) ? c : '.');
+            buf[len++] = (c >= 32 && c < 127) ? (char)c : '.';
         }
-        
-        fprintf(out, "\n");
+
+        buf[len++] = '\n';
     }
 
-    if (global_logger->use_colors && out == stdout) fprintf(out, "\033[0m");
-    fflush(out);
+    if (use_color) line_appendf(buf, chunk_max, &len, "\033[0m");
+    logger_emit(buf, len);
 }
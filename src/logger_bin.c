@@ -0,0 +1,645 @@
+/**
+ * @file logger_bin.c
+ * @brief Binary deferred-format logging and decoder
+ *
+ * File layout (host byte order):
+ *   header: magic[8], uint32 version, uint32 byte-order mark,
+ *           uint64 wall-clock ns at open, uint64 monotonic ns at open
+ *   records: uint8 type followed by
+ *     SITE:  uint32 id, uint8 level, uint8 nargs, uint8 types[nargs],
+ *            uint32 line, uint16 file_len, file, uint16 fmt_len, fmt
+ *     EVENT: uint32 id, uint16 thread, uint64 monotonic ns, packed args
+ *
+ * Site records are written directly under the file lock when a site is
+ * first used, so they always precede events that reference them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdbool.h>
+#include "logger_bin.h"
+
+#define LOGGER_BIN_BOM 0x01020304u
+
+/* Largest encoded event: header plus every argument as a maximal string */
+#define LOGGER_BIN_EVENT_MAX (1 + 4 + 2 + 8 + LOGGER_BIN_MAX_ARGS * (1 + LOGGER_BIN_STR_MAX))
+
+/* Per-thread staging buffer */
+typedef struct {
+    uint8_t data[LOGGER_BIN_THREAD_BUFFER];
+    size_t len;
+    uint16_t thread;
+} bin_buffer_t;
+
+_Atomic int g_logger_bin_active = 0;
+
+static FILE *g_bin_file = NULL;
+static log_level_t g_bin_min_level = LOG_DEBUG;
+static pthread_mutex_t g_bin_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_next_site_id = 1;
+static _Atomic uint64_t g_bin_events = 0;
+
+/* Registered thread buffers, flushed by logger_bin_close() */
+static bin_buffer_t *g_bin_buffers[LOGGER_BIN_MAX_THREADS];
+static int g_bin_buffer_count = 0;
+static _Atomic uint32_t g_bin_generation = 0;
+
+static _Thread_local bin_buffer_t *tls_bin_buffer = NULL;
+static _Thread_local uint32_t tls_bin_generation = 0;
+
+static uint64_t bin_clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * Format Parsing
+ * ============================================================================ */
+
+/**
+ * @brief Locate the next conversion in a format string
+ *
+ * @param p Position to scan from
+ * @param spec_start Receives the '%' of the conversion
+ * @param length Receives the length modifier ("", "h", "hh", "l", ...)
+ * @param star_count Receives the number of '*' width/precision arguments
+ * @return Pointer to the conversion character, or NULL at end of string
+ */
+static const char *next_conversion(const char *p, const char **spec_start,
+                                   char length[3], int *star_count) {
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+
+        *spec_start = p++;
+        *star_count = 0;
+        while (*p && strchr("-+ #0'", *p)) p++;
+        if (*p == '*') { (*star_count)++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p == '.') {
+            p++;
+            if (*p == '*') { (*star_count)++; p++; }
+            while (*p >= '0' && *p <= '9') p++;
+        }
+
+        int n = 0;
+        while (*p && strchr("hljztL", *p) && n < 2) {
+            length[n++] = *p++;
+        }
+        length[n] = '\0';
+        return *p ? p : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Map a conversion to its argument encoding (0 if unsupported)
+ */
+static uint8_t conversion_type(char conv, const char *length) {
+    if (strchr("diouxXc", conv)) {
+        if (strcmp(length, "l") == 0) return BIN_ARG_LONG;
+        if (strcmp(length, "ll") == 0) return BIN_ARG_LLONG;
+        if (strcmp(length, "z") == 0) return BIN_ARG_SIZE;
+        if (strcmp(length, "j") == 0) return BIN_ARG_INTMAX;
+        if (strcmp(length, "t") == 0) return BIN_ARG_PTRDIFF;
+        if (length[0] == '\0' || length[0] == 'h') return BIN_ARG_INT;
+        return 0;
+    }
+    if (strchr("fFeEgGaA", conv)) {
+        return (length[0] == '\0' || strcmp(length, "l") == 0) ? BIN_ARG_DOUBLE : 0;
+    }
+    if (conv == 's' && length[0] == '\0') return BIN_ARG_STRING;
+    if (conv == 'p' && length[0] == '\0') return BIN_ARG_PTR;
+    return 0;
+}
+
+/**
+ * @brief Derive a site's argument types from its format string
+ */
+static void parse_site_format(logger_bin_site_t *site) {
+    const char *p = site->format;
+    const char *spec;
+    char length[3];
+    int stars;
+    int nargs = 0;
+
+    while ((p = next_conversion(p, &spec, length, &stars)) != NULL) {
+        uint8_t type = conversion_type(*p, length);
+        if (type == 0 || nargs + stars + 1 > LOGGER_BIN_MAX_ARGS) {
+            site->nargs = -1;
+            return;
+        }
+        for (int i = 0; i < stars; i++) {
+            site->arg_types[nargs++] = BIN_ARG_INT;
+        }
+        site->arg_types[nargs++] = type;
+        p++;
+    }
+    site->nargs = nargs;
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+/**
+ * @brief Write a buffer to the file (caller holds g_bin_lock)
+ */
+static void bin_write_locked(const uint8_t *data, size_t len) {
+    if (g_bin_file != NULL && len > 0) {
+        fwrite(data, 1, len, g_bin_file);
+    }
+}
+
+/**
+ * @brief Assign an id to a site and write its definition record
+ *
+ * @return The site id, 0 if no log is open, UINT32_MAX if unsupported
+ */
+static uint32_t register_site(logger_bin_site_t *site) {
+    bool unsupported = false;
+
+    pthread_mutex_lock(&g_bin_lock);
+
+    uint32_t generation = atomic_load(&g_bin_generation);
+    uint32_t id = atomic_load(&site->id);
+    if (atomic_load(&site->generation) != generation && g_bin_file != NULL) {
+        parse_site_format(site);
+        if (site->nargs < 0) {
+            id = UINT32_MAX;
+            unsupported = true;
+        } else {
+            id = g_next_site_id++;
+
+            uint8_t rec_type = LOGGER_BIN_REC_SITE;
+            uint8_t level = (uint8_t)site->level;
+            uint8_t nargs = (uint8_t)site->nargs;
+            uint32_t line = (uint32_t)site->line;
+            uint16_t file_len = (uint16_t)strlen(site->file);
+            uint16_t fmt_len = (uint16_t)strlen(site->format);
+
+            fwrite(&rec_type, 1, 1, g_bin_file);
+            fwrite(&id, sizeof(id), 1, g_bin_file);
+            fwrite(&level, 1, 1, g_bin_file);
+            fwrite(&nargs, 1, 1, g_bin_file);
+            fwrite(site->arg_types, 1, nargs, g_bin_file);
+            fwrite(&line, sizeof(line), 1, g_bin_file);
+            fwrite(&file_len, sizeof(file_len), 1, g_bin_file);
+            fwrite(site->file, 1, file_len, g_bin_file);
+            fwrite(&fmt_len, sizeof(fmt_len), 1, g_bin_file);
+            fwrite(site->format, 1, fmt_len, g_bin_file);
+        }
+        atomic_store(&site->id, id);
+        atomic_store_explicit(&site->generation, generation, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&g_bin_lock);
+
+    if (unsupported) {
+        logger_warn("Binary log: unsupported format at %s:%d, site skipped",
+                    site->file, site->line);
+    }
+    return id;
+}
+
+/**
+ * @brief Get (or create) the calling thread's staging buffer
+ *
+ * Returns NULL when all buffer slots are taken; such threads write
+ * each event directly under the file lock.
+ */
+static bin_buffer_t *thread_buffer(void) {
+    uint32_t generation = atomic_load_explicit(&g_bin_generation, memory_order_acquire);
+    if (tls_bin_buffer != NULL && tls_bin_generation == generation) {
+        return tls_bin_buffer;
+    }
+
+    tls_bin_buffer = NULL;
+    tls_bin_generation = generation;
+
+    pthread_mutex_lock(&g_bin_lock);
+    if (g_bin_buffer_count < LOGGER_BIN_MAX_THREADS) {
+        bin_buffer_t *buffer = malloc(sizeof(bin_buffer_t));
+        if (buffer != NULL) {
+            buffer->len = 0;
+            buffer->thread = (uint16_t)g_bin_buffer_count;
+            g_bin_buffers[g_bin_buffer_count++] = buffer;
+            tls_bin_buffer = buffer;
+        }
+    }
+    pthread_mutex_unlock(&g_bin_lock);
+
+    return tls_bin_buffer;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); return p + 4; }
+static inline uint8_t *put_u64(uint8_t *p, uint64_t v) { memcpy(p, &v, 8); return p + 8; }
+
+void logger_bin_record(logger_bin_site_t *site, ...) {
+    if (!logger_bin_active() || site->level < g_bin_min_level) return;
+
+    uint32_t id;
+    if (atomic_load_explicit(&site->generation, memory_order_acquire) ==
+        atomic_load_explicit(&g_bin_generation, memory_order_relaxed)) {
+        id = atomic_load_explicit(&site->id, memory_order_relaxed);
+    } else {
+        id = register_site(site);
+    }
+    if (id == 0 || id == UINT32_MAX) return;
+
+    bin_buffer_t *buffer = thread_buffer();
+    uint8_t scratch[LOGGER_BIN_EVENT_MAX];
+    uint8_t *start;
+
+    if (buffer != NULL) {
+        if (buffer->len + LOGGER_BIN_EVENT_MAX > sizeof(buffer->data)) {
+            pthread_mutex_lock(&g_bin_lock);
+            bin_write_locked(buffer->data, buffer->len);
+            pthread_mutex_unlock(&g_bin_lock);
+            buffer->len = 0;
+        }
+        start = buffer->data + buffer->len;
+    } else {
+        start = scratch;
+    }
+
+    uint8_t *p = start;
+    uint16_t thread = buffer != NULL ? buffer->thread : UINT16_MAX;
+    *p++ = LOGGER_BIN_REC_EVENT;
+    p = put_u32(p, id);
+    memcpy(p, &thread, 2);
+    p += 2;
+    p = put_u64(p, bin_clock_ns(CLOCK_MONOTONIC));
+
+    va_list args;
+    va_start(args, site);
+    for (int i = 0; i < site->nargs; i++) {
+        switch (site->arg_types[i]) {
+            case BIN_ARG_INT:
+                p = put_u32(p, (uint32_t)va_arg(args, int));
+                break;
+            case BIN_ARG_LONG:
+                p = put_u64(p, (uint64_t)va_arg(args, long));
+                break;
+            case BIN_ARG_LLONG:
+                p = put_u64(p, (uint64_t)va_arg(args, long long));
+                break;
+            case BIN_ARG_SIZE:
+                p = put_u64(p, (uint64_t)va_arg(args, size_t));
+                break;
+            case BIN_ARG_INTMAX:
+                p = put_u64(p, (uint64_t)va_arg(args, intmax_t));
+                break;
+            case BIN_ARG_PTRDIFF:
+                p = put_u64(p, (uint64_t)va_arg(args, ptrdiff_t));
+                break;
+            case BIN_ARG_DOUBLE: {
+                double d = va_arg(args, double);
+                memcpy(p, &d, 8);
+                p += 8;
+                break;
+            }
+            case BIN_ARG_PTR:
+                p = put_u64(p, (uint64_t)(uintptr_t)va_arg(args, void *));
+                break;
+            case BIN_ARG_STRING: {
+                const char *s = va_arg(args, const char *);
+                if (s == NULL) s = "(null)";
+                size_t n = strnlen(s, LOGGER_BIN_STR_MAX);
+                *p++ = (uint8_t)n;
+                memcpy(p, s, n);
+                p += n;
+                break;
+            }
+        }
+    }
+    va_end(args);
+
+    if (buffer != NULL) {
+        buffer->len += (size_t)(p - start);
+    } else {
+        pthread_mutex_lock(&g_bin_lock);
+        bin_write_locked(start, (size_t)(p - start));
+        pthread_mutex_unlock(&g_bin_lock);
+    }
+
+    atomic_fetch_add_explicit(&g_bin_events, 1, memory_order_relaxed);
+}
+
+/* ============================================================================
+ * Open / Close
+ * ============================================================================ */
+
+int logger_bin_open(const char *filepath, log_level_t min_level) {
+    if (filepath == NULL) return -1;
+    if (logger_bin_active()) {
+        logger_error("Binary log already open");
+        return -1;
+    }
+
+    FILE *fp = fopen(filepath, "wb");
+    if (fp == NULL) {
+        logger_error("Failed to open binary log: %s", filepath);
+        return -1;
+    }
+
+    char magic[8] = LOGGER_BIN_MAGIC;
+    uint32_t version = LOGGER_BIN_VERSION;
+    uint32_t bom = LOGGER_BIN_BOM;
+    uint64_t wall_ns = bin_clock_ns(CLOCK_REALTIME);
+    uint64_t mono_ns = bin_clock_ns(CLOCK_MONOTONIC);
+
+    fwrite(magic, 1, sizeof(magic), fp);
+    fwrite(&version, sizeof(version), 1, fp);
+    fwrite(&bom, sizeof(bom), 1, fp);
+    fwrite(&wall_ns, sizeof(wall_ns), 1, fp);
+    fwrite(&mono_ns, sizeof(mono_ns), 1, fp);
+
+    pthread_mutex_lock(&g_bin_lock);
+    g_bin_file = fp;
+    g_bin_min_level = min_level;
+    g_bin_buffer_count = 0;
+    g_next_site_id = 1;
+    atomic_store(&g_bin_events, 0);
+    atomic_fetch_add(&g_bin_generation, 1);
+    pthread_mutex_unlock(&g_bin_lock);
+
+    atomic_store(&g_logger_bin_active, 1);
+    logger_info("Binary log enabled: %s", filepath);
+    return 0;
+}
+
+void logger_bin_close(void) {
+    if (!logger_bin_active()) return;
+    atomic_store(&g_logger_bin_active, 0);
+
+    pthread_mutex_lock(&g_bin_lock);
+    for (int i = 0; i < g_bin_buffer_count; i++) {
+        bin_write_locked(g_bin_buffers[i]->data, g_bin_buffers[i]->len);
+        free(g_bin_buffers[i]);
+        g_bin_buffers[i] = NULL;
+    }
+    g_bin_buffer_count = 0;
+    atomic_fetch_add(&g_bin_generation, 1);
+
+    fclose(g_bin_file);
+    g_bin_file = NULL;
+    pthread_mutex_unlock(&g_bin_lock);
+
+    logger_info("Binary log closed (%" PRIu64 " events)", atomic_load(&g_bin_events));
+}
+
+uint64_t logger_bin_event_count(void) {
+    return atomic_load(&g_bin_events);
+}
+
+/* ============================================================================
+ * Decoder
+ * ============================================================================ */
+
+/* Decoded site definition */
+typedef struct {
+    uint8_t level;
+    uint8_t nargs;
+    uint8_t types[LOGGER_BIN_MAX_ARGS];
+    uint32_t line;
+    char *file;
+    char *format;
+} decoded_site_t;
+
+static const char *bin_level_names[] = { "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL" };
+
+static int read_exact(FILE *in, void *dst, size_t len) {
+    return fread(dst, 1, len, in) == len ? 0 : -1;
+}
+
+static char *read_string16(FILE *in) {
+    uint16_t len;
+    if (read_exact(in, &len, sizeof(len)) != 0) return NULL;
+    char *s = malloc((size_t)len + 1);
+    if (s == NULL || read_exact(in, s, len) != 0) {
+        free(s);
+        return NULL;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+/**
+ * @brief Write format text, collapsing "%%"
+ */
+static void write_literal(FILE *out, const char *start, const char *end) {
+    for (const char *c = start; c < end; c++) {
+        fputc(*c, out);
+        if (c[0] == '%' && c[1] == '%' && c + 1 < end) c++;
+    }
+}
+
+/**
+ * @brief Render one event by formatting each conversion individually
+ *
+ * The format comes from the file, so a conversion only reaches fprintf()
+ * when it maps to the argument type recorded for it (and every '*' to an
+ * int). Anything else (%n, unknown conversions, pieces that do not match
+ * the recorded arguments) is printed literally and consumes nothing.
+ */
+static int render_event(FILE *in, const decoded_site_t *site, FILE *out) {
+    uint64_t values[LOGGER_BIN_MAX_ARGS];
+    char strings[LOGGER_BIN_MAX_ARGS][LOGGER_BIN_STR_MAX + 1];
+
+    for (int i = 0; i < site->nargs; i++) {
+        values[i] = 0;
+        if (site->types[i] == BIN_ARG_INT) {
+            uint32_t v;
+            if (read_exact(in, &v, 4) != 0) return -1;
+            values[i] = v;
+        } else if (site->types[i] == BIN_ARG_STRING) {
+            uint8_t n;
+            if (read_exact(in, &n, 1) != 0 || n > LOGGER_BIN_STR_MAX) return -1;
+            if (read_exact(in, strings[i], n) != 0) return -1;
+            strings[i][n] = '\0';
+        } else {
+            if (read_exact(in, &values[i], 8) != 0) return -1;
+        }
+    }
+
+    const char *p = site->format;
+    const char *spec;
+    const char *literal = p;
+    char length[3];
+    int stars;
+    int arg = 0;
+    char piece[64];
+
+    while ((p = next_conversion(p, &spec, length, &stars)) != NULL) {
+        write_literal(out, literal, spec);
+
+        size_t spec_len = (size_t)(p - spec) + 1;
+        bool valid = spec_len < sizeof(piece) && arg + stars < site->nargs &&
+                     conversion_type(*p, length) == site->types[arg + stars];
+        for (int s = 0; valid && s < stars; s++) {
+            valid = site->types[arg + s] == BIN_ARG_INT;
+        }
+        if (!valid) {
+            fwrite(spec, 1, spec_len, out);
+            p++;
+            literal = p;
+            continue;
+        }
+        memcpy(piece, spec, spec_len);
+        piece[spec_len] = '\0';
+
+        int star[2] = {0, 0};
+        for (int s = 0; s < stars; s++) {
+            star[s] = (int)(uint32_t)values[arg++];
+        }
+
+        uint64_t v = values[arg];
+        const char *str = strings[arg];
+        uint8_t type = site->types[arg++];
+
+#define EMIT(value) do { \
+            if (stars == 2) fprintf(out, piece, star[0], star[1], value); \
+            else if (stars == 1) fprintf(out, piece, star[0], value); \
+            else fprintf(out, piece, value); \
+        } while (0)
+
+        switch (type) {
+            case BIN_ARG_INT:     EMIT((int)(uint32_t)v); break;
+            case BIN_ARG_LONG:    EMIT((long)v); break;
+            case BIN_ARG_LLONG:   EMIT((long long)v); break;
+            case BIN_ARG_SIZE:    EMIT((size_t)v); break;
+            case BIN_ARG_INTMAX:  EMIT((intmax_t)v); break;
+            case BIN_ARG_PTRDIFF: EMIT((ptrdiff_t)v); break;
+            case BIN_ARG_DOUBLE: {
+                double d;
+                memcpy(&d, &v, sizeof(d));
+                EMIT(d);
+                break;
+            }
+            case BIN_ARG_PTR:     EMIT((void *)(uintptr_t)v); break;
+            case BIN_ARG_STRING:  EMIT(str); break;
+            default: return -1;
+        }
+#undef EMIT
+
+        p++;
+        literal = p;
+    }
+
+    write_literal(out, literal, literal + strlen(literal));
+    return 0;
+}
+
+long logger_bin_decode(FILE *in, FILE *out) {
+    char magic[8];
+    uint32_t version, bom;
+    uint64_t wall_ns, mono_ns;
+
+    if (read_exact(in, magic, sizeof(magic)) != 0 ||
+        memcmp(magic, LOGGER_BIN_MAGIC, sizeof(magic)) != 0) {
+        logger_error("Not a binary log (bad magic)");
+        return -1;
+    }
+    if (read_exact(in, &version, sizeof(version)) != 0 ||
+        read_exact(in, &bom, sizeof(bom)) != 0 ||
+        read_exact(in, &wall_ns, sizeof(wall_ns)) != 0 ||
+        read_exact(in, &mono_ns, sizeof(mono_ns)) != 0) {
+        logger_error("Truncated binary log header");
+        return -1;
+    }
+    if (version != LOGGER_BIN_VERSION || bom != LOGGER_BIN_BOM) {
+        logger_error("Unsupported binary log (version %u, byte order 0x%08x)", version, bom);
+        return -1;
+    }
+
+    decoded_site_t *sites = NULL;
+    uint32_t site_capacity = 0;
+    long events = 0;
+    int rec;
+
+    while ((rec = fgetc(in)) != EOF) {
+        uint32_t id;
+        if (read_exact(in, &id, sizeof(id)) != 0) goto malformed;
+
+        if (rec == LOGGER_BIN_REC_SITE) {
+            if (id >= site_capacity) {
+                uint32_t new_capacity = site_capacity ? site_capacity : 64;
+                while (new_capacity <= id) new_capacity *= 2;
+                decoded_site_t *grown = realloc(sites, new_capacity * sizeof(decoded_site_t));
+                if (grown == NULL) goto malformed;
+                memset(grown + site_capacity, 0, (new_capacity - site_capacity) * sizeof(decoded_site_t));
+                sites = grown;
+                site_capacity = new_capacity;
+            }
+            decoded_site_t *site = &sites[id];
+            free(site->file);
+            free(site->format);
+            site->file = site->format = NULL;
+            if (read_exact(in, &site->level, 1) != 0 ||
+                read_exact(in, &site->nargs, 1) != 0 ||
+                site->nargs > LOGGER_BIN_MAX_ARGS ||
+                read_exact(in, site->types, site->nargs) != 0 ||
+                read_exact(in, &site->line, sizeof(site->line)) != 0 ||
+                (site->file = read_string16(in)) == NULL ||
+                (site->format = read_string16(in)) == NULL) {
+                goto malformed;
+            }
+        } else if (rec == LOGGER_BIN_REC_EVENT) {
+            uint16_t thread;
+            uint64_t ts_ns;
+            if (read_exact(in, &thread, sizeof(thread)) != 0 ||
+                read_exact(in, &ts_ns, sizeof(ts_ns)) != 0) {
+                goto malformed;
+            }
+            if (id >= site_capacity || sites[id].format == NULL) goto malformed;
+
+            const decoded_site_t *site = &sites[id];
+            uint64_t event_ns = wall_ns + (ts_ns - mono_ns);
+            time_t secs = (time_t)(event_ns / 1000000000ULL);
+            struct tm tm_info;
+            char timestamp[32];
+            localtime_r(&secs, &tm_info);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+            fprintf(out, "[%s.%09" PRIu64 "] [%s] [t%u] ", timestamp,
+                    (uint64_t)(event_ns % 1000000000ULL),
+                    site->level < 5 ? bin_level_names[site->level] : "?",
+                    (unsigned)thread);
+            if (render_event(in, site, out) != 0) goto malformed;
+            fputc('\n', out);
+            events++;
+        } else {
+            goto malformed;
+        }
+    }
+
+    for (uint32_t i = 0; i < site_capacity; i++) {
+        free(sites[i].file);
+        free(sites[i].format);
+    }
+    free(sites);
+    return events;
+
+malformed:
+    logger_error("Malformed binary log after %ld events", events);
+    for (uint32_t i = 0; i < site_capacity; i++) {
+        free(sites[i].file);
+        free(sites[i].format);
+    }
+    free(sites);
+    return -1;
+}
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <time.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -13,9 +14,18 @@
 #include "socket_handler.h"
 #include "thread_pool.h"
 #include "logger.h"
+#include "logger_bin.h"
 #include "parser.h"
 #include "metrics.h"
 #include "regression.h"
+#include "membudget.h"
+#include "dump.h"
+#include "timeseries.h"
+#include "exporter.h"
+#include "shm_stats.h"
+#include "profiler.h"
+#include "anomaly.h"
+#include "probes.h"
 
 #define MAX_PACKET_SIZE 65535
 #define NUM_THREADS 4
@@ -38,6 +48,40 @@ static int stats_interval_sec = 1;     /* default 1 second, 0 = disabled */
 static uint32_t min_packets = 200;     /* minimum packets for valid run */
 static char *metrics_json_path = NULL;
 
+/* Logging configuration */
+static int async_log = 0;              /* Use background writer thread */
+static size_t log_buffer_kb = 0;       /* 0 = logger default */
+static log_overflow_policy_t log_overflow = LOG_OVERFLOW_DROP;
+static char *binlog_path = NULL;       /* Binary per-packet trace output */
+
+/* Latency histogram precision (significant digits) */
+static int latency_digits = METRICS_LATENCY_DIGITS_DEFAULT;
+
+/* Interval time series configuration */
+static timeseries_config_t timeseries_config = { .path = NULL, .format = TIMESERIES_JSONL };
+
+/* Rolling-baseline anomaly detection on the time series intervals */
+static int anomaly_detect = 0;
+static anomaly_config_t anomaly_config = { 0 };
+
+/* OpenMetrics exporter configuration */
+static exporter_config_t exporter_config = { .port = 0, .bind_addr = NULL };
+
+/* Shared-memory stats configuration */
+static int shm_stats = 0;              /* Publish metrics to /dev/shm */
+static uint32_t shm_interval_ms = SHM_STATS_INTERVAL_MS_DEFAULT;
+static pid_t attach_pid = 0;           /* View another analyzer's stats */
+
+/* Packet dump configuration */
+static dump_config_t dump_config = { .mode = DUMP_SUMMARY };
+
+/* Sampling profiler configuration */
+static char *profile_path = NULL;      /* Folded stack output, NULL = off */
+static int profile_hz = PROFILER_HZ_DEFAULT;
+
+/* Memory budget configuration */
+static uint64_t mem_budget_mb = 0;     /* 0 = unlimited (accounting only) */
+
 /* Regression configuration */
 static char *baseline_path = NULL;
 static int fail_on_regression = 0;
@@ -157,6 +201,11 @@ void signal_handler(int signum) {
     is_running = 0;
 }
 
+/* Async log writer start hook: sample it under the logger role */
+static void profile_logger_thread(void) {
+    profiler_register_thread(PROFILER_ROLE_LOGGER);
+}
+
 /* Comparison function for qsort (doubles) */
 static int compare_double(const void *a, const void *b) {
     double da = *(const double *)a;
@@ -204,8 +253,16 @@ typedef struct {
     uint64_t pkts_processed;
     uint64_t bytes_processed;
     double capture_elapsed_sec;
+    double cycles_per_packet;       /* 0 if hardware counters were unavailable */
+    double cpu_ns_per_packet;       /* 0 if thread CPU time was unavailable */
+    uint64_t peak_rss_bytes;        /* 0 if RSS was unavailable */
+    double bytes_per_queued_packet; /* 0 if nothing was queued */
     int pps_regressed;              /* 1 if this run shows PPS regression */
     int mbps_regressed;             /* 1 if this run shows Mbps regression */
+    int cpp_regressed;              /* 1 if this run shows cycles/packet regression */
+    int cpu_regressed;              /* 1 if this run shows CPU/packet regression */
+    int rss_regressed;              /* 1 if this run shows peak RSS regression */
+    int queued_bytes_regressed;     /* 1 if this run shows bytes/queued packet regression */
 } run_metrics_t;
 
 void print_usage(const char *program_name) {
@@ -225,9 +282,31 @@ void print_usage(const char *program_name) {
     fprintf(stdout, "  --icmp               Filter to capture ICMP/ICMPv6 packets only\n");
     fprintf(stdout, "  --stats-interval SEC Print live metrics every SEC seconds (default: 1, 0=off)\n");
     fprintf(stdout, "  --debug              Enable debug logging\n");
+    fprintf(stdout, "  --async-log          Log through per-thread rings and a background writer\n");
+    fprintf(stdout, "  --log-buffer-kb N    Total async log ring memory (default: 4096, minimum 64)\n");
+    fprintf(stdout, "  --log-overflow MODE  Async ring full: drop (count) or block (default: drop)\n");
+    fprintf(stdout, "  --binlog FILE        Record per-packet traces in binary form (decode with binlog_decode)\n");
+    fprintf(stdout, "  --dump MODE          Packet output: off, summary, full, hexdump (default: summary)\n");
+    fprintf(stdout, "  --dump-sample N      Dump 1 in N selected packets per worker (default: 1)\n");
+    fprintf(stdout, "  --dump-filter EXPR   Dump only matching packets, e.g. \"tcp port 443 host 10.0.0.1\"\n");
+    fprintf(stdout, "  --dump-first N       Dump only the first N packets of each flow (default: 0=all)\n");
     fprintf(stdout, "  --metrics-interval-ms N  Print metrics every N milliseconds\n");
     fprintf(stdout, "  --metrics-json FILE  Write final JSON metrics to FILE on exit\n");
+    fprintf(stdout, "  --timeseries FILE    Write per-interval metrics (rates, drops, p50/p95/p99, queue depth) to FILE\n");
+    fprintf(stdout, "  --timeseries-interval-ms N  Time series resolution (default: 1000)\n");
+    fprintf(stdout, "  --timeseries-format FMT     Time series format: jsonl or csv (default: jsonl)\n");
+    fprintf(stdout, "  --anomaly            Alert when an interval's pps, drop rate or latency leaves its rolling baseline\n");
+    fprintf(stdout, "  --anomaly-threshold K  Alert band in robust standard deviations (default: 4)\n");
+    fprintf(stdout, "  --metrics-port PORT  Serve OpenMetrics at http://127.0.0.1:PORT/metrics (default: off)\n");
+    fprintf(stdout, "  --metrics-bind ADDR  Address for --metrics-port (default: 127.0.0.1)\n");
+    fprintf(stdout, "  --shm-stats          Publish metrics to shared memory for --attach and sidecars\n");
+    fprintf(stdout, "  --shm-interval-ms N  Shared-memory publish period (default: 100)\n");
+    fprintf(stdout, "  --attach PID         Print the shared-memory stats of a running analyzer and exit\n");
+    fprintf(stdout, "  --latency-digits N   Latency histogram precision in significant digits, 1-5 (default: 3)\n");
     fprintf(stdout, "  --min-packets N      Minimum packets for valid run (default: 200)\n");
+    fprintf(stdout, "  --profile FILE       Sample thread stacks on CPU time and write folded stacks to FILE\n");
+    fprintf(stdout, "  --profile-hz N       Profiler samples per CPU second per thread (default: %d)\n", PROFILER_HZ_DEFAULT);
+    fprintf(stdout, "  --mem-budget-mb N    Global memory budget; degrade then drop near it (default: 0=unlimited)\n");
     fprintf(stdout, "\nTraffic Generation:\n");
     fprintf(stdout, "  --traffic MODE       Generate background traffic during warmup+measurement\n");
     fprintf(stdout, "                       Modes: icmp (runs ping)\n");
@@ -289,9 +368,31 @@ int main(int argc, char *argv[]) {
         {"debug",               no_argument,       0, 'D'},
         {"metrics-interval-ms", required_argument, 0, 'M'},
         {"metrics-json",        required_argument, 0, 'J'},
+        {"latency-digits",      required_argument, 0, 'H'},
+        {"timeseries",          required_argument, 0, 'C'},
+        {"metrics-port",        required_argument, 0, 'p'},
+        {"metrics-bind",        required_argument, 0, 'b'},
+        {"shm-stats",           no_argument,       0, 's'},
+        {"shm-interval-ms",     required_argument, 0, 'm'},
+        {"attach",              required_argument, 0, 'a'},
+        {"timeseries-interval-ms", required_argument, 0, 'c'},
+        {"timeseries-format",   required_argument, 0, 'f'},
+        {"anomaly",             no_argument,       0, 'y'},
+        {"anomaly-threshold",   required_argument, 0, 'k'},
         {"baseline",            required_argument, 0, 'B'},
         {"fail-on-regression",  no_argument,       0, 'F'},
         {"regression-threshold", required_argument, 0, 'R'},
+        {"profile",             required_argument, 0, 'g'},
+        {"profile-hz",          required_argument, 0, 'z'},
+        {"mem-budget-mb",       required_argument, 0, 'K'},
+        {"async-log",           no_argument,       0, 'Y'},
+        {"log-buffer-kb",       required_argument, 0, 'L'},
+        {"log-overflow",        required_argument, 0, 'O'},
+        {"binlog",              required_argument, 0, 'Q'},
+        {"dump",                required_argument, 0, 'U'},
+        {"dump-sample",         required_argument, 0, 'X'},
+        {"dump-filter",         required_argument, 0, 'V'},
+        {"dump-first",          required_argument, 0, 'Z'},
         {"help",                no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
@@ -353,6 +454,14 @@ int main(int argc, char *argv[]) {
             case 'J':
                 metrics_json_path = strdup(optarg);
                 break;
+            case 'H':
+                latency_digits = atoi(optarg);
+                if (latency_digits < HDR_DIGITS_MIN || latency_digits > HDR_DIGITS_MAX) {
+                    fprintf(stderr, "Invalid --latency-digits: %s (use %d-%d)\n",
+                            optarg, HDR_DIGITS_MIN, HDR_DIGITS_MAX);
+                    return 1;
+                }
+                break;
             case 'B':
                 baseline_path = strdup(optarg);
                 break;
@@ -362,6 +471,113 @@ int main(int argc, char *argv[]) {
             case 'R':
                 regression_threshold = strtod(optarg, NULL);
                 break;
+            case 'K':
+                mem_budget_mb = strtoull(optarg, NULL, 10);
+                break;
+            case 'Y':
+                async_log = 1;
+                break;
+            case 'L':
+                log_buffer_kb = (size_t)strtoul(optarg, NULL, 10);
+                if (log_buffer_kb != 0 && log_buffer_kb * 1024 < LOGGER_ASYNC_MIN_BUDGET) {
+                    fprintf(stderr, "Invalid --log-buffer-kb: %s (minimum %d)\n",
+                            optarg, LOGGER_ASYNC_MIN_BUDGET / 1024);
+                    return 1;
+                }
+                break;
+            case 'O':
+                if (strcmp(optarg, "block") == 0) {
+                    log_overflow = LOG_OVERFLOW_BLOCK;
+                } else if (strcmp(optarg, "drop") == 0) {
+                    log_overflow = LOG_OVERFLOW_DROP;
+                } else {
+                    fprintf(stderr, "Invalid --log-overflow mode: %s (use drop or block)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'Q':
+                binlog_path = optarg;
+                break;
+            case 'U':
+                if (dump_parse_mode(optarg, &dump_config.mode) != 0) {
+                    fprintf(stderr, "Invalid --dump mode: %s (use off, summary, full or hexdump)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'X':
+                dump_config.sample_n = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'V':
+                if (dump_parse_filter(optarg, &dump_config.filter) != 0) {
+                    fprintf(stderr, "Invalid --dump-filter expression: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'Z':
+                dump_config.first_n = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'C':
+                timeseries_config.path = optarg;
+                break;
+            case 'p': {
+                unsigned long port = strtoul(optarg, NULL, 10);
+                if (port == 0 || port > 65535) {
+                    fprintf(stderr, "Invalid --metrics-port: %s (1-65535)\n", optarg);
+                    return 1;
+                }
+                exporter_config.port = (uint16_t)port;
+                break;
+            }
+            case 'b':
+                exporter_config.bind_addr = optarg;
+                break;
+            case 's':
+                shm_stats = 1;
+                break;
+            case 'm':
+                shm_interval_ms = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'a':
+                attach_pid = (pid_t)atoi(optarg);
+                if (attach_pid <= 0) {
+                    fprintf(stderr, "Invalid --attach pid: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+                timeseries_config.interval_ms = (uint32_t)strtoul(optarg, NULL, 10);
+                if (timeseries_config.interval_ms == 0) {
+                    fprintf(stderr, "Invalid --timeseries-interval-ms: %s (must be > 0)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                if (timeseries_parse_format(optarg, &timeseries_config.format) != 0) {
+                    fprintf(stderr, "Invalid --timeseries-format: %s (use jsonl or csv)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'y':
+                anomaly_detect = 1;
+                break;
+            case 'k':
+                anomaly_config.threshold = atof(optarg);
+                if (!(anomaly_config.threshold > 0)) {
+                    fprintf(stderr, "Invalid --anomaly-threshold: %s (must be > 0)\n", optarg);
+                    return 1;
+                }
+                anomaly_detect = 1;
+                break;
+            case 'g':
+                profile_path = optarg;
+                break;
+            case 'z':
+                profile_hz = atoi(optarg);
+                if (profile_hz < 1 || profile_hz > PROFILER_HZ_MAX) {
+                    fprintf(stderr, "Invalid --profile-hz: %s (1-%d)\n", optarg, PROFILER_HZ_MAX);
+                    return 1;
+                }
+                break;
             case 'h':
             default:
                 print_usage(argv[0]);
@@ -371,6 +587,34 @@ int main(int argc, char *argv[]) {
 
     /* Initialize logger */
     logger_init(NULL, log_level);
+
+    /* Viewer mode: read another process's segment, never touch the network */
+    if (attach_pid > 0) {
+        signal(SIGINT, signal_handler);
+        signal(SIGTERM, signal_handler);
+        uint32_t view_ms = metrics_interval_ms > 0 ? (uint32_t)metrics_interval_ms :
+                           (uint32_t)(stats_interval_sec > 0 ? stats_interval_sec : 1) * 1000;
+        int rc = shm_stats_view(attach_pid, view_ms, &is_running);
+        logger_cleanup();
+        return rc == 0 ? 0 : 1;
+    }
+
+    /* Start the profiler before any thread it samples, the log writer included */
+    if (profile_path != NULL) {
+        if (profiler_start(profile_path, profile_hz) == 0) {
+            logger_set_writer_hooks(profile_logger_thread, profiler_unregister_thread);
+        } else {
+            logger_warn("Continuing without the profiler");
+        }
+    }
+
+    if (async_log) {
+        logger_start_async(log_buffer_kb * 1024, log_overflow);
+    }
+    if (binlog_path != NULL && logger_bin_open(binlog_path, LOG_DEBUG) != 0) {
+        logger_cleanup();
+        return 1;
+    }
     logger_info("=== Network Packet Analyzer Started ===");
     logger_info("Capturing on interface: %s", interface_name);
     logger_info("Threads: %d, Max Packets: %s",
@@ -409,8 +653,21 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    /* Initialize metrics */
+    /* Initialize metrics and memory budget */
+    metrics_set_latency_digits(latency_digits);
     metrics_init();
+    metrics_register_thread();  /* Capture loop counters */
+    metrics_set_thread_name("capture");
+    profiler_register_thread(PROFILER_ROLE_CAPTURE);
+    fastclock_info_t clock_info;
+    fastclock_get_info(&clock_info);
+    if (clock_info.source == FASTCLOCK_TSC) {
+        logger_info("Timestamp clock: invariant TSC at %.3f GHz (calibration spread %.1f ppm)",
+                    clock_info.ticks_per_ns, clock_info.spread_ppm);
+    } else {
+        logger_warn("Timestamp clock: CLOCK_MONOTONIC (%s)", clock_info.fallback_reason);
+    }
+    membudget_init(mem_budget_mb * 1024 * 1024);
 
     /* Register signal handlers */
     signal(SIGINT, signal_handler);
@@ -444,10 +701,18 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    /* Start the packet dump formatter before the workers that feed it */
+    if (dump_init(&dump_config) != 0) {
+        logger_critical("Failed to start packet dump");
+        socket_cleanup(socket_config);
+        return 1;
+    }
+
     /* Initialize thread pool */
     thread_pool = thread_pool_create(num_threads, MAX_QUEUE_SIZE);
     if (thread_pool == NULL) {
         logger_critical("Failed to create thread pool");
+        dump_shutdown();
         socket_cleanup(socket_config);
         return 1;
     }
@@ -457,21 +722,23 @@ int main(int argc, char *argv[]) {
     if (packet_buffer == NULL) {
         logger_critical("Failed to allocate packet buffer");
         thread_pool_destroy(thread_pool);
+        dump_shutdown();
         socket_cleanup(socket_config);
         return 1;
     }
 
-    /* Allocate per-run metrics storage */
-    run_metrics_t *run_results = NULL;
-    if (num_runs > 1) {
-        run_results = (run_metrics_t *)calloc(num_runs, sizeof(run_metrics_t));
-        if (run_results == NULL) {
-            logger_critical("Failed to allocate run results storage");
-            free(packet_buffer);
-            thread_pool_destroy(thread_pool);
-            socket_cleanup(socket_config);
-            return 1;
-        }
+    /* Allocate per-run metrics storage and the all-runs latency histogram */
+    run_metrics_t *run_results = (run_metrics_t *)calloc(num_runs, sizeof(run_metrics_t));
+    hdr_histogram_t *all_runs_hdr = hdr_create(METRICS_LATENCY_MAX_NS, latency_digits);
+    if (run_results == NULL || all_runs_hdr == NULL) {
+        logger_critical("Failed to allocate run results storage");
+        free(run_results);
+        hdr_destroy(all_runs_hdr);
+        free(packet_buffer);
+        thread_pool_destroy(thread_pool);
+        dump_shutdown();
+        socket_cleanup(socket_config);
+        return 1;
     }
 
     /* Set metadata for baseline compatibility tracking */
@@ -487,6 +754,22 @@ int main(int argc, char *argv[]) {
         traffic_mode ? traffic_rate : 0
     );
 
+    /* Sample per-interval metrics in the background while runs are measured */
+    /* The detector is fed by the sampler, which then runs even without an output file */
+    if (anomaly_detect && anomaly_configure(&anomaly_config) != 0) {
+        logger_warn("Continuing without anomaly detection");
+        anomaly_detect = 0;
+    }
+    if ((timeseries_config.path != NULL || anomaly_detect) && timeseries_start(&timeseries_config) != 0) {
+        logger_warn("Continuing without time series output");
+    }
+    if (exporter_config.port != 0 && exporter_start(&exporter_config) != 0) {
+        logger_warn("Continuing without the metrics exporter");
+    }
+    if (shm_stats && shm_stats_start(shm_interval_ms) != 0) {
+        logger_warn("Continuing without shared-memory stats");
+    }
+
     /* Run measurement loop N times */
     for (int run_idx = 0; run_idx < num_runs && is_running; run_idx++) {
         if (num_runs > 1) {
@@ -507,6 +790,7 @@ int main(int argc, char *argv[]) {
         int warmup_complete = (warmup_sec <= 0);  /* Skip warmup if 0 */
         uint64_t last_metrics_print_ns = loop_start_ns;
         uint64_t last_stats_print_ns = loop_start_ns;
+        uint64_t last_rss_sample_ns = loop_start_ns;
         int run_is_running = 1;
 
         /* Main packet capture loop */
@@ -524,7 +808,7 @@ int main(int argc, char *argv[]) {
         }
         
         while (is_running && run_is_running) {
-            uint64_t now_ns = metrics_now_ns();
+            uint64_t now_ns = fastclock_ticks_to_monotonic_ns(fastclock_ticks());
             
             /* Check for warmup completion */
             if (!warmup_complete && now_ns >= warmup_end_ns) {
@@ -536,6 +820,7 @@ int main(int argc, char *argv[]) {
                 metrics_start();
                 last_metrics_print_ns = now_ns;
                 last_stats_print_ns = now_ns;
+                last_rss_sample_ns = now_ns;
             }
             
             /* Check measurement end (only after warmup) */
@@ -556,6 +841,12 @@ int main(int argc, char *argv[]) {
                 }
             }
 
+            /* Sample RSS for the run's peak footprint */
+            if (warmup_complete && now_ns - last_rss_sample_ns >= MEMBUDGET_RSS_SAMPLE_MS * 1000000ULL) {
+                membudget_sample_rss();
+                last_rss_sample_ns = now_ns;
+            }
+
             /* Print live stats at interval (--stats-interval) - only during measurement */
             if (warmup_complete && stats_interval_sec > 0) {
                 uint64_t interval_ns = (uint64_t)stats_interval_sec * 1000000000ULL;
@@ -569,7 +860,7 @@ int main(int argc, char *argv[]) {
             
             if (packet_size < 0) {
                 if (is_running) {
-                    logger_error("Error receiving packet");
+                    LOGGER_ERROR_RATELIMITED("Error receiving packet");
                 }
                 continue;
             }
@@ -587,17 +878,27 @@ int main(int argc, char *argv[]) {
                 metrics_inc_captured((uint32_t)packet_size);
             }
 
+            /* Memory budget: truncate when degraded, refuse when exhausted */
+            packet_size = (int)membudget_snaplen((uint32_t)packet_size);
+            if (!membudget_admit(sizeof(packet_t) + (size_t)packet_size)) {
+                if (warmup_complete) {
+                    metrics_inc_capture_drops();
+                }
+                PROBE2(drop, PROBE_DROP_MEMBUDGET, packet_size);
+                continue;
+            }
+
             /* Create and enqueue packet */
             packet_t *packet = packet_create(packet_buffer, packet_size);
             if (packet != NULL) {
                 if (thread_pool_enqueue(thread_pool, packet) < 0) {
                     if (warmup_complete) {
-                        logger_warn("Failed to enqueue packet (queue full)");
+                        LOGGER_WARN_RATELIMITED("Failed to enqueue packet (queue full)");
                     }
                     packet_free(packet);
                     /* Note: queue_drops already incremented in thread_pool_enqueue */
                 } else {
-                    logger_debug("Packet #%u enqueued (size: %d bytes)", packets_captured, packet_size);
+                    LOGGER_TRACE("Packet #%u enqueued (size: %d bytes)", packets_captured, packet_size);
                 }
             }
 
@@ -619,9 +920,12 @@ int main(int argc, char *argv[]) {
         logger_info("Waiting for thread pool to finish processing (run %d)...", run_idx + 1);
         usleep(500000); /* 500ms */
 
+        /* Fold the drain into the run's peak RSS before the snapshot */
+        membudget_sample_rss();
+
         /* Take snapshot and store run results */
         metrics_snapshot_t run_snapshot;
-        metrics_snapshot(&run_snapshot);
+        metrics_snapshot_select(&run_snapshot, METRICS_SNAP_LATENCY);
         
         /* Compute pps and mbps from snapshot */
         double elapsed = run_snapshot.capture_elapsed_sec;
@@ -629,10 +933,23 @@ int main(int argc, char *argv[]) {
         
         run_results[run_idx].pps = run_snapshot.pkts_processed / elapsed;
         run_results[run_idx].mbps = (run_snapshot.bytes_processed * 8.0) / (elapsed * 1000000.0);
-        run_results[run_idx].p95_ns = metrics_percentile_ns(&run_snapshot, 95.0);
+        run_results[run_idx].p95_ns = metrics_percentile_ns(&run_snapshot, 0.95);
         run_results[run_idx].pkts_processed = run_snapshot.pkts_processed;
         run_results[run_idx].bytes_processed = run_snapshot.bytes_processed;
         run_results[run_idx].capture_elapsed_sec = elapsed;
+        if (run_snapshot.perf.available && run_snapshot.pkts_processed > 0) {
+            run_results[run_idx].cycles_per_packet =
+                (double)run_snapshot.perf.values[PERFCOUNT_CYCLES] / run_snapshot.pkts_processed;
+        }
+        run_results[run_idx].cpu_ns_per_packet = metrics_cpu_ns_per_packet(&run_snapshot);
+        if (run_snapshot.memory.rss_valid) {
+            run_results[run_idx].peak_rss_bytes = run_snapshot.memory.rss_peak_bytes;
+        }
+        run_results[run_idx].bytes_per_queued_packet = membudget_bytes_per_queued_packet(&run_snapshot.memory);
+        if (run_snapshot.latency_hdr != NULL) {
+            hdr_add(all_runs_hdr, run_snapshot.latency_hdr);
+        }
+        metrics_snapshot_free(&run_snapshot);
 
         /* Print run summary */
         logger_info("=== Run %d/%d Results ===", run_idx + 1, num_runs);
@@ -656,25 +973,67 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    timeseries_stop();
+
+    /* Write the profile now so the final metrics JSON can reference it */
+    profiler_stop();
+
     /* Compute aggregated metrics using median */
     double pps_values[num_runs];
     double mbps_values[num_runs];
     uint64_t p95_values[num_runs];
+    double cpp_values[num_runs];
+    double cpu_values[num_runs];
+    uint64_t rss_values[num_runs];
+    double queued_bytes_values[num_runs];
+    bool perf_all_runs = true;
+    bool cpu_all_runs = true;
+    bool rss_all_runs = true;
+    bool queued_bytes_all_runs = true;
     
     for (int i = 0; i < num_runs; i++) {
         pps_values[i] = run_results[i].pps;
         mbps_values[i] = run_results[i].mbps;
         p95_values[i] = run_results[i].p95_ns;
+        cpp_values[i] = run_results[i].cycles_per_packet;
+        perf_all_runs = perf_all_runs && run_results[i].cycles_per_packet > 0;
+        cpu_values[i] = run_results[i].cpu_ns_per_packet;
+        cpu_all_runs = cpu_all_runs && run_results[i].cpu_ns_per_packet > 0;
+        rss_values[i] = run_results[i].peak_rss_bytes;
+        rss_all_runs = rss_all_runs && run_results[i].peak_rss_bytes > 0;
+        queued_bytes_values[i] = run_results[i].bytes_per_queued_packet;
+        queued_bytes_all_runs = queued_bytes_all_runs && run_results[i].bytes_per_queued_packet > 0;
     }
     
     double median_pps = median_double(pps_values, num_runs);
     double median_mbps = median_double(mbps_values, num_runs);
     uint64_t median_p95 = median_uint64(p95_values, num_runs);
+    double median_cpp = perf_all_runs ? median_double(cpp_values, num_runs) : 0.0;
+    double median_cpu = cpu_all_runs ? median_double(cpu_values, num_runs) : 0.0;
+    uint64_t median_rss = rss_all_runs ? median_uint64(rss_values, num_runs) : 0;
+    double median_queued_bytes = queued_bytes_all_runs ? median_double(queued_bytes_values, num_runs) : 0.0;
 
     logger_info("=== Aggregated Results (median of %d runs) ===", num_runs);
     logger_info("Median PPS: %.2f", median_pps);
     logger_info("Median Mbps: %.4f", median_mbps);
     logger_info("Median P95 Latency: %lu ns (%.3f ms)", median_p95, median_p95 / 1000000.0);
+    logger_info("All-runs latency p50/p95/p99: %" PRIu64 "/%" PRIu64 "/%" PRIu64 " ns (%" PRIu64 " samples)",
+                hdr_value_at_quantile(all_runs_hdr, 0.50),
+                hdr_value_at_quantile(all_runs_hdr, 0.95),
+                hdr_value_at_quantile(all_runs_hdr, 0.99),
+                hdr_total_count(all_runs_hdr));
+    if (perf_all_runs) {
+        logger_info("Median cycles/packet: %.1f", median_cpp);
+    }
+    if (cpu_all_runs) {
+        logger_info("Median CPU/packet: %.1f ns", median_cpu);
+    }
+    if (rss_all_runs) {
+        logger_info("Median peak RSS: %.1f MB", median_rss / 1048576.0);
+    }
+    if (queued_bytes_all_runs) {
+        logger_info("Median bytes/queued packet: %.1f", median_queued_bytes);
+    }
 
     /* Check for sufficient sample size */
     uint64_t total_pkts_processed = 0;
@@ -725,6 +1084,24 @@ int main(int argc, char *argv[]) {
                 /* Check each run for regression and count */
                 int pps_regressed_count = 0;
                 int mbps_regressed_count = 0;
+                int cpp_regressed_count = 0;
+                int cpu_regressed_count = 0;
+                int rss_regressed_count = 0;
+                int queued_bytes_regressed_count = 0;
+                
+                /* Cycles per packet only gates when both sides were counted */
+                bool cpp_gated = baseline.perf_valid && perf_all_runs;
+                double baseline_cpp = baseline.cycles_per_packet;
+                
+                /* CPU time per packet: same gate, from thread CPU clocks */
+                bool cpu_gated = baseline.cpu_valid && cpu_all_runs;
+                double baseline_cpu = baseline.cpu_ns_per_packet;
+                
+                /* Memory footprint: peak RSS and bytes held per queued packet */
+                bool rss_gated = baseline.peak_rss_bytes > 0 && rss_all_runs;
+                double baseline_rss = (double)baseline.peak_rss_bytes;
+                bool queued_bytes_gated = baseline.bytes_per_queued_packet > 0 && queued_bytes_all_runs;
+                double baseline_queued_bytes = baseline.bytes_per_queued_packet;
                 
                 double baseline_pps = baseline.pkts_processed_per_sec;
                 double baseline_mbps = baseline.mbps_processed;
@@ -746,6 +1123,43 @@ int main(int argc, char *argv[]) {
                     if (pps_reg) pps_regressed_count++;
                     if (mbps_reg) mbps_regressed_count++;
                     
+                    if (cpp_gated) {
+                        double cpp_delta_pct = (run_results[i].cycles_per_packet - baseline_cpp) / baseline_cpp;
+                        run_results[i].cpp_regressed = (cpp_delta_pct > regression_threshold) ? 1 : 0;
+                        if (run_results[i].cpp_regressed) cpp_regressed_count++;
+                        logger_info("  Run %d: %.1f cycles/pkt (%+.1f%%)%s", i + 1,
+                                   run_results[i].cycles_per_packet, cpp_delta_pct * 100,
+                                   run_results[i].cpp_regressed ? " [REG]" : "");
+                    }
+                    
+                    if (cpu_gated) {
+                        double cpu_delta_pct = (run_results[i].cpu_ns_per_packet - baseline_cpu) / baseline_cpu;
+                        run_results[i].cpu_regressed = (cpu_delta_pct > regression_threshold) ? 1 : 0;
+                        if (run_results[i].cpu_regressed) cpu_regressed_count++;
+                        logger_info("  Run %d: %.1f CPU ns/pkt (%+.1f%%)%s", i + 1,
+                                   run_results[i].cpu_ns_per_packet, cpu_delta_pct * 100,
+                                   run_results[i].cpu_regressed ? " [REG]" : "");
+                    }
+                    
+                    if (rss_gated) {
+                        double rss_delta_pct = ((double)run_results[i].peak_rss_bytes - baseline_rss) / baseline_rss;
+                        run_results[i].rss_regressed = (rss_delta_pct > regression_threshold) ? 1 : 0;
+                        if (run_results[i].rss_regressed) rss_regressed_count++;
+                        logger_info("  Run %d: %.1f MB peak RSS (%+.1f%%)%s", i + 1,
+                                   run_results[i].peak_rss_bytes / 1048576.0, rss_delta_pct * 100,
+                                   run_results[i].rss_regressed ? " [REG]" : "");
+                    }
+                    
+                    if (queued_bytes_gated) {
+                        double queued_delta_pct = (run_results[i].bytes_per_queued_packet - baseline_queued_bytes) /
+                                                  baseline_queued_bytes;
+                        run_results[i].queued_bytes_regressed = (queued_delta_pct > regression_threshold) ? 1 : 0;
+                        if (run_results[i].queued_bytes_regressed) queued_bytes_regressed_count++;
+                        logger_info("  Run %d: %.1f B/queued pkt (%+.1f%%)%s", i + 1,
+                                   run_results[i].bytes_per_queued_packet, queued_delta_pct * 100,
+                                   run_results[i].queued_bytes_regressed ? " [REG]" : "");
+                    }
+                    
                     logger_info("  Run %d: %.2f pps (%+.1f%%)%s, %.4f Mbps (%+.1f%%)%s",
                                i + 1,
                                run_results[i].pps, pps_delta_pct * 100, pps_reg ? " [REG]" : "",
@@ -758,7 +1172,13 @@ int main(int argc, char *argv[]) {
                 
                 int pps_persistent = (pps_regressed_count >= min_regressed_runs);
                 int mbps_persistent = (mbps_regressed_count >= min_regressed_runs);
-                int any_persistent = pps_persistent || mbps_persistent;
+                int cpp_persistent = cpp_gated && (cpp_regressed_count >= min_regressed_runs);
+                int cpu_persistent = cpu_gated && (cpu_regressed_count >= min_regressed_runs);
+                int rss_persistent = rss_gated && (rss_regressed_count >= min_regressed_runs);
+                int queued_bytes_persistent = queued_bytes_gated &&
+                                              (queued_bytes_regressed_count >= min_regressed_runs);
+                int any_persistent = pps_persistent || mbps_persistent || cpp_persistent || cpu_persistent ||
+                                     rss_persistent || queued_bytes_persistent;
                 
                 /* Also check median values */
                 double median_pps_delta = (median_pps - baseline_pps) / baseline_pps;
@@ -788,6 +1208,37 @@ int main(int argc, char *argv[]) {
                         baseline_mbps, median_mbps, median_mbps_delta * 100,
                         mbps_regressed_count, num_runs,
                         mbps_persistent ? "REGRESSION" : "OK");
+                if (cpp_gated) {
+                    double median_cpp_delta = (median_cpp - baseline_cpp) / baseline_cpp;
+                    fprintf(stdout, "Cyc/pkt   %10.1f    %10.1f    %+6.1f%%    %d/%d             %s\n",
+                            baseline_cpp, median_cpp, median_cpp_delta * 100,
+                            cpp_regressed_count, num_runs,
+                            cpp_persistent ? "REGRESSION" : "OK");
+                } else if (baseline.perf_valid || perf_all_runs) {
+                    logger_info("Cycles/packet not compared: hardware counters missing in %s",
+                                baseline.perf_valid ? "this run" : "the baseline");
+                }
+                if (cpu_gated) {
+                    double median_cpu_delta = (median_cpu - baseline_cpu) / baseline_cpu;
+                    fprintf(stdout, "CPU ns/pkt%10.1f    %10.1f    %+6.1f%%    %d/%d             %s\n",
+                            baseline_cpu, median_cpu, median_cpu_delta * 100,
+                            cpu_regressed_count, num_runs,
+                            cpu_persistent ? "REGRESSION" : "OK");
+                }
+                if (rss_gated) {
+                    double median_rss_delta = ((double)median_rss - baseline_rss) / baseline_rss;
+                    fprintf(stdout, "RSS MB    %10.1f    %10.1f    %+6.1f%%    %d/%d             %s\n",
+                            baseline_rss / 1048576.0, median_rss / 1048576.0, median_rss_delta * 100,
+                            rss_regressed_count, num_runs,
+                            rss_persistent ? "REGRESSION" : "OK");
+                }
+                if (queued_bytes_gated) {
+                    double median_queued_delta = (median_queued_bytes - baseline_queued_bytes) / baseline_queued_bytes;
+                    fprintf(stdout, "B/q-pkt   %10.1f    %10.1f    %+6.1f%%    %d/%d             %s\n",
+                            baseline_queued_bytes, median_queued_bytes, median_queued_delta * 100,
+                            queued_bytes_regressed_count, num_runs,
+                            queued_bytes_persistent ? "REGRESSION" : "OK");
+                }
                 fprintf(stdout, "================================================================================\n");
                 
                 if (any_persistent) {
@@ -818,6 +1269,9 @@ int main(int argc, char *argv[]) {
     if (run_results != NULL) {
         free(run_results);
     }
+    hdr_destroy(all_runs_hdr);
+    exporter_stop();
+    shm_stats_stop();
     if (traffic_mode != NULL) {
         free(traffic_mode);
         traffic_mode = NULL;
@@ -828,7 +1282,12 @@ int main(int argc, char *argv[]) {
     }
     free(packet_buffer);
     thread_pool_destroy(thread_pool);
+    dump_shutdown();
     socket_cleanup(socket_config);
+    metrics_unregister_thread();
+    logger_bin_close();
+
+    profiler_cleanup();
 
     logger_info("=== Network Packet Analyzer Stopped ===");
     logger_cleanup();
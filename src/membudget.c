@@ -0,0 +1,392 @@
+/**
+ * @file membudget.c
+ * @brief Global memory budget implementation
+ *
+ * Accounting uses C11 atomics so any thread may charge or release.
+ * Level changes are rare and serialized by a mutex.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "membudget.h"
+#include "metrics.h"
+#include "lockstat.h"
+#include "logger.h"
+
+/* Entry thresholds per level in percent of budget (index = level) */
+static const uint64_t level_enter_pct[MEM_DEGRADE_LEVELS] = { 0, 70, 80, 90, 95 };
+
+/* Hysteresis: a level is left this many percent below its entry threshold */
+#define MEMBUDGET_HYSTERESIS_PCT 10
+
+/* Per-subsystem counters, kept together so a charge touches one cache line */
+typedef struct {
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t peak_bytes;        /* Since membudget_window_begin() */
+    _Atomic uint64_t allocs;
+    _Atomic uint64_t alloc_bytes;
+} subsys_usage_t;
+
+static uint64_t g_budget_bytes;
+static _Atomic uint64_t g_used_bytes;
+static _Atomic uint64_t g_peak_bytes;
+static subsys_usage_t g_subsys[MEM_SUBSYS_COUNT];
+static _Atomic int g_level;
+static _Atomic uint64_t g_admission_drops;
+static _Atomic uint64_t g_sampled_out;
+static _Atomic uint64_t g_sample_counter;
+
+/* Footprint profile of the current window */
+static _Atomic uint64_t g_queued_packets;
+static _Atomic uint64_t g_queued_bytes;
+static _Atomic bool g_rss_valid;
+static _Atomic bool g_hwm_reset;        /* VmHWM restarted at window begin */
+static _Atomic uint64_t g_rss_bytes;
+static _Atomic uint64_t g_rss_start_bytes;
+static _Atomic uint64_t g_rss_peak_bytes;
+static _Atomic uint64_t g_rss_samples;
+
+/* Transition history (protected by g_transition_lock) */
+static lockstat_mutex_t g_transition_lock = LOCKSTAT_MUTEX_INITIALIZER(LOCKSTAT_MEMBUDGET);
+static uint64_t g_transition_count;
+static membudget_transition_t g_transitions[MEMBUDGET_MAX_TRANSITIONS];
+
+/* Precomputed byte thresholds so the charge path avoids divisions */
+static uint64_t g_enter_bytes[MEM_DEGRADE_LEVELS];
+static uint64_t g_leave_bytes[MEM_DEGRADE_LEVELS];
+
+static const char *level_names[MEM_DEGRADE_LEVELS] = {
+    "none", "snaplen", "sampling", "evict_flows", "no_payload"
+};
+
+static const char *subsys_names[MEM_SUBSYS_COUNT] = {
+    "packet_pool", "queues", "flows", "reassembly", "sketches"
+};
+
+/**
+ * @brief Raise a peak to value if it is higher
+ */
+static inline void update_peak(_Atomic uint64_t *peak, uint64_t value) {
+    uint64_t current = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > current) {
+        if (atomic_compare_exchange_weak(peak, &current, value)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Read VmRSS and VmHWM from /proc/self/status
+ *
+ * @return 0 on success, -1 where /proc is unavailable (e.g. macOS)
+ */
+static int read_proc_status(uint64_t *rss_bytes, uint64_t *hwm_bytes) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp == NULL) return -1;
+
+    char line[128];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        unsigned long long kb;
+        if (sscanf(line, "VmRSS: %llu kB", &kb) == 1) {
+            *rss_bytes = (uint64_t)kb * 1024;
+            found++;
+        } else if (sscanf(line, "VmHWM: %llu kB", &kb) == 1) {
+            *hwm_bytes = (uint64_t)kb * 1024;
+            found++;
+        }
+    }
+    fclose(fp);
+    return found == 2 ? 0 : -1;
+}
+
+/**
+ * @brief Restart the kernel's RSS high-water mark (Linux 4.0+)
+ */
+static bool reset_hwm(void) {
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp == NULL) return false;
+    bool ok = fputs("5", fp) >= 0;
+    return fclose(fp) == 0 && ok;
+}
+
+void membudget_init(uint64_t budget_bytes) {
+    g_budget_bytes = budget_bytes;
+
+    for (int i = 0; i < MEM_DEGRADE_LEVELS; i++) {
+        g_enter_bytes[i] = budget_bytes / 100 * level_enter_pct[i];
+        uint64_t leave_pct = level_enter_pct[i] > MEMBUDGET_HYSTERESIS_PCT ?
+            level_enter_pct[i] - MEMBUDGET_HYSTERESIS_PCT : 0;
+        g_leave_bytes[i] = budget_bytes / 100 * leave_pct;
+    }
+
+    atomic_store(&g_level, MEM_DEGRADE_NONE);
+    atomic_store(&g_admission_drops, 0);
+    atomic_store(&g_sampled_out, 0);
+    atomic_store(&g_sample_counter, 0);
+    atomic_store(&g_peak_bytes, atomic_load(&g_used_bytes));
+
+    lockstat_lock(&g_transition_lock);
+    g_transition_count = 0;
+    memset(g_transitions, 0, sizeof(g_transitions));
+    lockstat_unlock(&g_transition_lock);
+
+    if (budget_bytes > 0) {
+        logger_info("Memory budget: %" PRIu64 " MB (degrade at 70/80/90/95%%)",
+                    budget_bytes / (1024 * 1024));
+    }
+}
+
+/**
+ * @brief Compute the level implied by usage, with hysteresis
+ */
+static mem_degrade_level_t level_for_usage(uint64_t used, mem_degrade_level_t current) {
+    mem_degrade_level_t level = current;
+
+    while (level + 1 < MEM_DEGRADE_LEVELS && used >= g_enter_bytes[level + 1]) {
+        level++;
+    }
+    while (level > MEM_DEGRADE_NONE && used < g_leave_bytes[level]) {
+        level--;
+    }
+    return level;
+}
+
+/**
+ * @brief Re-evaluate the degradation level after usage changed
+ */
+static void update_level(uint64_t used) {
+    if (g_budget_bytes == 0) return;
+
+    mem_degrade_level_t current = (mem_degrade_level_t)atomic_load_explicit(&g_level, memory_order_relaxed);
+    mem_degrade_level_t target = level_for_usage(used, current);
+    if (target == current) return;
+
+    lockstat_lock(&g_transition_lock);
+    /* Re-check under the lock: another thread may have moved the level */
+    current = (mem_degrade_level_t)atomic_load(&g_level);
+    target = level_for_usage(atomic_load(&g_used_bytes), current);
+    if (target != current) {
+        atomic_store(&g_level, target);
+
+        membudget_transition_t *t = &g_transitions[g_transition_count % MEMBUDGET_MAX_TRANSITIONS];
+        t->time_ns = metrics_now_ns();
+        t->from = current;
+        t->to = target;
+        t->used_bytes = used;
+        g_transition_count++;
+
+        logger_warn("Memory budget level %s -> %s (used %" PRIu64 " KB of %" PRIu64 " KB)",
+                    level_names[current], level_names[target],
+                    used / 1024, g_budget_bytes / 1024);
+    }
+    lockstat_unlock(&g_transition_lock);
+}
+
+void membudget_charge(mem_subsys_t subsys, size_t bytes) {
+    if (subsys >= MEM_SUBSYS_COUNT || bytes == 0) return;
+
+    subsys_usage_t *usage = &g_subsys[subsys];
+    atomic_fetch_add_explicit(&usage->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&usage->alloc_bytes, bytes, memory_order_relaxed);
+    update_peak(&usage->peak_bytes,
+                atomic_fetch_add_explicit(&usage->bytes, bytes, memory_order_relaxed) + bytes);
+
+    uint64_t used = atomic_fetch_add_explicit(&g_used_bytes, bytes, memory_order_relaxed) + bytes;
+    update_peak(&g_peak_bytes, used);
+
+    update_level(used);
+}
+
+void membudget_release(mem_subsys_t subsys, size_t bytes) {
+    if (subsys >= MEM_SUBSYS_COUNT || bytes == 0) return;
+
+    atomic_fetch_sub_explicit(&g_subsys[subsys].bytes, bytes, memory_order_relaxed);
+    uint64_t used = atomic_fetch_sub_explicit(&g_used_bytes, bytes, memory_order_relaxed) - bytes;
+
+    update_level(used);
+}
+
+void membudget_note_queued(size_t bytes) {
+    atomic_fetch_add_explicit(&g_queued_packets, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_queued_bytes, bytes, memory_order_relaxed);
+}
+
+void membudget_window_begin(void) {
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++) {
+        atomic_store(&g_subsys[i].allocs, 0);
+        atomic_store(&g_subsys[i].alloc_bytes, 0);
+        atomic_store(&g_subsys[i].peak_bytes, atomic_load(&g_subsys[i].bytes));
+    }
+    atomic_store(&g_peak_bytes, atomic_load(&g_used_bytes));
+    atomic_store(&g_queued_packets, 0);
+    atomic_store(&g_queued_bytes, 0);
+
+    atomic_store(&g_hwm_reset, reset_hwm());
+    uint64_t rss = 0, hwm = 0;
+    bool valid = read_proc_status(&rss, &hwm) == 0;
+    atomic_store(&g_rss_bytes, rss);
+    atomic_store(&g_rss_start_bytes, rss);
+    atomic_store(&g_rss_peak_bytes, rss);
+    atomic_store(&g_rss_samples, valid ? 1 : 0);
+    atomic_store(&g_rss_valid, valid);
+}
+
+void membudget_sample_rss(void) {
+    if (!atomic_load(&g_rss_valid)) return;
+
+    uint64_t rss = 0, hwm = 0;
+    if (read_proc_status(&rss, &hwm) != 0) return;
+    atomic_store(&g_rss_bytes, rss);
+    update_peak(&g_rss_peak_bytes, rss);
+    if (atomic_load(&g_hwm_reset)) {
+        /* Catches peaks between samples */
+        update_peak(&g_rss_peak_bytes, hwm);
+    }
+    atomic_fetch_add(&g_rss_samples, 1);
+}
+
+double membudget_bytes_per_queued_packet(const membudget_snapshot_t *snapshot) {
+    if (snapshot == NULL || snapshot->queued_packets == 0) return 0.0;
+    return (double)snapshot->queued_bytes / (double)snapshot->queued_packets;
+}
+
+bool membudget_admit(size_t bytes) {
+    if (g_budget_bytes == 0) return true;
+
+    uint64_t used = atomic_load_explicit(&g_used_bytes, memory_order_relaxed);
+    if (used + bytes > g_budget_bytes) {
+        atomic_fetch_add_explicit(&g_admission_drops, 1, memory_order_relaxed);
+        return false;
+    }
+
+    if (atomic_load_explicit(&g_level, memory_order_relaxed) >= MEM_DEGRADE_SAMPLING) {
+        uint64_t n = atomic_fetch_add_explicit(&g_sample_counter, 1, memory_order_relaxed);
+        if (n % MEMBUDGET_SAMPLE_RATE != 0) {
+            atomic_fetch_add_explicit(&g_sampled_out, 1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t membudget_snaplen(uint32_t length) {
+    if (atomic_load_explicit(&g_level, memory_order_relaxed) >= MEM_DEGRADE_SNAPLEN &&
+        length > MEMBUDGET_DEGRADED_SNAPLEN) {
+        return MEMBUDGET_DEGRADED_SNAPLEN;
+    }
+    return length;
+}
+
+bool membudget_payload_enabled(void) {
+    return atomic_load_explicit(&g_level, memory_order_relaxed) < MEM_DEGRADE_NO_PAYLOAD;
+}
+
+mem_degrade_level_t membudget_level(void) {
+    return (mem_degrade_level_t)atomic_load_explicit(&g_level, memory_order_relaxed);
+}
+
+const char* membudget_level_name(mem_degrade_level_t level) {
+    if ((int)level < 0 || level >= MEM_DEGRADE_LEVELS) return "unknown";
+    return level_names[level];
+}
+
+const char* membudget_subsys_name(mem_subsys_t subsys) {
+    if (subsys >= MEM_SUBSYS_COUNT) return "unknown";
+    return subsys_names[subsys];
+}
+
+void membudget_snapshot(membudget_snapshot_t *snapshot) {
+    if (snapshot == NULL) return;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->budget_bytes = g_budget_bytes;
+    snapshot->used_bytes = atomic_load(&g_used_bytes);
+    snapshot->peak_bytes = atomic_load(&g_peak_bytes);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++) {
+        snapshot->subsys_bytes[i] = atomic_load(&g_subsys[i].bytes);
+        snapshot->subsys_peak_bytes[i] = atomic_load(&g_subsys[i].peak_bytes);
+        snapshot->subsys_allocs[i] = atomic_load(&g_subsys[i].allocs);
+        snapshot->subsys_alloc_bytes[i] = atomic_load(&g_subsys[i].alloc_bytes);
+    }
+    logger_memory_usage(&snapshot->log_bytes, &snapshot->log_allocs);
+    snapshot->queued_packets = atomic_load(&g_queued_packets);
+    snapshot->queued_bytes = atomic_load(&g_queued_bytes);
+    snapshot->rss_valid = atomic_load(&g_rss_valid);
+    snapshot->rss_bytes = atomic_load(&g_rss_bytes);
+    snapshot->rss_start_bytes = atomic_load(&g_rss_start_bytes);
+    snapshot->rss_peak_bytes = atomic_load(&g_rss_peak_bytes);
+    snapshot->rss_samples = atomic_load(&g_rss_samples);
+    snapshot->level = (mem_degrade_level_t)atomic_load(&g_level);
+    snapshot->admission_drops = atomic_load(&g_admission_drops);
+    snapshot->sampled_out = atomic_load(&g_sampled_out);
+
+    lockstat_lock(&g_transition_lock);
+    snapshot->transition_count = g_transition_count;
+    uint64_t retained = g_transition_count < MEMBUDGET_MAX_TRANSITIONS ?
+        g_transition_count : MEMBUDGET_MAX_TRANSITIONS;
+    uint64_t first = g_transition_count - retained;
+    for (uint64_t i = 0; i < retained; i++) {
+        snapshot->transitions[i] = g_transitions[(first + i) % MEMBUDGET_MAX_TRANSITIONS];
+    }
+    snapshot->transitions_retained = (int)retained;
+    lockstat_unlock(&g_transition_lock);
+}
+
+/**
+ * @brief Write one per-subsystem object member of the memory block
+ */
+static void write_subsys_json(FILE *fp, const char *key, const uint64_t *values) {
+    fprintf(fp, "    \"%s\": {\n", key);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++) {
+        fprintf(fp, "      \"%s\": %" PRIu64 "%s\n", subsys_names[i], values[i],
+                (i < MEM_SUBSYS_COUNT - 1) ? "," : "");
+    }
+    fprintf(fp, "    },\n");
+}
+
+void membudget_write_json(FILE *fp) {
+    if (fp == NULL) return;
+
+    membudget_snapshot_t snap;
+    membudget_snapshot(&snap);
+
+    fprintf(fp, "  \"memory\": {\n");
+    fprintf(fp, "    \"budget_bytes\": %" PRIu64 ",\n", snap.budget_bytes);
+    fprintf(fp, "    \"used_bytes\": %" PRIu64 ",\n", snap.used_bytes);
+    fprintf(fp, "    \"peak_bytes\": %" PRIu64 ",\n", snap.peak_bytes);
+    write_subsys_json(fp, "subsystems", snap.subsys_bytes);
+    write_subsys_json(fp, "subsystem_peak_bytes", snap.subsys_peak_bytes);
+    write_subsys_json(fp, "allocations", snap.subsys_allocs);
+    write_subsys_json(fp, "allocated_bytes", snap.subsys_alloc_bytes);
+    fprintf(fp, "    \"log_buffer_bytes\": %" PRIu64 ",\n", snap.log_bytes);
+    fprintf(fp, "    \"log_buffer_allocations\": %" PRIu64 ",\n", snap.log_allocs);
+    fprintf(fp, "    \"queued_packets\": %" PRIu64 ",\n", snap.queued_packets);
+    fprintf(fp, "    \"bytes_per_queued_packet\": %.1f,\n", membudget_bytes_per_queued_packet(&snap));
+    fprintf(fp, "    \"rss_available\": %s,\n", snap.rss_valid ? "true" : "false");
+    fprintf(fp, "    \"rss_bytes\": %" PRIu64 ",\n", snap.rss_bytes);
+    fprintf(fp, "    \"rss_start_bytes\": %" PRIu64 ",\n", snap.rss_start_bytes);
+    fprintf(fp, "    \"peak_rss_bytes\": %" PRIu64 ",\n", snap.rss_peak_bytes);
+    fprintf(fp, "    \"rss_growth_bytes\": %" PRId64 ",\n",
+            (int64_t)snap.rss_bytes - (int64_t)snap.rss_start_bytes);
+    fprintf(fp, "    \"rss_samples\": %" PRIu64 ",\n", snap.rss_samples);
+    fprintf(fp, "    \"level\": \"%s\",\n", level_names[snap.level]);
+    fprintf(fp, "    \"admission_drops\": %" PRIu64 ",\n", snap.admission_drops);
+    fprintf(fp, "    \"sampled_out\": %" PRIu64 ",\n", snap.sampled_out);
+    fprintf(fp, "    \"level_change_count\": %" PRIu64 ",\n", snap.transition_count);
+    fprintf(fp, "    \"level_changes\": [");
+    for (int i = 0; i < snap.transitions_retained; i++) {
+        const membudget_transition_t *t = &snap.transitions[i];
+        fprintf(fp, "%s\n      {\"time_ns\": %" PRIu64 ", \"from\": \"%s\", \"to\": \"%s\", "
+                "\"used_bytes\": %" PRIu64 "}",
+                i > 0 ? "," : "", t->time_ns, level_names[t->from], level_names[t->to],
+                t->used_bytes);
+    }
+    fprintf(fp, "%s]\n", snap.transitions_retained > 0 ? "\n    " : "");
+    fprintf(fp, "  }");
+}
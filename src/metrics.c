@@ -8,80 +8,318 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
 #include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/utsname.h>
+#include <arpa/inet.h>
 #include "metrics.h"
+#include "membudget.h"
+#include "profiler.h"
+#include "lockstat.h"
+#include "anomaly.h"
 
 /* Build git SHA - defined at compile time via -DGIT_SHA="..." */
 #ifndef GIT_SHA
 #define GIT_SHA "unknown"
 #endif
 
-/* Global metrics instance */
-static metrics_t g_metrics;
+/* Shared metrics, double-buffered: the current epoch uses g_metrics_buf[epoch & 1] */
+static metrics_t g_metrics_buf[2];
 
 /* Global metadata instance */
 static metrics_metadata_t g_metadata;
 
+/* Registered thread shards (registry protected by g_shard_lock) */
+static lockstat_mutex_t g_shard_lock = LOCKSTAT_MUTEX_INITIALIZER(LOCKSTAT_METRICS);
+static metrics_shard_t *g_shards[METRICS_MAX_SHARDS];
+static int g_shard_count = 0;
+
+/* Advanced by metrics_init(); shards and buffers from an older epoch are stale */
+static _Atomic uint64_t g_epoch = 1;
+
+static _Thread_local metrics_shard_t *tls_shard = NULL;
+
+/**
+ * @brief Buffer of the current epoch (main thread, or with g_shard_lock held)
+ */
+static inline metrics_t *active_metrics(void) {
+    return &g_metrics_buf[atomic_load(&g_epoch) & 1];
+}
+
+/**
+ * @brief Enter the current buffer for a shared-path update
+ *
+ * The writer count is raised before the epoch is checked again, so
+ * metrics_init() either waits for this writer or the writer retries in
+ * the new buffer. Pair with shared_exit().
+ */
+static inline metrics_t *shared_enter(void) {
+    for (;;) {
+        uint64_t epoch = atomic_load(&g_epoch);
+        metrics_t *m = &g_metrics_buf[epoch & 1];
+        atomic_fetch_add(&m->writers, 1);
+        if (atomic_load(&g_epoch) == epoch) return m;
+        atomic_fetch_sub(&m->writers, 1);
+    }
+}
+
+static inline void shared_exit(metrics_t *m) {
+    atomic_fetch_sub_explicit(&m->writers, 1, memory_order_release);
+}
+
+/* Window CPU time of threads that unregistered since metrics_start() (g_shard_lock) */
+static uint64_t g_cpu_exited_ns = 0;
+static bool g_cpu_exited_valid = true;
+
+/* Work queue capacity, kept across metrics_init() */
+static _Atomic uint32_t g_queue_capacity = 0;
+
+/**
+ * @brief Work queue gauges, outside the epoch double buffer
+ *
+ * Every update already runs under the pool's queue lock, so writers use
+ * relaxed load + store and never enter the shared buffer. Resets are
+ * lazy: metrics_init() and metrics_start() only move g_epoch and
+ * g_queue_window_ticks, and the next update under the lock starts the
+ * counters and integrals over, carrying the live depth across.
+ */
+typedef struct {
+    _Atomic uint64_t epoch;             /* Epoch the counters belong to */
+    _Atomic uint64_t window_ticks;      /* Window the integrals belong to */
+    _Atomic uint32_t depth;             /* Current depth (gauge, never reset) */
+    _Atomic uint32_t depth_max;
+    _Atomic uint64_t occupancy[METRICS_QUEUE_OCC_BUCKETS];
+    _Atomic uint64_t area_ticks;        /* Integral of depth over time */
+    _Atomic uint64_t high_ticks;        /* Time at or above the high threshold */
+    _Atomic uint64_t change_ticks;      /* Last depth change, 0 before the first */
+} metrics_queue_t;
+
+static metrics_queue_t g_queue;
+
+/* Start of the queue integrals (metrics_start(), 0 until then) */
+static _Atomic uint64_t g_queue_window_ticks = 0;
+
+static const char *g_queue_occupancy_names[METRICS_QUEUE_OCC_BUCKETS] = {
+    "0-10", "10-20", "20-30", "30-40", "40-50", "50-60", "60-70", "70-80", "80-90", "90-100", "full"
+};
+
+/* HDR precision applied by the next metrics_init() */
+static int g_latency_digits = METRICS_LATENCY_DIGITS_DEFAULT;
+
+static const char *g_stage_names[METRICS_STAGE_COUNT] = {
+    "capture", "queue", "parse", "analyze"
+};
+
+/* Exemplar timestamps: end of each stage */
+static const char *g_exemplar_ts_names[METRICS_STAGE_COUNT] = {
+    "enqueued", "dequeued", "parsed", "analyzed"
+};
+
+static const char *g_l4_names[METRICS_L4_COUNT] = {
+    "tcp", "udp", "icmp", "other"
+};
+
+static const char *g_ethertype_names[] = { "ipv4", "ipv6", "arp", "other" };
+
+/* OpenMetrics label values; the JSON keeps its own "errors" block */
+static const char *g_error_names[] = { "parse", "checksum" };
+static const char *g_drop_names[] = { "queue", "capture" };
+
+/* Registry ids of the counters recorded through this module, and their
+ * slots resolved once for the per-packet path. Written only by the first
+ * metrics_init(), before any thread records; registry_reset() clears the
+ * values, never the layout. */
+static pthread_once_t g_register_once = PTHREAD_ONCE_INIT;
+static int g_errors_metric = -1;
+static int g_drops_metric = -1;
+static int g_ethertype_metric = -1;
+static int g_protocols_metric = -1;
+static int g_error_slot[2] = { -1, -1 };
+static int g_drop_slot[2] = { -1, -1 };
+static int g_ethertype_slot[4] = { -1, -1, -1, -1 };
+static int g_protocol_slot[METRICS_L4_COUNT] = { -1, -1, -1, -1 };
+
+/* Upper bound of each size class; the last class takes everything above */
+static const uint32_t g_size_class_max[METRICS_SIZE_CLASS_COUNT - 1] = {
+    64, 128, 256, 512, 1024, 1518
+};
+static const char *g_size_class_names[METRICS_SIZE_CLASS_COUNT] = {
+    "0-64", "65-128", "129-256", "257-512", "513-1024", "1025-1518", "1519+"
+};
+
+/**
+ * @brief Reuse a histogram for a new epoch, reallocating if the precision changed
+ */
+static hdr_histogram_t* latency_hdr_renew(hdr_histogram_t *h) {
+    if (h != NULL && h->significant_digits == g_latency_digits) {
+        hdr_reset(h);
+        return h;
+    }
+    hdr_destroy(h);
+    return hdr_create(METRICS_LATENCY_MAX_NS, g_latency_digits);
+}
+
+/**
+ * @brief Reset a protocol x size class histogram, creating it on first use
+ */
+static hdr_histogram_t* class_hdr_renew(hdr_histogram_t *h) {
+    if (h != NULL) {
+        hdr_reset(h);
+        return h;
+    }
+    return hdr_create(METRICS_LATENCY_MAX_NS, METRICS_CLASS_DIGITS);
+}
+
+/**
+ * @brief Register the counters this module keeps in the registry (once)
+ */
+static void register_builtin_metrics(void) {
+    static const registry_desc_t errors = {
+        .name = "errors", .help = "Packets rejected by the parser.", .type = REGISTRY_COUNTER,
+        .label = "type", .label_values = g_error_names, .label_count = 2, .json_owned = true
+    };
+    static const registry_desc_t drops = {
+        .name = "drops", .help = "Packets dropped before processing.", .type = REGISTRY_COUNTER,
+        .label = "where", .label_values = g_drop_names, .label_count = 2, .json_owned = true
+    };
+    static const registry_desc_t ethertype = {
+        .name = "ethertype", .family = "ethertype_packets",
+        .help = "Processed packets by EtherType.", .type = REGISTRY_COUNTER,
+        .label = "ethertype", .label_values = g_ethertype_names, .label_count = 4
+    };
+    static const registry_desc_t protocols = {
+        .name = "protocols", .family = "protocol_packets",
+        .help = "Processed packets by L4 protocol.", .type = REGISTRY_COUNTER,
+        .label = "protocol", .label_values = g_l4_names, .label_count = METRICS_L4_COUNT
+    };
+    g_errors_metric = registry_register(&errors);
+    g_drops_metric = registry_register(&drops);
+    g_ethertype_metric = registry_register(&ethertype);
+    g_protocols_metric = registry_register(&protocols);
+    for (int i = 0; i < 2; i++) {
+        g_error_slot[i] = registry_counter_slot(g_errors_metric, i);
+        g_drop_slot[i] = registry_counter_slot(g_drops_metric, i);
+    }
+    for (int i = 0; i < 4; i++) {
+        g_ethertype_slot[i] = registry_counter_slot(g_ethertype_metric, i);
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        g_protocol_slot[l] = registry_counter_slot(g_protocols_metric, l);
+    }
+    lockstat_register();
+}
+
+/**
+ * @brief Read a thread CPU-time clock in nanoseconds (0 if it cannot be read)
+ */
+static uint64_t cpu_clock_ns(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Start the CPU and busy/idle window of every registered thread
+ */
+static void cpu_window_begin(void) {
+    lockstat_lock(&g_shard_lock);
+    for (int s = 0; s < g_shard_count; s++) {
+        metrics_shard_t *shard = g_shards[s];
+        shard->cpu_base_ns = shard->has_cpu_clock ? cpu_clock_ns(shard->cpu_clock) : 0;
+        shard->busy_base_ticks = atomic_load_explicit(&shard->busy_ticks, memory_order_relaxed);
+        shard->idle_base_ticks = atomic_load_explicit(&shard->idle_ticks, memory_order_relaxed);
+    }
+    g_cpu_exited_ns = 0;
+    g_cpu_exited_valid = true;
+    lockstat_unlock(&g_shard_lock);
+}
+
 /* ============================================================================
  * Core Functions
  * ============================================================================ */
 
 void metrics_init(void) {
-    memset(&g_metrics, 0, sizeof(metrics_t));
+    fastclock_init();
     
-    /* Explicitly initialize all atomics to zero */
-    atomic_store(&g_metrics.pkts_captured, 0);
-    atomic_store(&g_metrics.pkts_processed, 0);
-    atomic_store(&g_metrics.bytes_captured, 0);
-    atomic_store(&g_metrics.bytes_processed, 0);
+    pthread_once(&g_register_once, register_builtin_metrics);
     
-    atomic_store(&g_metrics.parse_errors, 0);
-    atomic_store(&g_metrics.checksum_failures, 0);
-    atomic_store(&g_metrics.queue_drops, 0);
-    atomic_store(&g_metrics.capture_drops, 0);
+    /* Readers hold the lock, so the idle buffer is only touched here */
+    lockstat_lock(&g_shard_lock);
+    uint64_t epoch = atomic_load(&g_epoch);
+    metrics_t *retired = &g_metrics_buf[epoch & 1];
+    metrics_t *next = &g_metrics_buf[(epoch + 1) & 1];
     
-    atomic_store(&g_metrics.ether_ipv4, 0);
-    atomic_store(&g_metrics.ether_ipv6, 0);
-    atomic_store(&g_metrics.ether_arp, 0);
-    atomic_store(&g_metrics.ether_other, 0);
+    /* No writers: they left when it was retired, and stale ones back off
+     * before touching anything but the writer count */
+    hdr_histogram_t *latency_hdr = next->latency_hdr;
+    hdr_histogram_t *stage_hdr[METRICS_STAGE_COUNT];
+    hdr_histogram_t *class_hdr[METRICS_L4_COUNT][METRICS_SIZE_CLASS_COUNT];
+    memcpy(stage_hdr, next->stage_hdr, sizeof(stage_hdr));
+    memcpy(class_hdr, next->class_hdr, sizeof(class_hdr));
+    memset(next, 0, offsetof(metrics_t, epoch));
     
-    atomic_store(&g_metrics.proto_tcp, 0);
-    atomic_store(&g_metrics.proto_udp, 0);
-    atomic_store(&g_metrics.proto_icmp, 0);
-    atomic_store(&g_metrics.proto_other, 0);
-    
-    atomic_store(&g_metrics.queue_depth_max, 0);
+    /* Keep the allocations across runs unless the precision changed */
+    next->latency_hdr = latency_hdr_renew(latency_hdr);
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        next->stage_hdr[i] = latency_hdr_renew(stage_hdr[i]);
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            next->class_hdr[l][c] = class_hdr_renew(class_hdr[l][c]);
+        }
+    }
     
-    atomic_store(&g_metrics.latency_count, 0);
-    atomic_store(&g_metrics.latency_sum_ns, 0);
-    atomic_store(&g_metrics.latency_max_ns, 0);
+    next->epoch = epoch + 1;
+    atomic_store(&g_queue_window_ticks, 0);
     
-    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
-        atomic_store(&g_metrics.latency_histogram[i], 0);
+    /* Publish; shards are reset lazily by their owners on their next update.
+     * The registry counters are cut in the same critical section, so no
+     * snapshot sees one side of the switch without the other. */
+    registry_reset();
+    atomic_store(&g_epoch, epoch + 1);
+    while (atomic_load(&retired->writers) != 0) {
+        sched_yield();
     }
-    
-    g_metrics.start_time_ns = 0;
-    g_metrics.capture_end_time_ns = 0;
+    lockstat_unlock(&g_shard_lock);
+}
+
+int metrics_set_latency_digits(int digits) {
+    if (digits < HDR_DIGITS_MIN || digits > HDR_DIGITS_MAX) {
+        return -1;
+    }
+    g_latency_digits = digits;
+    return 0;
 }
 
 void metrics_start(void) {
-    g_metrics.start_time_ns = metrics_now_ns();
+    perfcount_window_begin();
+    cpu_window_begin();
+    membudget_window_begin();
+
+    /* Queue integrals cover the measurement window only */
+    atomic_store(&g_queue_window_ticks, fastclock_ticks());
+
+    metrics_t *m = shared_enter();
+    m->start_time_ns = metrics_now_ns();
+    shared_exit(m);
 }
 
 void metrics_stop_capture(void) {
-    g_metrics.capture_end_time_ns = metrics_now_ns();
+    active_metrics()->capture_end_time_ns = metrics_now_ns();
 }
 
 bool metrics_is_active(void) {
-    return g_metrics.start_time_ns > 0;
+    return active_metrics()->start_time_ns > 0;
 }
 
 uint64_t metrics_now_ns(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    return fastclock_monotonic_ns();
 }
 
 /* ============================================================================
@@ -112,108 +350,596 @@ static inline int latency_bucket(uint64_t latency_ns) {
     return bucket;
 }
 
+/* ============================================================================
+ * Exemplar Heaps
+ * ============================================================================ */
+
+/**
+ * @brief Offer an exemplar to a min-heap of at most METRICS_EXEMPLARS entries
+ *
+ * heap[0] is the fastest kept packet, so a full heap only changes when
+ * the new one is slower than that.
+ */
+static void exemplar_push(metrics_exemplar_t *heap, int *count, const metrics_exemplar_t *e) {
+    int i;
+    if (*count < METRICS_EXEMPLARS) {
+        /* Sift up from the new leaf */
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2].latency_ns > e->latency_ns) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *e;
+        return;
+    }
+    if (e->latency_ns <= heap[0].latency_ns) return;
+
+    /* Replace the root and sift down */
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *count) break;
+        if (child + 1 < *count && heap[child + 1].latency_ns < heap[child].latency_ns) {
+            child++;
+        }
+        if (heap[child].latency_ns >= e->latency_ns) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = *e;
+}
+
+static int exemplar_compare_desc(const void *a, const void *b) {
+    uint64_t la = ((const metrics_exemplar_t *)a)->latency_ns;
+    uint64_t lb = ((const metrics_exemplar_t *)b)->latency_ns;
+    return la < lb ? 1 : (la > lb ? -1 : 0);
+}
+
+/**
+ * @brief Copy a shard's exemplar heap while its owner may be writing it
+ *
+ * @return Number of entries copied, 0 if the owner kept changing it
+ */
+static int shard_exemplars_read(const metrics_shard_t *shard, metrics_exemplar_t *out) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        uint32_t seq = atomic_load_explicit(&shard->exemplar_seq, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        int count = shard->exemplar_count;
+        if (count < 0 || count > METRICS_EXEMPLARS) continue;
+        memcpy(out, shard->exemplars, (size_t)count * sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shard->exemplar_seq, memory_order_relaxed) == seq) {
+            return count;
+        }
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Thread Shards
+ * ============================================================================ */
+
+/**
+ * @brief Free a shard and its histograms
+ */
+static void shard_free(metrics_shard_t *shard) {
+    hdr_destroy(shard->latency_hdr);
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        hdr_destroy(shard->stage_hdr[i]);
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            hdr_destroy(shard->class_hdr[l][c]);
+        }
+    }
+    free(shard);
+}
+
+int metrics_register_thread(void) {
+    if (tls_shard != NULL) return 0;
+
+    metrics_shard_t *shard = aligned_alloc(METRICS_CACHE_LINE, sizeof(metrics_shard_t));
+    if (shard == NULL) return -1;
+    memset(shard, 0, sizeof(*shard));
+    bool allocated = (shard->latency_hdr = hdr_create(METRICS_LATENCY_MAX_NS, g_latency_digits)) != NULL;
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        shard->stage_hdr[i] = hdr_create(METRICS_LATENCY_MAX_NS, g_latency_digits);
+        allocated = allocated && shard->stage_hdr[i] != NULL;
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            shard->class_hdr[l][c] = hdr_create(METRICS_LATENCY_MAX_NS, METRICS_CLASS_DIGITS);
+            allocated = allocated && shard->class_hdr[l][c] != NULL;
+        }
+    }
+    if (!allocated) {
+        shard_free(shard);
+        return -1;
+    }
+    atomic_store(&shard->generation, atomic_load(&g_epoch));
+
+    /* The clock id lets metrics_snapshot() read this thread's CPU time from outside */
+    snprintf(shard->name, sizeof(shard->name), "thread");
+#if defined(_POSIX_THREAD_CPUTIME) && _POSIX_THREAD_CPUTIME >= 0
+    shard->has_cpu_clock = pthread_getcpuclockid(pthread_self(), &shard->cpu_clock) == 0;
+#endif
+    shard->cpu_base_ns = shard->has_cpu_clock ? cpu_clock_ns(shard->cpu_clock) : 0;
+
+    lockstat_lock(&g_shard_lock);
+    if (g_shard_count >= METRICS_MAX_SHARDS) {
+        lockstat_unlock(&g_shard_lock);
+        shard_free(shard);
+        return -1;
+    }
+    g_shards[g_shard_count++] = shard;
+    lockstat_unlock(&g_shard_lock);
+
+    tls_shard = shard;
+    registry_register_thread();
+    perfcount_register_thread();
+    return 0;
+}
+
+void metrics_unregister_thread(void) {
+    metrics_shard_t *shard = tls_shard;
+    if (shard == NULL) return;
+
+    lockstat_lock(&g_shard_lock);
+    for (int i = 0; i < g_shard_count; i++) {
+        if (g_shards[i] == shard) {
+            g_shards[i] = g_shards[--g_shard_count];
+            break;
+        }
+    }
+
+    /* Keep the counts: fold a current-epoch shard into the globals */
+    if (atomic_load(&shard->generation) == atomic_load(&g_epoch)) {
+        metrics_t *m = active_metrics();
+        atomic_fetch_add(&m->pkts_captured, atomic_load(&shard->pkts_captured));
+        atomic_fetch_add(&m->pkts_processed, atomic_load(&shard->pkts_processed));
+        atomic_fetch_add(&m->bytes_captured, atomic_load(&shard->bytes_captured));
+        atomic_fetch_add(&m->bytes_processed, atomic_load(&shard->bytes_processed));
+        atomic_fetch_add(&m->latency_count, atomic_load(&shard->latency_count));
+        atomic_fetch_add(&m->latency_sum_ns, atomic_load(&shard->latency_sum_ns));
+        if (m->latency_hdr != NULL) {
+            hdr_add(m->latency_hdr, shard->latency_hdr);
+        }
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            if (m->stage_hdr[i] != NULL) {
+                hdr_add(m->stage_hdr[i], shard->stage_hdr[i]);
+            }
+        }
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                atomic_fetch_add(&m->class_packets[l][c], atomic_load(&shard->class_packets[l][c]));
+                atomic_fetch_add(&m->class_bytes[l][c], atomic_load(&shard->class_bytes[l][c]));
+                if (m->class_hdr[l][c] != NULL) {
+                    hdr_add(m->class_hdr[l][c], shard->class_hdr[l][c]);
+                }
+            }
+        }
+
+        uint64_t shard_max = atomic_load(&shard->latency_max_ns);
+        uint64_t current_max = atomic_load(&m->latency_max_ns);
+        while (shard_max > current_max &&
+               !atomic_compare_exchange_weak(&m->latency_max_ns, &current_max, shard_max)) {
+        }
+        for (int i = 0; i < shard->exemplar_count; i++) {
+            exemplar_push(m->exemplars, &m->exemplar_count, &shard->exemplars[i]);
+        }
+    }
+
+    /* Keep the window CPU time of the exiting thread */
+    if (shard->has_cpu_clock) {
+        uint64_t cpu_ns = cpu_clock_ns(shard->cpu_clock);
+        g_cpu_exited_ns += cpu_ns > shard->cpu_base_ns ? cpu_ns - shard->cpu_base_ns : 0;
+    } else {
+        g_cpu_exited_valid = false;
+    }
+    lockstat_unlock(&g_shard_lock);
+
+    tls_shard = NULL;
+    shard_free(shard);
+    registry_unregister_thread();
+    perfcount_unregister_thread();
+}
+
+void metrics_set_thread_name(const char *name) {
+    metrics_shard_t *shard = tls_shard;
+    if (shard == NULL || name == NULL) return;
+
+    lockstat_lock(&g_shard_lock);
+    snprintf(shard->name, sizeof(shard->name), "%s", name);
+    lockstat_unlock(&g_shard_lock);
+}
+
+/**
+ * @brief Get the calling thread's shard, clearing it after a metrics reset
+ *
+ * @return The shard, or NULL if the thread is not registered
+ */
+static inline metrics_shard_t *current_shard(void) {
+    metrics_shard_t *shard = tls_shard;
+    if (shard == NULL) return NULL;
+
+    uint64_t generation = atomic_load_explicit(&g_epoch, memory_order_relaxed);
+    if (atomic_load_explicit(&shard->generation, memory_order_relaxed) != generation) {
+        /* Zero the counters before publishing the new epoch to readers */
+        atomic_store_explicit(&shard->generation, 0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        _Atomic uint64_t *counters = &shard->pkts_captured;
+        size_t n = (sizeof(*shard) - offsetof(metrics_shard_t, pkts_captured)) / sizeof(uint64_t);
+        for (size_t i = 0; i < n; i++) {
+            atomic_store_explicit(&counters[i], 0, memory_order_relaxed);
+        }
+        hdr_reset(shard->latency_hdr);
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            hdr_reset(shard->stage_hdr[i]);
+        }
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                hdr_reset(shard->class_hdr[l][c]);
+            }
+        }
+        shard->exemplar_count = 0;
+        atomic_store_explicit(&shard->generation, generation, memory_order_release);
+    }
+    return shard;
+}
+
+/**
+ * @brief Single-writer increment: relaxed load + store, no locked RMW
+ */
+static inline void shard_add(_Atomic uint64_t *counter, uint64_t n) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
+}
+
+void metrics_add_thread_time(uint64_t busy_ticks, uint64_t idle_ticks) {
+    metrics_shard_t *shard = tls_shard;
+    if (shard == NULL) return;
+
+    /* Never reset, so no epoch check: readers subtract the window base */
+    shard_add(&shard->busy_ticks, busy_ticks);
+    shard_add(&shard->idle_ticks, idle_ticks);
+}
+
 void metrics_observe_latency(uint64_t latency_ns) {
+    metrics_shard_t *shard = current_shard();
+
+    if (shard != NULL) {
+        shard_add(&shard->latency_count, 1);
+        shard_add(&shard->latency_sum_ns, latency_ns);
+        if (latency_ns > atomic_load_explicit(&shard->latency_max_ns, memory_order_relaxed)) {
+            atomic_store_explicit(&shard->latency_max_ns, latency_ns, memory_order_relaxed);
+        }
+        hdr_record_local(shard->latency_hdr, latency_ns);
+        return;
+    }
+
+    metrics_t *m = shared_enter();
+
     /* Update count */
-    atomic_fetch_add(&g_metrics.latency_count, 1);
+    atomic_fetch_add(&m->latency_count, 1);
     
     /* Update sum */
-    atomic_fetch_add(&g_metrics.latency_sum_ns, latency_ns);
+    atomic_fetch_add(&m->latency_sum_ns, latency_ns);
     
     /* Update max using compare-exchange loop */
-    uint64_t current_max = atomic_load(&g_metrics.latency_max_ns);
+    uint64_t current_max = atomic_load(&m->latency_max_ns);
     while (latency_ns > current_max) {
-        if (atomic_compare_exchange_weak(&g_metrics.latency_max_ns, 
+        if (atomic_compare_exchange_weak(&m->latency_max_ns, 
                                           &current_max, latency_ns)) {
             break;
         }
     }
     
     /* Update histogram */
-    int bucket = latency_bucket(latency_ns);
-    atomic_fetch_add(&g_metrics.latency_histogram[bucket], 1);
+    if (m->latency_hdr != NULL) {
+        hdr_record(m->latency_hdr, latency_ns);
+    }
+    shared_exit(m);
 }
 
-void metrics_record_protocol(uint8_t protocol) {
+void metrics_observe_stage(metrics_stage_t stage, uint64_t latency_ns) {
+    if ((unsigned)stage >= METRICS_STAGE_COUNT) return;
+
+    metrics_shard_t *shard = current_shard();
+    if (shard != NULL) {
+        hdr_record_local(shard->stage_hdr[stage], latency_ns);
+        return;
+    }
+
+    metrics_t *m = shared_enter();
+    if (m->stage_hdr[stage] != NULL) {
+        hdr_record(m->stage_hdr[stage], latency_ns);
+    }
+    shared_exit(m);
+}
+
+metrics_l4_t metrics_l4_class(uint8_t protocol) {
     switch (protocol) {
         case PROTO_TCP:
-            atomic_fetch_add(&g_metrics.proto_tcp, 1);
-            break;
+            return METRICS_L4_TCP;
         case PROTO_UDP:
-            atomic_fetch_add(&g_metrics.proto_udp, 1);
-            break;
+            return METRICS_L4_UDP;
         case PROTO_ICMP:
         case PROTO_ICMPV6:
-            atomic_fetch_add(&g_metrics.proto_icmp, 1);
-            break;
+            return METRICS_L4_ICMP;
         default:
-            atomic_fetch_add(&g_metrics.proto_other, 1);
-            break;
+            return METRICS_L4_OTHER;
+    }
+}
+
+int metrics_size_class(uint32_t length) {
+    int c = 0;
+    while (c < METRICS_SIZE_CLASS_COUNT - 1 && length > g_size_class_max[c]) {
+        c++;
     }
+    return c;
+}
+
+void metrics_observe_class(uint8_t protocol, uint32_t length, uint64_t latency_ns) {
+    metrics_l4_t l4 = metrics_l4_class(protocol);
+    int c = metrics_size_class(length);
+
+    metrics_shard_t *shard = current_shard();
+    if (shard != NULL) {
+        shard_add(&shard->class_packets[l4][c], 1);
+        shard_add(&shard->class_bytes[l4][c], length);
+        hdr_record_local(shard->class_hdr[l4][c], latency_ns);
+        return;
+    }
+
+    metrics_t *m = shared_enter();
+    atomic_fetch_add(&m->class_packets[l4][c], 1);
+    atomic_fetch_add(&m->class_bytes[l4][c], length);
+    if (m->class_hdr[l4][c] != NULL) {
+        hdr_record(m->class_hdr[l4][c], latency_ns);
+    }
+    shared_exit(m);
+}
+
+bool metrics_exemplar_wanted(uint64_t latency_ns) {
+    metrics_shard_t *shard = current_shard();
+    if (shard == NULL) return true;     /* Decided under the lock */
+    return shard->exemplar_count < METRICS_EXEMPLARS || latency_ns > shard->exemplars[0].latency_ns;
+}
+
+void metrics_observe_exemplar(const metrics_exemplar_t *exemplar) {
+    if (exemplar == NULL) return;
+
+    metrics_shard_t *shard = current_shard();
+    if (shard != NULL) {
+        if (shard->exemplar_count == METRICS_EXEMPLARS &&
+            exemplar->latency_ns <= shard->exemplars[0].latency_ns) {
+            return;
+        }
+        uint32_t seq = atomic_load_explicit(&shard->exemplar_seq, memory_order_relaxed);
+        atomic_store_explicit(&shard->exemplar_seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        exemplar_push(shard->exemplars, &shard->exemplar_count, exemplar);
+        atomic_store_explicit(&shard->exemplar_seq, seq + 2, memory_order_release);
+        return;
+    }
+
+    /* Rare: threads without a shard share one heap */
+    lockstat_lock(&g_shard_lock);
+    metrics_t *m = active_metrics();
+    exemplar_push(m->exemplars, &m->exemplar_count, exemplar);
+    lockstat_unlock(&g_shard_lock);
+}
+
+const char* metrics_l4_name(metrics_l4_t l4) {
+    if ((unsigned)l4 >= METRICS_L4_COUNT) return "unknown";
+    return g_l4_names[l4];
+}
+
+const char* metrics_size_class_name(int size_class) {
+    if (size_class < 0 || size_class >= METRICS_SIZE_CLASS_COUNT) return "unknown";
+    return g_size_class_names[size_class];
+}
+
+const char* metrics_stage_name(metrics_stage_t stage) {
+    if ((unsigned)stage >= METRICS_STAGE_COUNT) return "unknown";
+    return g_stage_names[stage];
+}
+
+void metrics_record_protocol(uint8_t protocol) {
+    registry_add_slot(g_protocol_slot[metrics_l4_class(protocol)], 1);
 }
 
 void metrics_record_ethertype(uint16_t ethertype) {
+    int series;
     switch (ethertype) {
         case ETHER_IPV4:
-            atomic_fetch_add(&g_metrics.ether_ipv4, 1);
+            series = 0;
             break;
         case ETHER_IPV6:
-            atomic_fetch_add(&g_metrics.ether_ipv6, 1);
+            series = 1;
             break;
         case ETHER_ARP:
-            atomic_fetch_add(&g_metrics.ether_arp, 1);
+            series = 2;
             break;
         default:
-            atomic_fetch_add(&g_metrics.ether_other, 1);
+            series = 3;
             break;
     }
+    registry_add_slot(g_ethertype_slot[series], 1);
 }
 
+/* Packets and bytes go to the same epoch */
+#define METRICS_ADD_PACKET(pkts, bytes_field, bytes) do { \
+    metrics_shard_t *shard_ = current_shard(); \
+    if (shard_ != NULL) { \
+        shard_add(&shard_->pkts, 1); \
+        shard_add(&shard_->bytes_field, (bytes)); \
+    } else { \
+        metrics_t *m_ = shared_enter(); \
+        atomic_fetch_add(&m_->pkts, 1); \
+        atomic_fetch_add(&m_->bytes_field, (bytes)); \
+        shared_exit(m_); \
+    } \
+} while (0)
+
 void metrics_inc_captured(uint32_t bytes) {
-    atomic_fetch_add(&g_metrics.pkts_captured, 1);
-    atomic_fetch_add(&g_metrics.bytes_captured, bytes);
+    METRICS_ADD_PACKET(pkts_captured, bytes_captured, bytes);
 }
 
 void metrics_inc_processed(uint32_t bytes) {
-    atomic_fetch_add(&g_metrics.pkts_processed, 1);
-    atomic_fetch_add(&g_metrics.bytes_processed, bytes);
+    METRICS_ADD_PACKET(pkts_processed, bytes_processed, bytes);
 }
 
 void metrics_inc_parse_errors(void) {
-    atomic_fetch_add(&g_metrics.parse_errors, 1);
+    registry_add_slot(g_error_slot[0], 1);
 }
 
 void metrics_inc_checksum_failures(void) {
-    atomic_fetch_add(&g_metrics.checksum_failures, 1);
+    registry_add_slot(g_error_slot[1], 1);
 }
 
 void metrics_inc_queue_drops(void) {
-    atomic_fetch_add(&g_metrics.queue_drops, 1);
+    registry_add_slot(g_drop_slot[0], 1);
 }
 
 void metrics_inc_capture_drops(void) {
-    atomic_fetch_add(&g_metrics.capture_drops, 1);
+    registry_add_slot(g_drop_slot[1], 1);
+}
+
+/**
+ * @brief Apply a pending metrics_init()/metrics_start() reset (queue lock held)
+ *
+ * The counters are cleared before the new tags are published, so a
+ * reader that sees current tags sees the cleared values.
+ */
+static inline metrics_queue_t *queue_current(void) {
+    metrics_queue_t *q = &g_queue;
+    uint64_t epoch = atomic_load_explicit(&g_epoch, memory_order_relaxed);
+    uint64_t window = atomic_load_explicit(&g_queue_window_ticks, memory_order_relaxed);
+    if (atomic_load_explicit(&q->epoch, memory_order_relaxed) == epoch &&
+        atomic_load_explicit(&q->window_ticks, memory_order_relaxed) == window) {
+        return q;
+    }
+
+    if (atomic_load_explicit(&q->epoch, memory_order_relaxed) != epoch) {
+        atomic_store_explicit(&q->depth_max, atomic_load_explicit(&q->depth, memory_order_relaxed),
+                              memory_order_relaxed);
+        for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+            atomic_store_explicit(&q->occupancy[i], 0, memory_order_relaxed);
+        }
+    }
+    /* The depth has been held since the window started */
+    atomic_store_explicit(&q->area_ticks, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->high_ticks, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->change_ticks, window, memory_order_relaxed);
+    atomic_store_explicit(&q->window_ticks, window, memory_order_release);
+    atomic_store_explicit(&q->epoch, epoch, memory_order_release);
+    return q;
 }
 
 void metrics_update_queue_depth_max(uint32_t current_depth) {
-    uint32_t current_max = atomic_load(&g_metrics.queue_depth_max);
-    while (current_depth > current_max) {
-        if (atomic_compare_exchange_weak(&g_metrics.queue_depth_max,
-                                          &current_max, current_depth)) {
-            break;
+    /* Serialized by the caller: relaxed load + store, no locked RMW */
+    metrics_queue_t *q = queue_current();
+    if (current_depth > atomic_load_explicit(&q->depth_max, memory_order_relaxed)) {
+        atomic_store_explicit(&q->depth_max, current_depth, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Depth from which the queue counts as "high"
+ */
+static inline uint32_t queue_high_threshold(uint32_t capacity) {
+    uint32_t threshold = (uint32_t)((uint64_t)capacity * METRICS_QUEUE_HIGH_PCT / 100);
+    return threshold > 0 ? threshold : 1;
+}
+
+void metrics_set_queue_depth(uint32_t current_depth) {
+    /* Serialized by the caller: relaxed load + store, no locked RMW */
+    metrics_queue_t *q = queue_current();
+    uint64_t now = fastclock_ticks();
+    uint64_t last = atomic_load_explicit(&q->change_ticks, memory_order_relaxed);
+    uint32_t prev_depth = atomic_load_explicit(&q->depth, memory_order_relaxed);
+    if (last != 0 && now > last) {
+        uint64_t held = now - last;
+        atomic_store_explicit(&q->area_ticks,
+                              atomic_load_explicit(&q->area_ticks, memory_order_relaxed) +
+                              (uint64_t)prev_depth * held, memory_order_relaxed);
+        uint32_t capacity = atomic_load_explicit(&g_queue_capacity, memory_order_relaxed);
+        if (capacity > 0 && prev_depth >= queue_high_threshold(capacity)) {
+            atomic_store_explicit(&q->high_ticks,
+                                  atomic_load_explicit(&q->high_ticks, memory_order_relaxed) +
+                                  held, memory_order_relaxed);
         }
     }
+    atomic_store_explicit(&q->change_ticks, now, memory_order_relaxed);
+    atomic_store_explicit(&q->depth, current_depth, memory_order_relaxed);
+}
+
+void metrics_set_queue_capacity(uint32_t capacity) {
+    atomic_store(&g_queue_capacity, capacity);
+}
+
+void metrics_observe_queue_occupancy(uint32_t depth) {
+    uint32_t capacity = atomic_load_explicit(&g_queue_capacity, memory_order_relaxed);
+    int bucket = 0;
+    if (capacity > 0) {
+        bucket = depth >= capacity ? METRICS_QUEUE_OCC_BUCKETS - 1 :
+                 (int)((uint64_t)depth * (METRICS_QUEUE_OCC_BUCKETS - 1) / capacity);
+    }
+    _Atomic uint64_t *count = &queue_current()->occupancy[bucket];
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+const char* metrics_queue_occupancy_name(int bucket) {
+    if (bucket < 0 || bucket >= METRICS_QUEUE_OCC_BUCKETS) return "unknown";
+    return g_queue_occupancy_names[bucket];
 }
 
 /* ============================================================================
  * Reporting Functions
  * ============================================================================ */
 
+/**
+ * @brief Window CPU and busy/idle time of one shard (g_shard_lock held)
+ */
+static void shard_thread_cpu(const metrics_shard_t *shard, bool current_epoch,
+                             metrics_thread_cpu_t *out) {
+    memset(out, 0, sizeof(*out));
+    memcpy(out->name, shard->name, sizeof(out->name));
+    out->cpu_valid = shard->has_cpu_clock;
+    if (shard->has_cpu_clock) {
+        uint64_t cpu_ns = cpu_clock_ns(shard->cpu_clock);
+        out->cpu_ns = cpu_ns > shard->cpu_base_ns ? cpu_ns - shard->cpu_base_ns : 0;
+    }
+    uint64_t busy = atomic_load_explicit(&shard->busy_ticks, memory_order_relaxed);
+    uint64_t idle = atomic_load_explicit(&shard->idle_ticks, memory_order_relaxed);
+    out->busy_ns = busy > shard->busy_base_ticks ? fastclock_to_ns(busy - shard->busy_base_ticks) : 0;
+    out->idle_ns = idle > shard->idle_base_ticks ? fastclock_to_ns(idle - shard->idle_base_ticks) : 0;
+    if (current_epoch) {
+        out->packets = atomic_load_explicit(&shard->pkts_captured, memory_order_relaxed) +
+                       atomic_load_explicit(&shard->pkts_processed, memory_order_relaxed);
+    }
+}
+
 void metrics_snapshot(metrics_snapshot_t *snapshot) {
+    metrics_snapshot_select(snapshot, METRICS_SNAP_ALL);
+}
+
+void metrics_snapshot_select(metrics_snapshot_t *snapshot, unsigned int flags) {
     if (snapshot == NULL) return;
     
+    /* The lock keeps metrics_init() from switching epochs under the reads */
+    lockstat_lock(&g_shard_lock);
+    uint64_t epoch = atomic_load(&g_epoch);
+    const metrics_t *m = &g_metrics_buf[epoch & 1];
+    snapshot->epoch = epoch;
     snapshot->snapshot_time_ns = metrics_now_ns();
-    snapshot->start_time_ns = g_metrics.start_time_ns;
-    snapshot->capture_end_time_ns = g_metrics.capture_end_time_ns;
+    snapshot->start_time_ns = m->start_time_ns;
+    snapshot->capture_end_time_ns = m->capture_end_time_ns;
     
     if (snapshot->start_time_ns > 0) {
         snapshot->elapsed_sec = (double)(snapshot->snapshot_time_ns - snapshot->start_time_ns) / 1e9;
@@ -232,35 +958,284 @@ void metrics_snapshot(metrics_snapshot_t *snapshot) {
     }
     
     /* Load all atomic values */
-    snapshot->pkts_captured = atomic_load(&g_metrics.pkts_captured);
-    snapshot->pkts_processed = atomic_load(&g_metrics.pkts_processed);
-    snapshot->bytes_captured = atomic_load(&g_metrics.bytes_captured);
-    snapshot->bytes_processed = atomic_load(&g_metrics.bytes_processed);
-    
-    snapshot->parse_errors = atomic_load(&g_metrics.parse_errors);
-    snapshot->checksum_failures = atomic_load(&g_metrics.checksum_failures);
-    snapshot->queue_drops = atomic_load(&g_metrics.queue_drops);
-    snapshot->capture_drops = atomic_load(&g_metrics.capture_drops);
+    snapshot->pkts_captured = atomic_load(&m->pkts_captured);
+    snapshot->pkts_processed = atomic_load(&m->pkts_processed);
+    snapshot->bytes_captured = atomic_load(&m->bytes_captured);
+    snapshot->bytes_processed = atomic_load(&m->bytes_processed);
     
-    snapshot->ether_ipv4 = atomic_load(&g_metrics.ether_ipv4);
-    snapshot->ether_ipv6 = atomic_load(&g_metrics.ether_ipv6);
-    snapshot->ether_arp = atomic_load(&g_metrics.ether_arp);
-    snapshot->ether_other = atomic_load(&g_metrics.ether_other);
+    registry_snapshot(&snapshot->registry);
+    snapshot->parse_errors = registry_value(&snapshot->registry, g_errors_metric, 0);
+    snapshot->checksum_failures = registry_value(&snapshot->registry, g_errors_metric, 1);
+    snapshot->queue_drops = registry_value(&snapshot->registry, g_drops_metric, 0);
+    snapshot->capture_drops = registry_value(&snapshot->registry, g_drops_metric, 1);
+    snapshot->ether_ipv4 = registry_value(&snapshot->registry, g_ethertype_metric, 0);
+    snapshot->ether_ipv6 = registry_value(&snapshot->registry, g_ethertype_metric, 1);
+    snapshot->ether_arp = registry_value(&snapshot->registry, g_ethertype_metric, 2);
+    snapshot->ether_other = registry_value(&snapshot->registry, g_ethertype_metric, 3);
     
-    snapshot->proto_tcp = atomic_load(&g_metrics.proto_tcp);
-    snapshot->proto_udp = atomic_load(&g_metrics.proto_udp);
-    snapshot->proto_icmp = atomic_load(&g_metrics.proto_icmp);
-    snapshot->proto_other = atomic_load(&g_metrics.proto_other);
+    snapshot->proto_tcp = registry_value(&snapshot->registry, g_protocols_metric, METRICS_L4_TCP);
+    snapshot->proto_udp = registry_value(&snapshot->registry, g_protocols_metric, METRICS_L4_UDP);
+    snapshot->proto_icmp = registry_value(&snapshot->registry, g_protocols_metric, METRICS_L4_ICMP);
+    snapshot->proto_other = registry_value(&snapshot->registry, g_protocols_metric, METRICS_L4_OTHER);
     
-    snapshot->queue_depth_max = atomic_load(&g_metrics.queue_depth_max);
+    /* Queue gauges not yet caught up with a reset read as just reset */
+    const metrics_queue_t *q = &g_queue;
+    uint64_t window_ticks = atomic_load(&g_queue_window_ticks);
+    bool queue_epoch = atomic_load_explicit(&q->epoch, memory_order_acquire) == epoch;
+    bool queue_window = queue_epoch && atomic_load(&q->window_ticks) == window_ticks;
+    snapshot->queue_depth = atomic_load(&q->depth);
+    snapshot->queue_depth_max = queue_epoch ? atomic_load(&q->depth_max) : snapshot->queue_depth;
+    snapshot->queue_capacity = atomic_load(&g_queue_capacity);
+    for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+        snapshot->queue_occupancy[i] = queue_epoch ? atomic_load(&q->occupancy[i]) : 0;
+    }
+
+    /* Close the integrals at snapshot time with the depth currently held */
+    uint64_t now_ticks = fastclock_ticks();
+    uint64_t change_ticks = queue_window ? atomic_load(&q->change_ticks) : window_ticks;
+    uint64_t area_ticks = queue_window ? atomic_load(&q->area_ticks) : 0;
+    uint64_t high_ticks = queue_window ? atomic_load(&q->high_ticks) : 0;
+    if (change_ticks != 0 && now_ticks > change_ticks) {
+        area_ticks += (uint64_t)snapshot->queue_depth * (now_ticks - change_ticks);
+        if (snapshot->queue_capacity > 0 &&
+            snapshot->queue_depth >= queue_high_threshold(snapshot->queue_capacity)) {
+            high_ticks += now_ticks - change_ticks;
+        }
+    }
+    snapshot->queue_window_ns = window_ticks != 0 && now_ticks > window_ticks ?
+        fastclock_to_ns(now_ticks - window_ticks) : 0;
+    snapshot->queue_area_ns = fastclock_to_ns(area_ticks);
+    snapshot->queue_high_ns = fastclock_to_ns(high_ticks);
+    snapshot->queue_depth_mean = snapshot->queue_window_ns > 0 ?
+        (double)snapshot->queue_area_ns / (double)snapshot->queue_window_ns : 0.0;
     
-    snapshot->latency_count = atomic_load(&g_metrics.latency_count);
-    snapshot->latency_sum_ns = atomic_load(&g_metrics.latency_sum_ns);
-    snapshot->latency_max_ns = atomic_load(&g_metrics.latency_max_ns);
+    snapshot->latency_count = atomic_load(&m->latency_count);
+    snapshot->latency_sum_ns = atomic_load(&m->latency_sum_ns);
+    snapshot->latency_max_ns = atomic_load(&m->latency_max_ns);
     
-    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
-        snapshot->latency_histogram[i] = atomic_load(&g_metrics.latency_histogram[i]);
+    /* Histogram copies dominate the cost; skip the ones not asked for */
+    snapshot->latency_hdr = (flags & METRICS_SNAP_LATENCY) ? hdr_copy(m->latency_hdr) : NULL;
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        snapshot->stage_hdr[i] = (flags & METRICS_SNAP_STAGES) ? hdr_copy(m->stage_hdr[i]) : NULL;
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            metrics_class_stats_t *cell = &snapshot->classes[l][c];
+            cell->packets = atomic_load(&m->class_packets[l][c]);
+            cell->bytes = atomic_load(&m->class_bytes[l][c]);
+            cell->latency_hdr = (flags & METRICS_SNAP_CLASSES) ? hdr_copy(m->class_hdr[l][c]) : NULL;
+        }
+    }
+    snapshot->exemplar_count = 0;
+    for (int i = 0; i < m->exemplar_count; i++) {
+        exemplar_push(snapshot->exemplars, &snapshot->exemplar_count, &m->exemplars[i]);
+    }
+
+    /* Merge thread shards from the current epoch */
+
+    /* CPU clocks first, together with the wall time they are compared to */
+    uint64_t cpu_read_ns = metrics_now_ns();
+    snapshot->cpu_window_ns = snapshot->start_time_ns > 0 && cpu_read_ns > snapshot->start_time_ns ?
+        cpu_read_ns - snapshot->start_time_ns : 0;
+    snapshot->thread_count = g_shard_count;
+    snapshot->cpu_ns = g_cpu_exited_ns;
+    snapshot->cpu_valid = g_cpu_exited_valid;
+    for (int s = 0; s < g_shard_count; s++) {
+        metrics_shard_t *shard = g_shards[s];
+        bool current_epoch = atomic_load_explicit(&shard->generation, memory_order_acquire) == epoch;
+        shard_thread_cpu(shard, current_epoch, &snapshot->threads[s]);
+        snapshot->cpu_ns += snapshot->threads[s].cpu_ns;
+        snapshot->cpu_valid = snapshot->cpu_valid && snapshot->threads[s].cpu_valid;
+    }
+
+    for (int s = 0; s < g_shard_count; s++) {
+        metrics_shard_t *shard = g_shards[s];
+        if (atomic_load_explicit(&shard->generation, memory_order_acquire) != epoch) continue;
+
+        snapshot->pkts_captured += atomic_load_explicit(&shard->pkts_captured, memory_order_relaxed);
+        snapshot->pkts_processed += atomic_load_explicit(&shard->pkts_processed, memory_order_relaxed);
+        snapshot->bytes_captured += atomic_load_explicit(&shard->bytes_captured, memory_order_relaxed);
+        snapshot->bytes_processed += atomic_load_explicit(&shard->bytes_processed, memory_order_relaxed);
+
+        snapshot->latency_count += atomic_load_explicit(&shard->latency_count, memory_order_relaxed);
+        snapshot->latency_sum_ns += atomic_load_explicit(&shard->latency_sum_ns, memory_order_relaxed);
+        uint64_t shard_max = atomic_load_explicit(&shard->latency_max_ns, memory_order_relaxed);
+        if (shard_max > snapshot->latency_max_ns) {
+            snapshot->latency_max_ns = shard_max;
+        }
+        if (snapshot->latency_hdr != NULL) {
+            hdr_add(snapshot->latency_hdr, shard->latency_hdr);
+        }
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            if (snapshot->stage_hdr[i] != NULL) {
+                hdr_add(snapshot->stage_hdr[i], shard->stage_hdr[i]);
+            }
+        }
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                metrics_class_stats_t *cell = &snapshot->classes[l][c];
+                cell->packets += atomic_load_explicit(&shard->class_packets[l][c], memory_order_relaxed);
+                cell->bytes += atomic_load_explicit(&shard->class_bytes[l][c], memory_order_relaxed);
+                if (cell->latency_hdr != NULL) {
+                    hdr_add(cell->latency_hdr, shard->class_hdr[l][c]);
+                }
+            }
+        }
+
+        metrics_exemplar_t exemplars[METRICS_EXEMPLARS];
+        int exemplar_count = shard_exemplars_read(shard, exemplars);
+        for (int i = 0; i < exemplar_count; i++) {
+            exemplar_push(snapshot->exemplars, &snapshot->exemplar_count, &exemplars[i]);
+        }
+    }
+    lockstat_unlock(&g_shard_lock);
+    qsort(snapshot->exemplars, (size_t)snapshot->exemplar_count, sizeof(snapshot->exemplars[0]),
+          exemplar_compare_desc);
+
+    perfcount_read(&snapshot->perf);
+    membudget_snapshot(&snapshot->memory);
+
+    /* Derive the log2 µs buckets kept for JSON compatibility */
+    memset(snapshot->latency_histogram, 0, sizeof(snapshot->latency_histogram));
+    if (snapshot->latency_hdr != NULL) {
+        hdr_histogram_t *hdr = snapshot->latency_hdr;
+        for (int i = 0; i < hdr_counts_len(hdr); i++) {
+            uint64_t count = atomic_load_explicit(&hdr->counts[i], memory_order_relaxed);
+            if (count > 0) {
+                snapshot->latency_histogram[latency_bucket(hdr_value_at_index(hdr, i))] += count;
+            }
+        }
+    }
+}
+
+void metrics_snapshot_free(metrics_snapshot_t *snapshot) {
+    if (snapshot == NULL) return;
+    hdr_destroy(snapshot->latency_hdr);
+    snapshot->latency_hdr = NULL;
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        hdr_destroy(snapshot->stage_hdr[i]);
+        snapshot->stage_hdr[i] = NULL;
+    }
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            hdr_destroy(snapshot->classes[l][c].latency_hdr);
+            snapshot->classes[l][c].latency_hdr = NULL;
+        }
+    }
+}
+
+void metrics_summary(metrics_summary_t *summary) {
+    if (summary == NULL) return;
+    memset(summary, 0, sizeof(*summary));
+
+    const hdr_histogram_t *hists[METRICS_MAX_SHARDS + 1];
+    int hist_count = 0;
+    static const double quantiles[3] = { 0.50, 0.95, 0.99 };
+    uint64_t values[3];
+
+    lockstat_lock(&g_shard_lock);
+    uint64_t epoch = atomic_load(&g_epoch);
+    const metrics_t *m = &g_metrics_buf[epoch & 1];
+    uint64_t now_ns = metrics_now_ns();
+    summary->epoch = epoch;
+    if (m->start_time_ns > 0) {
+        uint64_t end_ns = m->capture_end_time_ns > 0 ? m->capture_end_time_ns : now_ns;
+        summary->elapsed_sec = (double)(now_ns - m->start_time_ns) / 1e9;
+        summary->capture_elapsed_sec = (double)(end_ns - m->start_time_ns) / 1e9;
+    }
+
+    summary->pkts_captured = atomic_load(&m->pkts_captured);
+    summary->pkts_processed = atomic_load(&m->pkts_processed);
+    summary->bytes_captured = atomic_load(&m->bytes_captured);
+    summary->bytes_processed = atomic_load(&m->bytes_processed);
+    summary->latency_count = atomic_load(&m->latency_count);
+    summary->latency_sum_ns = atomic_load(&m->latency_sum_ns);
+    summary->latency_max_ns = atomic_load(&m->latency_max_ns);
+    hists[hist_count++] = m->latency_hdr;
+
+    for (int s = 0; s < g_shard_count; s++) {
+        metrics_shard_t *shard = g_shards[s];
+        if (atomic_load_explicit(&shard->generation, memory_order_acquire) != epoch) continue;
+
+        summary->pkts_captured += atomic_load_explicit(&shard->pkts_captured, memory_order_relaxed);
+        summary->pkts_processed += atomic_load_explicit(&shard->pkts_processed, memory_order_relaxed);
+        summary->bytes_captured += atomic_load_explicit(&shard->bytes_captured, memory_order_relaxed);
+        summary->bytes_processed += atomic_load_explicit(&shard->bytes_processed, memory_order_relaxed);
+        summary->latency_count += atomic_load_explicit(&shard->latency_count, memory_order_relaxed);
+        summary->latency_sum_ns += atomic_load_explicit(&shard->latency_sum_ns, memory_order_relaxed);
+        uint64_t shard_max = atomic_load_explicit(&shard->latency_max_ns, memory_order_relaxed);
+        if (shard_max > summary->latency_max_ns) {
+            summary->latency_max_ns = shard_max;
+        }
+        hists[hist_count++] = shard->latency_hdr;
     }
+
+    /* Percentiles and log2 buckets straight from the live histograms */
+    hdr_sum_quantiles(hists, hist_count, quantiles, values, 3);
+    for (int h = 0; h < hist_count; h++) {
+        const hdr_histogram_t *hdr = hists[h];
+        if (hdr == NULL) continue;
+        for (int i = 0; i < hdr_counts_len(hdr); i++) {
+            uint64_t count = atomic_load_explicit(&hdr->counts[i], memory_order_relaxed);
+            if (count > 0) {
+                summary->latency_histogram[latency_bucket(hdr_value_at_index(hdr, i))] += count;
+            }
+        }
+    }
+    lockstat_unlock(&g_shard_lock);
+
+    uint64_t *percentiles[3] = { &summary->latency_p50_ns, &summary->latency_p95_ns, &summary->latency_p99_ns };
+    for (int q = 0; q < 3; q++) {
+        *percentiles[q] = summary->latency_max_ns > 0 && values[q] > summary->latency_max_ns ?
+                          summary->latency_max_ns : values[q];
+    }
+
+    const metrics_queue_t *q = &g_queue;
+    summary->queue_depth = atomic_load(&q->depth);
+    summary->queue_depth_max = atomic_load_explicit(&q->epoch, memory_order_acquire) == epoch ?
+                               atomic_load(&q->depth_max) : summary->queue_depth;
+
+    registry_snapshot_t registry;
+    registry_snapshot(&registry);
+    summary->parse_errors = registry_value(&registry, g_errors_metric, 0);
+    summary->checksum_failures = registry_value(&registry, g_errors_metric, 1);
+    summary->queue_drops = registry_value(&registry, g_drops_metric, 0);
+    summary->capture_drops = registry_value(&registry, g_drops_metric, 1);
+    summary->ether_ipv4 = registry_value(&registry, g_ethertype_metric, 0);
+    summary->ether_ipv6 = registry_value(&registry, g_ethertype_metric, 1);
+    summary->ether_arp = registry_value(&registry, g_ethertype_metric, 2);
+    summary->ether_other = registry_value(&registry, g_ethertype_metric, 3);
+    summary->proto_tcp = registry_value(&registry, g_protocols_metric, METRICS_L4_TCP);
+    summary->proto_udp = registry_value(&registry, g_protocols_metric, METRICS_L4_UDP);
+    summary->proto_icmp = registry_value(&registry, g_protocols_metric, METRICS_L4_ICMP);
+    summary->proto_other = registry_value(&registry, g_protocols_metric, METRICS_L4_OTHER);
+}
+
+int metrics_shard_stats(metrics_shard_stats_t *out, int max) {
+    if (out == NULL || max <= 0) return 0;
+
+    uint64_t generation = atomic_load(&g_epoch);
+    int count = 0;
+    lockstat_lock(&g_shard_lock);
+    for (int s = 0; s < g_shard_count && count < max; s++, count++) {
+        metrics_shard_t *shard = g_shards[s];
+        memset(&out[count], 0, sizeof(out[count]));
+        if (atomic_load_explicit(&shard->generation, memory_order_acquire) != generation) continue;
+
+        out[count].pkts_captured = atomic_load_explicit(&shard->pkts_captured, memory_order_relaxed);
+        out[count].pkts_processed = atomic_load_explicit(&shard->pkts_processed, memory_order_relaxed);
+        out[count].bytes_processed = atomic_load_explicit(&shard->bytes_processed, memory_order_relaxed);
+    }
+    lockstat_unlock(&g_shard_lock);
+    return count;
+}
+
+double metrics_cpu_ns_per_packet(const metrics_snapshot_t *snapshot) {
+    if (snapshot == NULL || !snapshot->cpu_valid || snapshot->cpu_ns == 0 ||
+        snapshot->pkts_processed == 0) {
+        return 0.0;
+    }
+    return (double)snapshot->cpu_ns / (double)snapshot->pkts_processed;
 }
 
 uint64_t metrics_percentile_ns(const metrics_snapshot_t *snapshot, double percentile) {
@@ -268,6 +1243,14 @@ uint64_t metrics_percentile_ns(const metrics_snapshot_t *snapshot, double percen
         return 0;
     }
     
+    if (snapshot->latency_hdr != NULL) {
+        uint64_t value = hdr_value_at_quantile(snapshot->latency_hdr, percentile);
+        if (snapshot->latency_max_ns > 0 && value > snapshot->latency_max_ns) {
+            value = snapshot->latency_max_ns;
+        }
+        return value;
+    }
+    
     uint64_t target_count = (uint64_t)(snapshot->latency_count * percentile);
     uint64_t cumulative = 0;
     
@@ -333,6 +1316,149 @@ void metrics_print_human(void) {
             total_drops,
             p50_str, p95_str, p99_str, max_str);
     
+    /* Per-stage breakdown of the end-to-end latency */
+    fprintf(stdout, "[STAGES] p50/p95/p99");
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        const hdr_histogram_t *hdr = snap.stage_hdr[i];
+        format_latency(hdr ? hdr_value_at_quantile(hdr, 0.50) : 0, p50_str, sizeof(p50_str));
+        format_latency(hdr ? hdr_value_at_quantile(hdr, 0.95) : 0, p95_str, sizeof(p95_str));
+        format_latency(hdr ? hdr_value_at_quantile(hdr, 0.99) : 0, p99_str, sizeof(p99_str));
+        fprintf(stdout, " | %s: %s/%s/%s", g_stage_names[i], p50_str, p95_str, p99_str);
+    }
+    fprintf(stdout, "\n");
+
+    /* Latency by protocol and size class (non-empty cells only) */
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        bool printed = false;
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            const metrics_class_stats_t *cell = &snap.classes[l][c];
+            if (cell->packets == 0) continue;
+            if (!printed) {
+                fprintf(stdout, "[CLASS] %-5s p50/p99", g_l4_names[l]);
+                printed = true;
+            }
+            format_latency(cell->latency_hdr ? hdr_value_at_quantile(cell->latency_hdr, 0.50) : 0,
+                           p50_str, sizeof(p50_str));
+            format_latency(cell->latency_hdr ? hdr_value_at_quantile(cell->latency_hdr, 0.99) : 0,
+                           p99_str, sizeof(p99_str));
+            fprintf(stdout, " | %s: %" PRIu64 " pkts %.1f KB %s/%s", g_size_class_names[c],
+                    cell->packets, cell->bytes / 1024.0, p50_str, p99_str);
+        }
+        if (printed) {
+            fprintf(stdout, "\n");
+        }
+    }
+    metrics_snapshot_free(&snap);
+
+    /* Slowest packets: where the tail sits and the stage that dominated each */
+    if (snap.exemplar_count > 0) {
+        fprintf(stdout, "[TAIL] slowest");
+        for (int i = 0; i < snap.exemplar_count && i < 3; i++) {
+            const metrics_exemplar_t *e = &snap.exemplars[i];
+            int worst = 0;
+            uint64_t worst_ns = 0;
+            for (int s = 0; s < METRICS_STAGE_COUNT; s++) {
+                uint64_t start = s > 0 ? e->stage_end_ns[s - 1] : 0;
+                uint64_t ns = e->stage_end_ns[s] > start ? e->stage_end_ns[s] - start : 0;
+                if (ns > worst_ns) {
+                    worst = s;
+                    worst_ns = ns;
+                }
+            }
+            char stage_str[32];
+            format_latency(e->latency_ns, max_str, sizeof(max_str));
+            format_latency(worst_ns, stage_str, sizeof(stage_str));
+            fprintf(stdout, " | %s %s/%s worker=%d (%s %s)", max_str,
+                    g_l4_names[metrics_l4_class(e->protocol)],
+                    g_size_class_names[metrics_size_class(e->length)], e->worker_id,
+                    g_stage_names[worst], stage_str);
+        }
+        fprintf(stdout, "\n");
+    }
+
+    /* Work queue occupancy over the measurement window */
+    if (snap.queue_capacity > 0) {
+        uint64_t arrivals = 0;
+        for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+            arrivals += snap.queue_occupancy[i];
+        }
+        uint64_t high_arrivals = 0;
+        for (int i = METRICS_QUEUE_HIGH_PCT / 10; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+            high_arrivals += snap.queue_occupancy[i];
+        }
+        fprintf(stdout, "[QUEUE] depth mean=%.1f max=%" PRIu32 " cap=%" PRIu32 " | >=%d%%: %.2fs (%.1f%% of time, "
+                "%.1f%% of arrivals) | full on arrival: %" PRIu64 "\n",
+                snap.queue_depth_mean, snap.queue_depth_max, snap.queue_capacity, METRICS_QUEUE_HIGH_PCT,
+                snap.queue_high_ns / 1e9,
+                snap.queue_window_ns > 0 ? 100.0 * snap.queue_high_ns / snap.queue_window_ns : 0.0,
+                arrivals > 0 ? 100.0 * high_arrivals / arrivals : 0.0,
+                snap.queue_occupancy[METRICS_QUEUE_OCC_BUCKETS - 1]);
+    }
+
+    /* Lock contention per site; quantiles are log2 bucket upper bounds */
+    for (int site = 0; site < LOCKSTAT_SITE_COUNT; site++) {
+        lockstat_summary_t lock;
+        lockstat_summarize(&snap.registry, (lockstat_site_t)site, &lock);
+        if (lock.acquisitions == 0) continue;
+        char wait_p50[32], wait_p99[32], wait_total[32], hold_p50[32], hold_p99[32];
+        format_latency(lock.wait_p50_ns, wait_p50, sizeof(wait_p50));
+        format_latency(lock.wait_p99_ns, wait_p99, sizeof(wait_p99));
+        format_latency(lock.wait_ns, wait_total, sizeof(wait_total));
+        format_latency(lock.hold_p50_ns, hold_p50, sizeof(hold_p50));
+        format_latency(lock.hold_p99_ns, hold_p99, sizeof(hold_p99));
+        fprintf(stdout, "[LOCK] %-10s acquired=%" PRIu64 " contended=%" PRIu64 " (%.2f%%) | "
+                "wait p50<=%s p99<=%s total=%s | hold p50<=%s p99<=%s\n",
+                lockstat_site_name((lockstat_site_t)site), lock.acquisitions, lock.contentions,
+                100.0 * lock.contentions / lock.acquisitions, wait_p50, wait_p99, wait_total,
+                hold_p50, hold_p99);
+    }
+
+    /* Hardware counters over the measurement window */
+    if (snap.perf.available) {
+        uint64_t cycles = snap.perf.values[PERFCOUNT_CYCLES];
+        fprintf(stdout, "[PERF] cycles=%" PRIu64 " IPC=%.2f cycles/pkt=%.0f cache-miss=%" PRIu64
+                " branch-miss=%" PRIu64 " ctx-sw=%" PRIu64 "\n",
+                cycles,
+                cycles > 0 ? (double)snap.perf.values[PERFCOUNT_INSTRUCTIONS] / cycles : 0.0,
+                snap.pkts_processed > 0 ? (double)cycles / snap.pkts_processed : 0.0,
+                snap.perf.values[PERFCOUNT_CACHE_MISSES],
+                snap.perf.values[PERFCOUNT_BRANCH_MISSES],
+                snap.perf.values[PERFCOUNT_CONTEXT_SWITCHES]);
+    }
+    
+    /* Footprint over the measurement window */
+    const membudget_snapshot_t *mem = &snap.memory;
+    fprintf(stdout, "[MEMORY] accounted=%.1fKB peak=%.1fKB | allocs=%" PRIu64 " (%.1fKB)"
+            " | %.0f B/queued pkt",
+            mem->used_bytes / 1024.0, mem->peak_bytes / 1024.0,
+            mem->subsys_allocs[MEM_SUBSYS_PACKET] + mem->subsys_allocs[MEM_SUBSYS_QUEUE],
+            (mem->subsys_alloc_bytes[MEM_SUBSYS_PACKET] + mem->subsys_alloc_bytes[MEM_SUBSYS_QUEUE]) / 1024.0,
+            membudget_bytes_per_queued_packet(mem));
+    if (mem->rss_valid) {
+        fprintf(stdout, " | RSS=%.1fMB peak=%.1fMB growth=%+.1fMB",
+                mem->rss_bytes / 1048576.0, mem->rss_peak_bytes / 1048576.0,
+                ((double)mem->rss_bytes - (double)mem->rss_start_bytes) / 1048576.0);
+    }
+    fprintf(stdout, "\n");
+
+    /* Thread CPU time over the measurement window */
+    if (snap.thread_count > 0 && snap.cpu_valid) {
+        char cpp_str[32];
+        format_latency((uint64_t)metrics_cpu_ns_per_packet(&snap), cpp_str, sizeof(cpp_str));
+        fprintf(stdout, "[CPU] total=%.2fs cpu/pkt=%s", snap.cpu_ns / 1e9, cpp_str);
+        for (int t = 0; t < snap.thread_count; t++) {
+            const metrics_thread_cpu_t *thread = &snap.threads[t];
+            fprintf(stdout, " | %s: %.1f%%", thread->name,
+                    snap.cpu_window_ns > 0 ? 100.0 * thread->cpu_ns / snap.cpu_window_ns : 0.0);
+            if (thread->busy_ns + thread->idle_ns > 0) {
+                fprintf(stdout, " busy=%.1f%%", 100.0 * thread->busy_ns / (thread->busy_ns + thread->idle_ns));
+            }
+            fprintf(stdout, " %.0f pkts/cpu-s",
+                    thread->cpu_ns > 0 ? thread->packets / (thread->cpu_ns / 1e9) : 0.0);
+        }
+        fprintf(stdout, "\n");
+    }
+    
     /* Print protocol breakdown */
     fprintf(stdout, "[PROTO] L3: IPv4=%" PRIu64 " IPv6=%" PRIu64 " ARP=%" PRIu64 " other=%" PRIu64
             " | L4: TCP=%" PRIu64 " UDP=%" PRIu64 " ICMP=%" PRIu64 " other=%" PRIu64 "\n",
@@ -343,8 +1469,9 @@ void metrics_print_human(void) {
 }
 
 void metrics_print_live_stats(void) {
-    metrics_snapshot_t snap;
-    metrics_snapshot(&snap);
+    /* Counters only: no histogram copies or perf/proc reads per tick */
+    metrics_summary_t snap;
+    metrics_summary(&snap);
     
     /* Use capture_elapsed_sec for throughput (excludes drain time) */
     double pps = snap.capture_elapsed_sec > 0 ? snap.pkts_captured / snap.capture_elapsed_sec : 0;
@@ -362,6 +1489,152 @@ void metrics_print_live_stats(void) {
     fflush(stdout);
 }
 
+/**
+ * @brief Write "latency_by_class": one "proto/size" entry per non-empty cell
+ */
+static void write_class_json(FILE *fp, const metrics_snapshot_t *snap) {
+    bool first = true;
+    fprintf(fp, "  \"latency_by_class\": {");
+    for (int l = 0; l < METRICS_L4_COUNT; l++) {
+        for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+            const metrics_class_stats_t *cell = &snap->classes[l][c];
+            if (cell->packets == 0) continue;
+            const hdr_histogram_t *hdr = cell->latency_hdr;
+            fprintf(fp, "%s\n    \"%s/%s\": {\"packets\": %" PRIu64 ", \"bytes\": %" PRIu64
+                    ", \"p50\": %" PRIu64 ", \"p95\": %" PRIu64 ", \"p99\": %" PRIu64 "}",
+                    first ? "" : ",", g_l4_names[l], g_size_class_names[c],
+                    cell->packets, cell->bytes,
+                    hdr ? hdr_value_at_quantile(hdr, 0.50) : 0,
+                    hdr ? hdr_value_at_quantile(hdr, 0.95) : 0,
+                    hdr ? hdr_value_at_quantile(hdr, 0.99) : 0);
+            first = false;
+        }
+    }
+    fprintf(fp, "%s},\n", first ? "" : "\n  ");
+}
+
+/**
+ * @brief Write one HDR bucket reference: value range and count of the entry holding value
+ */
+static void write_hdr_bucket_json(FILE *fp, const char *key, const hdr_histogram_t *hdr, uint64_t value) {
+    int index = hdr_index_of(hdr, value);
+    fprintf(fp, "\"%s\": {\"low\": %" PRIu64 ", \"high\": %" PRIu64 ", \"count\": %" PRIu64 "}",
+            key, hdr_value_at_index(hdr, index), hdr_highest_equivalent(hdr, value),
+            atomic_load_explicit(&hdr->counts[index], memory_order_relaxed));
+}
+
+/**
+ * @brief Write "exemplars": the slowest packets, linked to their histogram buckets
+ *
+ * "histogram_bucket" indexes "latency_histogram", "bucket" and "percentile"
+ * refer to "latency_hdr", and "class_bucket" to the "latency_by_class" cell.
+ */
+static void write_exemplars_json(FILE *fp, const metrics_snapshot_t *snap) {
+    fprintf(fp, "  \"exemplars\": [");
+    for (int i = 0; i < snap->exemplar_count; i++) {
+        const metrics_exemplar_t *e = &snap->exemplars[i];
+        metrics_l4_t l4 = metrics_l4_class(e->protocol);
+        int size_class = metrics_size_class(e->length);
+        char src[INET6_ADDRSTRLEN] = "", dst[INET6_ADDRSTRLEN] = "";
+        if (e->ip_version == 4 || e->ip_version == 6) {
+            int family = e->ip_version == 4 ? AF_INET : AF_INET6;
+            inet_ntop(family, e->src_addr, src, sizeof(src));
+            inet_ntop(family, e->dst_addr, dst, sizeof(dst));
+        }
+
+        fprintf(fp, "%s\n    {\"latency_ns\": %" PRIu64 ", \"worker\": %d, \"protocol\": %u, "
+                "\"class\": \"%s/%s\", \"length\": %" PRIu32 ", \"ip_version\": %u, "
+                "\"src\": \"%s\", \"src_port\": %u, \"dst\": \"%s\", \"dst_port\": %u, "
+                "\"capture_ts_ns\": %" PRIu64 ", \"timestamps_ns\": {",
+                i > 0 ? "," : "", e->latency_ns, e->worker_id, e->protocol,
+                g_l4_names[l4], g_size_class_names[size_class], e->length, e->ip_version,
+                src, e->src_port, dst, e->dst_port, e->capture_ts_ns);
+        for (int s = 0; s < METRICS_STAGE_COUNT; s++) {
+            fprintf(fp, "%s\"%s\": %" PRIu64, s > 0 ? ", " : "", g_exemplar_ts_names[s], e->stage_end_ns[s]);
+        }
+        fprintf(fp, "}, \"stages_ns\": {");
+        for (int s = 0; s < METRICS_STAGE_COUNT; s++) {
+            uint64_t start = s > 0 ? e->stage_end_ns[s - 1] : 0;
+            fprintf(fp, "%s\"%s\": %" PRIu64, s > 0 ? ", " : "", g_stage_names[s],
+                    e->stage_end_ns[s] > start ? e->stage_end_ns[s] - start : 0);
+        }
+        fprintf(fp, "}, \"histogram_bucket\": %d", latency_bucket(e->latency_ns));
+        const hdr_histogram_t *hdr = snap->latency_hdr;
+        if (hdr != NULL) {
+            uint64_t total = hdr_total_count(hdr);
+            fprintf(fp, ", ");
+            write_hdr_bucket_json(fp, "bucket", hdr, e->latency_ns);
+            fprintf(fp, ", \"percentile\": %.4f",
+                    total > 0 ? 100.0 * hdr_count_at_or_below(hdr, e->latency_ns) / total : 0.0);
+        }
+        const hdr_histogram_t *class_hdr = snap->classes[l4][size_class].latency_hdr;
+        if (class_hdr != NULL) {
+            fprintf(fp, ", ");
+            write_hdr_bucket_json(fp, "class_bucket", class_hdr, e->latency_ns);
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "%s],\n", snap->exemplar_count > 0 ? "\n  " : "");
+}
+
+/**
+ * @brief Write the "perf" block: raw counter totals plus IPC and cycles/packet
+ */
+static void write_perf_json(FILE *fp, const metrics_snapshot_t *snap) {
+    const perfcount_totals_t *perf = &snap->perf;
+    fprintf(fp, "  \"perf\": {\n");
+    if (!perf->available) {
+        const char *reason = perfcount_unavailable_reason();
+        fprintf(fp, "    \"available\": false,\n");
+        fprintf(fp, "    \"reason\": \"%s\"\n", reason ? reason : "no counted threads");
+        fprintf(fp, "  },\n");
+        return;
+    }
+    fprintf(fp, "    \"available\": true,\n");
+    fprintf(fp, "    \"threads\": %d,\n", perf->threads);
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        if (perf->valid[e]) {
+            fprintf(fp, "    \"%s\": %" PRIu64 ",\n", perfcount_event_name(e), perf->values[e]);
+        }
+    }
+    uint64_t cycles = perf->values[PERFCOUNT_CYCLES];
+    if (perf->valid[PERFCOUNT_INSTRUCTIONS] && cycles > 0) {
+        fprintf(fp, "    \"ipc\": %.3f,\n", (double)perf->values[PERFCOUNT_INSTRUCTIONS] / cycles);
+    }
+    fprintf(fp, "    \"cycles_per_packet\": %.1f\n",
+            snap->pkts_processed > 0 ? (double)cycles / snap->pkts_processed : 0.0);
+    fprintf(fp, "  },\n");
+}
+
+/**
+ * @brief Write the "cpu" block: window totals, CPU per packet and one entry per thread
+ */
+static void write_cpu_json(FILE *fp, const metrics_snapshot_t *snap) {
+    double window_ns = (double)snap->cpu_window_ns;
+    fprintf(fp, "  \"cpu\": {\n");
+    fprintf(fp, "    \"available\": %s,\n", snap->cpu_valid ? "true" : "false");
+    fprintf(fp, "    \"cpu_sec\": %.6f,\n", snap->cpu_ns / 1e9);
+    fprintf(fp, "    \"cpu_ns_per_packet\": %.1f,\n", metrics_cpu_ns_per_packet(snap));
+    fprintf(fp, "    \"pkts_per_cpu_sec\": %.1f,\n",
+            snap->cpu_ns > 0 ? snap->pkts_processed / (snap->cpu_ns / 1e9) : 0.0);
+    fprintf(fp, "    \"threads\": [");
+    for (int t = 0; t < snap->thread_count; t++) {
+        const metrics_thread_cpu_t *thread = &snap->threads[t];
+        uint64_t loop_ns = thread->busy_ns + thread->idle_ns;
+        fprintf(fp, "%s\n      {\"name\": \"%s\", \"cpu_sec\": %.6f, \"utilization\": %.4f, "
+                "\"busy_sec\": %.6f, \"idle_sec\": %.6f, \"busy_ratio\": %.4f, "
+                "\"packets\": %" PRIu64 ", \"pkts_per_cpu_sec\": %.1f}",
+                t > 0 ? "," : "", thread->name, thread->cpu_ns / 1e9,
+                window_ns > 0 ? thread->cpu_ns / window_ns : 0.0,
+                thread->busy_ns / 1e9, thread->idle_ns / 1e9,
+                loop_ns > 0 ? (double)thread->busy_ns / loop_ns : 0.0,
+                thread->packets,
+                thread->cpu_ns > 0 ? thread->packets / (thread->cpu_ns / 1e9) : 0.0);
+    }
+    fprintf(fp, "%s]\n", snap->thread_count > 0 ? "\n    " : "");
+    fprintf(fp, "  },\n");
+}
+
 int metrics_snapshot_json(const char *filepath) {
     if (filepath == NULL) return -1;
     
@@ -370,6 +1643,7 @@ int metrics_snapshot_json(const char *filepath) {
     
     FILE *fp = fopen(filepath, "w");
     if (fp == NULL) {
+        metrics_snapshot_free(&snap);
         return -1;
     }
     
@@ -402,20 +1676,22 @@ int metrics_snapshot_json(const char *filepath) {
     fprintf(fp, "    \"queue_drops\": %" PRIu64 ",\n", snap.queue_drops);
     fprintf(fp, "    \"capture_drops\": %" PRIu64 "\n", snap.capture_drops);
     fprintf(fp, "  },\n");
-    fprintf(fp, "  \"ethertype\": {\n");
-    fprintf(fp, "    \"ipv4\": %" PRIu64 ",\n", snap.ether_ipv4);
-    fprintf(fp, "    \"ipv6\": %" PRIu64 ",\n", snap.ether_ipv6);
-    fprintf(fp, "    \"arp\": %" PRIu64 ",\n", snap.ether_arp);
-    fprintf(fp, "    \"other\": %" PRIu64 "\n", snap.ether_other);
-    fprintf(fp, "  },\n");
-    fprintf(fp, "  \"protocols\": {\n");
-    fprintf(fp, "    \"tcp\": %" PRIu64 ",\n", snap.proto_tcp);
-    fprintf(fp, "    \"udp\": %" PRIu64 ",\n", snap.proto_udp);
-    fprintf(fp, "    \"icmp\": %" PRIu64 ",\n", snap.proto_icmp);
-    fprintf(fp, "    \"other\": %" PRIu64 "\n", snap.proto_other);
-    fprintf(fp, "  },\n");
+    registry_write_json(fp, &snap.registry);
     fprintf(fp, "  \"queue\": {\n");
-    fprintf(fp, "    \"depth_max\": %" PRIu32 "\n", snap.queue_depth_max);
+    fprintf(fp, "    \"depth_max\": %" PRIu32 ",\n", snap.queue_depth_max);
+    fprintf(fp, "    \"capacity\": %" PRIu32 ",\n", snap.queue_capacity);
+    fprintf(fp, "    \"depth_mean\": %.3f,\n", snap.queue_depth_mean);
+    fprintf(fp, "    \"high_threshold\": %" PRIu32 ",\n",
+            snap.queue_capacity > 0 ? queue_high_threshold(snap.queue_capacity) : 0);
+    fprintf(fp, "    \"time_high_sec\": %.6f,\n", snap.queue_high_ns / 1e9);
+    fprintf(fp, "    \"time_high_pct\": %.3f,\n",
+            snap.queue_window_ns > 0 ? 100.0 * snap.queue_high_ns / snap.queue_window_ns : 0.0);
+    fprintf(fp, "    \"occupancy\": {");
+    for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+        fprintf(fp, "%s\"%s\": %" PRIu64, i > 0 ? ", " : "", g_queue_occupancy_names[i],
+                snap.queue_occupancy[i]);
+    }
+    fprintf(fp, "}\n");
     fprintf(fp, "  },\n");
     fprintf(fp, "  \"latency_ns\": {\n");
     fprintf(fp, "    \"count\": %" PRIu64 ",\n", snap.latency_count);
@@ -433,6 +1709,42 @@ int metrics_snapshot_json(const char *filepath) {
                 (i < METRICS_HISTOGRAM_BUCKETS - 1) ? "," : "");
     }
     fprintf(fp, "  ],\n");
+    if (snap.latency_hdr != NULL) {
+        fprintf(fp, "  \"latency_hdr\": ");
+        hdr_write_json(snap.latency_hdr, fp);
+        fprintf(fp, ",\n");
+    }
+    fprintf(fp, "  \"latency_stages_ns\": {\n");
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+        const hdr_histogram_t *hdr = snap.stage_hdr[i];
+        fprintf(fp, "    \"%s\": {", g_stage_names[i]);
+        if (hdr != NULL) {
+            fprintf(fp, "\"count\": %" PRIu64 ", \"p50\": %" PRIu64 ", \"p95\": %" PRIu64
+                    ", \"p99\": %" PRIu64 ", \"hdr\": ",
+                    hdr_total_count(hdr), hdr_value_at_quantile(hdr, 0.50),
+                    hdr_value_at_quantile(hdr, 0.95), hdr_value_at_quantile(hdr, 0.99));
+            hdr_write_json(hdr, fp);
+        }
+        fprintf(fp, "}%s\n", (i < METRICS_STAGE_COUNT - 1) ? "," : "");
+    }
+    fprintf(fp, "  },\n");
+    write_class_json(fp, &snap);
+    write_exemplars_json(fp, &snap);
+    write_perf_json(fp, &snap);
+    write_cpu_json(fp, &snap);
+    metrics_snapshot_free(&snap);
+    
+    /* Memory budget usage and degradation history */
+    membudget_write_json(fp);
+    fprintf(fp, ",\n");
+    
+    /* Folded stack profile of the run, when --profile is on */
+    profiler_write_json(fp);
+    fprintf(fp, ",\n");
+    
+    /* Rolling-baseline detector state, when --anomaly is on */
+    anomaly_write_json(fp);
+    fprintf(fp, ",\n");
     
     /* Include metadata for baseline compatibility validation */
     fprintf(fp, "  \"metadata\": {\n");
@@ -446,6 +1758,9 @@ int metrics_snapshot_json(const char *filepath) {
     fprintf(fp, "    \"traffic_target\": \"%s\",\n", g_metadata.traffic_target);
     fprintf(fp, "    \"traffic_rate\": %d,\n", g_metadata.traffic_rate);
     fprintf(fp, "    \"os\": \"%s\",\n", g_metadata.os);
+    fprintf(fp, "    \"clock_source\": \"%s\",\n", g_metadata.clock_source);
+    fprintf(fp, "    \"clock_ghz\": %.6f,\n", g_metadata.clock_ghz);
+    fprintf(fp, "    \"clock_spread_ppm\": %.1f,\n", g_metadata.clock_spread_ppm);
     fprintf(fp, "    \"git_sha\": \"%s\"\n", g_metadata.git_sha);
     fprintf(fp, "  }\n");
     fprintf(fp, "}\n");
@@ -462,12 +1777,12 @@ void metrics_set_metadata(const char *interface, const char *filter,
     memset(&g_metadata, 0, sizeof(g_metadata));
     
     if (interface != NULL) {
-        strncpy(g_metadata.interface, interface, METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.interface, sizeof(g_metadata.interface), "%s", interface);
     }
     if (filter != NULL) {
-        strncpy(g_metadata.filter, filter, METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.filter, sizeof(g_metadata.filter), "%s", filter);
     } else {
-        strncpy(g_metadata.filter, "none", METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.filter, sizeof(g_metadata.filter), "%s", "none");
     }
     
     g_metadata.threads = threads;
@@ -477,25 +1792,32 @@ void metrics_set_metadata(const char *interface, const char *filter,
     
     /* Traffic settings */
     if (traffic_mode_param != NULL) {
-        strncpy(g_metadata.traffic_mode, traffic_mode_param, METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.traffic_mode, sizeof(g_metadata.traffic_mode), "%s", traffic_mode_param);
     } else {
-        strncpy(g_metadata.traffic_mode, "none", METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.traffic_mode, sizeof(g_metadata.traffic_mode), "%s", "none");
     }
     if (traffic_target_param != NULL) {
-        strncpy(g_metadata.traffic_target, traffic_target_param, METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.traffic_target, sizeof(g_metadata.traffic_target), "%s", traffic_target_param);
     }
     g_metadata.traffic_rate = traffic_rate_param;
     
     /* Get OS info */
     struct utsname uts;
     if (uname(&uts) == 0) {
-        strncpy(g_metadata.os, uts.sysname, METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.os, sizeof(g_metadata.os), "%.*s", (int)sizeof(g_metadata.os) - 1, uts.sysname);
     } else {
-        strncpy(g_metadata.os, "unknown", METRICS_META_STRING_LEN - 1);
+        snprintf(g_metadata.os, sizeof(g_metadata.os), "%s", "unknown");
     }
     
+    /* Timestamp clock and its calibration quality */
+    fastclock_info_t clock_info;
+    fastclock_get_info(&clock_info);
+    snprintf(g_metadata.clock_source, sizeof(g_metadata.clock_source), "%s", fastclock_source_name(clock_info.source));
+    g_metadata.clock_ghz = clock_info.source == FASTCLOCK_TSC ? clock_info.ticks_per_ns : 0.0;
+    g_metadata.clock_spread_ppm = clock_info.spread_ppm;
+    
     /* Set git SHA from compile-time define */
-    strncpy(g_metadata.git_sha, GIT_SHA, METRICS_META_STRING_LEN - 1);
+    snprintf(g_metadata.git_sha, sizeof(g_metadata.git_sha), "%s", GIT_SHA);
     
     g_metadata.valid = true;
 }
@@ -505,5 +1827,5 @@ const metrics_metadata_t* metrics_get_metadata(void) {
 }
 
 metrics_t* metrics_get(void) {
-    return &g_metrics;
+    return active_metrics();
 }
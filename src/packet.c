@@ -3,7 +3,9 @@
 #include <arpa/inet.h>
 #include "packet.h"
 #include "logger.h"
+#include "logger_bin.h"
 #include "metrics.h"
+#include "membudget.h"
 
 packet_t* packet_create(uint8_t *raw_data, uint32_t length) {
     if (raw_data == NULL || length == 0) {
@@ -24,10 +26,17 @@ packet_t* packet_create(uint8_t *raw_data, uint32_t length) {
         return NULL;
     }
 
+    membudget_charge(MEM_SUBSYS_PACKET, sizeof(packet_t) + length);
+
     memcpy(packet->raw_data, raw_data, length);
     packet->packet_length = length;
-    packet->timestamp = time(NULL);
-    packet->capture_ts_ns = metrics_now_ns();  /* High-resolution capture timestamp */
+
+    /* One tick read gives all three capture timestamps */
+    uint64_t ticks = fastclock_ticks();
+    packet->timestamp = fastclock_ticks_to_wall_sec(ticks);
+    packet->capture_ts_ns = fastclock_ticks_to_monotonic_ns(ticks);
+    memset(packet->ts_ticks, 0, sizeof(packet->ts_ticks));
+    packet->ts_ticks[PACKET_TS_CAPTURE] = ticks;
     
     packet->ethernet = NULL;
     packet->ipv4 = NULL;
@@ -39,9 +48,25 @@ packet_t* packet_create(uint8_t *raw_data, uint32_t length) {
     return packet;
 }
 
+/**
+ * @brief Bytes held by a packet, as charged to the memory budget
+ */
+static size_t packet_footprint(const packet_t *packet) {
+    size_t bytes = sizeof(packet_t);
+    if (packet->raw_data != NULL) bytes += packet->packet_length;
+    if (packet->ethernet != NULL) bytes += sizeof(ethernet_header_t);
+    if (packet->ipv4 != NULL) bytes += sizeof(ipv4_header_t);
+    if (packet->tcp != NULL) bytes += sizeof(tcp_header_t);
+    if (packet->udp != NULL) bytes += sizeof(udp_header_t);
+    if (packet->payload != NULL) bytes += packet->payload_length;
+    return bytes;
+}
+
 void packet_free(packet_t *packet) {
     if (packet == NULL) return;
 
+    membudget_release(MEM_SUBSYS_PACKET, packet_footprint(packet));
+
     if (packet->raw_data != NULL) free(packet->raw_data);
     if (packet->ethernet != NULL) free(packet->ethernet);
     if (packet->ipv4 != NULL) free(packet->ipv4);
@@ -64,12 +89,13 @@ void packet_parse(packet_t *packet) {
     if (packet->packet_length >= sizeof(ethernet_header_t)) {
         packet->ethernet = (ethernet_header_t *)malloc(sizeof(ethernet_header_t));
         if (packet->ethernet != NULL) {
+            membudget_charge(MEM_SUBSYS_PACKET, sizeof(ethernet_header_t));
             memcpy(packet->ethernet, packet->raw_data + offset, sizeof(ethernet_header_t));
             offset += sizeof(ethernet_header_t);
-            logger_debug("Parsed Ethernet header");
+            LOGGER_TRACE("Parsed Ethernet header");
         }
     } else {
-        logger_warn("Packet too small for Ethernet header");
+        LOGGER_WARN_RATELIMITED("Packet too small for Ethernet header");
         return;
     }
 
@@ -79,43 +105,47 @@ void packet_parse(packet_t *packet) {
         if (packet->packet_length - offset >= sizeof(ipv4_header_t)) {
             packet->ipv4 = (ipv4_header_t *)malloc(sizeof(ipv4_header_t));
             if (packet->ipv4 != NULL) {
+                membudget_charge(MEM_SUBSYS_PACKET, sizeof(ipv4_header_t));
                 memcpy(packet->ipv4, packet->raw_data + offset, sizeof(ipv4_header_t));
                 uint8_t ihl = (packet->ipv4->version_ihl & 0x0F) * 4;
                 offset += ihl;
-                logger_debug("Parsed IPv4 header (IHL=%u)", ihl);
+                LOGGER_TRACE("Parsed IPv4 header (IHL=%u)", ihl);
                 
                 /* Parse TCP header (minimum 20 bytes) */
                 if (packet->ipv4->protocol == 6 && packet->packet_length - offset >= sizeof(tcp_header_t)) {
                     packet->tcp = (tcp_header_t *)malloc(sizeof(tcp_header_t));
                     if (packet->tcp != NULL) {
+                        membudget_charge(MEM_SUBSYS_PACKET, sizeof(tcp_header_t));
                         memcpy(packet->tcp, packet->raw_data + offset, sizeof(tcp_header_t));
                         uint8_t data_offset = (packet->tcp->data_offset >> 4) * 4;
                         offset += data_offset;
-                        logger_debug("Parsed TCP header (Offset=%u)", data_offset);
+                        LOGGER_TRACE("Parsed TCP header (Offset=%u)", data_offset);
                     }
                 }
                 /* Parse UDP header (8 bytes) */
                 else if (packet->ipv4->protocol == 17 && packet->packet_length - offset >= sizeof(udp_header_t)) {
                     packet->udp = (udp_header_t *)malloc(sizeof(udp_header_t));
                     if (packet->udp != NULL) {
+                        membudget_charge(MEM_SUBSYS_PACKET, sizeof(udp_header_t));
                         memcpy(packet->udp, packet->raw_data + offset, sizeof(udp_header_t));
                         offset += sizeof(udp_header_t);
-                        logger_debug("Parsed UDP header");
+                        LOGGER_TRACE("Parsed UDP header");
                     }
                 }
             }
         } else {
-            logger_warn("Packet too small for IPv4 header");
+            LOGGER_WARN_RATELIMITED("Packet too small for IPv4 header");
         }
     }
 
-    /* Extract payload */
-    if (offset < packet->packet_length) {
+    /* Extract payload (skipped when the memory budget disables payload analysis) */
+    if (offset < packet->packet_length && membudget_payload_enabled()) {
         packet->payload_length = packet->packet_length - offset;
         packet->payload = (uint8_t *)malloc(packet->payload_length);
         if (packet->payload != NULL) {
+            membudget_charge(MEM_SUBSYS_PACKET, packet->payload_length);
             memcpy(packet->payload, packet->raw_data + offset, packet->payload_length);
-            logger_debug("Extracted payload (%u bytes)", packet->payload_length);
+            LOGGER_TRACE("Extracted payload (%u bytes)", packet->payload_length);
         }
     }
 }
@@ -13,7 +13,7 @@ void parse_ethernet_header(packet_t *packet, const uint8_t *data) {
         return;
     }
 
-    logger_debug("Ethernet frame: %02x:%02x:%02x:%02x:%02x:%02x -> %02x:%02x:%02x:%02x:%02x:%02x (Type: 0x%04x)",
+    LOGGER_DEBUG("Ethernet frame: %02x:%02x:%02x:%02x:%02x:%02x -> %02x:%02x:%02x:%02x:%02x:%02x (Type: 0x%04x)",
                  packet->ethernet->src_mac[0], packet->ethernet->src_mac[1], packet->ethernet->src_mac[2],
                  packet->ethernet->src_mac[3], packet->ethernet->src_mac[4], packet->ethernet->src_mac[5],
                  packet->ethernet->dst_mac[0], packet->ethernet->dst_mac[1], packet->ethernet->dst_mac[2],
@@ -39,12 +39,12 @@ void parse_ipv4_header(packet_t *packet, const uint8_t *data) {
     src.s_addr = packet->ipv4->src_ip;
     dst.s_addr = packet->ipv4->dst_ip;
 
-    logger_debug("IPv4 Header: %s -> %s", inet_ntoa(src), inet_ntoa(dst));
-    logger_debug("  Version: %u, IHL: %u bytes, Total Length: %u bytes", version, ihl, total_length);
-    logger_debug("  TTL: %u, Protocol: %u, Checksum: 0x%04x", ttl, protocol, ntohs(packet->ipv4->checksum));
+    LOGGER_DEBUG("IPv4 Header: %s -> %s", inet_ntoa(src), inet_ntoa(dst));
+    LOGGER_DEBUG("  Version: %u, IHL: %u bytes, Total Length: %u bytes", version, ihl, total_length);
+    LOGGER_DEBUG("  TTL: %u, Protocol: %u, Checksum: 0x%04x", ttl, protocol, ntohs(packet->ipv4->checksum));
 
     if (!validate_ipv4_checksum(packet->ipv4)) {
-        logger_warn("IPv4 checksum validation failed");
+        LOGGER_WARN_RATELIMITED("IPv4 checksum validation failed");
         global_stats.malformed_packets++;
     }
 }
@@ -64,9 +64,9 @@ void parse_tcp_header(packet_t *packet, const uint8_t *data) {
     uint8_t flags = packet->tcp->flags;
     uint16_t window = ntohs(packet->tcp->window_size);
 
-    logger_debug("TCP Header: %u -> %u", src_port, dst_port);
-    logger_debug("  Seq: %u, Ack: %u, Window: %u", seq, ack, window);
-    logger_debug("  Flags: [%s%s%s%s%s%s]",
+    LOGGER_DEBUG("TCP Header: %u -> %u", src_port, dst_port);
+    LOGGER_DEBUG("  Seq: %u, Ack: %u, Window: %u", seq, ack, window);
+    LOGGER_DEBUG("  Flags: [%s%s%s%s%s%s]",
                  (flags & 0x01) ? "FIN " : "",
                  (flags & 0x02) ? "SYN " : "",
                  (flags & 0x04) ? "RST " : "",
@@ -87,8 +87,8 @@ void parse_udp_header(packet_t *packet, const uint8_t *data) {
     uint16_t dst_port = ntohs(packet->udp->dst_port);
     uint16_t length = ntohs(packet->udp->length);
 
-    logger_debug("UDP Header: %u -> %u", src_port, dst_port);
-    logger_debug("  Length: %u, Checksum: 0x%04x", length, ntohs(packet->udp->checksum));
+    LOGGER_DEBUG("UDP Header: %u -> %u", src_port, dst_port);
+    LOGGER_DEBUG("  Length: %u, Checksum: 0x%04x", length, ntohs(packet->udp->checksum));
 }
 
 int validate_ipv4_checksum(const ipv4_header_t *header) {
@@ -119,7 +119,7 @@ int validate_tcp_checksum(const ipv4_header_t *ipv4, const tcp_header_t *tcp, co
     if (tcp == NULL) return 0;
     
     /* Simplified validation - full implementation would require pseudo-header calculation */
-    logger_debug("TCP checksum validation: 0x%04x", ntohs(tcp->checksum));
+    LOGGER_DEBUG("TCP checksum validation: 0x%04x", ntohs(tcp->checksum));
     return 1;
 }
 
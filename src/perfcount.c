@@ -0,0 +1,236 @@
+/**
+ * @file perfcount.c
+ * @brief Per-thread hardware performance counters implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "perfcount.h"
+#include "logger.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+/* One registered thread */
+typedef struct {
+    int fds[PERFCOUNT_EVENT_COUNT];         /* -1 if the event could not be opened */
+    uint64_t base[PERFCOUNT_EVENT_COUNT];   /* Scaled values at window start */
+} perfcount_thread_t;
+
+static pthread_mutex_t g_perf_lock = PTHREAD_MUTEX_INITIALIZER;
+static perfcount_thread_t *g_threads[PERFCOUNT_MAX_THREADS];
+static int g_thread_count = 0;
+
+/* Window counts of threads that unregistered since the window began */
+static uint64_t g_exited[PERFCOUNT_EVENT_COUNT];
+static int g_exited_threads = 0;
+static bool g_exited_valid[PERFCOUNT_EVENT_COUNT];
+
+static const char *g_unavailable_reason = NULL;
+static bool g_warned = false;
+
+static _Thread_local perfcount_thread_t *tls_perf = NULL;
+
+static const char *g_event_names[PERFCOUNT_EVENT_COUNT] = {
+    "cycles", "instructions", "cache_misses", "branch_misses", "context_switches"
+};
+
+/* ============================================================================
+ * Counter Access
+ * ============================================================================ */
+
+#ifdef __linux__
+static int open_event(perfcount_event_t event) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (event) {
+        case PERFCOUNT_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERFCOUNT_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERFCOUNT_CACHE_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERFCOUNT_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            break;
+    }
+
+    /* pid 0, cpu -1: the calling thread on any CPU */
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Read a counter, scaled up if it was multiplexed off the PMU
+ */
+static uint64_t read_event(int fd) {
+    uint64_t data[3];   /* value, time_enabled, time_running */
+    if (fd < 0 || read(fd, data, sizeof(data)) != (ssize_t)sizeof(data)) {
+        return 0;
+    }
+    if (data[2] > 0 && data[2] < data[1]) {
+        return (uint64_t)((double)data[0] * (double)data[1] / (double)data[2]);
+    }
+    return data[0];
+}
+#else
+static int open_event(perfcount_event_t event) {
+    (void)event;
+    errno = ENOSYS;
+    return -1;
+}
+
+static uint64_t read_event(int fd) {
+    (void)fd;
+    return 0;
+}
+#endif
+
+static void close_thread(perfcount_thread_t *t) {
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        if (t->fds[e] >= 0) {
+            close(t->fds[e]);
+        }
+    }
+    free(t);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int perfcount_register_thread(void) {
+    if (tls_perf != NULL) return 0;
+
+    perfcount_thread_t *t = calloc(1, sizeof(perfcount_thread_t));
+    if (t == NULL) return -1;
+
+    int open_errno = 0;
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        t->fds[e] = open_event((perfcount_event_t)e);
+        if (t->fds[e] < 0 && open_errno == 0) {
+            open_errno = errno;
+        }
+    }
+
+    pthread_mutex_lock(&g_perf_lock);
+    if (t->fds[PERFCOUNT_CYCLES] < 0 || g_thread_count >= PERFCOUNT_MAX_THREADS) {
+        if (t->fds[PERFCOUNT_CYCLES] < 0) {
+            g_unavailable_reason = open_errno == EACCES || open_errno == EPERM ?
+                "not permitted (see /proc/sys/kernel/perf_event_paranoid)" :
+                open_errno == ENOENT || open_errno == EOPNOTSUPP ?
+                "no hardware PMU available" : "perf_event_open failed";
+        }
+        bool warn = !g_warned && g_unavailable_reason != NULL;
+        g_warned = g_warned || warn;
+        pthread_mutex_unlock(&g_perf_lock);
+        if (warn) {
+            logger_warn("Hardware counters unavailable: %s (%s)", g_unavailable_reason,
+                        strerror(open_errno));
+        }
+        close_thread(t);
+        return -1;
+    }
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        t->base[e] = read_event(t->fds[e]);
+    }
+    g_threads[g_thread_count++] = t;
+    pthread_mutex_unlock(&g_perf_lock);
+
+    tls_perf = t;
+    return 0;
+}
+
+void perfcount_unregister_thread(void) {
+    perfcount_thread_t *t = tls_perf;
+    if (t == NULL) return;
+
+    pthread_mutex_lock(&g_perf_lock);
+    for (int i = 0; i < g_thread_count; i++) {
+        if (g_threads[i] == t) {
+            g_threads[i] = g_threads[--g_thread_count];
+            break;
+        }
+    }
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        if (t->fds[e] >= 0) {
+            g_exited[e] += read_event(t->fds[e]) - t->base[e];
+        } else {
+            g_exited_valid[e] = false;
+        }
+    }
+    g_exited_threads++;
+    pthread_mutex_unlock(&g_perf_lock);
+
+    tls_perf = NULL;
+    close_thread(t);
+}
+
+void perfcount_window_begin(void) {
+    pthread_mutex_lock(&g_perf_lock);
+    for (int i = 0; i < g_thread_count; i++) {
+        for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+            g_threads[i]->base[e] = read_event(g_threads[i]->fds[e]);
+        }
+    }
+    memset(g_exited, 0, sizeof(g_exited));
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        g_exited_valid[e] = true;
+    }
+    g_exited_threads = 0;
+    pthread_mutex_unlock(&g_perf_lock);
+}
+
+void perfcount_read(perfcount_totals_t *totals) {
+    if (totals == NULL) return;
+    memset(totals, 0, sizeof(*totals));
+
+    pthread_mutex_lock(&g_perf_lock);
+    totals->threads = g_thread_count + g_exited_threads;
+    totals->available = totals->threads > 0;
+    for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+        totals->valid[e] = totals->available && (g_exited_threads == 0 || g_exited_valid[e]);
+        totals->values[e] = g_exited[e];
+    }
+    for (int i = 0; i < g_thread_count; i++) {
+        perfcount_thread_t *t = g_threads[i];
+        for (int e = 0; e < PERFCOUNT_EVENT_COUNT; e++) {
+            if (t->fds[e] < 0) {
+                totals->valid[e] = false;
+                continue;
+            }
+            uint64_t value = read_event(t->fds[e]);
+            totals->values[e] += value > t->base[e] ? value - t->base[e] : 0;
+        }
+    }
+    pthread_mutex_unlock(&g_perf_lock);
+}
+
+const char* perfcount_event_name(perfcount_event_t event) {
+    return (event >= 0 && event < PERFCOUNT_EVENT_COUNT) ? g_event_names[event] : "unknown";
+}
+
+const char* perfcount_unavailable_reason(void) {
+    return g_unavailable_reason;
+}
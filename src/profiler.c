@@ -0,0 +1,687 @@
+/**
+ * @file profiler.c
+ * @brief Sampling profiler implementation
+ *
+ * Everything the SIGPROF handler touches is allocated when a thread
+ * registers. The handler is async-signal-safe: it walks the frame-pointer
+ * chain from the interrupted registers, reading only inside the thread's
+ * stack, and updates the thread's own stack table with lock-free atomics.
+ * It calls no library function (backtrace() and the libgcc unwinder may
+ * take the loader lock or allocate).
+ *
+ * The analyzer is built with -fno-omit-frame-pointer. Frames of code built
+ * without frame pointers (parts of libc) are skipped or end the walk.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "profiler.h"
+#include "logger.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <elf.h>
+#include <ucontext.h>
+#include <sys/syscall.h>
+#define PROFILER_SUPPORTED 1
+#endif
+
+/* glibc before 2.35 only names the union member */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/* Open addressing probes before a sample counts as dropped */
+#define PROFILER_MAX_PROBES 32
+
+static const char *role_names[PROFILER_ROLE_COUNT] = { "capture", "worker", "logger" };
+
+#ifdef PROFILER_SUPPORTED
+
+/* One unique stack, leaf first */
+typedef struct {
+    _Atomic uint64_t count;             /* 0 = free entry */
+    uint64_t hash;
+    int depth;
+    void *frames[PROFILER_MAX_DEPTH];
+} profiler_stack_t;
+
+/* One registered thread; only its own SIGPROF handler writes the stacks */
+typedef struct {
+    profiler_role_t role;
+    timer_t timer;
+    bool timer_live;                    /* Protected by g_prof_lock */
+    _Atomic int active;                 /* Handler may record */
+    _Atomic int busy;                   /* Handler is recording */
+    _Atomic uint64_t samples;
+    _Atomic uint64_t dropped;
+    uintptr_t stack_lo;                 /* Thread stack bounds for the frame walk */
+    uintptr_t stack_hi;
+    profiler_stack_t stacks[PROFILER_MAX_STACKS];
+} profiler_thread_t;
+
+/* Function symbol of the executable, with the load bias applied */
+typedef struct {
+    uintptr_t start;
+    uint64_t size;
+    const char *name;
+} exe_symbol_t;
+
+/* Folded output line before merging */
+typedef struct {
+    char *text;
+    uint64_t count;
+} folded_line_t;
+
+static pthread_mutex_t g_prof_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(profiler_thread_t *) g_threads[PROFILER_MAX_THREADS];
+static int g_thread_count = 0;
+static bool g_running = false;
+static bool g_handler_installed = false;
+static struct sigaction g_prev_action;
+static long g_interval_ns;
+static profiler_summary_t g_summary;
+static _Thread_local int tls_slot = -1;
+
+/* Executable symbol table, loaded by profiler_stop() */
+static char *g_exe_image;
+static exe_symbol_t *g_exe_symbols;
+static size_t g_exe_symbol_count;
+
+/**
+ * @brief Interrupted program counter, frame pointer and stack pointer
+ *
+ * @return false if the architecture is not supported
+ */
+static bool interrupted_regs(void *ucontext, uintptr_t *pc, uintptr_t *fp, uintptr_t *sp) {
+    ucontext_t *uc = (ucontext_t *)ucontext;
+#if defined(__x86_64__)
+    *pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    *fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    *sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+    return true;
+#elif defined(__aarch64__)
+    *pc = (uintptr_t)uc->uc_mcontext.pc;
+    *fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    *sp = (uintptr_t)uc->uc_mcontext.sp;
+    return true;
+#else
+    (void)uc; (void)pc; (void)fp; (void)sp;
+    return false;
+#endif
+}
+
+/**
+ * @brief Walk the frame-pointer chain of the interrupted code (signal context)
+ *
+ * Each frame record is {saved frame pointer, return address}. Records are
+ * only read between the interrupted stack pointer and the top of the
+ * thread's stack, and must move strictly up, so a register that does not
+ * hold a frame pointer ends the walk instead of faulting. Without known
+ * stack bounds only the interrupted PC is recorded.
+ *
+ * @return Frames stored, leaf (the interrupted PC) first
+ */
+static int walk_frames(const profiler_thread_t *t, void *ucontext, void **frames, int max) {
+    uintptr_t pc, fp, sp;
+    if (!interrupted_regs(ucontext, &pc, &fp, &sp) || pc == 0) return 0;
+
+    int depth = 0;
+    frames[depth++] = (void *)pc;
+    if (t->stack_hi == 0) return depth;
+
+    uintptr_t lo = sp > t->stack_lo ? sp : t->stack_lo;
+    while (depth < max && fp >= lo && fp <= t->stack_hi - 2 * sizeof(uintptr_t) &&
+           (fp & (sizeof(uintptr_t) - 1)) == 0) {
+        const uintptr_t *record = (const uintptr_t *)fp;
+        uintptr_t next = record[0];
+        uintptr_t ret = record[1];
+        if (ret == 0) break;
+        frames[depth++] = (void *)ret;
+        if (next <= fp) break;
+        fp = next;
+    }
+    return depth;
+}
+
+/**
+ * @brief Count one stack in the thread's table (signal context)
+ */
+static void record_stack(profiler_thread_t *t, void *const *frames, int depth) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < depth; i++) {
+        hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ULL;
+    }
+
+    for (int probe = 0; probe < PROFILER_MAX_PROBES; probe++) {
+        profiler_stack_t *entry = &t->stacks[(hash + (uint64_t)probe) & (PROFILER_MAX_STACKS - 1)];
+        uint64_t count = atomic_load_explicit(&entry->count, memory_order_relaxed);
+        if (count == 0) {
+            entry->hash = hash;
+            entry->depth = depth;
+            memcpy(entry->frames, frames, (size_t)depth * sizeof(void *));
+            atomic_store_explicit(&entry->count, 1, memory_order_release);
+            return;
+        }
+        if (entry->hash == hash && entry->depth == depth &&
+            memcmp(entry->frames, frames, (size_t)depth * sizeof(void *)) == 0) {
+            atomic_store_explicit(&entry->count, count + 1, memory_order_relaxed);
+            return;
+        }
+    }
+    atomic_store_explicit(&t->dropped, atomic_load_explicit(&t->dropped, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static void profiler_signal_handler(int signum, siginfo_t *info, void *ucontext) {
+    (void)signum;
+    if (info->si_code != SI_TIMER) return;
+    int slot = info->si_value.sival_int;
+    if (slot < 0 || slot >= PROFILER_MAX_THREADS) return;
+    profiler_thread_t *t = atomic_load_explicit(&g_threads[slot], memory_order_acquire);
+    if (t == NULL) return;
+
+    /* busy before active: profiler_stop() clears active, then waits for busy */
+    atomic_store(&t->busy, 1);
+    if (atomic_load(&t->active)) {
+        void *frames[PROFILER_MAX_DEPTH];
+        int depth = walk_frames(t, ucontext, frames, PROFILER_MAX_DEPTH);
+
+        atomic_store_explicit(&t->samples, atomic_load_explicit(&t->samples, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        if (depth > 0) {
+            record_stack(t, frames, depth);
+        }
+    }
+    atomic_store(&t->busy, 0);
+}
+
+/**
+ * @brief Delete every live timer and wait for handlers in progress
+ *
+ * Caller holds g_prof_lock.
+ */
+static void disarm_all(void) {
+    for (int i = 0; i < g_thread_count; i++) {
+        profiler_thread_t *t = atomic_load(&g_threads[i]);
+        if (t == NULL) continue;
+        atomic_store(&t->active, 0);
+        if (t->timer_live) {
+            timer_delete(t->timer);
+            t->timer_live = false;
+        }
+        while (atomic_load(&t->busy)) {
+            sched_yield();
+        }
+    }
+}
+
+/* ============================================================================
+ * Symbolization
+ * ============================================================================ */
+
+static int compare_symbols(const void *a, const void *b) {
+    uintptr_t sa = ((const exe_symbol_t *)a)->start;
+    uintptr_t sb = ((const exe_symbol_t *)b)->start;
+    return (sa > sb) - (sa < sb);
+}
+
+/**
+ * @brief Load the function symbols of /proc/self/exe (static functions included)
+ *
+ * dladdr() only sees the dynamic symbol table, which holds none of the
+ * analyzer's own functions unless linked with -rdynamic.
+ */
+static void load_exe_symbols(void) {
+    FILE *fp = fopen("/proc/self/exe", "rb");
+    if (fp == NULL) return;
+    long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size < (long)sizeof(Elf64_Ehdr) || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return;
+    }
+    char *image = (char *)malloc((size_t)size);
+    if (image == NULL || fread(image, 1, (size_t)size, fp) != (size_t)size) {
+        free(image);
+        fclose(fp);
+        return;
+    }
+    fclose(fp);
+
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)image;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_shentsize != sizeof(Elf64_Shdr) ||
+        ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > (uint64_t)size) {
+        free(image);
+        return;
+    }
+
+    /* Position-independent executables are loaded at a random base */
+    uintptr_t bias = 0;
+    if (ehdr->e_type == ET_DYN) {
+        Dl_info info;
+        if (dladdr((void *)load_exe_symbols, &info) == 0) {
+            free(image);
+            return;
+        }
+        bias = (uintptr_t)info.dli_fbase;
+    }
+
+    const Elf64_Shdr *shdrs = (const Elf64_Shdr *)(image + ehdr->e_shoff);
+    const Elf64_Shdr *symtab = NULL;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdrs[i].sh_type == SHT_SYMTAB) symtab = &shdrs[i];
+    }
+    if (symtab == NULL || symtab->sh_link >= ehdr->e_shnum ||
+        symtab->sh_offset + symtab->sh_size > (uint64_t)size) {
+        free(image);
+        return;
+    }
+    const Elf64_Shdr *strtab = &shdrs[symtab->sh_link];
+    if (strtab->sh_offset + strtab->sh_size > (uint64_t)size) {
+        free(image);
+        return;
+    }
+
+    const Elf64_Sym *syms = (const Elf64_Sym *)(image + symtab->sh_offset);
+    size_t nsyms = symtab->sh_size / sizeof(Elf64_Sym);
+    exe_symbol_t *out = (exe_symbol_t *)calloc(nsyms > 0 ? nsyms : 1, sizeof(exe_symbol_t));
+    if (out == NULL) {
+        free(image);
+        return;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < nsyms; i++) {
+        if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_value == 0 ||
+            syms[i].st_name >= strtab->sh_size) {
+            continue;
+        }
+        out[count].start = (uintptr_t)syms[i].st_value + bias;
+        out[count].size = syms[i].st_size;
+        out[count].name = image + strtab->sh_offset + syms[i].st_name;
+        count++;
+    }
+    qsort(out, count, sizeof(exe_symbol_t), compare_symbols);
+
+    g_exe_image = image;
+    g_exe_symbols = out;
+    g_exe_symbol_count = count;
+}
+
+static void free_exe_symbols(void) {
+    free(g_exe_symbols);
+    free(g_exe_image);
+    g_exe_symbols = NULL;
+    g_exe_image = NULL;
+    g_exe_symbol_count = 0;
+}
+
+/**
+ * @brief Name of the function containing addr
+ */
+static void symbolize(void *addr, char *out, size_t out_len) {
+    uintptr_t a = (uintptr_t)addr;
+
+    /* Last symbol starting at or below addr */
+    size_t lo = 0, hi = g_exe_symbol_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (g_exe_symbols[mid].start <= a) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo > 0) {
+        const exe_symbol_t *sym = &g_exe_symbols[lo - 1];
+        if (a - sym->start < (sym->size > 0 ? sym->size : 1)) {
+            snprintf(out, out_len, "%s", sym->name);
+            return;
+        }
+    }
+
+    Dl_info info;
+    if (dladdr(addr, &info) != 0) {
+        if (info.dli_sname != NULL) {
+            snprintf(out, out_len, "%s", info.dli_sname);
+            return;
+        }
+        if (info.dli_fname != NULL) {
+            const char *base = strrchr(info.dli_fname, '/');
+            snprintf(out, out_len, "%s+0x%" PRIxPTR, base ? base + 1 : info.dli_fname,
+                     a - (uintptr_t)info.dli_fbase);
+            return;
+        }
+    }
+    snprintf(out, out_len, "0x%" PRIxPTR, a);
+}
+
+static int compare_lines(const void *a, const void *b) {
+    return strcmp(((const folded_line_t *)a)->text, ((const folded_line_t *)b)->text);
+}
+
+/**
+ * @brief Symbolize every stack and write merged folded lines
+ *
+ * Workers share a role, so identical stacks from different threads are
+ * merged into one line.
+ *
+ * @return Lines written, or -1 on error
+ */
+static int64_t write_folded(FILE *fp) {
+    size_t total = 0;
+    for (int i = 0; i < g_thread_count; i++) {
+        const profiler_thread_t *t = atomic_load(&g_threads[i]);
+        for (int s = 0; t != NULL && s < PROFILER_MAX_STACKS; s++) {
+            if (atomic_load_explicit(&t->stacks[s].count, memory_order_acquire) > 0) total++;
+        }
+    }
+    folded_line_t *lines = (folded_line_t *)calloc(total > 0 ? total : 1, sizeof(folded_line_t));
+    if (lines == NULL) return -1;
+
+    size_t n = 0;
+    char line[PROFILER_MAX_DEPTH * 128];
+    char name[256];
+    for (int i = 0; i < g_thread_count; i++) {
+        const profiler_thread_t *t = atomic_load(&g_threads[i]);
+        for (int s = 0; t != NULL && s < PROFILER_MAX_STACKS && n < total; s++) {
+            const profiler_stack_t *stack = &t->stacks[s];
+            uint64_t count = atomic_load_explicit(&stack->count, memory_order_acquire);
+            if (count == 0) continue;
+
+            size_t len = (size_t)snprintf(line, sizeof(line), "%s", role_names[t->role]);
+            for (int f = stack->depth - 1; f >= 0 && len < sizeof(line); f--) {
+                /* Callers hold return addresses: look up the call instruction */
+                void *addr = f > 0 ? (char *)stack->frames[f] - 1 : stack->frames[f];
+                symbolize(addr, name, sizeof(name));
+                len += (size_t)snprintf(line + len, sizeof(line) - len, ";%s", name);
+            }
+            lines[n].text = strdup(line);
+            lines[n].count = count;
+            if (lines[n].text != NULL) n++;
+        }
+    }
+
+    qsort(lines, n, sizeof(folded_line_t), compare_lines);
+    int64_t written = 0;
+    for (size_t i = 0; i < n; ) {
+        size_t j = i;
+        uint64_t count = 0;
+        while (j < n && strcmp(lines[j].text, lines[i].text) == 0) {
+            count += lines[j].count;
+            j++;
+        }
+        fprintf(fp, "%s %" PRIu64 "\n", lines[i].text, count);
+        written++;
+        i = j;
+    }
+    for (size_t i = 0; i < n; i++) {
+        free(lines[i].text);
+    }
+    free(lines);
+    return written;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int profiler_start(const char *path, int hz) {
+    if (path == NULL || hz < 1 || hz > PROFILER_HZ_MAX) {
+        logger_error("Invalid profiler settings (hz %d, 1-%d)", hz, PROFILER_HZ_MAX);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_prof_lock);
+    if (g_running) {
+        pthread_mutex_unlock(&g_prof_lock);
+        return 0;
+    }
+
+    if (!g_handler_installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = profiler_signal_handler;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGPROF, &sa, &g_prev_action) != 0) {
+            pthread_mutex_unlock(&g_prof_lock);
+            logger_error("Failed to install SIGPROF handler: %s", strerror(errno));
+            return -1;
+        }
+        g_handler_installed = true;
+    }
+
+    memset(&g_summary, 0, sizeof(g_summary));
+    snprintf(g_summary.path, sizeof(g_summary.path), "%s", path);
+    g_summary.enabled = true;
+    g_summary.hz = hz;
+    g_interval_ns = 1000000000L / hz;
+    g_running = true;
+    pthread_mutex_unlock(&g_prof_lock);
+
+    logger_info("Profiler started: %d Hz per thread of CPU time, folded stacks to %s", hz, path);
+    return 0;
+}
+
+int profiler_register_thread(profiler_role_t role) {
+    if (role < 0 || role >= PROFILER_ROLE_COUNT) return -1;
+
+    pthread_mutex_lock(&g_prof_lock);
+    if (!g_running || tls_slot >= 0) {
+        pthread_mutex_unlock(&g_prof_lock);
+        return -1;
+    }
+    if (g_thread_count >= PROFILER_MAX_THREADS) {
+        pthread_mutex_unlock(&g_prof_lock);
+        logger_warn("Profiler: all %d thread slots taken, %s thread not sampled",
+                    PROFILER_MAX_THREADS, role_names[role]);
+        return -1;
+    }
+
+    profiler_thread_t *t = (profiler_thread_t *)calloc(1, sizeof(profiler_thread_t));
+    clockid_t clock;
+    if (t == NULL || pthread_getcpuclockid(pthread_self(), &clock) != 0) {
+        pthread_mutex_unlock(&g_prof_lock);
+        free(t);
+        logger_error("Profiler: cannot set up %s thread", role_names[role]);
+        return -1;
+    }
+    int slot = g_thread_count;
+    t->role = role;
+
+    /* Stack bounds for the handler's frame walk (reads /proc for the main thread, so not there) */
+    pthread_attr_t attr;
+    void *stack_addr;
+    size_t stack_size;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0) {
+            t->stack_lo = (uintptr_t)stack_addr;
+            t->stack_hi = (uintptr_t)stack_addr + stack_size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_value.sival_int = slot;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(clock, &sev, &t->timer) != 0) {
+        int err = errno;
+        pthread_mutex_unlock(&g_prof_lock);
+        free(t);
+        logger_error("Profiler: timer_create failed: %s", strerror(err));
+        return -1;
+    }
+    t->timer_live = true;
+    atomic_store(&t->active, 1);
+    atomic_store_explicit(&g_threads[slot], t, memory_order_release);
+    g_thread_count++;
+    tls_slot = slot;
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = g_interval_ns / 1000000000L;
+    its.it_interval.tv_nsec = g_interval_ns % 1000000000L;
+    its.it_value = its.it_interval;
+    timer_settime(t->timer, 0, &its, NULL);
+    pthread_mutex_unlock(&g_prof_lock);
+    return 0;
+}
+
+void profiler_unregister_thread(void) {
+    if (tls_slot < 0) return;
+
+    pthread_mutex_lock(&g_prof_lock);
+    profiler_thread_t *t = atomic_load(&g_threads[tls_slot]);
+    if (t != NULL && t->timer_live) {
+        atomic_store(&t->active, 0);
+        timer_delete(t->timer);
+        t->timer_live = false;
+    }
+    tls_slot = -1;
+    pthread_mutex_unlock(&g_prof_lock);
+}
+
+int profiler_stop(void) {
+    pthread_mutex_lock(&g_prof_lock);
+    if (!g_running) {
+        pthread_mutex_unlock(&g_prof_lock);
+        return 0;
+    }
+    g_running = false;
+    disarm_all();
+
+    FILE *fp = fopen(g_summary.path, "w");
+    if (fp == NULL) {
+        int err = errno;
+        pthread_mutex_unlock(&g_prof_lock);
+        logger_error("Failed to open profile output %s: %s", g_summary.path, strerror(err));
+        return -1;
+    }
+    load_exe_symbols();
+    int64_t stacks = write_folded(fp);
+    free_exe_symbols();
+    int rc = (fclose(fp) == 0 && stacks >= 0) ? 0 : -1;
+    if (rc == 0) {
+        g_summary.written = true;
+        g_summary.stacks = (uint64_t)stacks;
+    }
+    pthread_mutex_unlock(&g_prof_lock);
+
+    profiler_summary_t summary;
+    profiler_get_summary(&summary);
+    if (rc != 0) {
+        logger_error("Failed to write profile to %s", summary.path);
+        return -1;
+    }
+    logger_info("Profile written to %s: %" PRIu64 " stacks, %" PRIu64 "/%" PRIu64 "/%" PRIu64
+                " capture/worker/logger samples, %" PRIu64 " dropped",
+                summary.path, summary.stacks, summary.samples[PROFILER_ROLE_CAPTURE],
+                summary.samples[PROFILER_ROLE_WORKER], summary.samples[PROFILER_ROLE_LOGGER],
+                summary.dropped);
+    return 0;
+}
+
+void profiler_cleanup(void) {
+    pthread_mutex_lock(&g_prof_lock);
+    g_running = false;
+    disarm_all();
+    if (g_handler_installed) {
+        sigaction(SIGPROF, &g_prev_action, NULL);
+        g_handler_installed = false;
+    }
+    for (int i = 0; i < g_thread_count; i++) {
+        free(atomic_exchange(&g_threads[i], NULL));
+    }
+    g_thread_count = 0;
+    memset(&g_summary, 0, sizeof(g_summary));
+    pthread_mutex_unlock(&g_prof_lock);
+}
+
+void profiler_get_summary(profiler_summary_t *summary) {
+    if (summary == NULL) return;
+
+    pthread_mutex_lock(&g_prof_lock);
+    *summary = g_summary;
+    summary->threads = g_thread_count;
+    for (int i = 0; i < g_thread_count; i++) {
+        const profiler_thread_t *t = atomic_load(&g_threads[i]);
+        if (t == NULL) continue;
+        summary->samples[t->role] += atomic_load_explicit(&t->samples, memory_order_relaxed);
+        summary->dropped += atomic_load_explicit(&t->dropped, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_prof_lock);
+}
+
+#else /* !PROFILER_SUPPORTED */
+
+int profiler_start(const char *path, int hz) {
+    (void)path;
+    (void)hz;
+    logger_warn("Sampling profiler is only supported on Linux");
+    return -1;
+}
+
+int profiler_register_thread(profiler_role_t role) {
+    (void)role;
+    return -1;
+}
+
+void profiler_unregister_thread(void) {
+}
+
+int profiler_stop(void) {
+    return 0;
+}
+
+void profiler_cleanup(void) {
+}
+
+void profiler_get_summary(profiler_summary_t *summary) {
+    if (summary != NULL) memset(summary, 0, sizeof(*summary));
+}
+
+#endif /* PROFILER_SUPPORTED */
+
+void profiler_write_json(FILE *fp) {
+    if (fp == NULL) return;
+
+    profiler_summary_t summary;
+    profiler_get_summary(&summary);
+
+    fprintf(fp, "  \"profile\": {\n");
+    if (!summary.enabled) {
+        fprintf(fp, "    \"enabled\": false\n");
+        fprintf(fp, "  }");
+        return;
+    }
+    fprintf(fp, "    \"enabled\": true,\n");
+    fprintf(fp, "    \"path\": \"%s\",\n", summary.path);
+    fprintf(fp, "    \"format\": \"folded\",\n");
+    fprintf(fp, "    \"written\": %s,\n", summary.written ? "true" : "false");
+    fprintf(fp, "    \"hz\": %d,\n", summary.hz);
+    fprintf(fp, "    \"threads\": %d,\n", summary.threads);
+    fprintf(fp, "    \"samples\": {");
+    for (int r = 0; r < PROFILER_ROLE_COUNT; r++) {
+        fprintf(fp, "%s\"%s\": %" PRIu64, r > 0 ? ", " : "", role_names[r], summary.samples[r]);
+    }
+    fprintf(fp, "},\n");
+    fprintf(fp, "    \"unique_stacks\": %" PRIu64 ",\n", summary.stacks);
+    fprintf(fp, "    \"dropped_samples\": %" PRIu64 "\n", summary.dropped);
+    fprintf(fp, "  }");
+}
+
+const char* profiler_role_name(profiler_role_t role) {
+    if (role < 0 || role >= PROFILER_ROLE_COUNT) return "unknown";
+    return role_names[role];
+}
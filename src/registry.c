@@ -0,0 +1,403 @@
+/**
+ * @file registry.c
+ * @brief Metrics registry implementation
+ *
+ * Descriptors are appended under g_registry_lock and published by
+ * g_metric_count; the recording path only reads published entries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "registry.h"
+#include "logger.h"
+
+/* A registered metric and where its series live */
+typedef struct {
+    registry_desc_t desc;
+    int slot_base;              /* First slot of series 0 */
+    int series_slots;           /* Slots per series: 1, or buckets + count + sum */
+    int series_count;           /* label_count, or 1 without a label */
+} registry_metric_t;
+
+static pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static registry_metric_t g_metrics[REGISTRY_MAX_METRICS];
+static _Atomic int g_metric_count = 0;
+static int g_slot_count = 0;
+
+/* Gauges, threads without a shard, and shards folded in on unregister */
+_Atomic uint64_t registry_shared[REGISTRY_MAX_SLOTS];
+
+/* Thread shards (protected by g_registry_lock) */
+static registry_shard_t *g_shards[REGISTRY_MAX_THREADS];
+static int g_shard_count = 0;
+
+/* Bumped by registry_reset(); shards from an older epoch are stale */
+_Atomic uint64_t registry_generation = 1;
+
+_Thread_local registry_shard_t *registry_tls_shard = NULL;
+
+static const char *g_type_names[] = { "counter", "gauge", "histogram" };
+
+/* ============================================================================
+ * Registration
+ * ============================================================================ */
+
+int registry_register(const registry_desc_t *desc) {
+    if (desc == NULL || desc->name == NULL || desc->type < REGISTRY_COUNTER ||
+        desc->type > REGISTRY_HISTOGRAM || desc->label_count < 0 ||
+        desc->label_count > REGISTRY_MAX_LABEL_VALUES ||
+        (desc->label_count > 0 && (desc->label == NULL || desc->label_values == NULL))) {
+        logger_error("Invalid metric descriptor: %s", desc && desc->name ? desc->name : "(null)");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_registry_lock);
+    int count = atomic_load(&g_metric_count);
+    for (int id = 0; id < count; id++) {
+        if (strcmp(g_metrics[id].desc.name, desc->name) == 0) {
+            pthread_mutex_unlock(&g_registry_lock);
+            return id;
+        }
+    }
+
+    int series_slots = desc->type == REGISTRY_HISTOGRAM ? REGISTRY_HISTOGRAM_BUCKETS + 2 : 1;
+    int series_count = desc->label_count > 0 ? desc->label_count : 1;
+    if (count >= REGISTRY_MAX_METRICS || g_slot_count + series_slots * series_count > REGISTRY_MAX_SLOTS) {
+        pthread_mutex_unlock(&g_registry_lock);
+        logger_error("Metrics registry full, cannot register %s", desc->name);
+        return -1;
+    }
+
+    registry_metric_t *metric = &g_metrics[count];
+    metric->desc = *desc;
+    if (desc->label_count == 0) {
+        metric->desc.label = NULL;
+        metric->desc.label_values = NULL;
+    }
+    metric->slot_base = g_slot_count;
+    metric->series_slots = series_slots;
+    metric->series_count = series_count;
+    g_slot_count += series_slots * series_count;
+
+    /* Publish the filled entry to the recording path */
+    atomic_store_explicit(&g_metric_count, count + 1, memory_order_release);
+    pthread_mutex_unlock(&g_registry_lock);
+    return count;
+}
+
+int registry_find(const char *name) {
+    if (name == NULL) return -1;
+    int count = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    for (int id = 0; id < count; id++) {
+        if (strcmp(g_metrics[id].desc.name, name) == 0) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+const registry_desc_t* registry_describe(int id) {
+    int count = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    return (id >= 0 && id < count) ? &g_metrics[id].desc : NULL;
+}
+
+/* ============================================================================
+ * Thread Shards
+ * ============================================================================ */
+
+int registry_register_thread(void) {
+    if (registry_tls_shard != NULL) return 0;
+
+    registry_shard_t *shard = aligned_alloc(REGISTRY_CACHE_LINE, sizeof(registry_shard_t));
+    if (shard == NULL) return -1;
+    memset(shard, 0, sizeof(*shard));
+    atomic_store(&shard->generation, atomic_load(&registry_generation));
+
+    pthread_mutex_lock(&g_registry_lock);
+    if (g_shard_count >= REGISTRY_MAX_THREADS) {
+        pthread_mutex_unlock(&g_registry_lock);
+        free(shard);
+        return -1;
+    }
+    g_shards[g_shard_count++] = shard;
+    pthread_mutex_unlock(&g_registry_lock);
+
+    registry_tls_shard = shard;
+    return 0;
+}
+
+void registry_unregister_thread(void) {
+    registry_shard_t *shard = registry_tls_shard;
+    if (shard == NULL) return;
+
+    pthread_mutex_lock(&g_registry_lock);
+    for (int i = 0; i < g_shard_count; i++) {
+        if (g_shards[i] == shard) {
+            g_shards[i] = g_shards[--g_shard_count];
+            break;
+        }
+    }
+    if (atomic_load(&shard->generation) == atomic_load(&registry_generation)) {
+        for (int i = 0; i < g_slot_count; i++) {
+            uint64_t value = atomic_load_explicit(&shard->slots[i], memory_order_relaxed);
+            if (value != 0) {
+                atomic_fetch_add(&registry_shared[i], value);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+
+    registry_tls_shard = NULL;
+    free(shard);
+}
+
+void registry_reset(void) {
+    pthread_mutex_lock(&g_registry_lock);
+    for (int i = 0; i < REGISTRY_MAX_SLOTS; i++) {
+        atomic_store_explicit(&registry_shared[i], 0, memory_order_relaxed);
+    }
+    atomic_fetch_add(&registry_generation, 1);
+    pthread_mutex_unlock(&g_registry_lock);
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+void registry_shard_refresh(registry_shard_t *shard) {
+    uint64_t generation = atomic_load_explicit(&registry_generation, memory_order_relaxed);
+
+    /* Zero the slots before publishing the new epoch to readers */
+    atomic_store_explicit(&shard->generation, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int i = 0; i < REGISTRY_MAX_SLOTS; i++) {
+        atomic_store_explicit(&shard->slots[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&shard->generation, generation, memory_order_release);
+}
+
+/**
+ * @brief First slot of a series, or -1 if id or series is out of range
+ */
+static inline int series_slot(int id, int series) {
+    if ((unsigned)id >= (unsigned)atomic_load_explicit(&g_metric_count, memory_order_acquire)) {
+        return -1;
+    }
+    const registry_metric_t *metric = &g_metrics[id];
+    if ((unsigned)series >= (unsigned)metric->series_count) {
+        return -1;
+    }
+    return metric->slot_base + series * metric->series_slots;
+}
+
+int registry_counter_slot(int id, int series) {
+    return series_slot(id, series);
+}
+
+void registry_add(int id, int series, uint64_t n) {
+    registry_add_slot(series_slot(id, series), n);
+}
+
+void registry_set(int id, int series, uint64_t value) {
+    int slot = series_slot(id, series);
+    if (slot >= 0) {
+        atomic_store(&registry_shared[slot], value);
+    }
+}
+
+void registry_observe(int id, int series, uint64_t value) {
+    registry_observe_slot(series_slot(id, series), value);
+}
+
+/* ============================================================================
+ * Snapshot
+ * ============================================================================ */
+
+void registry_snapshot(registry_snapshot_t *snapshot) {
+    if (snapshot == NULL) return;
+
+    uint64_t generation = atomic_load(&registry_generation);
+    pthread_mutex_lock(&g_registry_lock);
+    snapshot->metric_count = atomic_load(&g_metric_count);
+    for (int i = 0; i < REGISTRY_MAX_SLOTS; i++) {
+        snapshot->slots[i] = atomic_load_explicit(&registry_shared[i], memory_order_relaxed);
+    }
+    for (int s = 0; s < g_shard_count; s++) {
+        registry_shard_t *shard = g_shards[s];
+        if (atomic_load_explicit(&shard->generation, memory_order_acquire) != generation) continue;
+        for (int i = 0; i < g_slot_count; i++) {
+            snapshot->slots[i] += atomic_load_explicit(&shard->slots[i], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+}
+
+/**
+ * @brief First slot of a series in a snapshot, or -1 if out of range
+ */
+static int snapshot_slot(const registry_snapshot_t *snapshot, int id, int series) {
+    if (snapshot == NULL || id < 0 || id >= snapshot->metric_count) return -1;
+    const registry_metric_t *metric = &g_metrics[id];
+    if (series < 0 || series >= metric->series_count) return -1;
+    return metric->slot_base + series * metric->series_slots;
+}
+
+uint64_t registry_value(const registry_snapshot_t *snapshot, int id, int series) {
+    int slot = snapshot_slot(snapshot, id, series);
+    if (slot < 0) return 0;
+    if (g_metrics[id].desc.type == REGISTRY_HISTOGRAM) {
+        slot += REGISTRY_HISTOGRAM_BUCKETS;
+    }
+    return snapshot->slots[slot];
+}
+
+uint64_t registry_bucket(const registry_snapshot_t *snapshot, int id, int series, int bucket) {
+    int slot = snapshot_slot(snapshot, id, series);
+    if (slot < 0 || g_metrics[id].desc.type != REGISTRY_HISTOGRAM ||
+        bucket < 0 || bucket >= REGISTRY_HISTOGRAM_BUCKETS) {
+        return 0;
+    }
+    return snapshot->slots[slot + bucket];
+}
+
+uint64_t registry_sum(const registry_snapshot_t *snapshot, int id, int series) {
+    int slot = snapshot_slot(snapshot, id, series);
+    if (slot < 0 || g_metrics[id].desc.type != REGISTRY_HISTOGRAM) return 0;
+    return snapshot->slots[slot + REGISTRY_HISTOGRAM_BUCKETS + 1];
+}
+
+uint64_t registry_quantile(const registry_snapshot_t *snapshot, int id, int series, double q) {
+    int slot = snapshot_slot(snapshot, id, series);
+    if (slot < 0 || g_metrics[id].desc.type != REGISTRY_HISTOGRAM) return 0;
+    uint64_t count = snapshot->slots[slot + REGISTRY_HISTOGRAM_BUCKETS];
+    if (count == 0) return 0;
+
+    uint64_t rank = (uint64_t)(q * (double)count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    uint64_t seen = 0;
+    for (int b = 0; b < REGISTRY_HISTOGRAM_BUCKETS; b++) {
+        seen += snapshot->slots[slot + b];
+        if (seen >= rank) {
+            /* Bucket b holds [2^(b-1), 2^b) */
+            return b == 0 ? 0 : (1ULL << b) - 1;
+        }
+    }
+    return UINT64_MAX;
+}
+
+/* ============================================================================
+ * Serialization
+ * ============================================================================ */
+
+static void write_histogram_json(FILE *fp, const registry_snapshot_t *snapshot, int id, int series) {
+    fprintf(fp, "{\"count\": %" PRIu64 ", \"sum\": %" PRIu64 ", \"buckets\": [",
+            registry_value(snapshot, id, series), registry_sum(snapshot, id, series));
+    for (int b = 0; b < REGISTRY_HISTOGRAM_BUCKETS; b++) {
+        fprintf(fp, "%s%" PRIu64, b > 0 ? ", " : "", registry_bucket(snapshot, id, series, b));
+    }
+    fprintf(fp, "]}");
+}
+
+void registry_write_json(FILE *fp, const registry_snapshot_t *snapshot) {
+    if (fp == NULL || snapshot == NULL) return;
+
+    for (int id = 0; id < snapshot->metric_count; id++) {
+        const registry_metric_t *metric = &g_metrics[id];
+        if (metric->desc.json_owned) continue;
+        bool histogram = metric->desc.type == REGISTRY_HISTOGRAM;
+        fprintf(fp, "  \"%s\": ", metric->desc.name);
+        if (metric->desc.label_count == 0) {
+            if (histogram) {
+                write_histogram_json(fp, snapshot, id, 0);
+            } else {
+                fprintf(fp, "%" PRIu64, registry_value(snapshot, id, 0));
+            }
+        } else {
+            fprintf(fp, "{");
+            for (int s = 0; s < metric->series_count; s++) {
+                fprintf(fp, "%s\"%s\": ", s > 0 ? ", " : "", metric->desc.label_values[s]);
+                if (histogram) {
+                    write_histogram_json(fp, snapshot, id, s);
+                } else {
+                    fprintf(fp, "%" PRIu64, registry_value(snapshot, id, s));
+                }
+            }
+            fprintf(fp, "}");
+        }
+        fprintf(fp, ",\n");
+    }
+}
+
+/**
+ * @brief Write the label set of a series, e.g. {protocol="tcp",le="7"}
+ *
+ * @param extra Additional label appended inside the braces, or NULL
+ */
+static void write_om_labels(FILE *fp, const registry_metric_t *metric, int series, const char *extra) {
+    bool labeled = metric->desc.label_count > 0;
+    if (!labeled && extra == NULL) return;
+    fprintf(fp, "{");
+    if (labeled) {
+        fprintf(fp, "%s=\"%s\"", metric->desc.label, metric->desc.label_values[series]);
+    }
+    if (extra != NULL) {
+        fprintf(fp, "%s%s", labeled ? "," : "", extra);
+    }
+    fprintf(fp, "}");
+}
+
+void registry_write_openmetrics(FILE *fp, const registry_snapshot_t *snapshot, const char *prefix) {
+    if (fp == NULL || snapshot == NULL) return;
+    if (prefix == NULL) prefix = "";
+
+    for (int id = 0; id < snapshot->metric_count; id++) {
+        const registry_metric_t *metric = &g_metrics[id];
+        const char *family = metric->desc.family != NULL ? metric->desc.family : metric->desc.name;
+
+        fprintf(fp, "# TYPE %s%s %s\n", prefix, family, g_type_names[metric->desc.type]);
+        if (metric->desc.unit != NULL) {
+            fprintf(fp, "# UNIT %s%s %s\n", prefix, family, metric->desc.unit);
+        }
+        if (metric->desc.help != NULL) {
+            fprintf(fp, "# HELP %s%s %s\n", prefix, family, metric->desc.help);
+        }
+
+        for (int s = 0; s < metric->series_count; s++) {
+            if (metric->desc.type == REGISTRY_COUNTER) {
+                fprintf(fp, "%s%s_total", prefix, family);
+                write_om_labels(fp, metric, s, NULL);
+                fprintf(fp, " %" PRIu64 "\n", registry_value(snapshot, id, s));
+            } else if (metric->desc.type == REGISTRY_GAUGE) {
+                fprintf(fp, "%s%s", prefix, family);
+                write_om_labels(fp, metric, s, NULL);
+                fprintf(fp, " %" PRIu64 "\n", registry_value(snapshot, id, s));
+            } else {
+                /* Cumulative buckets; bucket k holds integers up to 2^k - 1 */
+                uint64_t cumulative = 0;
+                for (int b = 0; b < REGISTRY_HISTOGRAM_BUCKETS; b++) {
+                    char le[48];
+                    cumulative += registry_bucket(snapshot, id, s, b);
+                    if (b < REGISTRY_HISTOGRAM_BUCKETS - 1) {
+                        snprintf(le, sizeof(le), "le=\"%" PRIu64 "\"", (uint64_t)((1ULL << b) - 1));
+                    } else {
+                        snprintf(le, sizeof(le), "le=\"+Inf\"");
+                    }
+                    fprintf(fp, "%s%s_bucket", prefix, family);
+                    write_om_labels(fp, metric, s, le);
+                    fprintf(fp, " %" PRIu64 "\n", cumulative);
+                }
+                fprintf(fp, "%s%s_count", prefix, family);
+                write_om_labels(fp, metric, s, NULL);
+                fprintf(fp, " %" PRIu64 "\n", registry_value(snapshot, id, s));
+                fprintf(fp, "%s%s_sum", prefix, family);
+                write_om_labels(fp, metric, s, NULL);
+                fprintf(fp, " %" PRIu64 "\n", registry_sum(snapshot, id, s));
+            }
+        }
+    }
+}
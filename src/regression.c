@@ -261,6 +261,89 @@ int regression_load_baseline(const char *filepath, regression_baseline_t *baseli
         logger_warn("Failed to parse latency_ns.p95 from baseline");
     }
     
+    /* HDR histogram (newer format): p95 at the same precision as current runs */
+    const char *hdr_pos = strstr(json, "\"latency_hdr\"");
+    if (hdr_pos != NULL) {
+        hdr_histogram_t *hdr = hdr_parse_json(hdr_pos);
+        if (hdr != NULL) {
+            uint64_t max_ns = 0;
+            json_extract_uint64(json, "max", &max_ns);
+            baseline->latency_p95_ns = hdr_value_at_quantile(hdr, 0.95);
+            if (max_ns > 0 && baseline->latency_p95_ns > max_ns) {
+                baseline->latency_p95_ns = max_ns;
+            }
+            baseline->latency_hdr_valid = true;
+            hdr_destroy(hdr);
+        } else {
+            logger_warn("Failed to parse latency_hdr from baseline");
+        }
+    }
+    
+    /* Per-stage latency (newer format) */
+    const char *stages_pos = strstr(json, "\"latency_stages_ns\"");
+    if (stages_pos != NULL) {
+        baseline->stages_valid = true;
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            char key[32];
+            snprintf(key, sizeof(key), "\"%s\"", metrics_stage_name((metrics_stage_t)i));
+            const char *stage_pos = strstr(stages_pos, key);
+            const char *p95_pos = stage_pos ? strstr(stage_pos, "\"p95\"") : NULL;
+            const char *stage_end = stage_pos ? strchr(stage_pos, '}') : NULL;
+            if (p95_pos == NULL || stage_end == NULL || p95_pos > stage_end) {
+                baseline->stages_valid = false;
+                break;
+            }
+            json_extract_uint64(stage_pos, "p95", &baseline->stage_p95_ns[i]);
+        }
+    }
+    
+    /* Latency by protocol x size class: flat "proto/size" keys, empty cells omitted */
+    const char *classes_pos = strstr(json, "\"latency_by_class\"");
+    const char *classes_end = classes_pos ? strstr(classes_pos, "\n  }") : NULL;
+    if (classes_pos != NULL) {
+        baseline->classes_valid = true;
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                char key[48];
+                snprintf(key, sizeof(key), "\"%s/%s\"", metrics_l4_name((metrics_l4_t)l),
+                         metrics_size_class_name(c));
+                const char *cell_pos = strstr(classes_pos, key);
+                if (cell_pos == NULL || classes_end == NULL || cell_pos > classes_end) continue;
+                json_extract_uint64(cell_pos, "packets", &baseline->class_packets[l][c]);
+                json_extract_uint64(cell_pos, "p95", &baseline->class_p95_ns[l][c]);
+            }
+        }
+    }
+    
+    /* Hardware counters (present only if perf was available for the run) */
+    const char *perf_pos = strstr(json, "\"perf\"");
+    if (perf_pos != NULL) {
+        const char *cpp_pos = strstr(perf_pos, "\"cycles_per_packet\"");
+        const char *perf_end = strchr(perf_pos, '}');
+        if (cpp_pos != NULL && perf_end != NULL && cpp_pos < perf_end &&
+            json_extract_double(perf_pos, "cycles_per_packet", &baseline->cycles_per_packet) == 0) {
+            baseline->perf_valid = baseline->cycles_per_packet > 0;
+        }
+    }
+    
+    /* Thread CPU time (0 per packet when the clocks were unavailable) */
+    const char *cpu_pos = strstr(json, "\"cpu\"");
+    if (cpu_pos != NULL &&
+        json_extract_double(cpu_pos, "cpu_ns_per_packet", &baseline->cpu_ns_per_packet) == 0) {
+        baseline->cpu_valid = baseline->cpu_ns_per_packet > 0;
+    }
+    
+    /* Memory footprint (older baselines have no RSS or queued-packet bytes) */
+    const char *memory_pos = strstr(json, "\"memory\"");
+    if (memory_pos != NULL) {
+        if (json_extract_uint64(memory_pos, "peak_rss_bytes", &baseline->peak_rss_bytes) != 0) {
+            baseline->peak_rss_bytes = 0;
+        }
+        if (json_extract_double(memory_pos, "bytes_per_queued_packet", &baseline->bytes_per_queued_packet) != 0) {
+            baseline->bytes_per_queued_packet = 0.0;
+        }
+    }
+    
     /* Extract drop counts */
     if (json_extract_uint64(json, "queue_drops", &baseline->queue_drops) != 0) {
         baseline->queue_drops = 0;
@@ -293,6 +376,8 @@ int regression_load_baseline(const char *filepath, regression_baseline_t *baseli
                            baseline->metadata.os, METRICS_META_STRING_LEN);
         json_extract_string(metadata_pos, "git_sha", 
                            baseline->metadata.git_sha, METRICS_META_STRING_LEN);
+        json_extract_string(metadata_pos, "clock_source", 
+                           baseline->metadata.clock_source, METRICS_META_STRING_LEN);
         json_extract_int(metadata_pos, "threads", &baseline->metadata.threads);
         json_extract_int(metadata_pos, "bpf_buffer_size", &baseline->metadata.bpf_buffer_size);
         json_extract_int(metadata_pos, "duration_sec", &baseline->metadata.duration_sec);
@@ -354,7 +439,16 @@ int regression_compare(const regression_baseline_t *baseline,
         (double)current->pkts_processed / current->capture_elapsed_sec : 0;
     double current_mbps = current->capture_elapsed_sec > 0 ?
         (double)current->bytes_processed / current->capture_elapsed_sec / (1024 * 1024) : 0;
-    uint64_t current_p95 = metrics_percentile_ns(current, 0.95);
+    
+    /* Compare like with like: bucket-midpoint p95 against older baselines */
+    metrics_snapshot_t legacy_view;
+    const metrics_snapshot_t *latency_source = current;
+    if (!baseline->latency_hdr_valid && current->latency_hdr != NULL) {
+        legacy_view = *current;
+        legacy_view.latency_hdr = NULL;
+        latency_source = &legacy_view;
+    }
+    uint64_t current_p95 = metrics_percentile_ns(latency_source, 0.95);
     
     uint64_t total_drops = current->queue_drops + current->capture_drops;
     double current_drop_rate = current->pkts_captured > 0 ?
@@ -370,6 +464,89 @@ int regression_compare(const regression_baseline_t *baseline,
     result->baseline_drop_rate = baseline->drop_rate;
     result->current_drop_rate = current_drop_rate;
     
+    /* Per-stage p95 to attribute latency changes */
+    result->stages_valid = baseline->stages_valid;
+    if (baseline->stages_valid) {
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            const hdr_histogram_t *hdr = current->stage_hdr[i];
+            result->baseline_stage_p95_ns[i] = baseline->stage_p95_ns[i];
+            result->current_stage_p95_ns[i] = hdr ? hdr_value_at_quantile(hdr, 0.95) : 0;
+            if (baseline->stage_p95_ns[i] > 0) {
+                result->stage_delta_pct[i] = ((double)result->current_stage_p95_ns[i] -
+                                              (double)baseline->stage_p95_ns[i]) /
+                                             (double)baseline->stage_p95_ns[i];
+            }
+        }
+    }
+    
+    /* Per protocol x size class p95, so a shift in one traffic class is not
+     * averaged away by the others */
+    result->classes_valid = baseline->classes_valid;
+    result->class_threshold = REGRESSION_CLASS_THRESHOLD_DEFAULT;
+    if (baseline->classes_valid) {
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                const metrics_class_stats_t *cell = &current->classes[l][c];
+                if (baseline->class_packets[l][c] < REGRESSION_CLASS_MIN_PACKETS ||
+                    cell->packets < REGRESSION_CLASS_MIN_PACKETS ||
+                    cell->latency_hdr == NULL || baseline->class_p95_ns[l][c] == 0) {
+                    continue;
+                }
+                uint64_t baseline_p95 = baseline->class_p95_ns[l][c];
+                uint64_t current_p95 = hdr_value_at_quantile(cell->latency_hdr, 0.95);
+                result->class_compared[l][c] = true;
+                result->baseline_class_p95_ns[l][c] = baseline_p95;
+                result->current_class_p95_ns[l][c] = current_p95;
+                result->class_delta_pct[l][c] = ((double)current_p95 - (double)baseline_p95) /
+                                                (double)baseline_p95;
+                result->class_regression[l][c] = (current_p95 >
+                                                  (uint64_t)(baseline_p95 * (1.0 + result->class_threshold)));
+                result->any_class_regression = result->any_class_regression ||
+                                               result->class_regression[l][c];
+            }
+        }
+    }
+    
+    /* Cycles per packet: a CPU-efficiency signal that is less noisy than pps */
+    if (baseline->perf_valid && current->perf.available && current->pkts_processed > 0) {
+        result->perf_valid = true;
+        result->baseline_cpp = baseline->cycles_per_packet;
+        result->current_cpp = (double)current->perf.values[PERFCOUNT_CYCLES] /
+                              (double)current->pkts_processed;
+        result->cpp_delta_pct = (result->current_cpp - result->baseline_cpp) / result->baseline_cpp;
+        result->cpp_regression = (result->current_cpp > result->baseline_cpp * (1.0 + threshold));
+    }
+    
+    /* CPU time per packet: what hardware sizing by packets per core depends on */
+    double current_cpu = metrics_cpu_ns_per_packet(current);
+    if (baseline->cpu_valid && current_cpu > 0) {
+        result->cpu_valid = true;
+        result->baseline_cpu_ns_per_packet = baseline->cpu_ns_per_packet;
+        result->current_cpu_ns_per_packet = current_cpu;
+        result->cpu_delta_pct = (current_cpu - baseline->cpu_ns_per_packet) / baseline->cpu_ns_per_packet;
+        result->cpu_regression = (current_cpu > baseline->cpu_ns_per_packet * (1.0 + threshold));
+    }
+    
+    /* Memory footprint: peak RSS of the run and bytes held per queued packet */
+    if (baseline->peak_rss_bytes > 0 && current->memory.rss_valid && current->memory.rss_peak_bytes > 0) {
+        result->rss_valid = true;
+        result->baseline_peak_rss_bytes = baseline->peak_rss_bytes;
+        result->current_peak_rss_bytes = current->memory.rss_peak_bytes;
+        result->rss_delta_pct = ((double)result->current_peak_rss_bytes - (double)baseline->peak_rss_bytes) /
+                                (double)baseline->peak_rss_bytes;
+        result->rss_regression = (result->rss_delta_pct > threshold);
+    }
+    double current_queued_bytes = membudget_bytes_per_queued_packet(&current->memory);
+    if (baseline->bytes_per_queued_packet > 0 && current_queued_bytes > 0) {
+        result->queued_bytes_valid = true;
+        result->baseline_bytes_per_queued_packet = baseline->bytes_per_queued_packet;
+        result->current_bytes_per_queued_packet = current_queued_bytes;
+        result->queued_bytes_delta_pct = (current_queued_bytes - baseline->bytes_per_queued_packet) /
+                                         baseline->bytes_per_queued_packet;
+        result->queued_bytes_regression = (current_queued_bytes >
+                                           baseline->bytes_per_queued_packet * (1.0 + threshold));
+    }
+    
     /* Throughput regression: current < baseline * (1 - threshold) */
     if (result->baseline_pps > 0) {
         result->pps_delta_pct = (current_pps - result->baseline_pps) / result->baseline_pps;
@@ -404,6 +581,10 @@ int regression_compare(const regression_baseline_t *baseline,
     result->any_regression = result->pps_regression || 
                              result->mbps_regression ||
                              result->latency_regression || 
+                             result->cpp_regression ||
+                             result->cpu_regression ||
+                             result->rss_regression ||
+                             result->queued_bytes_regression ||
                              result->drop_regression;
     
     return 0;
@@ -477,6 +658,89 @@ void regression_print_report(const regression_result_t *result) {
     fprintf(stdout, "  Delta:     %s\n\n",
             format_delta(result->latency_delta_pct, result->latency_regression, delta_buf, sizeof(delta_buf)));
     
+    /* Latency by pipeline stage */
+    int worst_stage = -1;
+    if (result->stages_valid) {
+        int64_t worst_increase = 0;
+        fprintf(stdout, "LATENCY BY STAGE (p95, informational):\n");
+        for (int i = 0; i < METRICS_STAGE_COUNT; i++) {
+            int64_t increase = (int64_t)result->current_stage_p95_ns[i] -
+                               (int64_t)result->baseline_stage_p95_ns[i];
+            if (increase > worst_increase) {
+                worst_increase = increase;
+                worst_stage = i;
+            }
+            format_latency_ns(result->baseline_stage_p95_ns[i], lat_baseline, sizeof(lat_baseline));
+            format_latency_ns(result->current_stage_p95_ns[i], lat_current, sizeof(lat_current));
+            fprintf(stdout, "  %-8s %12s -> %12s  (%+.2f%%)\n",
+                    metrics_stage_name((metrics_stage_t)i), lat_baseline, lat_current,
+                    result->stage_delta_pct[i] * 100);
+        }
+        fprintf(stdout, "\n");
+    }
+    
+    /* Latency by protocol x size class */
+    if (result->classes_valid) {
+        bool header = false;
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                if (!result->class_compared[l][c]) continue;
+                if (!header) {
+                    fprintf(stdout, "LATENCY BY PROTOCOL / SIZE (p95, cells with >= %d packets, "
+                            "informational, flagged above +%.0f%%):\n",
+                            REGRESSION_CLASS_MIN_PACKETS, result->class_threshold * 100);
+                    header = true;
+                }
+                char cell_name[32];
+                snprintf(cell_name, sizeof(cell_name), "%s/%s", metrics_l4_name((metrics_l4_t)l),
+                         metrics_size_class_name(c));
+                format_latency_ns(result->baseline_class_p95_ns[l][c], lat_baseline, sizeof(lat_baseline));
+                format_latency_ns(result->current_class_p95_ns[l][c], lat_current, sizeof(lat_current));
+                fprintf(stdout, "  %-16s %12s -> %12s  [%s] %s%.2f%%\n", cell_name, lat_baseline, lat_current,
+                        result->class_regression[l][c] ? "WARN" : "OK",
+                        result->class_delta_pct[l][c] >= 0 ? "+" : "", result->class_delta_pct[l][c] * 100);
+            }
+        }
+        if (header) {
+            fprintf(stdout, "\n");
+        }
+    }
+    
+    /* Cycles per packet */
+    if (result->perf_valid) {
+        fprintf(stdout, "CYCLES PER PACKET:\n");
+        fprintf(stdout, "  Baseline:  %12.1f\n", result->baseline_cpp);
+        fprintf(stdout, "  Current:   %12.1f\n", result->current_cpp);
+        fprintf(stdout, "  Delta:     %s\n\n",
+                format_delta(result->cpp_delta_pct, result->cpp_regression, delta_buf, sizeof(delta_buf)));
+    }
+    
+    /* CPU time per packet */
+    if (result->cpu_valid) {
+        fprintf(stdout, "CPU TIME PER PACKET (ns):\n");
+        fprintf(stdout, "  Baseline:  %12.1f\n", result->baseline_cpu_ns_per_packet);
+        fprintf(stdout, "  Current:   %12.1f\n", result->current_cpu_ns_per_packet);
+        fprintf(stdout, "  Delta:     %s\n\n",
+                format_delta(result->cpu_delta_pct, result->cpu_regression, delta_buf, sizeof(delta_buf)));
+    }
+    
+    /* Memory footprint */
+    if (result->rss_valid || result->queued_bytes_valid) {
+        fprintf(stdout, "MEMORY:\n");
+        if (result->rss_valid) {
+            fprintf(stdout, "  Peak RSS:       %10.1f MB -> %10.1f MB  %s\n",
+                    result->baseline_peak_rss_bytes / 1048576.0, result->current_peak_rss_bytes / 1048576.0,
+                    format_delta(result->rss_delta_pct, result->rss_regression, delta_buf, sizeof(delta_buf)));
+        }
+        if (result->queued_bytes_valid) {
+            fprintf(stdout, "  B/queued pkt:   %10.1f    -> %10.1f     %s\n",
+                    result->baseline_bytes_per_queued_packet, result->current_bytes_per_queued_packet,
+                    format_delta(result->queued_bytes_delta_pct, result->queued_bytes_regression,
+                                 delta_buf, sizeof(delta_buf)));
+        }
+        fprintf(stdout, "\n");
+    }
+    
     /* Drop Rate */
     fprintf(stdout, "DROP RATE:\n");
     fprintf(stdout, "  Baseline:  %12.4f%%\n", result->baseline_drop_rate * 100);
@@ -491,12 +755,34 @@ void regression_print_report(const regression_result_t *result) {
         fprintf(stdout, "  Regressions found in:");
         if (result->pps_regression) fprintf(stdout, " [throughput-pps]");
         if (result->mbps_regression) fprintf(stdout, " [throughput-mbps]");
-        if (result->latency_regression) fprintf(stdout, " [latency-p95]");
+        if (result->latency_regression) {
+            fprintf(stdout, " [latency-p95]");
+            if (worst_stage >= 0) {
+                fprintf(stdout, " (largest stage increase: %s)",
+                        metrics_stage_name((metrics_stage_t)worst_stage));
+            }
+        }
+        if (result->cpp_regression) fprintf(stdout, " [cycles-per-packet]");
+        if (result->cpu_regression) fprintf(stdout, " [cpu-per-packet]");
+        if (result->rss_regression) fprintf(stdout, " [peak-rss]");
+        if (result->queued_bytes_regression) fprintf(stdout, " [bytes-per-queued-packet]");
         if (result->drop_regression) fprintf(stdout, " [drop-rate]");
         fprintf(stdout, "\n");
     } else {
         fprintf(stdout, "RESULT: ALL METRICS WITHIN THRESHOLD\n");
     }
+    if (result->any_class_regression) {
+        fprintf(stdout, "  Informational, not gated:");
+        for (int l = 0; l < METRICS_L4_COUNT; l++) {
+            for (int c = 0; c < METRICS_SIZE_CLASS_COUNT; c++) {
+                if (result->class_regression[l][c]) {
+                    fprintf(stdout, " [latency-%s/%s]", metrics_l4_name((metrics_l4_t)l),
+                            metrics_size_class_name(c));
+                }
+            }
+        }
+        fprintf(stdout, "\n");
+    }
     fprintf(stdout, "================================================================================\n\n");
     
     fflush(stdout);
@@ -758,5 +1044,12 @@ bool regression_validate_metadata(const regression_baseline_t *baseline,
         /* Allow - informational only */
     }
     
+    /* Timestamp clock - latency resolution differs, but results stay comparable */
+    if (strlen(baseline->metadata.clock_source) > 0 && 
+        strcmp(baseline->metadata.clock_source, current_meta->clock_source) != 0) {
+        logger_info("Note: Timestamp clock differs: baseline='%s', current='%s'",
+                    baseline->metadata.clock_source, current_meta->clock_source);
+    }
+    
     return true;
 }
@@ -0,0 +1,314 @@
+/**
+ * @file shm_stats.c
+ * @brief Shared-memory metrics segment implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_stats.h"
+#include "logger.h"
+
+static shm_stats_segment_t *g_segment = NULL;
+static char g_segment_name[64];
+static uint32_t g_interval_ms;
+static pthread_t g_publisher_thread;
+static _Atomic int g_publisher_running = 0;
+
+/* ============================================================================
+ * Publisher
+ * ============================================================================ */
+
+/**
+ * @brief Fill the published stats from the light metrics reader
+ *
+ * Runs every interval, so it uses metrics_summary(): no histogram
+ * copies and no /proc reads.
+ */
+static void fill_stats(shm_stats_t *stats) {
+    metrics_summary_t snap;
+    metrics_summary(&snap);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->pkts_captured = snap.pkts_captured;
+    stats->pkts_processed = snap.pkts_processed;
+    stats->bytes_captured = snap.bytes_captured;
+    stats->bytes_processed = snap.bytes_processed;
+    stats->parse_errors = snap.parse_errors;
+    stats->checksum_failures = snap.checksum_failures;
+    stats->queue_drops = snap.queue_drops;
+    stats->capture_drops = snap.capture_drops;
+    stats->ether_ipv4 = snap.ether_ipv4;
+    stats->ether_ipv6 = snap.ether_ipv6;
+    stats->ether_arp = snap.ether_arp;
+    stats->ether_other = snap.ether_other;
+    stats->proto_tcp = snap.proto_tcp;
+    stats->proto_udp = snap.proto_udp;
+    stats->proto_icmp = snap.proto_icmp;
+    stats->proto_other = snap.proto_other;
+    stats->queue_depth = snap.queue_depth;
+    stats->queue_depth_max = snap.queue_depth_max;
+    stats->latency_count = snap.latency_count;
+    stats->latency_sum_ns = snap.latency_sum_ns;
+    stats->latency_max_ns = snap.latency_max_ns;
+    stats->latency_p50_ns = snap.latency_p50_ns;
+    stats->latency_p95_ns = snap.latency_p95_ns;
+    stats->latency_p99_ns = snap.latency_p99_ns;
+    memcpy(stats->latency_histogram, snap.latency_histogram, sizeof(stats->latency_histogram));
+    stats->elapsed_sec = snap.elapsed_sec;
+    stats->capture_elapsed_sec = snap.capture_elapsed_sec;
+    stats->active = metrics_is_active() ? 1 : 0;
+    stats->shard_count = (uint32_t)metrics_shard_stats(stats->shards, METRICS_MAX_SHARDS);
+}
+
+/**
+ * @brief Seqlock write: odd sequence, copy, even sequence
+ */
+static void publish(const shm_stats_t *stats) {
+    uint64_t seq = atomic_load_explicit(&g_segment->seq, memory_order_relaxed);
+    atomic_store_explicit(&g_segment->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&g_segment->stats, stats, sizeof(*stats));
+    g_segment->publish_count++;
+    g_segment->publish_time_ns = metrics_now_ns();
+
+    atomic_store_explicit(&g_segment->seq, seq + 2, memory_order_release);
+}
+
+static void* shm_stats_publisher_thread(void *arg) {
+    (void)arg;
+
+    /* Snapshot into a private buffer so the odd-sequence window is one memcpy */
+    shm_stats_t *stats = malloc(sizeof(shm_stats_t));
+    if (stats == NULL) {
+        logger_error("Failed to allocate shared-memory stats buffer");
+        return NULL;
+    }
+
+    while (atomic_load(&g_publisher_running)) {
+        fill_stats(stats);
+        publish(stats);
+
+        for (uint32_t waited = 0; waited < g_interval_ms && atomic_load(&g_publisher_running);
+             waited += 10) {
+            usleep(10000);
+        }
+    }
+
+    fill_stats(stats);
+    publish(stats);
+    free(stats);
+    return NULL;
+}
+
+int shm_stats_start(uint32_t interval_ms) {
+    if (g_segment != NULL) {
+        logger_error("Shared-memory stats already published");
+        return -1;
+    }
+    g_interval_ms = interval_ms > 0 ? interval_ms : SHM_STATS_INTERVAL_MS_DEFAULT;
+
+    snprintf(g_segment_name, sizeof(g_segment_name), SHM_STATS_NAME_FMT, (int)getpid());
+    int fd = shm_open(g_segment_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        logger_error("Failed to create shared-memory segment %s: %s", g_segment_name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(shm_stats_segment_t)) < 0) {
+        logger_error("Failed to size shared-memory segment %s: %s", g_segment_name, strerror(errno));
+        close(fd);
+        shm_unlink(g_segment_name);
+        return -1;
+    }
+    void *addr = mmap(NULL, sizeof(shm_stats_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        logger_error("Failed to map shared-memory segment %s: %s", g_segment_name, strerror(errno));
+        shm_unlink(g_segment_name);
+        return -1;
+    }
+
+    g_segment = addr;
+    g_segment->version = SHM_STATS_VERSION;
+    g_segment->size = sizeof(shm_stats_segment_t);
+    g_segment->pid = (int32_t)getpid();
+    atomic_store(&g_segment->seq, 0);
+    g_segment->magic = SHM_STATS_MAGIC;     /* Readers check this last-written field */
+
+    atomic_store(&g_publisher_running, 1);
+    if (pthread_create(&g_publisher_thread, NULL, shm_stats_publisher_thread, NULL) != 0) {
+        logger_error("Failed to create shared-memory stats thread");
+        atomic_store(&g_publisher_running, 0);
+        munmap(g_segment, sizeof(shm_stats_segment_t));
+        g_segment = NULL;
+        shm_unlink(g_segment_name);
+        return -1;
+    }
+
+    logger_info("Publishing metrics to shared memory %s every %u ms (view with --attach %d)",
+                g_segment_name, g_interval_ms, (int)getpid());
+    return 0;
+}
+
+void shm_stats_stop(void) {
+    if (g_segment == NULL) return;
+
+    atomic_store(&g_publisher_running, 0);
+    pthread_join(g_publisher_thread, NULL);
+
+    shm_unlink(g_segment_name);
+    munmap(g_segment, sizeof(shm_stats_segment_t));
+    g_segment = NULL;
+}
+
+/* ============================================================================
+ * Reader
+ * ============================================================================ */
+
+int shm_stats_attach(pid_t pid, shm_stats_reader_t *reader) {
+    if (reader == NULL) return -1;
+
+    char name[64];
+    snprintf(name, sizeof(name), SHM_STATS_NAME_FMT, (int)pid);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        logger_error("No shared-memory stats for pid %d (%s): %s", (int)pid, name, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shm_stats_segment_t)) {
+        logger_error("Shared-memory segment %s is too small for this version", name);
+        close(fd);
+        return -1;
+    }
+    void *addr = mmap(NULL, sizeof(shm_stats_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        logger_error("Failed to map shared-memory segment %s: %s", name, strerror(errno));
+        return -1;
+    }
+
+    const shm_stats_segment_t *segment = addr;
+    if (segment->magic != SHM_STATS_MAGIC || segment->version != SHM_STATS_VERSION ||
+        segment->size != sizeof(shm_stats_segment_t)) {
+        logger_error("Shared-memory segment %s has layout version %u (expected %u)",
+                     name, segment->version, SHM_STATS_VERSION);
+        munmap(addr, sizeof(shm_stats_segment_t));
+        return -1;
+    }
+
+    reader->segment = segment;
+    reader->pid = pid;
+    return 0;
+}
+
+int shm_stats_read(const shm_stats_reader_t *reader, shm_stats_t *out, uint64_t *publish_count) {
+    if (reader == NULL || reader->segment == NULL || out == NULL) return -1;
+
+    /* The segment is mapped read-only; casting away const only for the atomic loads */
+    shm_stats_segment_t *segment = (shm_stats_segment_t *)reader->segment;
+    for (int attempt = 0; attempt < SHM_STATS_READ_RETRIES; attempt++) {
+        uint64_t before = atomic_load_explicit(&segment->seq, memory_order_acquire);
+        if (before & 1) continue;
+
+        memcpy(out, &segment->stats, sizeof(*out));
+        uint64_t count = segment->publish_count;
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&segment->seq, memory_order_relaxed) == before) {
+            if (publish_count != NULL) *publish_count = count;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void shm_stats_detach(shm_stats_reader_t *reader) {
+    if (reader == NULL || reader->segment == NULL) return;
+    munmap((void *)reader->segment, sizeof(shm_stats_segment_t));
+    reader->segment = NULL;
+}
+
+/* ============================================================================
+ * Viewer
+ * ============================================================================ */
+
+static void print_view(pid_t pid, const shm_stats_t *cur, const shm_stats_t *prev) {
+    /* Rates over the last interval; after a metrics reset, since the reset */
+    double dt = cur->elapsed_sec;
+    uint64_t pkts = cur->pkts_processed;
+    uint64_t bytes = cur->bytes_processed;
+    if (prev != NULL && cur->elapsed_sec > prev->elapsed_sec &&
+        cur->pkts_processed >= prev->pkts_processed) {
+        dt = cur->elapsed_sec - prev->elapsed_sec;
+        pkts -= prev->pkts_processed;
+        bytes -= prev->bytes_processed;
+    }
+    double pps = dt > 0 ? pkts / dt : 0;
+    double mbps = dt > 0 ? (bytes / dt) / (1024 * 1024) : 0;
+
+    fprintf(stdout, "[ATTACH %d]%s t=%.1f pkts=%" PRIu64 " pps=%.0f MB/s=%.2f drops=%" PRIu64
+            " queue=%u p50/p95/p99=%.1f/%.1f/%.1f us threads=",
+            (int)pid, cur->active ? "" : " (idle)", cur->elapsed_sec, cur->pkts_processed,
+            pps, mbps, cur->queue_drops + cur->capture_drops, cur->queue_depth,
+            cur->latency_p50_ns / 1000.0, cur->latency_p95_ns / 1000.0,
+            cur->latency_p99_ns / 1000.0);
+    for (uint32_t i = 0; i < cur->shard_count && i < METRICS_MAX_SHARDS; i++) {
+        fprintf(stdout, "%s%" PRIu64, i > 0 ? "/" : "", cur->shards[i].pkts_processed);
+    }
+    fprintf(stdout, "\n");
+    fflush(stdout);
+}
+
+int shm_stats_view(pid_t pid, uint32_t interval_ms, volatile int *running) {
+    shm_stats_reader_t reader;
+    if (shm_stats_attach(pid, &reader) != 0) {
+        return -1;
+    }
+    if (interval_ms == 0) interval_ms = 1000;
+
+    shm_stats_t *cur = malloc(sizeof(shm_stats_t));
+    shm_stats_t *prev = malloc(sizeof(shm_stats_t));
+    if (cur == NULL || prev == NULL) {
+        logger_error("Failed to allocate attach buffers");
+        free(cur);
+        free(prev);
+        shm_stats_detach(&reader);
+        return -1;
+    }
+
+    bool have_prev = false;
+    uint64_t last_count = 0;
+    while (running == NULL || *running) {
+        if (kill(pid, 0) != 0 && errno == ESRCH) {
+            logger_info("Process %d exited", (int)pid);
+            break;
+        }
+
+        uint64_t count;
+        if (shm_stats_read(&reader, cur, &count) == 0 && count != last_count) {
+            print_view(pid, cur, have_prev ? prev : NULL);
+            shm_stats_t *swap = prev;
+            prev = cur;
+            cur = swap;
+            have_prev = true;
+            last_count = count;
+        }
+        usleep(interval_ms * 1000);
+    }
+
+    free(cur);
+    free(prev);
+    shm_stats_detach(&reader);
+    return 0;
+}
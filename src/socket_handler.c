@@ -10,6 +10,8 @@
 #include <errno.h>
 #include "socket_handler.h"
 #include "logger.h"
+#include "logger_bin.h"
+#include "probes.h"
 
 /* Platform-specific includes */
 #ifdef __linux__
@@ -223,11 +225,12 @@ int socket_receive_packet(socket_config_t *config, uint8_t *buffer, size_t buffe
         if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
             return 0;  /* No packet available, not an error */
         }
-        logger_error("Failed to receive packet: %s", strerror(errno));
+        LOGGER_ERROR_RATELIMITED("Failed to receive packet: %s", strerror(errno));
         return -1;
     }
 
-    logger_debug("Received packet: %zd bytes on interface %u", packet_size, sll.sll_ifindex);
+    LOGGER_TRACE("Received packet: %zd bytes on interface %u", packet_size, sll.sll_ifindex);
+    PROBE1(receive, packet_size);
     return (int)packet_size;
     
 #elif __APPLE__
@@ -260,13 +263,14 @@ int socket_receive_packet(socket_config_t *config, uint8_t *buffer, size_t buffe
         
         /* Copy packet to caller's buffer */
         if (pkt_len > buffer_size) {
-            logger_warn("Packet truncated: %u bytes > buffer %zu bytes", pkt_len, buffer_size);
+            LOGGER_WARN_RATELIMITED("Packet truncated: %u bytes > buffer %zu bytes", pkt_len, buffer_size);
             pkt_len = (uint32_t)buffer_size;
         }
         
         memcpy(buffer, pkt_data, pkt_len);
-        logger_debug("BPF packet: %u bytes (captured), %u bytes (wire)", 
+        LOGGER_TRACE("BPF packet: %u bytes (captured), %u bytes (wire)", 
                      bh->bh_caplen, bh->bh_datalen);
+        PROBE1(receive, pkt_len);
         
         return (int)pkt_len;
     }
@@ -282,7 +286,7 @@ int socket_receive_packet(socket_config_t *config, uint8_t *buffer, size_t buffe
             /* No data available - this is normal for non-blocking or idle periods */
             return 0;
         }
-        logger_error("BPF read failed: %s", strerror(errno));
+        LOGGER_ERROR_RATELIMITED("BPF read failed: %s", strerror(errno));
         return -1;
     }
     
@@ -292,7 +296,7 @@ int socket_receive_packet(socket_config_t *config, uint8_t *buffer, size_t buffe
     }
     
     config->bpf_data_len = (size_t)bytes_read;
-    logger_debug("BPF read: %zd bytes", bytes_read);
+    LOGGER_TRACE("BPF read: %zd bytes", bytes_read);
     
     /* Recursively call to parse first packet from new buffer */
     return socket_receive_packet(config, buffer, buffer_size);
@@ -1,23 +1,120 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <arpa/inet.h>
 #include "thread_pool.h"
 #include "logger.h"
+#include "logger_bin.h"
 #include "metrics.h"
+#include "profiler.h"
+#include "membudget.h"
+#include "dump.h"
+#include "probes.h"
+
+/**
+ * @brief Offer a slow packet as an exemplar with its flow tuple and stage timestamps
+ */
+static void record_exemplar(const packet_t *packet, uint8_t ip_protocol,
+                            uint64_t latency_ns, int worker_id) {
+    const uint64_t *ts = packet->ts_ticks;
+    metrics_exemplar_t e;
+    memset(&e, 0, sizeof(e));
+    e.latency_ns = latency_ns;
+    e.capture_ts_ns = packet->capture_ts_ns;
+    for (int stage = 0; stage < METRICS_STAGE_COUNT; stage++) {
+        uint64_t end = ts[stage + 1];
+        e.stage_end_ns[stage] = end > ts[PACKET_TS_CAPTURE] ? fastclock_to_ns(end - ts[PACKET_TS_CAPTURE]) : 0;
+    }
+    e.length = packet->packet_length;
+    e.protocol = ip_protocol;
+    e.worker_id = worker_id;
+
+    if (packet->ipv4 != NULL) {
+        e.ip_version = 4;
+        memcpy(e.src_addr, &packet->ipv4->src_ip, 4);
+        memcpy(e.dst_addr, &packet->ipv4->dst_ip, 4);
+        if (packet->tcp != NULL) {
+            e.src_port = ntohs(packet->tcp->src_port);
+            e.dst_port = ntohs(packet->tcp->dst_port);
+        } else if (packet->udp != NULL) {
+            e.src_port = ntohs(packet->udp->src_port);
+            e.dst_port = ntohs(packet->udp->dst_port);
+        }
+    } else if (packet->ethernet != NULL && ntohs(packet->ethernet->ethertype) == ETHER_IPV6 &&
+               packet->raw_data != NULL && packet->packet_length >= 14 + 40) {
+        /* IPv6: fixed header at 14; ports only when TCP/UDP follows it directly */
+        e.ip_version = 6;
+        memcpy(e.src_addr, packet->raw_data + 14 + 8, 16);
+        memcpy(e.dst_addr, packet->raw_data + 14 + 24, 16);
+        uint8_t next_header = packet->raw_data[14 + 6];
+        if ((next_header == PROTO_TCP || next_header == PROTO_UDP) &&
+            packet->packet_length >= 14 + 40 + 4) {
+            const uint8_t *l4 = packet->raw_data + 14 + 40;
+            e.src_port = (uint16_t)(l4[0] << 8 | l4[1]);
+            e.dst_port = (uint16_t)(l4[2] << 8 | l4[3]);
+        }
+    }
+    metrics_observe_exemplar(&e);
+}
+
+/**
+ * @brief Record per-stage and end-to-end latency from a packet's timestamps
+ *
+ * The end-to-end latency also goes to the packet's protocol x size class cell,
+ * and the packet becomes an exemplar if it is among the slowest seen.
+ *
+ * Stage i spans ts_ticks[i] to ts_ticks[i + 1]. Differences that come out
+ * negative (TSC skew between cores) are recorded as 0.
+ */
+static void record_latencies(const packet_t *packet, uint8_t ip_protocol, int worker_id) {
+    const uint64_t *ts = packet->ts_ticks;
+
+    for (int stage = 0; stage < METRICS_STAGE_COUNT; stage++) {
+        uint64_t start = ts[stage];
+        uint64_t end = ts[stage + 1];
+        metrics_observe_stage((metrics_stage_t)stage,
+                              end > start ? fastclock_to_ns(end - start) : 0);
+    }
+
+    uint64_t start = ts[PACKET_TS_CAPTURE];
+    uint64_t end = ts[PACKET_TS_ANALYZED];
+    uint64_t latency_ns = end > start ? fastclock_to_ns(end - start) : 0;
+    metrics_observe_latency(latency_ns);
+    metrics_observe_class(ip_protocol, packet->packet_length, latency_ns);
+    if (metrics_exemplar_wanted(latency_ns)) {
+        record_exemplar(packet, ip_protocol, latency_ns, worker_id);
+    }
+}
 
 static void* thread_worker(void *arg) {
     thread_pool_t *pool = (thread_pool_t *)arg;
 
+    /* Per-thread counters; falls back to global atomics if none is free */
+    metrics_register_thread();
+
+    lockstat_lock(&pool->queue_lock);
+    int worker_id = pool->workers_started++;
+    lockstat_unlock(&pool->queue_lock);
+    char name[METRICS_THREAD_NAME_LEN];
+    snprintf(name, sizeof(name), "worker-%d", worker_id);
+    metrics_set_thread_name(name);
+    profiler_register_thread(PROFILER_ROLE_WORKER);
+
     while (pool->is_running) {
-        pthread_mutex_lock(&pool->queue_lock);
+        uint64_t idle_ticks = 0;
+        lockstat_lock(&pool->queue_lock);
 
-        while (pool->queue_head == NULL && pool->is_running) {
-            pthread_cond_wait(&pool->queue_cond, &pool->queue_lock);
+        if (pool->queue_head == NULL && pool->is_running) {
+            uint64_t wait_start = fastclock_ticks();
+            while (pool->queue_head == NULL && pool->is_running) {
+                lockstat_cond_wait(&pool->queue_cond, &pool->queue_lock);
+            }
+            idle_ticks = fastclock_ticks() - wait_start;
         }
 
         if (!pool->is_running) {
-            pthread_mutex_unlock(&pool->queue_lock);
+            lockstat_unlock(&pool->queue_lock);
             break;
         }
 
@@ -27,17 +124,28 @@ static void* thread_worker(void *arg) {
             pool->queue_tail = NULL;
         }
         pool->queue_size--;
+        metrics_set_queue_depth((uint32_t)pool->queue_size);
+        if (item->packet != NULL) {
+            PROBE3(dequeue, item->packet, item->packet->packet_length, pool->queue_size);
+        }
 
-        pthread_mutex_unlock(&pool->queue_lock);
+        lockstat_unlock(&pool->queue_lock);
+        uint64_t busy_start = fastclock_ticks();
 
         /* Process the packet */
         if (item->packet != NULL) {
+            item->packet->ts_ticks[PACKET_TS_DEQUEUE] = fastclock_ticks();
             packet_parse(item->packet);
-            packet_print(item->packet);
+            item->packet->ts_ticks[PACKET_TS_PARSED] = fastclock_ticks();
+            PROBE3(parsed, item->packet, item->packet->packet_length,
+                   item->packet->ipv4 != NULL ? item->packet->ipv4->protocol : 0);
+            dump_packet(item->packet);
             pool->packets_processed++;
             
             /* Only record metrics during measurement phase (after warmup) */
             if (metrics_is_active()) {
+                uint8_t ip_protocol = 0;    /* Non-IP frames land in the "other" row */
+                
                 /* Record EtherType metrics (with safe NULL check) */
                 if (item->packet->ethernet != NULL) {
                     /* EtherType is stored in network byte order, convert to host */
@@ -47,30 +155,36 @@ static void* thread_worker(void *arg) {
                     /* Record L4 protocol metrics */
                     if (ethertype == 0x0800 && item->packet->ipv4 != NULL) {
                         /* IPv4 packet - record IP protocol */
-                        metrics_record_protocol(item->packet->ipv4->protocol);
+                        ip_protocol = item->packet->ipv4->protocol;
+                        metrics_record_protocol(ip_protocol);
                     } else if (ethertype == 0x86DD && item->packet->raw_data != NULL && 
                                item->packet->packet_length >= 14 + 40) {
                         /* IPv6 packet - next header is at offset 14 + 6 = 20 */
-                        uint8_t next_header = item->packet->raw_data[14 + 6];
-                        metrics_record_protocol(next_header);
+                        ip_protocol = item->packet->raw_data[14 + 6];
+                        metrics_record_protocol(ip_protocol);
                     }
                 }
                 
-                /* Calculate and record end-to-end latency */
-                uint64_t now_ns = metrics_now_ns();
-                uint64_t latency_ns = now_ns - item->packet->capture_ts_ns;
-                metrics_observe_latency(latency_ns);
+                /* Record stage and end-to-end latency */
+                item->packet->ts_ticks[PACKET_TS_ANALYZED] = fastclock_ticks();
+                record_latencies(item->packet, ip_protocol, worker_id);
                 
                 /* Record processed packet metrics */
                 metrics_inc_processed(item->packet->packet_length);
             }
             
-            logger_debug("Processed packet (Total: %d)", pool->packets_processed);
+            LOGGER_TRACE("Processed packet (Total: %d)", pool->packets_processed);
+            PROBE2(analyzed, item->packet, item->packet->packet_length);
+            packet_free(item->packet);
         }
 
         free(item);
+        membudget_release(MEM_SUBSYS_QUEUE, sizeof(work_item_t));
+        metrics_add_thread_time(fastclock_ticks() - busy_start, idle_ticks);
     }
 
+    profiler_unregister_thread();
+    metrics_unregister_thread();
     return NULL;
 }
 
@@ -98,10 +212,12 @@ thread_pool_t* thread_pool_create(int num_threads, int max_queue_size) {
     pool->queue_tail = NULL;
     pool->queue_size = 0;
     pool->max_queue_size = max_queue_size;
+    metrics_set_queue_capacity((uint32_t)max_queue_size);
     pool->is_running = 1;
     pool->packets_processed = 0;
+    pool->workers_started = 0;
 
-    pthread_mutex_init(&pool->queue_lock, NULL);
+    lockstat_mutex_init(&pool->queue_lock, LOCKSTAT_QUEUE);
     pthread_cond_init(&pool->queue_cond, NULL);
 
     for (int i = 0; i < num_threads; i++) {
@@ -119,10 +235,10 @@ thread_pool_t* thread_pool_create(int num_threads, int max_queue_size) {
 void thread_pool_destroy(thread_pool_t *pool) {
     if (pool == NULL) return;
 
-    pthread_mutex_lock(&pool->queue_lock);
+    lockstat_lock(&pool->queue_lock);
     pool->is_running = 0;
     pthread_cond_broadcast(&pool->queue_cond);
-    pthread_mutex_unlock(&pool->queue_lock);
+    lockstat_unlock(&pool->queue_lock);
 
     for (int i = 0; i < pool->num_threads; i++) {
         pthread_join(pool->threads[i], NULL);
@@ -134,10 +250,11 @@ void thread_pool_destroy(thread_pool_t *pool) {
         work_item_t *next = current->next;
         packet_free(current->packet);
         free(current);
+        membudget_release(MEM_SUBSYS_QUEUE, sizeof(work_item_t));
         current = next;
     }
 
-    pthread_mutex_destroy(&pool->queue_lock);
+    lockstat_mutex_destroy(&pool->queue_lock);
     pthread_cond_destroy(&pool->queue_cond);
 
     free(pool->threads);
@@ -148,29 +265,38 @@ void thread_pool_destroy(thread_pool_t *pool) {
 
 int thread_pool_enqueue(thread_pool_t *pool, packet_t *packet) {
     if (pool == NULL || packet == NULL) {
-        logger_error("Invalid thread pool or packet");
+        LOGGER_ERROR_RATELIMITED("Invalid thread pool or packet");
         return -1;
     }
 
     work_item_t *item = (work_item_t *)malloc(sizeof(work_item_t));
     if (item == NULL) {
-        logger_error("Failed to allocate memory for work item");
+        LOGGER_ERROR_RATELIMITED("Failed to allocate memory for work item");
         return -1;
     }
 
+    membudget_charge(MEM_SUBSYS_QUEUE, sizeof(work_item_t));
     item->packet = packet;
     item->next = NULL;
 
-    pthread_mutex_lock(&pool->queue_lock);
+    /* Workers may free the packet as soon as it is queued */
+    size_t queued_bytes = sizeof(packet_t) + packet->packet_length + sizeof(work_item_t);
+
+    lockstat_lock(&pool->queue_lock);
 
+    /* Fill level this arrival finds, drops included */
+    metrics_observe_queue_occupancy((uint32_t)pool->queue_size);
     if (pool->queue_size >= pool->max_queue_size) {
-        logger_warn("Work queue is full (%d items)", pool->queue_size);
-        pthread_mutex_unlock(&pool->queue_lock);
+        LOGGER_WARN_RATELIMITED("Work queue is full (%d items)", pool->queue_size);
+        lockstat_unlock(&pool->queue_lock);
         free(item);
+        membudget_release(MEM_SUBSYS_QUEUE, sizeof(work_item_t));
         metrics_inc_queue_drops();  /* Track queue drop */
+        PROBE2(drop, PROBE_DROP_QUEUE_FULL, packet->packet_length);
         return -1;
     }
 
+    packet->ts_ticks[PACKET_TS_ENQUEUE] = fastclock_ticks();
     if (pool->queue_tail == NULL) {
         pool->queue_head = item;
     } else {
@@ -178,22 +304,25 @@ int thread_pool_enqueue(thread_pool_t *pool, packet_t *packet) {
     }
     pool->queue_tail = item;
     pool->queue_size++;
+    PROBE3(enqueue, packet, packet->packet_length, pool->queue_size);
     
     /* Update queue depth maximum watermark */
     metrics_update_queue_depth_max((uint32_t)pool->queue_size);
+    metrics_set_queue_depth((uint32_t)pool->queue_size);
 
     pthread_cond_signal(&pool->queue_cond);
-    pthread_mutex_unlock(&pool->queue_lock);
+    lockstat_unlock(&pool->queue_lock);
 
+    membudget_note_queued(queued_bytes);
     return 0;
 }
 
 int thread_pool_is_running(thread_pool_t *pool) {
     if (pool == NULL) return 0;
     
-    pthread_mutex_lock(&pool->queue_lock);
+    lockstat_lock(&pool->queue_lock);
     int running = pool->is_running;
-    pthread_mutex_unlock(&pool->queue_lock);
+    lockstat_unlock(&pool->queue_lock);
     
     return running;
 }
@@ -201,9 +330,9 @@ int thread_pool_is_running(thread_pool_t *pool) {
 int thread_pool_get_processed_count(thread_pool_t *pool) {
     if (pool == NULL) return 0;
     
-    pthread_mutex_lock(&pool->queue_lock);
+    lockstat_lock(&pool->queue_lock);
     int count = pool->packets_processed;
-    pthread_mutex_unlock(&pool->queue_lock);
+    lockstat_unlock(&pool->queue_lock);
     
     return count;
 }
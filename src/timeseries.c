@@ -0,0 +1,382 @@
+/**
+ * @file timeseries.c
+ * @brief Per-interval metrics time series implementation
+ *
+ * The sampler thread owns the previous snapshot and appends one sample
+ * per interval to the ring under g_ring_lock. The writer thread copies
+ * samples it has not written yet out of the ring and formats them outside
+ * the lock. If the writer falls more than a full ring behind, the oldest
+ * unwritten samples are overwritten and counted as lost.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "timeseries.h"
+#include "metrics.h"
+#include "lockstat.h"
+#include "anomaly.h"
+#include "logger.h"
+
+static timeseries_config_t g_ts_config;  /* Set with the ring under g_ring_lock */
+static _Atomic int g_ts_active = 0;
+
+/* Sample ring: g_sample_count samples appended so far; readers may call
+ * in at any time, so the ring is only replaced under g_ring_lock */
+static lockstat_mutex_t g_ring_lock = LOCKSTAT_MUTEX_INITIALIZER(LOCKSTAT_TIMESERIES);
+static timeseries_sample_t *g_samples = NULL;
+static uint64_t g_sample_count;
+static uint64_t g_written_count;        /* Writer thread only */
+static uint64_t g_lost_count;           /* Writer thread only */
+
+static FILE *g_ts_file = NULL;
+static pthread_t g_sampler_thread;
+static pthread_t g_writer_thread;
+static _Atomic int g_sampler_running;
+static _Atomic int g_writer_running;
+
+static const char *format_names[] = { "jsonl", "csv" };
+
+/* ============================================================================
+ * Sampler Thread
+ * ============================================================================ */
+
+/**
+ * @brief Turn the difference between two snapshots into a sample
+ *
+ * @param prev Previous snapshot of the same measurement epoch, or NULL
+ */
+static void build_sample(const metrics_snapshot_t *cur, const metrics_snapshot_t *prev,
+                         timeseries_sample_t *sample) {
+    metrics_snapshot_t zero;
+    if (prev == NULL) {
+        memset(&zero, 0, sizeof(zero));
+        prev = &zero;
+    }
+
+    sample->t_sec = cur->elapsed_sec;
+    sample->interval_sec = cur->elapsed_sec - prev->elapsed_sec;
+    sample->pkts = cur->pkts_processed - prev->pkts_processed;
+    sample->bytes = cur->bytes_processed - prev->bytes_processed;
+    sample->drops = (cur->queue_drops + cur->capture_drops) -
+                    (prev->queue_drops + prev->capture_drops);
+    sample->pps = sample->interval_sec > 0 ? sample->pkts / sample->interval_sec : 0;
+    sample->mbps = sample->interval_sec > 0 ?
+        (sample->bytes / sample->interval_sec) / (1024 * 1024) : 0;
+    sample->queue_depth = cur->queue_depth;
+
+    /* Queue integrals restart with each epoch, so prev is always earlier */
+    uint64_t window_ns = cur->queue_window_ns - prev->queue_window_ns;
+    sample->queue_depth_mean = window_ns > 0 ?
+        (double)(cur->queue_area_ns - prev->queue_area_ns) / (double)window_ns : 0.0;
+    sample->queue_high_pct = window_ns > 0 ?
+        100.0 * (double)(cur->queue_high_ns - prev->queue_high_ns) / (double)window_ns : 0.0;
+    for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+        sample->queue_occupancy[i] = cur->queue_occupancy[i] - prev->queue_occupancy[i];
+    }
+
+    /* Latency percentiles of this interval only */
+    sample->latency_p50_ns = 0;
+    sample->latency_p95_ns = 0;
+    sample->latency_p99_ns = 0;
+    hdr_histogram_t *delta = hdr_copy(cur->latency_hdr);
+    if (delta != NULL) {
+        if (prev->latency_hdr != NULL) {
+            hdr_subtract(delta, prev->latency_hdr);
+        }
+        sample->latency_p50_ns = hdr_value_at_quantile(delta, 0.50);
+        sample->latency_p95_ns = hdr_value_at_quantile(delta, 0.95);
+        sample->latency_p99_ns = hdr_value_at_quantile(delta, 0.99);
+        hdr_destroy(delta);
+    }
+}
+
+static void ring_append(const timeseries_sample_t *sample) {
+    lockstat_lock(&g_ring_lock);
+    g_samples[g_sample_count % g_ts_config.capacity] = *sample;
+    g_sample_count++;
+    lockstat_unlock(&g_ring_lock);
+}
+
+static void* timeseries_sampler_thread(void *arg) {
+    (void)arg;
+
+    metrics_snapshot_t prev;
+    bool have_prev = false;
+    uint64_t interval_ns = (uint64_t)g_ts_config.interval_ms * 1000000ULL;
+    uint64_t next_ns = metrics_now_ns() + interval_ns;
+
+    while (atomic_load(&g_sampler_running)) {
+        uint64_t now_ns = metrics_now_ns();
+        if (now_ns < next_ns) {
+            uint64_t wait_us = (next_ns - now_ns) / 1000;
+            usleep(wait_us < 10000 ? (useconds_t)wait_us : 10000);
+            continue;
+        }
+        next_ns += interval_ns;
+        if (next_ns <= now_ns) {
+            next_ns = now_ns + interval_ns;     /* Skip missed intervals */
+        }
+
+        /* Sample only during measurement; a reset starts a new epoch */
+        if (!metrics_is_active()) {
+            if (have_prev) {
+                metrics_snapshot_free(&prev);
+                have_prev = false;
+                anomaly_reset();
+            }
+            continue;
+        }
+
+        metrics_snapshot_t cur;
+        metrics_snapshot_select(&cur, METRICS_SNAP_LATENCY);
+        if (have_prev && prev.epoch != cur.epoch) {
+            metrics_snapshot_free(&prev);
+            have_prev = false;
+            anomaly_reset();
+        }
+        if (cur.start_time_ns == 0) {
+            /* Reset between the check and the snapshot, not started yet */
+            metrics_snapshot_free(&cur);
+            continue;
+        }
+
+        timeseries_sample_t sample;
+        build_sample(&cur, have_prev ? &prev : NULL, &sample);
+        ring_append(&sample);
+        /* After capture ends the pipeline only drains; throughput falling is expected */
+        if (cur.capture_end_time_ns == 0) {
+            anomaly_observe(&sample);
+        }
+
+        if (have_prev) {
+            metrics_snapshot_free(&prev);
+        }
+        prev = cur;
+        have_prev = true;
+    }
+
+    if (have_prev) {
+        metrics_snapshot_free(&prev);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Writer Thread
+ * ============================================================================ */
+
+static void write_sample(const timeseries_sample_t *s) {
+    if (g_ts_config.format == TIMESERIES_CSV) {
+        fprintf(g_ts_file, "%.3f,%.3f,%" PRIu64 ",%" PRIu64 ",%.2f,%.4f,%" PRIu64 ",%" PRIu64
+                ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 ",%.3f,%.3f",
+                s->t_sec, s->interval_sec, s->pkts, s->bytes, s->pps, s->mbps, s->drops,
+                s->latency_p50_ns, s->latency_p95_ns, s->latency_p99_ns, s->queue_depth,
+                s->queue_depth_mean, s->queue_high_pct);
+        for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+            fprintf(g_ts_file, ",%" PRIu64, s->queue_occupancy[i]);
+        }
+        fprintf(g_ts_file, "\n");
+    } else {
+        fprintf(g_ts_file, "{\"t\": %.3f, \"interval\": %.3f, \"pkts\": %" PRIu64
+                ", \"bytes\": %" PRIu64 ", \"pps\": %.2f, \"mbps\": %.4f, \"drops\": %" PRIu64
+                ", \"p50_ns\": %" PRIu64 ", \"p95_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64
+                ", \"queue_depth\": %" PRIu32 ", \"queue_depth_mean\": %.3f"
+                ", \"queue_high_pct\": %.3f, \"queue_occupancy\": [",
+                s->t_sec, s->interval_sec, s->pkts, s->bytes, s->pps, s->mbps, s->drops,
+                s->latency_p50_ns, s->latency_p95_ns, s->latency_p99_ns, s->queue_depth,
+                s->queue_depth_mean, s->queue_high_pct);
+        for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+            fprintf(g_ts_file, "%s%" PRIu64, i > 0 ? ", " : "", s->queue_occupancy[i]);
+        }
+        fprintf(g_ts_file, "]}\n");
+    }
+}
+
+/**
+ * @brief Write all samples appended since the last call
+ *
+ * @return Number of samples written
+ */
+static size_t write_pending(void) {
+    size_t count = 0;
+
+    for (;;) {
+        timeseries_sample_t sample;
+
+        lockstat_lock(&g_ring_lock);
+        if (g_sample_count - g_written_count > g_ts_config.capacity) {
+            uint64_t oldest = g_sample_count - g_ts_config.capacity;
+            g_lost_count += oldest - g_written_count;
+            g_written_count = oldest;
+        }
+        if (g_written_count == g_sample_count) {
+            lockstat_unlock(&g_ring_lock);
+            break;
+        }
+        sample = g_samples[g_written_count % g_ts_config.capacity];
+        g_written_count++;
+        lockstat_unlock(&g_ring_lock);
+
+        write_sample(&sample);
+        count++;
+    }
+
+    if (count > 0) {
+        fflush(g_ts_file);
+    }
+    return count;
+}
+
+static void* timeseries_writer_thread(void *arg) {
+    (void)arg;
+
+    while (atomic_load(&g_writer_running)) {
+        if (write_pending() == 0) {
+            usleep(10000);
+        }
+    }
+    write_pending();
+    return NULL;
+}
+
+/**
+ * @brief Detach and free the sample ring under the lock readers index it with
+ */
+static void ring_free(void) {
+    lockstat_lock(&g_ring_lock);
+    timeseries_sample_t *samples = g_samples;
+    g_samples = NULL;
+    g_sample_count = 0;
+    lockstat_unlock(&g_ring_lock);
+    free(samples);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int timeseries_start(const timeseries_config_t *config) {
+    if (config == NULL) return -1;
+    if (atomic_load(&g_ts_active)) {
+        logger_error("Time series already running");
+        return -1;
+    }
+
+    timeseries_config_t c = *config;
+    if (c.interval_ms == 0) c.interval_ms = TIMESERIES_INTERVAL_MS_DEFAULT;
+    if (c.capacity == 0) c.capacity = TIMESERIES_CAPACITY_DEFAULT;
+
+    timeseries_sample_t *samples = calloc(c.capacity, sizeof(timeseries_sample_t));
+    if (samples == NULL) {
+        logger_error("Failed to allocate time series ring (%u samples)", c.capacity);
+        return -1;
+    }
+    lockstat_lock(&g_ring_lock);
+    g_ts_config = c;
+    g_samples = samples;
+    g_sample_count = 0;
+    g_written_count = 0;
+    g_lost_count = 0;
+    lockstat_unlock(&g_ring_lock);
+
+    if (g_ts_config.path != NULL) {
+        g_ts_file = fopen(g_ts_config.path, "w");
+        if (g_ts_file == NULL) {
+            logger_error("Failed to open time series file: %s", g_ts_config.path);
+            ring_free();
+            return -1;
+        }
+        if (g_ts_config.format == TIMESERIES_CSV) {
+            fprintf(g_ts_file, "t_sec,interval_sec,pkts,bytes,pps,mbps,drops,"
+                    "p50_ns,p95_ns,p99_ns,queue_depth,queue_depth_mean,queue_high_pct");
+            for (int i = 0; i < METRICS_QUEUE_OCC_BUCKETS; i++) {
+                fprintf(g_ts_file, ",occ_%s", metrics_queue_occupancy_name(i));
+            }
+            fprintf(g_ts_file, "\n");
+        }
+
+        atomic_store(&g_writer_running, 1);
+        if (pthread_create(&g_writer_thread, NULL, timeseries_writer_thread, NULL) != 0) {
+            logger_error("Failed to create time series writer thread");
+            fclose(g_ts_file);
+            g_ts_file = NULL;
+            ring_free();
+            return -1;
+        }
+    }
+
+    atomic_store(&g_sampler_running, 1);
+    if (pthread_create(&g_sampler_thread, NULL, timeseries_sampler_thread, NULL) != 0) {
+        logger_error("Failed to create time series sampler thread");
+        if (g_ts_file != NULL) {
+            atomic_store(&g_writer_running, 0);
+            pthread_join(g_writer_thread, NULL);
+            fclose(g_ts_file);
+            g_ts_file = NULL;
+        }
+        ring_free();
+        return -1;
+    }
+
+    atomic_store(&g_ts_active, 1);
+    logger_info("Time series: every %u ms, %u-sample ring%s%s (%s)",
+                g_ts_config.interval_ms, g_ts_config.capacity,
+                g_ts_file ? ", writing to " : "", g_ts_file ? g_ts_config.path : "",
+                format_names[g_ts_config.format]);
+    return 0;
+}
+
+void timeseries_stop(void) {
+    if (!atomic_load(&g_ts_active)) return;
+
+    atomic_store(&g_ts_active, 0);
+    atomic_store(&g_sampler_running, 0);
+    pthread_join(g_sampler_thread, NULL);
+
+    if (g_ts_file != NULL) {
+        atomic_store(&g_writer_running, 0);
+        pthread_join(g_writer_thread, NULL);
+        fclose(g_ts_file);
+        g_ts_file = NULL;
+        logger_info("Time series: %" PRIu64 " samples written, %" PRIu64 " lost (writer behind)",
+                    g_written_count - g_lost_count, g_lost_count);
+    }
+
+    ring_free();
+}
+
+size_t timeseries_get_samples(timeseries_sample_t *out, size_t max) {
+    if (out == NULL || max == 0) return 0;
+
+    lockstat_lock(&g_ring_lock);
+    if (g_samples == NULL) {
+        lockstat_unlock(&g_ring_lock);
+        return 0;
+    }
+    uint64_t available = g_sample_count < g_ts_config.capacity ? g_sample_count : g_ts_config.capacity;
+    size_t count = available < max ? (size_t)available : max;
+    uint64_t first = g_sample_count - count;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = g_samples[(first + i) % g_ts_config.capacity];
+    }
+    lockstat_unlock(&g_ring_lock);
+    return count;
+}
+
+int timeseries_parse_format(const char *name, timeseries_format_t *format) {
+    if (name == NULL || format == NULL) return -1;
+
+    for (int i = 0; i <= TIMESERIES_CSV; i++) {
+        if (strcmp(name, format_names[i]) == 0) {
+            *format = (timeseries_format_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
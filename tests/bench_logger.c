@@ -0,0 +1,149 @@
+/**
+ * @file bench_logger.c
+ * @brief Per-packet cost of disabled debug logging and timestamp caching
+ *
+ * Runs the IPv4 + TCP header logging from parser.c with debug disabled in
+ * three forms: a plain logger_debug() call (arguments evaluated, filtered
+ * inside the call), the LOGGER_DEBUG macro (inlined runtime check) and the
+ * compiled-out form used when LOGGER_COMPILE_LEVEL > 0. Also measures the
+ * localtime_r()+strftime() work the per-second timestamp cache avoids.
+ *
+ * Build and run with: make bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "packet.h"
+#include "logger.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+static inline uint64_t bench_ticks(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_ticks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define BENCH_ITERATIONS 1000000
+#define BENCH_LINES 200000
+
+/* Expansion of a level macro below LOGGER_COMPILE_LEVEL */
+#define DEBUG_COMPILED_OUT(fmt, ...) do { if (0) logger_debug((fmt), ##__VA_ARGS__); } while (0)
+
+/* Header logging from parse_ipv4_header()/parse_tcp_header(), parameterized by log macro */
+#define DEFINE_HEADER_LOGGING(name, LOG) \
+static __attribute__((noinline)) void name(const ipv4_header_t *ip, const tcp_header_t *tcp) { \
+    struct in_addr src, dst; \
+    src.s_addr = ip->src_ip; \
+    dst.s_addr = ip->dst_ip; \
+    LOG("IPv4 Header: %s -> %s", inet_ntoa(src), inet_ntoa(dst)); \
+    LOG("  TTL: %u, Protocol: %u, Checksum: 0x%04x", ip->ttl, ip->protocol, ntohs(ip->checksum)); \
+    uint8_t flags = tcp->flags; \
+    LOG("TCP Header: %u -> %u", ntohs(tcp->src_port), ntohs(tcp->dst_port)); \
+    LOG("  Seq: %u, Ack: %u, Window: %u", ntohl(tcp->seq_num), ntohl(tcp->ack_num), \
+        ntohs(tcp->window_size)); \
+    LOG("  Flags: [%s%s%s%s%s%s]", \
+        (flags & 0x01) ? "FIN " : "", (flags & 0x02) ? "SYN " : "", \
+        (flags & 0x04) ? "RST " : "", (flags & 0x08) ? "PSH " : "", \
+        (flags & 0x10) ? "ACK " : "", (flags & 0x20) ? "URG " : ""); \
+}
+
+DEFINE_HEADER_LOGGING(log_headers_call, logger_debug)
+DEFINE_HEADER_LOGGING(log_headers_macro, LOGGER_DEBUG)
+DEFINE_HEADER_LOGGING(log_headers_compiled_out, DEBUG_COMPILED_OUT)
+
+typedef void (*header_logger_fn)(const ipv4_header_t *, const tcp_header_t *);
+
+static double bench_headers(header_logger_fn fn, const ipv4_header_t *ip, const tcp_header_t *tcp) {
+    /* Warm up caches and branch predictors */
+    for (int i = 0; i < BENCH_ITERATIONS / 10; i++) {
+        fn(ip, tcp);
+    }
+
+    uint64_t start = bench_ticks();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(ip, tcp);
+    }
+    return (double)(bench_ticks() - start) / BENCH_ITERATIONS;
+}
+
+static double bench_strftime(void) {
+    char timestamp[32];
+    volatile size_t sink = 0;
+
+    uint64_t start = bench_ticks();
+    for (int i = 0; i < BENCH_LINES; i++) {
+        time_t now = time(NULL);
+        struct tm timeinfo;
+        localtime_r(&now, &timeinfo);
+        sink += strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    }
+    (void)sink;
+    return (double)(bench_ticks() - start) / BENCH_LINES;
+}
+
+static double bench_log_lines(void) {
+    uint64_t start = bench_ticks();
+    for (int i = 0; i < BENCH_LINES; i++) {
+        logger_info("Processed packet %d (%u bytes)", i, 60u);
+    }
+    return (double)(bench_ticks() - start) / BENCH_LINES;
+}
+
+int main(void) {
+    ipv4_header_t ip;
+    tcp_header_t tcp;
+    memset(&ip, 0, sizeof(ip));
+    memset(&tcp, 0, sizeof(tcp));
+    ip.version_ihl = 0x45;
+    ip.ttl = 64;
+    ip.protocol = 6;
+    ip.src_ip = htonl(0xac100a63);
+    ip.dst_ip = htonl(0xac100a01);
+    tcp.src_port = htons(80);
+    tcp.dst_port = htons(4660);
+    tcp.seq_num = htonl(1);
+    tcp.flags = 0x12;
+    tcp.window_size = htons(8192);
+
+    printf("================================================================================\n");
+    printf("                      LOGGER BENCHMARK (%s per operation)\n", BENCH_UNIT);
+    printf("================================================================================\n");
+
+    /* Debug disabled at runtime, as in normal operation */
+    logger_init(NULL, LOG_INFO);
+
+    double call = bench_headers(log_headers_call, &ip, &tcp);
+    double macro = bench_headers(log_headers_macro, &ip, &tcp);
+    double off = bench_headers(log_headers_compiled_out, &ip, &tcp);
+
+    printf("\nPer-packet IPv4+TCP debug logging (debug disabled, %d packets):\n", BENCH_ITERATIONS);
+    printf("  logger_debug() call      %8.1f %s\n", call, BENCH_UNIT);
+    printf("  LOGGER_DEBUG runtime     %8.1f %s  (saves %.1f)\n", macro, BENCH_UNIT, call - macro);
+    printf("  LOGGER_DEBUG compiled out %7.1f %s  (saves %.1f)\n", off, BENCH_UNIT, call - off);
+
+    logger_cleanup();
+
+    /* Enabled lines to /dev/null: the timestamp is formatted once per second */
+    logger_init("/dev/null", LOG_INFO);
+    double line = bench_log_lines();
+    double stamp = bench_strftime();
+    logger_cleanup();
+
+    printf("\nTimestamp formatting (%d lines):\n", BENCH_LINES);
+    printf("  logged line (cached ts)  %8.1f %s\n", line, BENCH_UNIT);
+    printf("  localtime_r+strftime     %8.1f %s  (per-line cost removed by the cache)\n",
+           stamp, BENCH_UNIT);
+
+    printf("\n================================================================================\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file bench_metrics.c
+ * @brief Scaling of per-packet metric updates: global atomics vs thread shards
+ *
+ * Each thread performs the per-packet update sequence of thread_worker()
+ * (EtherType, protocol, latency, processed). Unregistered threads hit the
+ * shared global atomics; registered threads update their own shard.
+ * Totals are checked against metrics_snapshot() after every run.
+ *
+ * Build and run with: make bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "metrics.h"
+
+#define BENCH_PACKETS_PER_THREAD 1000000
+
+typedef struct {
+    bool sharded;
+    pthread_barrier_t *barrier;
+} bench_arg_t;
+
+static void* bench_worker(void *arg) {
+    bench_arg_t *bench = (bench_arg_t *)arg;
+
+    if (bench->sharded) {
+        metrics_register_thread();
+    }
+    pthread_barrier_wait(bench->barrier);
+
+    for (uint32_t i = 0; i < BENCH_PACKETS_PER_THREAD; i++) {
+        metrics_record_ethertype(0x0800);
+        metrics_record_protocol((i & 1) ? 6 : 17);
+        metrics_observe_latency(1000 + (i & 0xfff));
+        metrics_inc_processed(64 + (i & 0x3ff));
+    }
+
+    /* Wait so the snapshot sees live shards before they are folded */
+    pthread_barrier_wait(bench->barrier);
+    pthread_barrier_wait(bench->barrier);
+
+    if (bench->sharded) {
+        metrics_unregister_thread();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run one configuration
+ *
+ * @return Million packets per second across all threads, or -1 on a count mismatch
+ */
+static double bench_run(int threads, bool sharded) {
+    pthread_t tids[METRICS_MAX_SHARDS];
+    pthread_barrier_t barrier;
+    bench_arg_t arg = { sharded, &barrier };
+
+    metrics_init();
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, bench_worker, &arg);
+    }
+
+    pthread_barrier_wait(&barrier);
+    uint64_t start = metrics_now_ns();
+    pthread_barrier_wait(&barrier);
+    uint64_t elapsed = metrics_now_ns() - start;
+
+    metrics_snapshot_t live;
+    metrics_snapshot(&live);
+    metrics_snapshot_free(&live);
+    pthread_barrier_wait(&barrier);
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    metrics_snapshot_t folded;
+    metrics_snapshot(&folded);
+    metrics_snapshot_free(&folded);
+
+    uint64_t expected = (uint64_t)threads * BENCH_PACKETS_PER_THREAD;
+    if (live.pkts_processed != expected || folded.pkts_processed != expected ||
+        live.latency_count != expected || live.proto_tcp + live.proto_udp != expected) {
+        fprintf(stderr, "Count mismatch: expected %llu, live %llu, folded %llu\n",
+                (unsigned long long)expected, (unsigned long long)live.pkts_processed,
+                (unsigned long long)folded.pkts_processed);
+        return -1;
+    }
+
+    return (double)expected / ((double)elapsed / 1e9) / 1e6;
+}
+
+int main(void) {
+    static const int thread_counts[] = { 1, 2, 4, 8, 16, 32 };
+    int failures = 0;
+
+    printf("================================================================================\n");
+    printf("                 METRICS SCALING BENCHMARK (%d packets/thread)\n", BENCH_PACKETS_PER_THREAD);
+    printf("================================================================================\n");
+    printf("\n  %-8s %18s %18s %10s\n", "threads", "global (Mpps)", "sharded (Mpps)", "speedup");
+
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+        int threads = thread_counts[i];
+        double global = bench_run(threads, false);
+        double sharded = bench_run(threads, true);
+        if (global < 0 || sharded < 0) {
+            failures++;
+            continue;
+        }
+        printf("  %-8d %18.1f %18.1f %9.1fx\n", threads, global, sharded, sharded / global);
+    }
+
+    printf("\n================================================================================\n");
+    return failures > 0 ? 1 : 0;
+}
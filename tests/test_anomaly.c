@@ -0,0 +1,284 @@
+/**
+ * @file test_anomaly.c
+ * @brief Unit tests for rolling-baseline anomaly detection
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "anomaly.h"
+#include "timeseries.h"
+#include "metrics.h"
+#include "registry.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_noise_state = 12345;
+
+/* Deterministic noise in [-1, 1] */
+static double noise(void) {
+    g_noise_state = g_noise_state * 1103515245u + 12345u;
+    return ((g_noise_state >> 16) & 0x7FFF) / 16383.5 - 1.0;
+}
+
+/**
+ * @brief One 1 s interval: pps packets with the given drops and p99, p50/p95 below it
+ */
+static int observe(double pps, uint64_t drops, uint64_t p99_ns) {
+    timeseries_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.interval_sec = 1.0;
+    sample.pps = pps;
+    sample.pkts = (uint64_t)pps;
+    sample.drops = drops;
+    sample.latency_p50_ns = p99_ns / 4;
+    sample.latency_p95_ns = p99_ns / 2;
+    sample.latency_p99_ns = p99_ns;
+    return anomaly_observe(&sample);
+}
+
+/* Normal traffic: 10k pps +-2%, no drops, p99 200 us +-5% */
+static int observe_normal(int intervals) {
+    int raised = 0;
+    for (int i = 0; i < intervals; i++) {
+        raised += observe(10000.0 * (1.0 + 0.02 * noise()), 0, (uint64_t)(200000.0 * (1.0 + 0.05 * noise())));
+    }
+    return raised;
+}
+
+static uint64_t registry_metric(const char *name, anomaly_metric_t metric) {
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    return registry_value(&snap, registry_find(name), metric);
+}
+
+/**
+ * @brief Test: Nothing happens until detection is configured
+ */
+void test_disabled(void) {
+    printf("\n=== Test: Detection off ===\n");
+
+    anomaly_disable();
+    metrics_init();
+    TEST_ASSERT(registry_find("anomaly_alerts") < 0 && registry_find("anomaly_active") < 0,
+                "Alert metrics not registered");
+    TEST_ASSERT(!anomaly_enabled() && observe(0.0, 1000, 1000000000) == 0, "Observations ignored");
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].observed == 0, "No baseline kept");
+
+    anomaly_config_t bad = { .window = 1 };
+    TEST_ASSERT(anomaly_configure(&bad) == -1 && !anomaly_enabled(), "One-interval window rejected");
+    bad.window = 10;
+    bad.threshold = -1.0;
+    TEST_ASSERT(anomaly_configure(&bad) == -1, "Negative threshold rejected");
+}
+
+/**
+ * @brief Test: Noise and short spikes raise nothing; the baseline tracks the level
+ */
+void test_steady(void) {
+    printf("\n=== Test: Steady traffic ===\n");
+
+    metrics_init();
+    TEST_ASSERT(anomaly_configure(NULL) == 0 && anomaly_enabled(), "Enabled with defaults");
+    TEST_ASSERT(observe_normal(100) == 0, "No alerts on noise");
+
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].observed == 100 && status[ANOMALY_DROP_RATE].observed == 100,
+                "Every interval observed");
+    TEST_ASSERT(status[ANOMALY_PPS].baseline > 9800 && status[ANOMALY_PPS].baseline < 10200 &&
+                status[ANOMALY_PPS].mad > 0 && status[ANOMALY_PPS].mad < 300, "Baseline and MAD track the noise");
+
+    /* Spikes shorter than the persistence barely move the baseline */
+    double before = status[ANOMALY_PPS].baseline;
+    TEST_ASSERT(observe(1000.0, 0, 200000) == 0 && observe(1000.0, 0, 200000) == 0, "Two-interval dip not alerted");
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].streak == 2 && status[ANOMALY_PPS].baseline > before - 100,
+                "Outliers clamped before updating the baseline");
+    TEST_ASSERT(observe_normal(1) == 0, "Streak broken by a normal interval");
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].streak == 0, "Streak reset");
+
+    /* Higher throughput is not an anomaly */
+    int raised = 0;
+    for (int i = 0; i < 5; i++) raised += observe(20000.0, 0, 200000);
+    TEST_ASSERT(raised == 0, "Throughput rise not alerted");
+    observe_normal(60);
+}
+
+/**
+ * @brief Test: Persistent deviations raise one alert each and clear on recovery
+ */
+void test_alerts(void) {
+    printf("\n=== Test: Persistent deviations ===\n");
+
+    metrics_init();
+    anomaly_configure(NULL);
+    observe_normal(60);
+
+    /* Throughput halves */
+    int first = observe(5000.0, 0, 200000);
+    int second = observe(5000.0, 0, 200000);
+    int third = observe(5000.0, 0, 200000);
+    TEST_ASSERT(first == 0 && second == 0 && third == 1, "Alert on the third deviating interval");
+    TEST_ASSERT(observe(5000.0, 0, 200000) == 0, "Raised once while it lasts");
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].active && status[ANOMALY_PPS].alerts == 1 &&
+                !status[ANOMALY_P99].active, "Only pps is active");
+    TEST_ASSERT(registry_metric("anomaly_alerts", ANOMALY_PPS) == 1 &&
+                registry_metric("anomaly_active", ANOMALY_PPS) == 1, "Alert counted in the registry");
+
+    observe_normal(2);
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].active, "Still active after two normal intervals");
+    observe_normal(1);
+    anomaly_get_status(status);
+    TEST_ASSERT(!status[ANOMALY_PPS].active && registry_metric("anomaly_active", ANOMALY_PPS) == 0,
+                "Cleared after three normal intervals");
+
+    /* Drops appear: 5% of offered packets */
+    int raised = 0;
+    for (int i = 0; i < 3; i++) raised += observe(9500.0, 500, 200000);
+    anomaly_get_status(status);
+    TEST_ASSERT(raised == 1 && status[ANOMALY_DROP_RATE].active, "Drop rate alert");
+
+    /* Tail latency triples while the median holds */
+    observe_normal(10);
+    raised = 0;
+    for (int i = 0; i < 3; i++) {
+        timeseries_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.interval_sec = 1.0;
+        sample.pps = 10000.0;
+        sample.pkts = 10000;
+        sample.latency_p50_ns = 50000;
+        sample.latency_p95_ns = 100000;
+        sample.latency_p99_ns = 600000;
+        raised += anomaly_observe(&sample);
+    }
+    anomaly_get_status(status);
+    TEST_ASSERT(raised == 1 && status[ANOMALY_P99].active && !status[ANOMALY_P50].active, "p99 alert only");
+    TEST_ASSERT(registry_metric("anomaly_alerts", ANOMALY_PPS) == 1 &&
+                registry_metric("anomaly_alerts", ANOMALY_DROP_RATE) == 1 &&
+                registry_metric("anomaly_alerts", ANOMALY_P99) == 1, "Alerts counted per metric");
+}
+
+/**
+ * @brief Test: A lasting level shift becomes the new baseline; reset starts over
+ */
+void test_level_shift(void) {
+    printf("\n=== Test: Level shift ===\n");
+
+    metrics_init();
+    anomaly_configure(NULL);
+    observe_normal(60);
+    int raised = 0;
+    for (int i = 0; i < 300; i++) {
+        raised += observe(5000.0 * (1.0 + 0.02 * noise()), 0, 200000);
+    }
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    anomaly_get_status(status);
+    TEST_ASSERT(raised == 1 && !status[ANOMALY_PPS].active, "One alert, then absorbed");
+    TEST_ASSERT(status[ANOMALY_PPS].baseline > 4500 && status[ANOMALY_PPS].baseline < 5500,
+                "Baseline moved to the new level");
+
+    anomaly_reset();
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].observed == 0 && status[ANOMALY_PPS].alerts == 0, "Reset clears the state");
+    TEST_ASSERT(anomaly_enabled(), "Reset keeps detection on");
+}
+
+/**
+ * @brief Test: The time series sampler feeds the detector; state in the metrics JSON
+ */
+void test_integration(void) {
+    printf("\n=== Test: Time series and JSON ===\n");
+
+    metrics_init();
+    anomaly_configure(NULL);
+    metrics_start();
+    timeseries_config_t config = { .path = NULL, .interval_ms = 50 };
+    TEST_ASSERT(timeseries_start(&config) == 0, "Sampler started without an output file");
+    usleep(300000);
+    anomaly_status_t status[ANOMALY_METRIC_COUNT];
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].observed >= 3, "Intervals observed by the sampler");
+    TEST_ASSERT(status[ANOMALY_P99].observed == 0, "Latency skipped without packets");
+
+    /* The drain after capture ends is not compared against the baseline */
+    metrics_stop_capture();
+    usleep(100000);
+    anomaly_get_status(status);
+    uint64_t observed = status[ANOMALY_PPS].observed;
+    usleep(200000);
+    timeseries_stop();
+    anomaly_get_status(status);
+    TEST_ASSERT(status[ANOMALY_PPS].observed == observed, "Nothing observed after capture ends");
+
+    const char *path = "/tmp/test_anomaly_metrics.json";
+    metrics_snapshot_json(path);
+    FILE *fp = fopen(path, "r");
+    char *buf = (char *)calloc(1, 1 << 20);
+    size_t n = fp != NULL ? fread(buf, 1, (1 << 20) - 1, fp) : 0;
+    buf[n] = '\0';
+    if (fp != NULL) fclose(fp);
+    remove(path);
+    TEST_ASSERT(strstr(buf, "\"anomaly\": {\n    \"enabled\": true,\n    \"window\": 60,") != NULL &&
+                strstr(buf, "\"pps\": {\"observed\": ") != NULL, "Detector state in JSON");
+    TEST_ASSERT(strstr(buf, "\"anomaly_alerts\": {\"pps\": 0, ") != NULL, "Alert counters in JSON");
+    free(buf);
+
+    anomaly_disable();
+    fp = open_memstream(&buf, &n);
+    anomaly_write_json(fp);
+    fclose(fp);
+    TEST_ASSERT(strstr(buf, "\"enabled\": false") != NULL, "JSON reports detection as off");
+    free(buf);
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      ANOMALY DETECTION UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_disabled();
+    test_steady();
+    test_alerts();
+    test_level_shift();
+    test_integration();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
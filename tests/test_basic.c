@@ -1,9 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 #include "packet.h"
 #include "buffer.h"
 #include "logger.h"
+#include "logger_bin.h"
+
+static int failures = 0;
 
 void test_logger() {
     printf("\n=== Testing Logger ===\n");
@@ -21,6 +27,354 @@ void test_logger() {
     logger_cleanup();
 }
 
+#define ASYNC_PRODUCERS 4
+#define ASYNC_LINES 200
+
+static void* async_log_producer(void *arg) {
+    int id = *(int *)arg;
+    for (int i = 0; i < ASYNC_LINES; i++) {
+        logger_info("Async producer %d line %d", id, i);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check "Async producer <id> line <n>" lines in a log file
+ *
+ * Every producer's lines must appear once each, in order, starting at 0.
+ *
+ * @return false on a gap, duplicate or reordering; per-producer counts in seen
+ */
+static int async_lines_in_order(const char *path, int *seen, int producers) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return 0;
+
+    char line[LOGGER_LINE_MAX];
+    int ok = 1;
+    for (int p = 0; p < producers; p++) seen[p] = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        const char *msg = strstr(line, "Async producer ");
+        int id, n;
+        if (msg == NULL || sscanf(msg, "Async producer %d line %d", &id, &n) != 2) continue;
+        if (id < 0 || id >= producers || n != seen[id]) {
+            ok = 0;
+            continue;
+        }
+        seen[id]++;
+    }
+    fclose(fp);
+    return ok;
+}
+
+static _Atomic int g_writer_gate;
+
+/* Writer start hook: hold the writer back until the test opens the gate */
+static void wait_writer_gate(void) {
+    while (!atomic_load(&g_writer_gate)) {
+        usleep(1000);
+    }
+}
+
+void test_async_logger() {
+    printf("\n=== Testing Async Logger ===\n");
+
+    char path[] = "/tmp/test_async_log_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        failures++;
+        return;
+    }
+    close(fd);
+    logger_init(path, LOG_DEBUG);
+
+    if (logger_start_async(0, LOG_OVERFLOW_BLOCK) != 0) {
+        printf("Failed to start async logger\n");
+        failures++;
+        logger_cleanup();
+        unlink(path);
+        return;
+    }
+
+    pthread_t threads[ASYNC_PRODUCERS];
+    int ids[ASYNC_PRODUCERS];
+    for (int i = 0; i < ASYNC_PRODUCERS; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, async_log_producer, &ids[i]);
+    }
+    for (int i = 0; i < ASYNC_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    uint8_t test_data[] = {0xde, 0xad, 0xbe, 0xef};
+    logger_hexdump("Async hexdump", test_data, sizeof(test_data));
+
+    logger_flush();
+    uint64_t dropped = logger_dropped_count();
+    logger_cleanup();
+
+    int seen[ASYNC_PRODUCERS];
+    int ok = async_lines_in_order(path, seen, ASYNC_PRODUCERS);
+    for (int i = 0; i < ASYNC_PRODUCERS; i++) {
+        if (seen[i] != ASYNC_LINES) ok = 0;
+    }
+    printf("Blocking rings: %d producers x %d lines, %llu dropped\n",
+           ASYNC_PRODUCERS, ASYNC_LINES, (unsigned long long)dropped);
+    if (!ok || dropped != 0) {
+        printf("Async logger lost, duplicated or reordered lines FAILED\n");
+        failures++;
+    }
+    unlink(path);
+
+    /* Smallest rings, writer held back: the overflow is dropped and counted */
+    strcpy(path, "/tmp/test_async_log_XXXXXX");
+    fd = mkstemp(path);
+    if (fd < 0) {
+        failures++;
+        return;
+    }
+    close(fd);
+    logger_init(path, LOG_DEBUG);
+    if (logger_start_async(LOGGER_ASYNC_MIN_BUDGET - 1, LOG_OVERFLOW_DROP) == 0) {
+        printf("Async budget below the minimum accepted FAILED\n");
+        failures++;
+    }
+    atomic_store(&g_writer_gate, 0);
+    logger_set_writer_hooks(wait_writer_gate, NULL);
+    if (logger_start_async(LOGGER_ASYNC_MIN_BUDGET, LOG_OVERFLOW_DROP) != 0) {
+        printf("Failed to start async logger\n");
+        failures++;
+        logger_set_writer_hooks(NULL, NULL);
+        logger_cleanup();
+        unlink(path);
+        return;
+    }
+
+    int producer = 0;
+    async_log_producer(&producer);
+    dropped = logger_dropped_count();
+    atomic_store(&g_writer_gate, 1);
+    logger_flush();
+    logger_cleanup();
+    logger_set_writer_hooks(NULL, NULL);
+
+    ok = async_lines_in_order(path, seen, 1);
+    printf("Dropping ring: %d written, %llu dropped\n", seen[0], (unsigned long long)dropped);
+    if (!ok || dropped == 0 || seen[0] == 0 || (uint64_t)seen[0] + dropped != ASYNC_LINES) {
+        printf("Async logger drop accounting FAILED\n");
+        failures++;
+    }
+    unlink(path);
+
+    /* A hexdump larger than the smallest ring arrives whole, in ring-sized chunks */
+    strcpy(path, "/tmp/test_async_log_XXXXXX");
+    fd = mkstemp(path);
+    if (fd < 0) {
+        failures++;
+        return;
+    }
+    close(fd);
+    logger_init(path, LOG_DEBUG);
+    logger_start_async(LOGGER_ASYNC_MIN_BUDGET, LOG_OVERFLOW_BLOCK);
+    uint8_t block[1024];
+    memset(block, 0x5a, sizeof(block));
+    logger_hexdump("Large hexdump", block, sizeof(block));
+    logger_flush();
+    dropped = logger_dropped_count();
+    logger_cleanup();
+
+    int rows = 0;
+    char row[256];
+    FILE *fp = fopen(path, "r");
+    while (fp != NULL && fgets(row, sizeof(row), fp) != NULL) {
+        rows += strstr(row, "5a  | ZZZZZZZZZZZZZZZZ\n") != NULL;
+    }
+    if (fp != NULL) fclose(fp);
+    printf("Large hexdump: %d of %zu rows, %llu dropped\n", rows, sizeof(block) / 16,
+           (unsigned long long)dropped);
+    if (rows != (int)(sizeof(block) / 16) || dropped != 0) {
+        printf("Hexdump cut by a small ring FAILED\n");
+        failures++;
+    }
+    unlink(path);
+}
+
+void test_binary_log() {
+    printf("\n=== Testing Binary Log ===\n");
+    logger_init(NULL, LOG_INFO);
+
+    char path[] = "/tmp/test_binlog_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || logger_bin_open(path, LOG_DEBUG) != 0) {
+        printf("Failed to open binary log\n");
+        failures++;
+        logger_cleanup();
+        return;
+    }
+    close(fd);
+
+    for (int i = 0; i < 3; i++) {
+        LOGGER_BIN(LOG_INFO, "event %d of %zu: %s %.2f%% [%*d] %llx", i, (size_t)3, "flow",
+                   12.5, 4, i, 0xabcULL);
+    }
+    LOGGER_TRACE("trace %u", 7u);
+    LOGGER_BIN(LOG_DEBUG, "no arguments");
+    logger_bin_close();
+
+    FILE *in = fopen(path, "rb");
+    FILE *out = tmpfile();
+    long events = (in && out) ? logger_bin_decode(in, out) : -1;
+    char text[1024] = {0};
+    if (out != NULL) {
+        rewind(out);
+        size_t n = fread(text, 1, sizeof(text) - 1, out);
+        text[n] = '\0';
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+    unlink(path);
+
+    printf("%s", text);
+    if (events != 5 ||
+        strstr(text, "[INFO] [t0] event 2 of 3: flow 12.50% [   2] abc") == NULL ||
+        strstr(text, "[DEBUG] [t0] trace 7") == NULL ||
+        strstr(text, "no arguments") == NULL) {
+        printf("Binary log round trip FAILED (%ld events)\n", events);
+        failures++;
+    } else {
+        printf("Binary log round trip OK (%ld events)\n", events);
+    }
+
+    logger_cleanup();
+}
+
+/* Append one site record with a hand-written format to a binary log */
+static void write_bin_site(FILE *fp, uint32_t id, const uint8_t *types, uint8_t nargs, const char *format) {
+    uint8_t level = LOG_INFO;
+    uint32_t line = 1;
+    uint16_t file_len = 1, format_len = (uint16_t)strlen(format);
+    fputc(LOGGER_BIN_REC_SITE, fp);
+    fwrite(&id, sizeof(id), 1, fp);
+    fwrite(&level, 1, 1, fp);
+    fwrite(&nargs, 1, 1, fp);
+    fwrite(types, 1, nargs, fp);
+    fwrite(&line, sizeof(line), 1, fp);
+    fwrite(&file_len, sizeof(file_len), 1, fp);
+    fwrite("x", 1, 1, fp);
+    fwrite(&format_len, sizeof(format_len), 1, fp);
+    fwrite(format, 1, format_len, fp);
+}
+
+void test_binary_log_untrusted_format() {
+    printf("\n=== Testing Binary Log Format Checks ===\n");
+    logger_init(NULL, LOG_INFO);
+
+    FILE *fp = tmpfile();
+    if (fp == NULL) {
+        failures++;
+        logger_cleanup();
+        return;
+    }
+    uint32_t version = LOGGER_BIN_VERSION, bom = 0x01020304u;
+    uint64_t zero = 0;
+    fwrite(LOGGER_BIN_MAGIC, 8, 1, fp);
+    fwrite(&version, sizeof(version), 1, fp);
+    fwrite(&bom, sizeof(bom), 1, fp);
+    fwrite(&zero, sizeof(zero), 1, fp);
+    fwrite(&zero, sizeof(zero), 1, fp);
+
+    /* Conversions that do not match the recorded int and string are not formatted */
+    const uint8_t types[] = { BIN_ARG_INT, BIN_ARG_STRING };
+    write_bin_site(fp, 1, types, 2, "n=%n s=%s w=%*d i=%d %5.1f%% %s%p");
+
+    uint32_t id = 1, value = 42;
+    uint16_t thread = 0;
+    uint8_t str_len = 2;
+    fputc(LOGGER_BIN_REC_EVENT, fp);
+    fwrite(&id, sizeof(id), 1, fp);
+    fwrite(&thread, sizeof(thread), 1, fp);
+    fwrite(&zero, sizeof(zero), 1, fp);
+    fwrite(&value, sizeof(value), 1, fp);
+    fwrite(&str_len, 1, 1, fp);
+    fwrite("ok", 1, 2, fp);
+
+    rewind(fp);
+    FILE *out = tmpfile();
+    long events = out != NULL ? logger_bin_decode(fp, out) : -1;
+    char text[512] = {0};
+    if (out != NULL) {
+        rewind(out);
+        size_t n = fread(text, 1, sizeof(text) - 1, out);
+        text[n] = '\0';
+        fclose(out);
+    }
+    fclose(fp);
+
+    printf("%s", text);
+    if (events != 1 || strstr(text, "n=%n s=%s w=%*d i=42 %5.1f% ok%p") == NULL) {
+        printf("Untrusted format pieces FAILED (%ld events)\n", events);
+        failures++;
+    }
+
+    logger_cleanup();
+}
+
+static void log_queue_full(int drop) {
+    LOGGER_WARN_RATELIMITED("Queue full (drop %d)", drop);
+}
+
+void test_rate_limited_logging() {
+    printf("\n=== Testing Rate-Limited Logging ===\n");
+
+    logger_ratelimit_t rl = {0};
+    uint64_t suppressed = 0;
+    int allowed = 0;
+    for (int i = 0; i < 100; i++) {
+        allowed += logger_ratelimit_allow(&rl, 1, 5, &suppressed);
+    }
+    usleep(1100 * 1000);
+    int after_refill = logger_ratelimit_allow(&rl, 1, 5, &suppressed);
+    printf("Allowed %d of 100 in a burst, refill allowed=%d, suppressed=%llu\n",
+           allowed, after_refill, (unsigned long long)suppressed);
+    if (allowed != 5 || !after_refill || suppressed != 95) {
+        printf("Token bucket FAILED\n");
+        failures++;
+    }
+
+    char path[] = "/tmp/test_ratelimit_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        failures++;
+        return;
+    }
+    close(fd);
+
+    logger_init(path, LOG_INFO);
+    for (int i = 0; i < 1000; i++) {
+        log_queue_full(i);
+    }
+    usleep(1100 * 1000);
+    log_queue_full(1000);
+    logger_cleanup();
+
+    FILE *fp = fopen(path, "r");
+    int lines = 0;
+    int summarized = 0;
+    char line[LOGGER_LINE_MAX];
+    while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+        if (strstr(line, "Queue full") != NULL) lines++;
+        if (strstr(line, "(drop 1000) (suppressed 995 similar messages)") != NULL) summarized = 1;
+    }
+    if (fp) fclose(fp);
+    unlink(path);
+
+    printf("Logged %d of 1001 warnings, suppression summary %s\n", lines,
+           summarized ? "present" : "missing");
+    if (lines != LOGGER_RATELIMIT_BURST + 1 || !summarized) {
+        printf("Rate-limited logging FAILED\n");
+        failures++;
+    }
+}
+
 void test_buffer() {
     printf("\n=== Testing Circular Buffer ===\n");
     logger_init(NULL, LOG_INFO);
@@ -85,9 +439,13 @@ int main() {
     printf("=== Network Packet Analyzer - Unit Tests ===\n");
     
     test_logger();
+    test_async_logger();
+    test_binary_log();
+    test_binary_log_untrusted_format();
+    test_rate_limited_logging();
     test_buffer();
     test_packet();
     
     printf("\n=== All Tests Completed ===\n");
-    return 0;
+    return failures > 0 ? 1 : 0;
 }
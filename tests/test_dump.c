@@ -0,0 +1,156 @@
+/**
+ * @file test_dump.c
+ * @brief Unit tests for the sampled packet dump subsystem
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <arpa/inet.h>
+#include "dump.h"
+#include "packet.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/* Ethernet + IPv4 + TCP, 172.16.10.99:80 -> 172.16.10.1:4660 */
+static uint8_t tcp_frame[60] = {
+    0x00, 0x1a, 0x2b, 0x3c, 0x4d, 0x5e, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x08, 0x00,
+    0x45, 0x00, 0x00, 0x3c, 0x1c, 0x46, 0x40, 0x00, 0x40, 0x06, 0x4c, 0xe7,
+    0xac, 0x10, 0x0a, 0x63, 0xac, 0x10, 0x0a, 0x01,
+    0x00, 0x50, 0x12, 0x34, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x50, 0x12, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/**
+ * @brief Offer the test frame to the dump count times
+ */
+static void offer_packets(int count) {
+    for (int i = 0; i < count; i++) {
+        packet_t *packet = packet_create(tcp_frame, sizeof(tcp_frame));
+        packet_parse(packet);
+        dump_packet(packet);
+        packet_free(packet);
+    }
+}
+
+/**
+ * @brief Test: Mode names and filter expressions parse
+ */
+void test_parsing(void) {
+    printf("\n=== Test: Mode and filter parsing ===\n");
+
+    dump_mode_t mode = DUMP_OFF;
+    TEST_ASSERT(dump_parse_mode("hexdump", &mode) == 0 && mode == DUMP_HEXDUMP, "hexdump mode parsed");
+    TEST_ASSERT(dump_parse_mode("verbose", &mode) != 0, "Unknown mode rejected");
+
+    dump_filter_t filter;
+    TEST_ASSERT(dump_parse_filter("tcp port 80,host 172.16.10.1", &filter) == 0, "Filter parsed");
+    TEST_ASSERT(filter.ip_proto == 6 && filter.port == 80 &&
+                filter.host == inet_addr("172.16.10.1"), "Filter fields set");
+    TEST_ASSERT(dump_parse_filter("port 70000", &filter) != 0, "Out-of-range port rejected");
+    TEST_ASSERT(dump_parse_filter("host", &filter) != 0, "Missing host rejected");
+}
+
+/**
+ * @brief Test: 1-in-N sampling
+ */
+void test_sampling(void) {
+    printf("\n=== Test: 1-in-N sampling ===\n");
+
+    dump_config_t config = { .mode = DUMP_SUMMARY, .sample_n = 4 };
+    TEST_ASSERT(dump_init(&config) == 0, "Dump started");
+    offer_packets(40);
+    dump_shutdown();
+
+    dump_stats_t stats;
+    dump_get_stats(&stats);
+    TEST_ASSERT(stats.seen == 40 && stats.selected == 40, "All packets selected before sampling");
+    TEST_ASSERT(stats.written == 10, "One in four written");
+    TEST_ASSERT(stats.dropped == 0, "No queue drops");
+}
+
+/**
+ * @brief Test: Filter match and first-N-per-flow selection
+ */
+void test_filter_and_first_n(void) {
+    printf("\n=== Test: Filter and first-N selection ===\n");
+
+    dump_config_t config = { .mode = DUMP_FULL };
+    dump_parse_filter("udp", &config.filter);
+    dump_init(&config);
+    offer_packets(5);
+    dump_shutdown();
+
+    dump_stats_t stats;
+    dump_get_stats(&stats);
+    TEST_ASSERT(stats.selected == 0 && stats.written == 0, "UDP filter skips TCP packets");
+
+    memset(&config, 0, sizeof(config));
+    config.mode = DUMP_HEXDUMP;
+    config.first_n = 3;
+    dump_parse_filter("tcp port 4660", &config.filter);
+    dump_init(&config);
+    offer_packets(10);
+    dump_shutdown();
+
+    dump_get_stats(&stats);
+    TEST_ASSERT(stats.selected == 3 && stats.written == 3, "Only first 3 packets of the flow written");
+}
+
+/**
+ * @brief Test: Mode off records nothing
+ */
+void test_off(void) {
+    printf("\n=== Test: Mode off ===\n");
+
+    dump_config_t config = { .mode = DUMP_OFF };
+    TEST_ASSERT(dump_init(&config) == 0, "Off mode initializes");
+    offer_packets(3);
+    dump_shutdown();
+
+    dump_stats_t stats;
+    dump_get_stats(&stats);
+    TEST_ASSERT(stats.seen == 0, "No packets offered while off");
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      PACKET DUMP UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_parsing();
+    test_sampling();
+    test_filter_and_first_n();
+    test_off();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_exporter.c
+ * @brief Unit tests for the OpenMetrics exporter
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "exporter.h"
+#include "metrics.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/**
+ * @brief Send one request to the exporter and return the whole response
+ */
+static char* http_get(uint16_t port, const char *path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    char request[128];
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+    if (send(fd, request, (size_t)len, 0) != len) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t capacity = 65536, used = 0;
+    char *response = calloc(1, capacity);
+    ssize_t n;
+    while ((n = recv(fd, response + used, capacity - 1 - used, 0)) > 0) {
+        used += (size_t)n;
+        if (used == capacity - 1) {
+            capacity *= 2;
+            response = realloc(response, capacity);
+        }
+    }
+    response[used] = '\0';
+    close(fd);
+    return response;
+}
+
+/**
+ * @brief Test: Rendered families and histogram buckets
+ */
+void test_render(void) {
+    printf("\n=== Test: OpenMetrics rendering ===\n");
+
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+    for (int i = 0; i < 10; i++) {
+        metrics_inc_processed(100);
+        metrics_record_protocol(PROTO_TCP);
+        metrics_observe_latency(1500);       /* Below the 2^11 ns bound */
+    }
+    metrics_observe_latency(5000000);        /* 5 ms */
+    metrics_set_queue_depth(7);
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    exporter_write_openmetrics(fp);
+    fclose(fp);
+
+    TEST_ASSERT(strstr(text, "packet_analyzer_processed_packets_total 10\n") != NULL,
+                "Counter with _total suffix");
+    TEST_ASSERT(strstr(text, "packet_analyzer_protocol_packets_total{protocol=\"tcp\"} 10\n") != NULL,
+                "Protocol breakdown as labels");
+    TEST_ASSERT(strstr(text, "packet_analyzer_queue_depth 7\n") != NULL, "Queue depth gauge");
+    TEST_ASSERT(strstr(text, "packet_analyzer_latency_seconds_bucket{le=\"1.024e-06\"} 0\n") != NULL &&
+                strstr(text, "packet_analyzer_latency_seconds_bucket{le=\"2.048e-06\"} 10\n") != NULL &&
+                strstr(text, "packet_analyzer_latency_seconds_bucket{le=\"+Inf\"} 11\n") != NULL,
+                "Cumulative latency buckets from the HDR histogram");
+    TEST_ASSERT(strstr(text, "packet_analyzer_stage_latency_seconds_count{stage=\"queue\"} 0\n") != NULL,
+                "Stage histograms labelled by stage");
+    TEST_ASSERT(len > 6 && strcmp(text + len - 6, "# EOF\n") == 0, "Ends with # EOF");
+
+    free(text);
+    metrics_unregister_thread();
+}
+
+/**
+ * @brief Test: HTTP endpoint
+ */
+void test_http(void) {
+    printf("\n=== Test: HTTP endpoint ===\n");
+
+    exporter_config_t config = { .port = (uint16_t)(20000 + getpid() % 20000), .bind_addr = NULL };
+    TEST_ASSERT(exporter_start(&config) == 0, "Exporter listening");
+
+    char *response = http_get(config.port, "/metrics");
+    TEST_ASSERT(response != NULL && strncmp(response, "HTTP/1.1 200 OK", 15) == 0 &&
+                strstr(response, "application/openmetrics-text") != NULL &&
+                strstr(response, "# EOF\n") != NULL,
+                "GET /metrics returns OpenMetrics");
+    free(response);
+
+    response = http_get(config.port, "/");
+    TEST_ASSERT(response != NULL && strncmp(response, "HTTP/1.1 404", 12) == 0, "Other paths are 404");
+    free(response);
+
+    exporter_stop();
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      METRICS EXPORTER UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_render();
+    test_http();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
@@ -0,0 +1,553 @@
+/**
+ * @file test_hdr.c
+ * @brief Unit tests for the HDR latency histogram, per-stage latency and the tick clock
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "hdr_histogram.h"
+#include "metrics.h"
+#include "regression.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/**
+ * @brief Test: Precision bounds for small and large values
+ */
+void test_precision(void) {
+    printf("\n=== Test: Precision ===\n");
+
+    TEST_ASSERT(hdr_create(1000, 0) == NULL && hdr_create(1000, 6) == NULL,
+                "Out-of-range digits rejected");
+
+    hdr_histogram_t *h = hdr_create(METRICS_LATENCY_MAX_NS, 3);
+    TEST_ASSERT(h != NULL, "Histogram created");
+
+    hdr_record(h, 1234);
+    TEST_ASSERT(hdr_value_at_quantile(h, 1.0) == 1234, "Values below 2000 are exact");
+
+    bool within = true;
+    for (uint64_t v = 2000; v < 50000000000ULL; v = v * 3 + 7) {
+        hdr_reset(h);
+        hdr_record(h, v);
+        uint64_t got = hdr_value_at_quantile(h, 0.5);
+        if (got < v || (double)(got - v) > (double)v / 1000.0) {
+            within = false;
+        }
+    }
+    TEST_ASSERT(within, "Large values within 0.1% (3 digits)");
+
+    hdr_reset(h);
+    hdr_record(h, METRICS_LATENCY_MAX_NS * 10);
+    TEST_ASSERT(hdr_total_count(h) == 1, "Out-of-range value clamped, not lost");
+    hdr_destroy(h);
+}
+
+/**
+ * @brief Test: Quantiles of a uniform distribution
+ */
+void test_quantiles(void) {
+    printf("\n=== Test: Quantiles ===\n");
+
+    hdr_histogram_t *h = hdr_create(METRICS_LATENCY_MAX_NS, 3);
+    for (uint64_t v = 1; v <= 100000; v++) {
+        hdr_record_local(h, v * 1000);
+    }
+
+    uint64_t p50 = hdr_value_at_quantile(h, 0.50);
+    uint64_t p99 = hdr_value_at_quantile(h, 0.99);
+    TEST_ASSERT(p50 >= 50000000 && p50 <= 50050000, "p50 of 1..100000 us within 0.1%");
+    TEST_ASSERT(p99 >= 99000000 && p99 <= 99100000, "p99 of 1..100000 us within 0.1%");
+    TEST_ASSERT(hdr_total_count(h) == 100000, "Total count");
+    hdr_destroy(h);
+}
+
+/**
+ * @brief Test: Merging is exact and JSON round-trips
+ */
+void test_merge_and_json(void) {
+    printf("\n=== Test: Merge and JSON ===\n");
+
+    hdr_histogram_t *all = hdr_create(METRICS_LATENCY_MAX_NS, 2);
+    hdr_histogram_t *run1 = hdr_create(METRICS_LATENCY_MAX_NS, 2);
+    hdr_histogram_t *run2 = hdr_create(METRICS_LATENCY_MAX_NS, 2);
+    for (uint64_t v = 0; v < 20000; v++) {
+        uint64_t value = v * v * 37;
+        hdr_record(all, value);
+        hdr_record((v & 1) ? run1 : run2, value);
+    }
+
+    hdr_histogram_t *merged = hdr_create(METRICS_LATENCY_MAX_NS, 2);
+    hdr_add(merged, run1);
+    hdr_add(merged, run2);
+    bool equal = true;
+    for (int i = 0; i < hdr_counts_len(all); i++) {
+        if (atomic_load(&merged->counts[i]) != atomic_load(&all->counts[i])) equal = false;
+    }
+    TEST_ASSERT(equal, "Merged runs equal a single histogram of all values");
+
+    const hdr_histogram_t *runs[3] = { run1, NULL, run2 };
+    const double quantiles[4] = { 0.0, 0.5, 0.99, 1.0 };
+    uint64_t summed[4];
+    hdr_sum_quantiles(runs, 3, quantiles, summed, 4);
+    equal = true;
+    for (int q = 0; q < 4; q++) {
+        if (summed[q] != hdr_value_at_quantile(merged, quantiles[q])) equal = false;
+    }
+    TEST_ASSERT(equal, "Quantiles of the sum equal those of the merged histogram");
+
+    hdr_histogram_t *other = hdr_create(METRICS_LATENCY_MAX_NS, 3);
+    TEST_ASSERT(hdr_add(other, run1) != 0, "Merge across precisions rejected");
+    hdr_destroy(other);
+
+    FILE *fp = tmpfile();
+    fprintf(fp, "{\"latency_hdr\": ");
+    hdr_write_json(merged, fp);
+    fprintf(fp, "}\n");
+    long size = ftell(fp);
+    rewind(fp);
+    char *text = calloc(1, (size_t)size + 1);
+    size_t read_bytes = fread(text, 1, (size_t)size, fp);
+    fclose(fp);
+
+    hdr_histogram_t *parsed = hdr_parse_json(text);
+    TEST_ASSERT(read_bytes == (size_t)size && parsed != NULL, "JSON parsed");
+    equal = parsed != NULL && parsed->counts_len == merged->counts_len;
+    for (int i = 0; equal && i < hdr_counts_len(merged); i++) {
+        if (atomic_load(&parsed->counts[i]) != atomic_load(&merged->counts[i])) equal = false;
+    }
+    TEST_ASSERT(equal, "JSON round trip is exact");
+
+    /* 1000 values within 10% of each other: 125 non-zero entries of 27648 */
+    hdr_histogram_t *narrow = hdr_create(METRICS_LATENCY_MAX_NS, 3);
+    for (uint64_t v = 10001; v <= 11000; v++) {
+        hdr_record(narrow, v);
+    }
+    fp = tmpfile();
+    hdr_write_json(narrow, fp);
+    TEST_ASSERT(ftell(fp) < 512, "Sparse encoding stays compact");
+    fclose(fp);
+    hdr_destroy(narrow);
+
+    TEST_ASSERT(hdr_parse_json("{\"digits\": 2, \"highest\": 1000, \"counts\": [1,-99999]}") == NULL,
+                "Zero run past the end rejected");
+
+    free(text);
+    hdr_destroy(parsed);
+    hdr_destroy(merged);
+    hdr_destroy(run1);
+    hdr_destroy(run2);
+    hdr_destroy(all);
+}
+
+/**
+ * @brief Test: Metrics percentiles and regression use the HDR histogram
+ */
+void test_metrics_integration(void) {
+    printf("\n=== Test: Metrics and regression ===\n");
+
+    metrics_init();
+    metrics_register_thread();
+    for (uint64_t v = 1; v <= 1000; v++) {
+        metrics_observe_latency(10000 + v);
+    }
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    uint64_t p95 = metrics_percentile_ns(&snap, 0.95);
+    TEST_ASSERT(snap.latency_hdr != NULL && p95 >= 10950 && p95 <= 10961,
+                "p95 from HDR, not a log2 bucket midpoint");
+    TEST_ASSERT(snap.latency_histogram[3] == 1000, "log2 buckets derived from HDR");
+
+    regression_baseline_t baseline;
+    memset(&baseline, 0, sizeof(baseline));
+    baseline.valid = true;
+    baseline.latency_p95_ns = 10955;
+    baseline.latency_hdr_valid = true;
+
+    regression_result_t result;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(result.current_p95_ns == p95 && !result.latency_regression,
+                "HDR baseline compared against HDR p95");
+
+    baseline.latency_hdr_valid = false;
+    baseline.latency_p95_ns = 6000;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(result.current_p95_ns == 6000, "Older baseline compared against bucket midpoint");
+
+    metrics_snapshot_t light;
+    metrics_snapshot_select(&light, METRICS_SNAP_LATENCY);
+    TEST_ASSERT(light.latency_hdr != NULL && metrics_percentile_ns(&light, 0.95) == p95 &&
+                light.stage_hdr[METRICS_STAGE_PARSE] == NULL &&
+                light.classes[METRICS_L4_OTHER][0].latency_hdr == NULL,
+                "Selected snapshot copies only the latency histogram");
+    metrics_snapshot_free(&light);
+
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+}
+
+static atomic_bool g_writers_running;
+
+static void* reset_writer(void *arg) {
+    bool sharded = *(bool *)arg;
+    if (sharded) {
+        metrics_register_thread();
+    }
+    while (atomic_load(&g_writers_running)) {
+        metrics_inc_processed(100);
+        metrics_observe_latency(5000);
+    }
+    if (sharded) {
+        metrics_unregister_thread();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Test: metrics_init() while threads record keeps every update whole
+ */
+void test_reset_under_load(void) {
+    printf("\n=== Test: Reset under load ===\n");
+
+    metrics_init();
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    uint64_t first_epoch = snap.epoch;
+    metrics_snapshot_free(&snap);
+
+    bool sharded[4] = { false, false, true, true };
+    pthread_t threads[4];
+    atomic_store(&g_writers_running, true);
+    for (int t = 0; t < 4; t++) {
+        pthread_create(&threads[t], NULL, reset_writer, &sharded[t]);
+    }
+    for (int i = 0; i < 200; i++) {
+        metrics_init();
+        metrics_start();
+        usleep(200);
+    }
+    atomic_store(&g_writers_running, false);
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.epoch == first_epoch + 200, "Every reset advances the epoch");
+    TEST_ASSERT(snap.pkts_processed > 0 && snap.bytes_processed == snap.pkts_processed * 100,
+                "Packets and bytes land in the same epoch");
+    TEST_ASSERT(snap.latency_count > 0 && snap.latency_sum_ns == snap.latency_count * 5000 &&
+                snap.latency_hdr != NULL && hdr_total_count(snap.latency_hdr) == snap.latency_count,
+                "Latency count, sum and histogram agree");
+    metrics_snapshot_free(&snap);
+}
+
+/**
+ * @brief Test: Per-stage histograms and tick conversion
+ */
+void test_stage_latency(void) {
+    printf("\n=== Test: Stage latency ===\n");
+
+    metrics_init();
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t start = fastclock_ticks();
+    usleep(20000);
+    uint64_t ticks_ns = fastclock_to_ns(fastclock_ticks() - start);
+    uint64_t clock_ns = metrics_now_ns() - start_ns;
+    TEST_ASSERT(ticks_ns > clock_ns * 9 / 10 && ticks_ns < clock_ns * 11 / 10,
+                "Calibrated ticks agree with CLOCK_MONOTONIC within 10%");
+
+    metrics_register_thread();
+    for (uint64_t v = 1; v <= 100; v++) {
+        metrics_observe_stage(METRICS_STAGE_QUEUE, v * 1000);
+        metrics_observe_stage(METRICS_STAGE_PARSE, 500);
+    }
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(hdr_total_count(snap.stage_hdr[METRICS_STAGE_QUEUE]) == 100 &&
+                hdr_total_count(snap.stage_hdr[METRICS_STAGE_CAPTURE]) == 0,
+                "Stages recorded separately");
+
+    regression_baseline_t baseline;
+    memset(&baseline, 0, sizeof(baseline));
+    baseline.valid = true;
+    baseline.stages_valid = true;
+    baseline.stage_p95_ns[METRICS_STAGE_QUEUE] = 50000;
+    baseline.stage_p95_ns[METRICS_STAGE_PARSE] = 500;
+
+    regression_result_t result;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(result.current_stage_p95_ns[METRICS_STAGE_QUEUE] >= 95000 &&
+                result.current_stage_p95_ns[METRICS_STAGE_QUEUE] <= 95100 &&
+                result.stage_delta_pct[METRICS_STAGE_QUEUE] > 0.8,
+                "Queue stage growth visible in regression result");
+    TEST_ASSERT(result.current_stage_p95_ns[METRICS_STAGE_PARSE] == 500 &&
+                !result.any_regression, "Stage deltas do not gate");
+
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+}
+
+/**
+ * @brief Record latency for a batch of packets of one protocol and size
+ */
+static void observe_class_batch(uint8_t protocol, uint32_t length, uint64_t latency_ns, int count) {
+    for (int i = 0; i < count; i++) {
+        metrics_inc_processed(length);
+        metrics_observe_latency(latency_ns);
+        metrics_observe_class(protocol, length, latency_ns);
+    }
+}
+
+/**
+ * @brief Test: Protocol x size class cells and their regression comparison
+ */
+void test_class_latency(void) {
+    printf("\n=== Test: Latency by protocol and size class ===\n");
+
+    TEST_ASSERT(metrics_size_class(64) == 0 && metrics_size_class(65) == 1 &&
+                metrics_size_class(1518) == 5 && metrics_size_class(9000) == 6,
+                "IMIX size class boundaries");
+    TEST_ASSERT(metrics_l4_class(6) == METRICS_L4_TCP && metrics_l4_class(58) == METRICS_L4_ICMP &&
+                metrics_l4_class(0) == METRICS_L4_OTHER, "Protocol rows");
+
+    /* Baseline: ICMP is a small share, so its latency hardly moves the global p95 */
+    const char *path = "/tmp/test_hdr_classes.json";
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+    observe_class_batch(6, 1500, 10000, 30000);
+    observe_class_batch(1, 64, 5000, 1000);
+    observe_class_batch(17, 64, 5000, 100);
+    TEST_ASSERT(metrics_snapshot_json(path) == 0, "Metrics JSON written");
+
+    regression_baseline_t baseline;
+    TEST_ASSERT(regression_load_baseline(path, &baseline) == 0 && baseline.classes_valid &&
+                baseline.class_packets[METRICS_L4_TCP][5] == 30000 &&
+                baseline.class_packets[METRICS_L4_ICMP][0] == 1000 &&
+                baseline.class_packets[METRICS_L4_UDP][0] == 100 &&
+                baseline.class_packets[METRICS_L4_UDP][1] == 0,
+                "Cells round-trip through the baseline JSON");
+    TEST_ASSERT(baseline.class_p95_ns[METRICS_L4_ICMP][0] >= 5000 &&
+                baseline.class_p95_ns[METRICS_L4_ICMP][0] < 5500, "Cell p95 within 1-digit precision");
+
+    /* Current: only small ICMP and the sparse UDP cell got slower */
+    metrics_init();
+    metrics_start();
+    observe_class_batch(6, 1500, 10000, 30000);
+    observe_class_batch(1, 64, 20000, 1000);
+    observe_class_batch(17, 64, 20000, 100);
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.classes[METRICS_L4_ICMP][0].packets == 1000 &&
+                snap.classes[METRICS_L4_ICMP][0].bytes == 64000, "Packets and bytes per cell");
+
+    regression_result_t result;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(!result.latency_regression && result.class_compared[METRICS_L4_TCP][5] &&
+                !result.class_regression[METRICS_L4_TCP][5], "Global and TCP p95 unchanged");
+    TEST_ASSERT(result.class_regression[METRICS_L4_ICMP][0] && result.any_class_regression,
+                "Regression in the small ICMP cell is flagged");
+    TEST_ASSERT(!result.class_compared[METRICS_L4_UDP][0], "Cell below the minimum sample count skipped");
+
+    /* Run-wide thresholds the timing of this test cannot trip; the cell keeps its own */
+    regression_compare(&baseline, &snap, 1.0, &result);
+    TEST_ASSERT(result.class_regression[METRICS_L4_ICMP][0] && !result.any_regression,
+                "Per-class cells do not gate the verdict");
+
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+    unlink(path);
+}
+
+/**
+ * @brief Offer one UDP exemplar from 10.0.0.1 with the given latency
+ */
+static void observe_exemplar(uint64_t latency_ns, int worker_id) {
+    metrics_observe_latency(latency_ns);
+    metrics_observe_class(PROTO_UDP, 60, latency_ns);
+    if (!metrics_exemplar_wanted(latency_ns)) return;
+    metrics_exemplar_t e;
+    memset(&e, 0, sizeof(e));
+    e.latency_ns = latency_ns;
+    for (int s = 0; s < METRICS_STAGE_COUNT; s++) {
+        e.stage_end_ns[s] = latency_ns / METRICS_STAGE_COUNT * (s + 1);
+    }
+    e.stage_end_ns[METRICS_STAGE_COUNT - 1] = latency_ns;
+    e.length = 60;
+    e.protocol = PROTO_UDP;
+    e.ip_version = 4;
+    memcpy(e.src_addr, (const uint8_t[]){ 10, 0, 0, 1 }, 4);
+    memcpy(e.dst_addr, (const uint8_t[]){ 10, 0, 0, 2 }, 4);
+    e.src_port = 5353;
+    e.dst_port = 53;
+    e.worker_id = worker_id;
+    metrics_observe_exemplar(&e);
+}
+
+static void* exemplar_worker(void *arg) {
+    uint64_t base_ns = *(const uint64_t *)arg;
+    if (base_ns > 0) metrics_register_thread();
+    for (int i = 1; i <= 200; i++) {
+        observe_exemplar(base_ns + (uint64_t)i * 1000, base_ns > 0 ? 1 : -1);
+    }
+    if (base_ns > 0) metrics_unregister_thread();
+    return NULL;
+}
+
+/**
+ * @brief Test: Slowest packets kept per thread and merged at snapshot
+ */
+void test_exemplars(void) {
+    printf("\n=== Test: Tail-latency exemplars ===\n");
+
+    hdr_histogram_t *h = hdr_create(METRICS_LATENCY_MAX_NS, 3);
+    hdr_record(h, 1000);
+    hdr_record(h, 123456);
+    int index = hdr_index_of(h, 123456);
+    TEST_ASSERT(hdr_value_at_index(h, index) <= 123456 && hdr_highest_equivalent(h, 123456) >= 123456 &&
+                hdr_highest_equivalent(h, 123456) < 123456 * 1.001, "Bucket bounds bracket the value");
+    TEST_ASSERT(hdr_count_at_or_below(h, 999) == 0 && hdr_count_at_or_below(h, 1000) == 1 &&
+                hdr_count_at_or_below(h, 123456) == 2, "Count at or below a value");
+    hdr_destroy(h);
+
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+    for (int i = 1; i <= 1000; i++) {
+        observe_exemplar((uint64_t)i * 1000, 0);
+    }
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.exemplar_count == METRICS_EXEMPLARS, "Heap bounded");
+    TEST_ASSERT(snap.exemplars[0].latency_ns == 1000000 &&
+                snap.exemplars[METRICS_EXEMPLARS - 1].latency_ns == (1000 - METRICS_EXEMPLARS + 1) * 1000ULL,
+                "Slowest packets kept, slowest first");
+    metrics_snapshot_free(&snap);
+
+    /* A worker that exits and an unregistered thread both feed the merge */
+    uint64_t slow_base = 2000000, shared_base = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, exemplar_worker, &slow_base);
+    pthread_join(thread, NULL);
+    pthread_create(&thread, NULL, exemplar_worker, &shared_base);
+    pthread_join(thread, NULL);
+    metrics_snapshot(&snap);
+    bool sorted = true;
+    for (int i = 1; i < snap.exemplar_count; i++) {
+        sorted = sorted && snap.exemplars[i - 1].latency_ns >= snap.exemplars[i].latency_ns;
+    }
+    TEST_ASSERT(snap.exemplar_count == METRICS_EXEMPLARS && sorted &&
+                snap.exemplars[0].latency_ns == slow_base + 200000 && snap.exemplars[0].worker_id == 1,
+                "Exited worker's exemplars folded in and merged");
+    metrics_snapshot_free(&snap);
+
+    const char *path = "/tmp/test_hdr_exemplars.json";
+    TEST_ASSERT(metrics_snapshot_json(path) == 0, "Metrics JSON written");
+    FILE *fp = fopen(path, "r");
+    char *buf = (char *)calloc(1, 1 << 20);
+    size_t n = fp != NULL ? fread(buf, 1, (1 << 20) - 1, fp) : 0;
+    buf[n] = '\0';
+    if (fp != NULL) fclose(fp);
+    unlink(path);
+    TEST_ASSERT(strstr(buf, "\"exemplars\": [\n    {\"latency_ns\": 2200000, \"worker\": 1, \"protocol\": 17, "
+                            "\"class\": \"udp/0-64\", \"length\": 60, \"ip_version\": 4, \"src\": \"10.0.0.1\", "
+                            "\"src_port\": 5353, \"dst\": \"10.0.0.2\", \"dst_port\": 53") != NULL,
+                "Exemplar with class and flow tuple in JSON");
+    TEST_ASSERT(strstr(buf, "\"timestamps_ns\": {\"enqueued\": 550000, \"dequeued\": 1100000, "
+                            "\"parsed\": 1650000, \"analyzed\": 2200000}, \"stages_ns\": {\"capture\": 550000, ") != NULL,
+                "Stage timestamps and durations");
+    TEST_ASSERT(strstr(buf, "\"percentile\": 100.0000, \"class_bucket\": {\"low\": ") != NULL,
+                "Slowest exemplar linked to the top of its histograms");
+    free(buf);
+
+    metrics_init();
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.exemplar_count == 0, "Exemplars reset with the metrics");
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+}
+
+/**
+ * @brief Test: Tick clock calibration and derived timestamps
+ */
+void test_fastclock(void) {
+    printf("\n=== Test: Tick clock ===\n");
+
+    fastclock_init();
+    fastclock_info_t info;
+    fastclock_get_info(&info);
+    TEST_ASSERT((info.source == FASTCLOCK_TSC && info.fallback_reason == NULL &&
+                 info.ticks_per_ns > 0.1 && info.spread_ppm <= FASTCLOCK_MAX_SPREAD_PPM) ||
+                (info.source == FASTCLOCK_MONOTONIC && info.fallback_reason != NULL),
+                "Calibration reports a source and its quality");
+
+    uint64_t before_ns = metrics_now_ns();
+    uint64_t ticks = fastclock_ticks();
+    uint64_t after_ns = metrics_now_ns();
+    uint64_t mapped_ns = fastclock_ticks_to_monotonic_ns(ticks);
+    TEST_ASSERT(mapped_ns + 1000000 >= before_ns && mapped_ns <= after_ns + 1000000,
+                "Ticks map onto CLOCK_MONOTONIC within 1 ms");
+
+    time_t wall = time(NULL);
+    time_t derived = fastclock_ticks_to_wall_sec(fastclock_ticks());
+    TEST_ASSERT(derived >= wall - 1 && derived <= wall + 1, "Wall seconds derived from ticks");
+
+    metrics_set_metadata("lo", NULL, 1, 0, 1, 0, NULL, NULL, 0);
+    TEST_ASSERT(strcmp(metrics_get_metadata()->clock_source, fastclock_source_name(info.source)) == 0,
+                "Clock source recorded in metadata");
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      HDR HISTOGRAM UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_precision();
+    test_quantiles();
+    test_merge_and_json();
+    test_metrics_integration();
+    test_reset_under_load();
+    test_stage_latency();
+    test_class_latency();
+    test_exemplars();
+    test_fastclock();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
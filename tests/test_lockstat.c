@@ -0,0 +1,223 @@
+/**
+ * @file test_lockstat.c
+ * @brief Unit tests for the instrumented mutexes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "lockstat.h"
+#include "metrics.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define TEST_HOLD_US 20000
+#define TEST_THREADS 4
+#define TEST_LOCKS_PER_THREAD 20000
+
+static lockstat_mutex_t g_lock = LOCKSTAT_MUTEX_INITIALIZER(LOCKSTAT_QUEUE);
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static pthread_barrier_t g_barrier;
+static bool g_ready;
+static uint64_t g_counter;
+
+static void* hold_worker(void *arg) {
+    (void)arg;
+    lockstat_lock(&g_lock);
+    pthread_barrier_wait(&g_barrier);
+    usleep(TEST_HOLD_US);
+    lockstat_unlock(&g_lock);
+    return NULL;
+}
+
+static void* hammer_worker(void *arg) {
+    (void)arg;
+    metrics_register_thread();
+    for (int i = 0; i < TEST_LOCKS_PER_THREAD; i++) {
+        lockstat_lock(&g_lock);
+        g_counter++;
+        lockstat_unlock(&g_lock);
+    }
+    metrics_unregister_thread();
+    return NULL;
+}
+
+static void* signal_worker(void *arg) {
+    (void)arg;
+    usleep(10000);
+    lockstat_lock(&g_lock);
+    g_ready = true;
+    pthread_cond_signal(&g_cond);
+    lockstat_unlock(&g_lock);
+    return NULL;
+}
+
+static void summarize(lockstat_summary_t *summary) {
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    lockstat_summarize(&snap, LOCKSTAT_QUEUE, summary);
+}
+
+/**
+ * @brief Test: Uncontended acquisitions count hold time but no wait
+ */
+void test_uncontended(void) {
+    printf("\n=== Test: Uncontended lock ===\n");
+
+    metrics_init();
+    for (int i = 0; i < 1000; i++) {
+        lockstat_lock(&g_lock);
+        lockstat_unlock(&g_lock);
+    }
+    lockstat_summary_t summary;
+    summarize(&summary);
+    TEST_ASSERT(summary.acquisitions == 1000, "Every acquisition counted");
+    TEST_ASSERT(summary.contentions == 0 && summary.wait_ns == 0, "No contention recorded");
+    TEST_ASSERT(summary.hold_p99_ns < 1000000, "Hold time recorded and short");
+
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    int hold = registry_find("lock_hold_ns");
+    TEST_ASSERT(registry_value(&snap, hold, LOCKSTAT_QUEUE) == 1000, "One hold observation per acquisition");
+}
+
+/**
+ * @brief Test: A blocked acquisition records its wait
+ */
+void test_contended(void) {
+    printf("\n=== Test: Contended lock ===\n");
+
+    metrics_init();
+    pthread_barrier_init(&g_barrier, NULL, 2);
+    pthread_t thread;
+    pthread_create(&thread, NULL, hold_worker, NULL);
+    pthread_barrier_wait(&g_barrier);
+    lockstat_lock(&g_lock);
+    lockstat_unlock(&g_lock);
+    pthread_join(thread, NULL);
+    pthread_barrier_destroy(&g_barrier);
+
+    lockstat_summary_t summary;
+    summarize(&summary);
+    TEST_ASSERT(summary.acquisitions == 2 && summary.contentions == 1, "One of two acquisitions contended");
+    TEST_ASSERT(summary.wait_ns >= TEST_HOLD_US * 1000ULL / 2, "Wait covers the other thread's hold");
+    TEST_ASSERT(summary.wait_p99_ns >= summary.wait_ns, "Wait quantile is the bucket upper bound");
+    TEST_ASSERT(summary.hold_p99_ns >= TEST_HOLD_US * 1000ULL / 2, "Long hold lands in the hold histogram");
+
+    /* Many threads started against a held lock: counts stay exact, contention shows up */
+    metrics_init();
+    g_counter = 0;
+    pthread_t threads[TEST_THREADS];
+    lockstat_lock(&g_lock);
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_create(&threads[t], NULL, hammer_worker, NULL);
+    }
+    usleep(TEST_HOLD_US);
+    lockstat_unlock(&g_lock);
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    summarize(&summary);
+    TEST_ASSERT(g_counter == TEST_THREADS * TEST_LOCKS_PER_THREAD &&
+                summary.acquisitions == TEST_THREADS * TEST_LOCKS_PER_THREAD + 1,
+                "Acquisitions exact under load");
+    TEST_ASSERT(summary.contentions > 0, "Threads blocked on the held lock counted as contended");
+}
+
+/**
+ * @brief Test: Condition waits split the hold and count the wake-up
+ */
+void test_cond_wait(void) {
+    printf("\n=== Test: Condition wait ===\n");
+
+    metrics_init();
+    g_ready = false;
+    pthread_t thread;
+    pthread_create(&thread, NULL, signal_worker, NULL);
+    lockstat_lock(&g_lock);
+    while (!g_ready) {
+        lockstat_cond_wait(&g_cond, &g_lock);
+    }
+    lockstat_unlock(&g_lock);
+    pthread_join(thread, NULL);
+
+    lockstat_summary_t summary;
+    summarize(&summary);
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    int hold = registry_find("lock_hold_ns");
+    TEST_ASSERT(summary.acquisitions == registry_value(&snap, hold, LOCKSTAT_QUEUE),
+                "Every acquisition or wake-up has one hold");
+    TEST_ASSERT(summary.hold_p99_ns < 5000000, "Condition wait not counted as hold");
+}
+
+/**
+ * @brief Test: Lock metrics in the metrics JSON
+ */
+void test_output(void) {
+    printf("\n=== Test: Output ===\n");
+
+    metrics_init();
+    lockstat_lock(&g_lock);
+    lockstat_unlock(&g_lock);
+
+    const char *path = "/tmp/test_lockstat_metrics.json";
+    metrics_snapshot_json(path);
+    FILE *fp = fopen(path, "r");
+    char *buf = (char *)calloc(1, 1 << 20);
+    size_t n = fp != NULL ? fread(buf, 1, (1 << 20) - 1, fp) : 0;
+    buf[n] = '\0';
+    if (fp != NULL) fclose(fp);
+    remove(path);
+    TEST_ASSERT(strstr(buf, "\"lock_acquisitions\": {\"queue\": 1, ") != NULL, "Acquisitions by site");
+    TEST_ASSERT(strstr(buf, "\"lock_contentions\": {\"queue\": 0, ") != NULL, "Contentions by site");
+    TEST_ASSERT(strstr(buf, "\"lock_hold_ns\": {\"queue\": {\"count\": 1, ") != NULL, "Hold histogram by site");
+    TEST_ASSERT(strstr(buf, "\"lock_wait_ns\": {\"queue\": {\"count\": 0, ") != NULL, "Wait histogram by site");
+    free(buf);
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      LOCK CONTENTION UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+    metrics_register_thread();
+
+    test_uncontended();
+    test_contended();
+    test_cond_wait();
+    test_output();
+
+    metrics_unregister_thread();
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
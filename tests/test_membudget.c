@@ -0,0 +1,200 @@
+/**
+ * @file test_membudget.c
+ * @brief Unit tests for memory budget accounting and degradation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "membudget.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/**
+ * @brief Test: Charges and releases are tracked per subsystem
+ */
+void test_accounting(void) {
+    printf("\n=== Test: Per-subsystem accounting ===\n");
+
+    membudget_init(0);
+    membudget_charge(MEM_SUBSYS_PACKET, 1000);
+    membudget_charge(MEM_SUBSYS_QUEUE, 24);
+
+    membudget_snapshot_t snap;
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.subsys_bytes[MEM_SUBSYS_PACKET] == 1000, "Packet pool bytes tracked");
+    TEST_ASSERT(snap.subsys_bytes[MEM_SUBSYS_QUEUE] == 24, "Queue bytes tracked");
+    TEST_ASSERT(snap.used_bytes == 1024, "Total is sum of subsystems");
+
+    membudget_release(MEM_SUBSYS_PACKET, 1000);
+    membudget_release(MEM_SUBSYS_QUEUE, 24);
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.used_bytes == 0, "Releases return usage to zero");
+    TEST_ASSERT(snap.peak_bytes == 1024, "Peak usage retained");
+    TEST_ASSERT(membudget_admit(1 << 30), "Unlimited budget admits everything");
+}
+
+/**
+ * @brief Test: Levels step up and down with hysteresis
+ */
+void test_degradation_levels(void) {
+    printf("\n=== Test: Degradation levels ===\n");
+
+    membudget_init(1000);
+
+    membudget_charge(MEM_SUBSYS_PACKET, 750);
+    TEST_ASSERT(membudget_level() == MEM_DEGRADE_SNAPLEN, "75% usage reduces snaplen");
+    TEST_ASSERT(membudget_snaplen(1500) == MEMBUDGET_DEGRADED_SNAPLEN, "Snaplen applied");
+    TEST_ASSERT(membudget_payload_enabled(), "Payload still enabled");
+
+    membudget_charge(MEM_SUBSYS_PACKET, 210);
+    TEST_ASSERT(membudget_level() == MEM_DEGRADE_NO_PAYLOAD, "96% usage disables payload");
+    TEST_ASSERT(!membudget_payload_enabled(), "Payload disabled");
+
+    membudget_release(MEM_SUBSYS_PACKET, 20);
+    TEST_ASSERT(membudget_level() == MEM_DEGRADE_NO_PAYLOAD, "Hysteresis holds level at 94%");
+
+    membudget_release(MEM_SUBSYS_PACKET, 940);
+    TEST_ASSERT(membudget_level() == MEM_DEGRADE_NONE, "Level returns to none when drained");
+
+    membudget_snapshot_t snap;
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.transition_count == 3, "Three level changes recorded");
+    TEST_ASSERT(snap.transitions[2].to == MEM_DEGRADE_NONE, "Last transition is to none");
+}
+
+/**
+ * @brief Test: Admission refuses packets beyond the budget and samples when degraded
+ */
+void test_admission(void) {
+    printf("\n=== Test: Admission control ===\n");
+
+    membudget_init(1000);
+    TEST_ASSERT(membudget_admit(100), "Admits within budget");
+    TEST_ASSERT(!membudget_admit(1001), "Refuses beyond budget");
+
+    membudget_charge(MEM_SUBSYS_QUEUE, 850);
+    int admitted = 0;
+    for (int i = 0; i < MEMBUDGET_SAMPLE_RATE * 10; i++) {
+        if (membudget_admit(1)) admitted++;
+    }
+    TEST_ASSERT(admitted == 10, "Sampling admits 1-in-N while degraded");
+
+    membudget_snapshot_t snap;
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.admission_drops == 1, "Admission drop counted");
+    TEST_ASSERT(snap.sampled_out == (uint64_t)(MEMBUDGET_SAMPLE_RATE - 1) * 10, "Sampled-out packets counted");
+
+    membudget_release(MEM_SUBSYS_QUEUE, 850);
+}
+
+/**
+ * @brief Test: Allocation counts, window peaks, queued bytes and RSS
+ */
+void test_window_profile(void) {
+    printf("\n=== Test: Footprint profile ===\n");
+
+    membudget_init(0);
+    membudget_charge(MEM_SUBSYS_PACKET, 500);     /* Before the window */
+    membudget_window_begin();
+
+    membudget_snapshot_t snap;
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.subsys_allocs[MEM_SUBSYS_PACKET] == 0 &&
+                snap.subsys_peak_bytes[MEM_SUBSYS_PACKET] == 500 && snap.peak_bytes == 500,
+                "Window starts from current usage");
+
+    membudget_charge(MEM_SUBSYS_PACKET, 300);
+    membudget_charge(MEM_SUBSYS_PACKET, 200);
+    membudget_charge(MEM_SUBSYS_QUEUE, 24);
+    membudget_release(MEM_SUBSYS_PACKET, 1000);
+    membudget_release(MEM_SUBSYS_QUEUE, 24);
+    membudget_note_queued(100);
+    membudget_note_queued(300);
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.subsys_allocs[MEM_SUBSYS_PACKET] == 2 &&
+                snap.subsys_alloc_bytes[MEM_SUBSYS_PACKET] == 500 &&
+                snap.subsys_allocs[MEM_SUBSYS_QUEUE] == 1,
+                "Allocations and bytes counted per subsystem");
+    TEST_ASSERT(snap.subsys_peak_bytes[MEM_SUBSYS_PACKET] == 1000 && snap.peak_bytes == 1024 &&
+                snap.used_bytes == 0,
+                "Peaks kept after release");
+    TEST_ASSERT(snap.queued_packets == 2 && membudget_bytes_per_queued_packet(&snap) == 200.0,
+                "Bytes per queued packet");
+
+#ifdef __linux__
+    TEST_ASSERT(snap.rss_valid && snap.rss_bytes > 0 && snap.rss_samples == 1,
+                "RSS read at window begin, not by the snapshot");
+    membudget_sample_rss();
+    membudget_snapshot(&snap);
+    TEST_ASSERT(snap.rss_bytes > 0 && snap.rss_peak_bytes >= snap.rss_bytes && snap.rss_samples == 2,
+                "RSS sampled from /proc/self/status");
+
+    /* A touched allocation shows up in the peak even after it is freed */
+    size_t big = 32 * 1024 * 1024;
+    volatile char *block = malloc(big);
+    if (block != NULL) {
+        for (size_t i = 0; i < big; i += 4096) {
+            block[i] = 1;
+        }
+        membudget_sample_rss();
+        free((void *)block);
+    }
+    membudget_snapshot(&snap);
+    TEST_ASSERT(block != NULL && snap.rss_peak_bytes >= snap.rss_start_bytes + big / 2,
+                "Peak RSS covers a freed allocation");
+#endif
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    membudget_write_json(fp);
+    fclose(fp);
+    TEST_ASSERT(strstr(text, "\"allocations\": {") != NULL &&
+                strstr(text, "\"bytes_per_queued_packet\": 200.0,") != NULL &&
+                strstr(text, "\"peak_rss_bytes\": ") != NULL,
+                "Profile written to the memory block");
+    free(text);
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      MEMORY BUDGET UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init(NULL, LOG_ERROR);  /* Level-change warnings are expected */
+
+    test_accounting();
+    test_degradation_levels();
+    test_admission();
+    test_window_profile();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
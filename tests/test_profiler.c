@@ -0,0 +1,183 @@
+/**
+ * @file test_profiler.c
+ * @brief Unit tests for the sampling profiler
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "profiler.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define TEST_PROFILE_PATH "/tmp/test_profiler.folded"
+#define TEST_JSON_PATH "/tmp/test_profiler.json"
+#define TEST_BURN_MS 300
+
+static volatile uint64_t g_sink;
+
+static uint64_t thread_cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* Named CPU burner the folded stacks must show */
+__attribute__((noinline)) static void profiler_test_burn(uint64_t ms) {
+    uint64_t end = thread_cpu_ms() + ms;
+    uint64_t x = 1;
+    while (thread_cpu_ms() < end) {
+        for (int i = 0; i < 10000; i++) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        g_sink = x;
+    }
+}
+
+static void* burn_worker(void *arg) {
+    (void)arg;
+    profiler_register_thread(PROFILER_ROLE_WORKER);
+    profiler_test_burn(TEST_BURN_MS);
+    profiler_unregister_thread();
+    profiler_test_burn(50);     /* Not sampled */
+    return NULL;
+}
+
+static char* read_file(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return NULL;
+    char *buf = (char *)calloc(1, 1 << 20);
+    if (buf != NULL) {
+        size_t n = fread(buf, 1, (1 << 20) - 1, fp);
+        buf[n] = '\0';
+    }
+    fclose(fp);
+    return buf;
+}
+
+/**
+ * @brief Test: Nothing is sampled or written while the profiler is off
+ */
+void test_disabled(void) {
+    printf("\n=== Test: Profiler off ===\n");
+
+    TEST_ASSERT(profiler_register_thread(PROFILER_ROLE_CAPTURE) == -1, "Registering without start fails");
+    TEST_ASSERT(profiler_stop() == 0, "Stop without start is a no-op");
+    TEST_ASSERT(profiler_start(TEST_PROFILE_PATH, 0) == -1, "Zero rate rejected");
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    profiler_write_json(fp);
+    fclose(fp);
+    TEST_ASSERT(strstr(text, "\"enabled\": false") != NULL, "JSON reports the profiler as off");
+    free(text);
+}
+
+/**
+ * @brief Test: Samples per role end up as folded stacks
+ */
+void test_folded_output(void) {
+    printf("\n=== Test: Folded stacks ===\n");
+
+    remove(TEST_PROFILE_PATH);
+    TEST_ASSERT(profiler_start(TEST_PROFILE_PATH, 997) == 0, "Profiler started");
+    TEST_ASSERT(profiler_register_thread(PROFILER_ROLE_CAPTURE) == 0, "Main thread registered as capture");
+    TEST_ASSERT(profiler_register_thread(PROFILER_ROLE_CAPTURE) == -1, "Second registration refused");
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, burn_worker, NULL);
+    profiler_test_burn(TEST_BURN_MS);
+    pthread_join(thread, NULL);
+
+    TEST_ASSERT(profiler_stop() == 0, "Profile written");
+    profiler_summary_t summary;
+    profiler_get_summary(&summary);
+    TEST_ASSERT(summary.written && summary.threads == 2, "Summary counts both threads");
+    TEST_ASSERT(summary.samples[PROFILER_ROLE_CAPTURE] > 10 && summary.samples[PROFILER_ROLE_WORKER] > 10,
+                "Both roles sampled on CPU time");
+    TEST_ASSERT(summary.samples[PROFILER_ROLE_LOGGER] == 0, "No samples for an unregistered role");
+
+    char *folded = read_file(TEST_PROFILE_PATH);
+    TEST_ASSERT(folded != NULL, "Folded file readable");
+    if (folded != NULL) {
+        bool well_formed = true;
+        uint64_t total = 0;
+        for (char *line = strtok(folded, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+            char *count = strrchr(line, ' ');
+            well_formed = well_formed && count != NULL && strchr(line, ';') != NULL &&
+                          (strncmp(line, "capture;", 8) == 0 || strncmp(line, "worker;", 7) == 0);
+            if (count != NULL) total += strtoull(count + 1, NULL, 10);
+        }
+        TEST_ASSERT(well_formed, "Every line is role;frames count");
+        TEST_ASSERT(total + summary.dropped == summary.samples[PROFILER_ROLE_CAPTURE] +
+                                              summary.samples[PROFILER_ROLE_WORKER],
+                    "Line counts add up to the samples");
+        free(folded);
+    }
+
+    folded = read_file(TEST_PROFILE_PATH);
+    TEST_ASSERT(folded != NULL && strstr(folded, "capture;") != NULL &&
+                strstr(folded, "main;") != NULL && strstr(folded, "test_folded_output;profiler_test_burn") != NULL,
+                "Capture stacks symbolized from root to leaf");
+    TEST_ASSERT(folded != NULL && strstr(folded, "worker;") != NULL &&
+                strstr(folded, "burn_worker;profiler_test_burn") != NULL,
+                "Worker stacks include static functions");
+    free(folded);
+
+    FILE *fp = fopen(TEST_JSON_PATH, "w");
+    fprintf(fp, "{\n");
+    profiler_write_json(fp);
+    fprintf(fp, "\n}\n");
+    fclose(fp);
+    char *json = read_file(TEST_JSON_PATH);
+    TEST_ASSERT(json != NULL && strstr(json, "\"path\": \"" TEST_PROFILE_PATH "\"") != NULL &&
+                strstr(json, "\"written\": true") != NULL, "JSON references the folded file");
+    free(json);
+
+    profiler_cleanup();
+    remove(TEST_PROFILE_PATH);
+    remove(TEST_JSON_PATH);
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      SAMPLING PROFILER UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_disabled();
+    test_folded_output();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file test_registry.c
+ * @brief Unit tests for the metrics registry
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "registry.h"
+#include "metrics.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define TEST_THREADS 4
+#define TEST_ADDS 10000
+
+static const char *g_result_values[] = { "ok", "error" };
+
+static const registry_desc_t g_requests_desc = {
+    .name = "test_requests", .help = "Test requests by result.", .type = REGISTRY_COUNTER,
+    .label = "result", .label_values = g_result_values, .label_count = 2
+};
+static const registry_desc_t g_inflight_desc = {
+    .name = "test_inflight", .help = "Test gauge.", .type = REGISTRY_GAUGE
+};
+static const registry_desc_t g_size_desc = {
+    .name = "test_size", .help = "Test histogram.", .unit = "bytes", .type = REGISTRY_HISTOGRAM
+};
+
+static pthread_barrier_t g_barrier;
+
+static void* add_worker(void *arg) {
+    int id = *(int *)arg;
+    registry_register_thread();
+    for (int i = 0; i < TEST_ADDS; i++) {
+        registry_add(id, i & 1, 1);
+    }
+    /* Hold the shard until the main thread has taken a live snapshot */
+    pthread_barrier_wait(&g_barrier);
+    pthread_barrier_wait(&g_barrier);
+    registry_unregister_thread();
+    return NULL;
+}
+
+/**
+ * @brief Test: Registration, idempotence and bounded cardinality
+ */
+void test_register(void) {
+    printf("\n=== Test: Registration ===\n");
+
+    int requests = registry_register(&g_requests_desc);
+    TEST_ASSERT(requests >= 0, "Labeled counter registered");
+    TEST_ASSERT(registry_register(&g_requests_desc) == requests, "Registering again returns the same id");
+    TEST_ASSERT(registry_find("test_requests") == requests, "Found by name");
+    TEST_ASSERT(registry_find("missing") == -1, "Unknown name not found");
+
+    static const char *too_many[REGISTRY_MAX_LABEL_VALUES + 1];
+    for (int i = 0; i <= REGISTRY_MAX_LABEL_VALUES; i++) {
+        too_many[i] = "v";
+    }
+    registry_desc_t unbounded = { .name = "test_unbounded", .type = REGISTRY_COUNTER,
+                                  .label = "v", .label_values = too_many,
+                                  .label_count = REGISTRY_MAX_LABEL_VALUES + 1 };
+    TEST_ASSERT(registry_register(&unbounded) == -1, "Too many label values rejected");
+    TEST_ASSERT(registry_counter_slot(requests, 2) == -1, "Out-of-range series has no slot");
+}
+
+/**
+ * @brief Test: Sharded counters from several threads, live and after unregister
+ */
+void test_sharded_counters(void) {
+    printf("\n=== Test: Sharded counters ===\n");
+
+    int id = registry_register(&g_requests_desc);
+    registry_reset();
+    pthread_barrier_init(&g_barrier, NULL, TEST_THREADS + 1);
+    pthread_t threads[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_create(&threads[t], NULL, add_worker, &id);
+    }
+    registry_add(id, 0, 5);     /* Unregistered thread: shared slot */
+    registry_add(id, 7, 5);     /* Unknown series: ignored */
+
+    pthread_barrier_wait(&g_barrier);
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    TEST_ASSERT(registry_value(&snap, id, 0) == TEST_THREADS * TEST_ADDS / 2 + 5 &&
+                registry_value(&snap, id, 1) == TEST_THREADS * TEST_ADDS / 2,
+                "Live shards summed per series");
+    pthread_barrier_wait(&g_barrier);
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&g_barrier);
+
+    registry_snapshot(&snap);
+    TEST_ASSERT(registry_value(&snap, id, 0) + registry_value(&snap, id, 1) == TEST_THREADS * TEST_ADDS + 5,
+                "Exited shards folded into the shared slots");
+
+    registry_reset();
+    registry_snapshot(&snap);
+    TEST_ASSERT(registry_value(&snap, id, 0) == 0 && registry_value(&snap, id, 1) == 0,
+                "Reset clears the counters");
+}
+
+/**
+ * @brief Test: Gauges, histograms and serialization
+ */
+void test_gauge_histogram_output(void) {
+    printf("\n=== Test: Gauges, histograms and output ===\n");
+
+    int inflight = registry_register(&g_inflight_desc);
+    int size = registry_register(&g_size_desc);
+    registry_register_thread();
+    registry_set(inflight, 0, 3);
+    registry_set(inflight, 0, 7);
+    registry_observe(size, 0, 0);
+    registry_observe(size, 0, 1);
+    registry_observe(size, 0, 5);
+    registry_observe(size, 0, 1000);
+
+    registry_snapshot_t snap;
+    registry_snapshot(&snap);
+    TEST_ASSERT(registry_value(&snap, inflight, 0) == 7, "Gauge keeps the last value");
+    TEST_ASSERT(registry_value(&snap, size, 0) == 4 && registry_sum(&snap, size, 0) == 1006,
+                "Histogram count and sum");
+    TEST_ASSERT(registry_bucket(&snap, size, 0, 0) == 1 && registry_bucket(&snap, size, 0, 1) == 1 &&
+                registry_bucket(&snap, size, 0, 3) == 1 && registry_bucket(&snap, size, 0, 10) == 1,
+                "Values land in log2 buckets");
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    registry_write_json(fp, &snap);
+    fclose(fp);
+    TEST_ASSERT(strstr(text, "\"test_inflight\": 7,\n") != NULL, "Gauge as a JSON number");
+    TEST_ASSERT(strstr(text, "\"test_size\": {\"count\": 4, \"sum\": 1006, \"buckets\": [1, 1, 0, 1,") != NULL,
+                "Histogram as a JSON object");
+    free(text);
+
+    fp = open_memstream(&text, &len);
+    registry_write_openmetrics(fp, &snap, "x_");
+    fclose(fp);
+    TEST_ASSERT(strstr(text, "# TYPE x_test_requests counter\n") != NULL &&
+                strstr(text, "x_test_requests_total{result=\"error\"} 0\n") != NULL,
+                "Labeled counter in OpenMetrics");
+    TEST_ASSERT(strstr(text, "# UNIT x_test_size bytes\n") != NULL &&
+                strstr(text, "x_test_size_bucket{le=\"7\"} 3\n") != NULL &&
+                strstr(text, "x_test_size_bucket{le=\"+Inf\"} 4\n") != NULL &&
+                strstr(text, "x_test_size_sum 1006\n") != NULL,
+                "Cumulative histogram buckets in OpenMetrics");
+    free(text);
+    registry_unregister_thread();
+}
+
+/**
+ * @brief Test: Error, drop, EtherType and protocol counts recorded through the registry
+ */
+void test_metrics_port(void) {
+    printf("\n=== Test: Built-in metrics on the registry ===\n");
+
+    metrics_init();
+    metrics_register_thread();
+    metrics_record_ethertype(ETHER_IPV6);
+    metrics_record_protocol(PROTO_UDP);
+    metrics_record_protocol(PROTO_ICMPV6);
+    metrics_inc_checksum_failures();
+    metrics_inc_queue_drops();
+    metrics_inc_queue_drops();
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.ether_ipv6 == 1 && snap.proto_udp == 1 && snap.proto_icmp == 1 && snap.proto_tcp == 0,
+                "Snapshot fields read from the registry");
+    TEST_ASSERT(snap.checksum_failures == 1 && snap.parse_errors == 0 && snap.queue_drops == 2 &&
+                registry_value(&snap.registry, registry_find("drops"), 0) == 2,
+                "Errors and drops recorded through the registry");
+    TEST_ASSERT(registry_value(&snap.registry, registry_find("protocols"), METRICS_L4_UDP) == 1,
+                "Protocols registered under their JSON name");
+    metrics_snapshot_free(&snap);
+
+    const char *path = "/tmp/test_registry_metrics.json";
+    metrics_snapshot_json(path);
+    FILE *fp = fopen(path, "r");
+    char buf[65536];
+    size_t n = fp != NULL ? fread(buf, 1, sizeof(buf) - 1, fp) : 0;
+    buf[n] = '\0';
+    if (fp != NULL) fclose(fp);
+    remove(path);
+    TEST_ASSERT(strstr(buf, "\"protocols\": {\"tcp\": 0, \"udp\": 1, \"icmp\": 1, \"other\": 0},") != NULL,
+                "Protocols block written by the registry");
+    TEST_ASSERT(strstr(buf, "  \"errors\": {\n    \"parse_errors\": 0,\n    \"checksum_failures\": 1,\n"
+                            "    \"queue_drops\": 2,\n    \"capture_drops\": 0\n  },\n") != NULL &&
+                strstr(buf, "\"drops\":") == NULL,
+                "Errors and drops keep their JSON block");
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *om = open_memstream(&text, &len);
+    registry_write_openmetrics(om, &snap.registry, "x_");
+    fclose(om);
+    TEST_ASSERT(strstr(text, "x_errors_total{type=\"checksum\"} 1\n") != NULL &&
+                strstr(text, "x_drops_total{where=\"queue\"} 2\n") != NULL,
+                "Errors and drops keep their OpenMetrics labels");
+    free(text);
+
+    /* A reset keeps the layout and clears only the values */
+    int drops = registry_find("drops");
+    int slot = registry_counter_slot(drops, 0);
+    metrics_init();
+    metrics_inc_capture_drops();
+    metrics_snapshot(&snap);
+    TEST_ASSERT(registry_find("drops") == drops && registry_counter_slot(drops, 0) == slot &&
+                snap.queue_drops == 0 && snap.capture_drops == 1,
+                "Registered once, values reset per epoch");
+    metrics_snapshot_free(&snap);
+
+    metrics_unregister_thread();
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      METRICS REGISTRY UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_register();
+    test_sharded_counters();
+    test_gauge_histogram_output();
+    test_metrics_port();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
@@ -419,6 +419,196 @@ void test_load_fixture_warn_only(void) {
     TEST_ASSERT(result == true, "Warn-only mismatches should pass validation");
 }
 
+/**
+ * @brief Test: Cycles per packet gates only when both sides have counters
+ */
+void test_cycles_per_packet_gate(void) {
+    printf("\n=== Test: Cycles per packet regression ===\n");
+    
+    regression_baseline_t baseline;
+    regression_load_baseline("tests/fixtures/baseline_valid.json", &baseline);
+    TEST_ASSERT(baseline.perf_valid == false, "Baseline without perf block has no cycles/packet");
+    
+    baseline.perf_valid = true;
+    baseline.cycles_per_packet = 1000.0;
+    
+    metrics_snapshot_t current;
+    memset(&current, 0, sizeof(current));
+    current.pkts_processed = 1000;
+    current.pkts_captured = 1000;
+    current.capture_elapsed_sec = 1.0;
+    
+    regression_result_t result;
+    regression_compare(&baseline, &current, 0.10, &result);
+    TEST_ASSERT(!result.perf_valid && !result.cpp_regression, "Not compared without current counters");
+    
+    current.perf.available = true;
+    current.perf.values[PERFCOUNT_CYCLES] = 1050000;
+    regression_compare(&baseline, &current, 0.10, &result);
+    TEST_ASSERT(result.perf_valid && !result.cpp_regression, "5% more cycles/packet within threshold");
+    
+    current.perf.values[PERFCOUNT_CYCLES] = 1200000;
+    regression_compare(&baseline, &current, 0.10, &result);
+    TEST_ASSERT(result.cpp_regression && result.any_regression, "20% more cycles/packet is a regression");
+}
+
+/**
+ * @brief Test: Counters cover the window, or report why they are unavailable
+ */
+void test_perf_counters_window(void) {
+    printf("\n=== Test: Hardware counter window ===\n");
+    
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 1000000; i++) {
+        sink += (uint64_t)i * i;
+    }
+    
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    if (snap.perf.available) {
+        TEST_ASSERT(snap.perf.threads == 1 && snap.perf.values[PERFCOUNT_CYCLES] > 0,
+                    "Cycles counted for the registered thread");
+        TEST_ASSERT(!snap.perf.valid[PERFCOUNT_INSTRUCTIONS] ||
+                    snap.perf.values[PERFCOUNT_INSTRUCTIONS] >= 1000000,
+                    "Instructions cover the loop");
+    } else {
+        TEST_ASSERT(perfcount_unavailable_reason() != NULL, "Unavailable counters report a reason");
+        TEST_ASSERT(snap.perf.values[PERFCOUNT_CYCLES] == 0, "No cycles reported without counters");
+    }
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+    
+    /* Counts of an exited thread stay in the window */
+    perfcount_totals_t totals;
+    perfcount_read(&totals);
+    TEST_ASSERT(totals.available == snap.perf.available, "Unregistered thread still counted");
+}
+
+/**
+ * @brief Test: Thread CPU time per packet is reported and gated
+ */
+void test_cpu_per_packet(void) {
+    printf("\n=== Test: Thread CPU accounting ===\n");
+    
+    metrics_init();
+    metrics_register_thread();
+    metrics_set_thread_name("capture");
+    metrics_add_thread_time(5000, 5000);   /* Before the window, not counted */
+    metrics_start();
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 2000000; i++) {
+        sink += (uint64_t)i * i;
+    }
+    metrics_add_thread_time(3000, 1000);
+    for (int i = 0; i < 1000; i++) {
+        metrics_inc_processed(100);
+    }
+    
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.thread_count == 1 && strcmp(snap.threads[0].name, "capture") == 0,
+                "Registered thread reported under its name");
+    TEST_ASSERT(snap.threads[0].busy_ns == fastclock_to_ns(3000) &&
+                snap.threads[0].idle_ns == fastclock_to_ns(1000),
+                "Busy/idle time counts from metrics_start()");
+    TEST_ASSERT(snap.threads[0].packets == 1000, "Thread packets from its shard");
+    
+    double cpu_per_pkt = metrics_cpu_ns_per_packet(&snap);
+    if (snap.cpu_valid) {
+        TEST_ASSERT(snap.threads[0].cpu_ns > 0 && cpu_per_pkt > 0, "CPU time covers the loop");
+        
+        const char *path = "/tmp/test_regression_cpu.json";
+        metrics_snapshot_json(path);
+        regression_baseline_t baseline;
+        regression_load_baseline(path, &baseline);
+        remove(path);
+        TEST_ASSERT(baseline.cpu_valid && baseline.cpu_ns_per_packet > 0,
+                    "CPU per packet read back from the cpu block");
+        
+        regression_result_t result;
+        baseline.cpu_ns_per_packet = cpu_per_pkt * 0.95;
+        regression_compare(&baseline, &snap, 0.10, &result);
+        TEST_ASSERT(result.cpu_valid && !result.cpu_regression, "5% more CPU/packet within threshold");
+        
+        baseline.cpu_ns_per_packet = cpu_per_pkt / 1.2;
+        regression_compare(&baseline, &snap, 0.10, &result);
+        TEST_ASSERT(result.cpu_regression && result.any_regression, "20% more CPU/packet is a regression");
+    } else {
+        TEST_ASSERT(cpu_per_pkt == 0.0, "No CPU/packet without thread CPU clocks");
+    }
+    metrics_snapshot_free(&snap);
+    metrics_unregister_thread();
+    
+    /* CPU time of an exited thread stays in the window */
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.thread_count == 0 && (!snap.cpu_valid || snap.cpu_ns > 0),
+                "Unregistered thread's CPU time kept");
+    metrics_snapshot_free(&snap);
+}
+
+/**
+ * @brief Test: Peak RSS and bytes per queued packet gate on the threshold
+ */
+void test_memory_gate(void) {
+    printf("\n=== Test: Memory footprint gate ===\n");
+    
+    metrics_init();
+    metrics_start();
+    membudget_note_queued(1000);
+    membudget_note_queued(1200);
+    for (int i = 0; i < 1000; i++) {
+        metrics_inc_processed(100);
+    }
+    
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    TEST_ASSERT(membudget_bytes_per_queued_packet(&snap.memory) == 1100.0,
+                "Snapshot carries the memory profile");
+    
+    const char *path = "/tmp/test_regression_memory.json";
+    metrics_snapshot_json(path);
+    regression_baseline_t baseline;
+    regression_load_baseline(path, &baseline);
+    remove(path);
+    TEST_ASSERT(baseline.bytes_per_queued_packet == 1100.0 &&
+                (baseline.peak_rss_bytes > 0) == snap.memory.rss_valid,
+                "Memory footprint read back from the memory block");
+    
+    regression_result_t result;
+    baseline.bytes_per_queued_packet = 1050.0;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(result.queued_bytes_valid && !result.queued_bytes_regression,
+                "5% more bytes per queued packet within threshold");
+    
+    baseline.bytes_per_queued_packet = 900.0;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(result.queued_bytes_regression && result.any_regression,
+                "22% more bytes per queued packet is a regression");
+    
+    if (snap.memory.rss_valid) {
+        baseline.bytes_per_queued_packet = 1100.0;
+        baseline.peak_rss_bytes = snap.memory.rss_peak_bytes * 100 / 125;
+        regression_compare(&baseline, &snap, 0.10, &result);
+        TEST_ASSERT(result.rss_valid && result.rss_regression && result.any_regression,
+                    "25% higher peak RSS is a regression");
+        
+        baseline.peak_rss_bytes = snap.memory.rss_peak_bytes;
+        regression_compare(&baseline, &snap, 0.10, &result);
+        TEST_ASSERT(!result.rss_regression && !result.queued_bytes_regression,
+                    "Unchanged footprint passes");
+    }
+    
+    baseline.peak_rss_bytes = 0;
+    baseline.bytes_per_queued_packet = 0.0;
+    regression_compare(&baseline, &snap, 0.10, &result);
+    TEST_ASSERT(!result.rss_valid && !result.queued_bytes_valid,
+                "Older baselines without memory data are not gated");
+    metrics_snapshot_free(&snap);
+}
+
 int main(void) {
     printf("================================================================================\n");
     printf("              REGRESSION METADATA VALIDATION UNIT TESTS\n");
@@ -456,6 +646,14 @@ int main(void) {
     test_load_fixture_mismatch_traffic();
     test_load_fixture_warn_only();
     
+    /* Hardware counter tests */
+    test_cycles_per_packet_gate();
+    test_perf_counters_window();
+    test_cpu_per_packet();
+    
+    /* Memory footprint */
+    test_memory_gate();
+    
     /* Cleanup */
     logger_cleanup();
     
@@ -0,0 +1,109 @@
+/**
+ * @file test_shm_stats.c
+ * @brief Unit tests for the shared-memory metrics segment
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "shm_stats.h"
+#include "metrics.h"
+#include "logger.h"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/**
+ * @brief Test: Published stats are readable through the segment
+ */
+void test_publish_and_read(void) {
+    printf("\n=== Test: Publish and read ===\n");
+
+    shm_stats_reader_t reader;
+    TEST_ASSERT(shm_stats_attach(getpid(), &reader) != 0, "Attach fails before publishing");
+
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+    for (int i = 0; i < 42; i++) {
+        metrics_inc_processed(64);
+        metrics_observe_latency(3000);
+    }
+
+    TEST_ASSERT(shm_stats_start(10) == 0, "Segment created");
+    TEST_ASSERT(shm_stats_attach(getpid(), &reader) == 0, "Attach to own segment");
+
+    shm_stats_t *stats = malloc(sizeof(shm_stats_t));
+    uint64_t first_count = 0, count = 0;
+    usleep(50000);
+    TEST_ASSERT(shm_stats_read(&reader, stats, &first_count) == 0 && first_count > 0,
+                "Consistent read");
+    TEST_ASSERT(stats->pkts_processed == 42 && stats->bytes_processed == 42 * 64 &&
+                stats->active == 1, "Counters published");
+    TEST_ASSERT(stats->latency_p50_ns >= 3000 && stats->latency_p50_ns <= 3004,
+                "Latency percentiles published");
+    TEST_ASSERT(stats->shard_count >= 1 && stats->shards[0].pkts_processed == 42,
+                "Per-thread shard counters published");
+
+    metrics_snapshot_t snap;
+    metrics_summary_t summary;
+    metrics_observe_latency(90000);
+    metrics_snapshot(&snap);
+    metrics_summary(&summary);
+    TEST_ASSERT(summary.pkts_processed == snap.pkts_processed && summary.latency_count == 43 &&
+                summary.latency_p50_ns == metrics_percentile_ns(&snap, 0.50) &&
+                summary.latency_p99_ns == metrics_percentile_ns(&snap, 0.99) &&
+                memcmp(summary.latency_histogram, snap.latency_histogram, sizeof(snap.latency_histogram)) == 0,
+                "Light reader matches the full snapshot");
+    metrics_snapshot_free(&snap);
+
+    metrics_inc_processed(64);
+    usleep(50000);
+    shm_stats_read(&reader, stats, &count);
+    TEST_ASSERT(count > first_count && stats->pkts_processed == 43, "Updates follow the metrics");
+
+    shm_stats_stop();
+    shm_stats_detach(&reader);
+    TEST_ASSERT(shm_stats_attach(getpid(), &reader) != 0, "Segment unlinked on stop");
+
+    free(stats);
+    metrics_unregister_thread();
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      SHARED-MEMORY STATS UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_publish_and_read();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file test_timeseries.c
+ * @brief Unit tests for the per-interval metrics time series
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "timeseries.h"
+#include "metrics.h"
+#include "logger.h"
+
+#define TEST_FILE "/tmp/test_timeseries.csv"
+
+/* Test result tracking */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  [PASS] %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  [FAIL] %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+/**
+ * @brief Test: Format names
+ */
+void test_parse_format(void) {
+    printf("\n=== Test: Format names ===\n");
+
+    timeseries_format_t format = TIMESERIES_JSONL;
+    TEST_ASSERT(timeseries_parse_format("csv", &format) == 0 && format == TIMESERIES_CSV,
+                "csv accepted");
+    TEST_ASSERT(timeseries_parse_format("jsonl", &format) == 0 && format == TIMESERIES_JSONL,
+                "jsonl accepted");
+    TEST_ASSERT(timeseries_parse_format("xml", &format) != 0, "Unknown format rejected");
+}
+
+/**
+ * @brief Test: Samples hold per-interval deltas and reach the file
+ */
+void test_interval_deltas(void) {
+    printf("\n=== Test: Interval deltas ===\n");
+
+    metrics_init();
+    metrics_register_thread();
+    metrics_start();
+
+    timeseries_config_t config = {
+        .path = TEST_FILE, .format = TIMESERIES_CSV, .interval_ms = 50, .capacity = 64
+    };
+    TEST_ASSERT(timeseries_start(&config) == 0, "Time series started");
+
+    /* Fast phase, then a slow phase two intervals later */
+    for (int i = 0; i < 100; i++) {
+        metrics_inc_processed(100);
+        metrics_observe_latency(1000);
+    }
+    usleep(150000);
+    for (int i = 0; i < 100; i++) {
+        metrics_inc_processed(100);
+        metrics_observe_latency(100000);
+    }
+    usleep(150000);
+
+    timeseries_sample_t samples[64];
+    size_t count = timeseries_get_samples(samples, 64);
+    timeseries_stop();
+
+    uint64_t total_pkts = 0;
+    int first = -1, last = -1;
+    for (size_t i = 0; i < count; i++) {
+        total_pkts += samples[i].pkts;
+        if (samples[i].pkts > 0) {
+            if (first < 0) first = (int)i;
+            last = (int)i;
+        }
+    }
+    TEST_ASSERT(count >= 4, "One sample per interval");
+    TEST_ASSERT(total_pkts == 200, "Interval packet counts add up to the total");
+    TEST_ASSERT(first >= 0 && first != last &&
+                samples[first].latency_p99_ns < 2000 && samples[last].latency_p50_ns >= 100000,
+                "Latency percentiles cover their own interval only");
+
+    FILE *fp = fopen(TEST_FILE, "r");
+    char line[512];
+    int lines = 0;
+    bool header = false;
+    while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+        if (lines == 0) header = strncmp(line, "t_sec,interval_sec,pkts", 23) == 0;
+        lines++;
+    }
+    if (fp != NULL) fclose(fp);
+    TEST_ASSERT(header && lines >= (int)count + 1, "CSV header and one row per sample written");
+
+    unlink(TEST_FILE);
+    metrics_unregister_thread();
+}
+
+/**
+ * @brief Test: Time-weighted queue depth and occupancy, per run and per interval
+ */
+void test_queue_occupancy(void) {
+    printf("\n=== Test: Queue occupancy ===\n");
+
+    metrics_set_queue_capacity(10);
+    metrics_init();
+    metrics_start();
+
+    timeseries_config_t config = { .path = NULL, .interval_ms = 50, .capacity = 64 };
+    timeseries_start(&config);
+
+    /* Near full for 200 ms, then empty for 200 ms */
+    metrics_observe_queue_occupancy(0);
+    metrics_set_queue_depth(9);
+    usleep(200000);
+    metrics_observe_queue_occupancy(5);
+    metrics_observe_queue_occupancy(9);
+    metrics_observe_queue_occupancy(10);
+    metrics_set_queue_depth(0);
+    usleep(200000);
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    timeseries_sample_t samples[64];
+    size_t count = timeseries_get_samples(samples, 64);
+    timeseries_stop();
+
+    TEST_ASSERT(snap.queue_capacity == 10 && snap.queue_depth_mean > 3.5 && snap.queue_depth_mean < 5.5,
+                "Time-weighted mean depth");
+    double high_pct = 100.0 * snap.queue_high_ns / snap.queue_window_ns;
+    TEST_ASSERT(high_pct > 35.0 && high_pct < 65.0, "Time at or above the high threshold");
+    TEST_ASSERT(snap.queue_occupancy[0] == 1 && snap.queue_occupancy[5] == 1 &&
+                snap.queue_occupancy[9] == 1 && snap.queue_occupancy[METRICS_QUEUE_OCC_BUCKETS - 1] == 1,
+                "Arrivals bucketed by fill level, full queue separate");
+
+    bool saw_high = false, saw_empty = false;
+    for (size_t i = 0; i < count; i++) {
+        saw_high = saw_high || (samples[i].queue_depth_mean > 8.5 && samples[i].queue_high_pct > 95.0);
+        saw_empty = saw_empty || (samples[i].queue_depth_mean < 0.5 && samples[i].queue_high_pct < 5.0);
+    }
+    TEST_ASSERT(saw_high && saw_empty, "Intervals report their own mean depth and high time");
+
+    metrics_snapshot_free(&snap);
+
+    /* A reset starts the run's counters over but keeps the live depth */
+    metrics_set_queue_depth(4);
+    metrics_init();
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.queue_depth == 4 && snap.queue_depth_max == 4 && snap.queue_occupancy[0] == 0,
+                "Depth carried across a reset, per-run counters cleared");
+    metrics_snapshot_free(&snap);
+    metrics_observe_queue_occupancy(4);
+    metrics_set_queue_depth(0);
+    metrics_snapshot(&snap);
+    TEST_ASSERT(snap.queue_depth == 0 && snap.queue_depth_max == 4 && snap.queue_occupancy[4] == 1 &&
+                snap.queue_occupancy[9] == 0, "Counters restart on the first update after the reset");
+    metrics_snapshot_free(&snap);
+    metrics_set_queue_capacity(0);
+}
+
+static atomic_bool g_reader_running;
+
+static void* ring_reader(void *arg) {
+    size_t *reads = (size_t *)arg;
+    timeseries_sample_t samples[16];
+    while (atomic_load(&g_reader_running)) {
+        *reads += timeseries_get_samples(samples, 16) <= 16;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Test: Readers may run while the ring is created and torn down
+ */
+void test_reader_during_stop(void) {
+    printf("\n=== Test: Reader during start/stop ===\n");
+
+    metrics_init();
+    metrics_start();
+    size_t reads = 0;
+    pthread_t reader;
+    atomic_store(&g_reader_running, true);
+    pthread_create(&reader, NULL, ring_reader, &reads);
+
+    bool started = true;
+    for (int i = 0; i < 20; i++) {
+        timeseries_config_t config = { .path = NULL, .interval_ms = 1, .capacity = 4 + (uint32_t)i };
+        started = started && timeseries_start(&config) == 0;
+        usleep(5000);
+        timeseries_stop();
+    }
+    atomic_store(&g_reader_running, false);
+    pthread_join(reader, NULL);
+
+    timeseries_sample_t samples[4];
+    TEST_ASSERT(started && reads > 0, "Ring replaced 20 times under a concurrent reader");
+    TEST_ASSERT(timeseries_get_samples(samples, 4) == 0, "No samples after stop");
+}
+
+int main(void) {
+    printf("================================================================================\n");
+    printf("                      TIME SERIES UNIT TESTS\n");
+    printf("================================================================================\n");
+
+    logger_init("/dev/null", LOG_INFO);
+
+    test_parse_format();
+    test_interval_deltas();
+    test_queue_occupancy();
+    test_reader_during_stop();
+
+    logger_cleanup();
+
+    printf("\n================================================================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("================================================================================\n");
+
+    if (tests_failed > 0) {
+        printf("\n*** TESTS FAILED ***\n\n");
+        return 1;
+    }
+
+    printf("\n*** ALL TESTS PASSED ***\n\n");
+    return 0;
+}
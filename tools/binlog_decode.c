@@ -0,0 +1,48 @@
+/**
+ * @file binlog_decode.c
+ * @brief Offline decoder for binary logs written with --binlog
+ *
+ * Usage: binlog_decode FILE [OUTPUT]
+ */
+
+#include <stdio.h>
+#include "logger.h"
+#include "logger_bin.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s FILE [OUTPUT]\n", argv[0]);
+        fprintf(stderr, "Decode a binary log recorded with --binlog into text.\n");
+        return 1;
+    }
+
+    logger_init(NULL, LOG_WARN);
+
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        logger_error("Cannot open %s", argv[1]);
+        logger_cleanup();
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            logger_error("Cannot create %s", argv[2]);
+            fclose(in);
+            logger_cleanup();
+            return 1;
+        }
+    }
+
+    long events = logger_bin_decode(in, out);
+
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+    logger_cleanup();
+
+    return events < 0 ? 1 : 0;
+}